@@ -0,0 +1,27 @@
+#!/bin/bash
+##############################################################################
+# Benchmark the construction time and the simulation step rate of the
+# DriftChamber for each wire mode (DC_construct_wire, see det.xml).
+#
+# Usage (from the top directory of CEPCSW, after source setup.sh):
+# $ Detector/DetDriftChamber/scripts/bench-wire-modes.sh [evtmax]
+##############################################################################
+
+evtmax=${1:-100}
+options=Examples/options/bench_detsim_DC_wiremodes.py
+
+printf "%-6s %-12s %-16s %-16s %-12s\n" "mode" "build [s]" "steps/s" "s/event" "steps in DC"
+
+for mode in 0 1 2 3; do
+    log=bench-wire-mode-${mode}.log
+    DC_CONSTRUCT_WIRE=${mode} EVTMAX=${evtmax} ./run.sh ${options} > ${log} 2>&1 || {
+        echo "ERROR: mode ${mode} failed, see ${log}" 1>&2
+        continue
+    }
+
+    build=$(sed -n 's/.*elapsed time (DC_construct_wire=[0-9]*): \([0-9.e+-]*\)s.*/\1/p' ${log} | tail -1)
+    rate=$(sed -n 's/.*Step rate: \([0-9.e+-]*\) steps\/s, time per event: \([0-9.e+-]*\) s.*/\1 \2/p' ${log} | tail -1)
+    dcsteps=$(sed -n "s/.*Steps in volumes 'DriftChamber\*': \([0-9]*\).*/\1/p" ${log} | tail -1)
+
+    printf "%-6s %-12s %-16s %-16s %-12s\n" ${mode} "${build}" ${rate:-"- -"} "${dcsteps}"
+done
@@ -1,5 +1,6 @@
 #include "DD4hep/DetFactoryHelper.h"
 #include "DD4hep/Printout.h"
+#include "DD4hep/Version.h"
 #include "XML/Layering.h"
 #include "XML/Utilities.h"
 #include "XML/XMLElements.h"
@@ -7,8 +8,13 @@
 #include "DDSegmentation/Segmentation.h"
 #include "DetSegmentation/GridDriftChamber.h"
 
+#include "TGeoManager.h"
+#include "TGeoMaterial.h"
+#include "TGeoMedium.h"
+
 #include <iostream>
 #include <chrono>
+#include <vector>
 
 using namespace dd4hep;
 using namespace dd4hep::detail;
@@ -17,6 +23,85 @@ using namespace dd4hep::rec ;
 #define MYDEBUG(x) std::cout << __FILE__ << ":" << __LINE__ << ": " << x << std::endl;
 #define MYDEBUGVAL(x) std::cout << __FILE__ << ":" << __LINE__ << ": " << #x << ": " << x << std::endl;
 
+// How the wires are built, selected by the constant DC_construct_wire
+// - NoWire:         no wire at all
+// - IndividualWire: each wire is placed individually
+// - ParamWire:      the wires at the same position in the cell are placed
+//                   as one parametrised volume per layer
+// - SmearedWire:    no wire volume, the layer is filled with a mixture of
+//                   the gas and the wire materials with the same mass
+enum WireMode {
+    NoWire = 0,
+    IndividualWire = 1,
+    ParamWire = 2,
+    SmearedWire = 3
+};
+
+// material and cross section of one wire component
+struct WireComponent {
+    dd4hep::Material material;
+    double area;
+};
+
+// Mixture of the layer gas with the wires of one layer.
+// The fractions are the ratio of the wire volumes to the layer volume.
+static dd4hep::Material smeared_material(dd4hep::Detector& theDetector,
+                                         const std::string& name,
+                                         dd4hep::Material gas,
+                                         const std::vector<WireComponent>& wires,
+                                         const std::vector<double>& fractions) {
+    TGeoManager& mgr = theDetector.manager();
+    TGeoMaterial* gas_mat = gas->GetMaterial();
+
+    double gas_fraction = 1.;
+    double density = 0.;
+    for(size_t i=0; i<wires.size(); i++) {
+        gas_fraction -= fractions[i];
+        density += fractions[i]*wires[i].material->GetMaterial()->GetDensity();
+    }
+    density += gas_fraction*gas_mat->GetDensity();
+
+    TGeoMixture* mix = new TGeoMixture(name.c_str(), wires.size()+1, density);
+    mix->AddElement(gas_mat, gas_fraction*gas_mat->GetDensity()/density);
+    for(size_t i=0; i<wires.size(); i++) {
+        TGeoMaterial* wire_mat = wires[i].material->GetMaterial();
+        mix->AddElement(wire_mat, fractions[i]*wire_mat->GetDensity()/density);
+    }
+
+    TGeoMedium* medium = new TGeoMedium(name.c_str(), mgr.GetListOfMedia()->GetSize()+1, mix);
+    return dd4hep::Material(medium);
+}
+
+// Volume of the hyperboloid layer between z=-dz and z=dz, with the radii
+// r(z)^2 = r0^2 + z^2*tan(stereo)^2 at the inner and the outer surface
+static double hyperboloid_volume(double rin0, double stin, double rout0, double stout, double dz) {
+    double tin = std::tan(stin);
+    double tout = std::tan(stout);
+    return 2*M_PI*dz*(rout0*rout0-rin0*rin0) + 2*M_PI*dz*dz*dz/3*(tout*tout-tin*tin);
+}
+
+// Place count copies of vol rotated around z by step, the first one at start
+static void place_wires(dd4hep::Volume& mother, dd4hep::Volume& vol,
+                        const dd4hep::Transform3D& start, int count, double step,
+                        bool parametrised) {
+#if DD4HEP_VERSION_GE(1,19)
+    if(parametrised && count > 1) {
+        // the transformation of the copy i is start * inc^i.
+        // conjugate the rotation by start, so that the copies are rotated
+        // around the z axis of the mother: start * inc^i = Rz(i*step) * start
+        dd4hep::Transform3D inc = start.Inverse()*dd4hep::Transform3D(dd4hep::RotationZ(step))*start;
+        mother.paramVolume1D(start, vol, count, inc);
+        return;
+    }
+#else
+    (void)parametrised;
+#endif
+    for(int i=0; i<count; i++) {
+        dd4hep::Transform3D transform = dd4hep::Transform3D(dd4hep::RotationZ(i*step))*start;
+        mother.placeVolume(vol,transform);
+    }
+}
+
 static dd4hep::Ref_t create_detector(dd4hep::Detector& theDetector,
         xml_h e,
         dd4hep::SensitiveDetector sens) {
@@ -72,6 +157,15 @@ static dd4hep::Ref_t create_detector(dd4hep::Detector& theDetector,
     double cell_width = theDetector.constant<double>("DC_cell_width");
 
     int DC_construct_wire = theDetector.constant<int>("DC_construct_wire");
+    if(DC_construct_wire < NoWire || DC_construct_wire > SmearedWire) {
+        throw std::runtime_error("DriftChamber: unknown DC_construct_wire "+std::to_string(DC_construct_wire));
+    }
+#if !DD4HEP_VERSION_GE(1,19)
+    if(DC_construct_wire == ParamWire) {
+        std::cout << "DriftChamber: parametrised volumes are not supported by this DD4hep, "
+                  << "the wires are placed individually." << std::endl;
+    }
+#endif
 
     // =======================================================================
     // Detector Construction
@@ -109,6 +203,9 @@ static dd4hep::Ref_t create_detector(dd4hep::Detector& theDetector,
     /// - construct wires
     dd4hep::Volume signalWireVolume;
     dd4hep::Volume fieldWireVolume;
+    // wire components used by the smeared material
+    std::vector<WireComponent> signalWireComponents;
+    std::vector<WireComponent> fieldWireComponents;
     for(xml_coll_t dcModule(x_det,_U(module)); dcModule; ++dcModule) {
         xml_comp_t x_module = dcModule;
         std::string module_name = x_module.nameStr();
@@ -129,10 +226,13 @@ static dd4hep::Ref_t create_detector(dd4hep::Detector& theDetector,
             dd4hep::Tube wire_solid(x_tube.rmin(),x_tube.rmax(),chamber_half_length);
             dd4hep::Volume wire_vol(wire_name,wire_solid,tube_mat);
             dd4hep::Transform3D transform_wire(dd4hep::Rotation3D(),dd4hep::Position(0.,0.,0.));
+            WireComponent component = {tube_mat, M_PI*(x_tube.rmax()*x_tube.rmax()-x_tube.rmin()*x_tube.rmin())};
             if(0==x_module.id()) {
                 signalWireVolume.placeVolume(wire_vol,transform_wire);
+                signalWireComponents.push_back(component);
             } else {
                 fieldWireVolume.placeVolume(wire_vol,transform_wire);
+                fieldWireComponents.push_back(component);
             }
         }//end of construct tubes
     }//end of construct wire
@@ -160,7 +260,7 @@ static dd4hep::Ref_t create_detector(dd4hep::Detector& theDetector,
         double rmid_zEnd = rmid_zZero/std::cos(alpha/2);  //  z=endcap
         int nCell = floor((2. * M_PI * rmid_zZero) / layer_width);
         int nWire = nCell;
-        if(!DC_construct_wire) nWire =0;
+        if(NoWire==DC_construct_wire || SmearedWire==DC_construct_wire) nWire =0;
         double cell_phi = 2*M_PI / nCell;
         double offset=0;//phi offset of first cell in each layer
         double sign_eps = 1;// setero angle sign
@@ -190,9 +290,36 @@ static dd4hep::Ref_t create_detector(dd4hep::Detector& theDetector,
         double eps_in = epsilon_func(delta_a_in, chamber_length );
         double eps_out = epsilon_func(delta_a_out, chamber_length );
 
+        // the outermost layer has two more field wires per cell
+        int num = 3;
+        if(layer_id==(DC_layer_number-1)) {
+            num = 5;
+        }
+
         /// create hyper layer volume
+        dd4hep::Material layer_mat = det_mat;
+        if(SmearedWire==DC_construct_wire) {
+            // The wires are tilted by epsilon, so they are longer than the layer by 1/cos(epsilon).
+            // The layer is a hyperboloid: its volume is larger than the one of the
+            // annulus at z=0 times the length by a factor 1+tan(alpha/2)^2/3
+            // (e.g. 1% for alpha = 20 deg).
+            double layer_volume = hyperboloid_volume(r_in0, eps_in, r_out0, eps_out, chamber_half_length);
+            double scale = nCell*chamber_length/(layer_volume*std::cos(epsilon));
+            std::vector<WireComponent> components;
+            std::vector<double> fractions;
+            for(auto& comp: signalWireComponents) {
+                components.push_back(comp);
+                fractions.push_back(comp.area*scale);
+            }
+            for(auto& comp: fieldWireComponents) {
+                components.push_back(comp);
+                fractions.push_back(num*comp.area*scale);
+            }
+            layer_mat = smeared_material(theDetector, det_name+"_layer_mat_"+std::to_string(layer_id),
+                                         det_mat, components, fractions);
+        }
         dd4hep::Hyperboloid layer_vol_solid(r_in0, eps_in, r_out0, eps_out, chamber_half_length);
-        dd4hep::Volume layer_vol(det_name+"_layer_vol",layer_vol_solid,det_mat);
+        dd4hep::Volume layer_vol(det_name+"_layer_vol",layer_vol_solid,layer_mat);
         current_vol_ptr = &layer_vol;
 
         if ( x_det.isSensitive() )   {
@@ -210,10 +337,11 @@ static dd4hep::Ref_t create_detector(dd4hep::Detector& theDetector,
         //    |             |
         //    |    F0     F1|
         //--------------------
-        // loop over cells
-        for(int icell=0; icell<nWire; icell++) {
+        // the wires of the first cell. The wires of cell icell are the same
+        // ones rotated by icell*cell_phi around z.
+        if(nWire > 0) {
 
-            double wire_phi = icell*cell_phi + offset;
+            double wire_phi = offset;
 
             // - signal wire
             dd4hep::RotationZ rz(wire_phi+Pi);
@@ -221,14 +349,11 @@ static dd4hep::Ref_t create_detector(dd4hep::Detector& theDetector,
             dd4hep::Position tr3D = Position(rmid_zZero*std::cos(wire_phi),rmid_zZero*std::sin(wire_phi),0.);
             dd4hep::Transform3D transform_signal_wire(rz*ry,tr3D);
 
-            (*current_vol_ptr).placeVolume(signalWireVolume,transform_signal_wire);
+            place_wires(*current_vol_ptr, signalWireVolume, transform_signal_wire,
+                        nWire, cell_phi, ParamWire==DC_construct_wire);
             // - Field wire
             double radius[5] = {rmid_zZero-layer_width*0.5+safe_distance,rmid_zZero-layer_width*0.5+safe_distance,rmid_zZero,rmid_zZero+layer_width*0.5-safe_distance,rmid_zZero+layer_width*0.5-safe_distance};
             double phi[5] = {wire_phi,wire_phi-cell_phi*0.5,wire_phi-cell_phi*0.5,wire_phi-cell_phi*0.5,wire_phi};
-            int num = 3;
-            if(layer_id==(DC_layer_number-1)) {
-                num = 5;
-            }
             for(int i=0; i<num ; i++) {
                 dd4hep::RotationZ rz_field(phi[i]+Pi);
                 dd4hep::RotationY ry_field(epsilon);
@@ -236,9 +361,10 @@ static dd4hep::Ref_t create_detector(dd4hep::Detector& theDetector,
 
                 dd4hep::Transform3D transform_field_wire(rz_field*ry_field,tr3D_field);
 
-                (*current_vol_ptr).placeVolume(fieldWireVolume,transform_field_wire);
+                place_wires(*current_vol_ptr, fieldWireVolume, transform_field_wire,
+                            nWire, cell_phi, ParamWire==DC_construct_wire);
             }
-        }//end of loop over cell
+        }//end of wires
         dd4hep::Transform3D transform_layer(dd4hep::Rotation3D(),
                 dd4hep::Position(0,0,0));
         dd4hep::PlacedVolume layer_phy = det_chamber_vol.placeVolume(layer_vol,transform_layer);
@@ -286,7 +412,8 @@ static dd4hep::Ref_t create_detector(dd4hep::Detector& theDetector,
     MYDEBUG("Build Detector Drift Chamber successfully.");
     auto end = std::chrono::steady_clock::now();
     std::chrono::duration<double> elapsed_seconds = end-start;
-    std::cout << "elapsed time: " << elapsed_seconds.count() << "s\n"; 
+    std::cout << "elapsed time (DC_construct_wire=" << DC_construct_wire << "): "
+              << elapsed_seconds.count() << "s\n";
     return sdet;
 
 }
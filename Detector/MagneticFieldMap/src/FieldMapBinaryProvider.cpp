@@ -0,0 +1,229 @@
+#include "FieldMapBinaryProvider.h"
+
+#include <cmath>
+#include <cstring>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <iostream>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+static const char s_magic[8] = {'C', 'E', 'P', 'C', 'B', 'M', 'A', 'P'};
+
+FieldMapBinaryProvider::FieldMapBinaryProvider(const std::string& filename)
+    : m_filename(filename), m_addr(nullptr), m_length(0),
+      Brdata(nullptr), Bzdata(nullptr),
+      nr(-1), nz(-1),
+      rBinMin(-1), zBinMin(-1),
+      rBinMax(-1), zBinMax(-1),
+      drBin(-1), dzBin(-1) {
+    init();
+}
+
+FieldMapBinaryProvider::~FieldMapBinaryProvider() {
+    if (m_addr) {
+        munmap(m_addr, m_length);
+    }
+}
+
+int FieldMapBinaryProvider::rBinIdx(double r, double& rn) {
+    double absr = std::fabs(r);
+
+    int idx = -1;
+
+    if ( rBinMin <= absr && absr < rBinMax) {
+        idx = (absr - rBinMin) / drBin;
+        double r0 = rBinMin + idx*drBin;
+        rn = (absr - r0)/drBin;
+    }
+
+    return idx;
+}
+
+int FieldMapBinaryProvider::zBinIdx(double z, double& zn) {
+    double absz = std::fabs(z);
+
+    int idx = -1;
+
+    if ( zBinMin <= absz && absz < zBinMax) {
+        idx = (absz - zBinMin) / dzBin;
+        double z0 = zBinMin + idx*dzBin;
+        zn = (absz - z0)/dzBin;
+    }
+
+    return idx;
+}
+
+void FieldMapBinaryProvider::access(int rbin, int zbin, double& Br, double& Bz) {
+    // the valid bin should between [0, n)
+    // if the point is not in the valid region, return 0
+    if ((rbin < 0 || rbin >= nr) || (zbin < 0 || zbin >= nz)) {
+        Br = 0;
+        Bz = 0;
+        return;
+    }
+
+    int globalidx = rbin + zbin*nr;
+
+    Br = Brdata[globalidx];
+    Bz = Bzdata[globalidx];
+}
+
+bool FieldMapBinaryProvider::write(const std::string& filename,
+                                   int nr_, int nz_,
+                                   double rmin, double rmax,
+                                   double zmin, double zmax,
+                                   const std::vector<double>& Br,
+                                   const std::vector<double>& Bz) {
+    size_t npoints = static_cast<size_t>(nr_) * static_cast<size_t>(nz_);
+
+    if (nr_ < 2 || nz_ < 2 || Br.size() != npoints || Bz.size() != npoints) {
+        std::string error_msg = "[ERROR] FieldMapBinaryProvider: inconsistent shape when writing '" + filename + "'";
+        throw std::runtime_error(error_msg);
+    }
+
+    FieldMapBinaryHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, s_magic, sizeof(s_magic));
+    header.version = s_version;
+    header.endian = s_endian;
+    header.nr = nr_;
+    header.nz = nz_;
+    header.rBinMin = rmin;
+    header.rBinMax = rmax;
+    header.zBinMin = zmin;
+    header.zBinMax = zmax;
+
+    FILE* fp = std::fopen(filename.c_str(), "wb");
+    if (!fp) {
+        std::string error_msg = "[ERROR] FieldMapBinaryProvider: can't open '" + filename + "' for writing";
+        throw std::runtime_error(error_msg);
+    }
+
+    bool ok = std::fwrite(&header, sizeof(header), 1, fp) == 1
+           && std::fwrite(Br.data(), sizeof(double), npoints, fp) == npoints
+           && std::fwrite(Bz.data(), sizeof(double), npoints, fp) == npoints;
+
+    if (std::fclose(fp) != 0) {
+        ok = false;
+    }
+
+    if (!ok) {
+        std::string error_msg = "[ERROR] FieldMapBinaryProvider: failed to write '" + filename + "'";
+        throw std::runtime_error(error_msg);
+    }
+
+    return true;
+}
+
+bool FieldMapBinaryProvider::grid(FieldMapGrid& g) {
+    g.nr = nr;
+    g.nz = nz;
+    g.rBinMin = rBinMin;
+    g.rBinMax = rBinMax;
+    g.zBinMin = zBinMin;
+    g.zBinMax = zBinMax;
+    g.drBin = drBin;
+    g.dzBin = dzBin;
+    g.Br = Brdata;
+    g.Bz = Bzdata;
+    g.stride = nr;
+
+    return true;
+}
+
+// ======================
+// Below are private impl
+// ======================
+
+void FieldMapBinaryProvider::init() {
+    int fd = ::open(m_filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+        std::string error_msg = "[ERROR] FieldMapBinaryProvider: can't open '" + m_filename + "'";
+        throw std::runtime_error(error_msg);
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(FieldMapBinaryHeader)) {
+        ::close(fd);
+        std::string error_msg = "[ERROR] FieldMapBinaryProvider: '" + m_filename + "' is too small";
+        throw std::runtime_error(error_msg);
+    }
+
+    m_length = st.st_size;
+
+    // the mapping stays valid after the descriptor is closed.
+    // MAP_SHARED + PROT_READ lets the page cache be shared between processes.
+    void* addr = mmap(nullptr, m_length, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+
+    if (addr == MAP_FAILED) {
+        m_length = 0;
+        std::string error_msg = "[ERROR] FieldMapBinaryProvider: mmap failed for '" + m_filename + "'";
+        throw std::runtime_error(error_msg);
+    }
+
+    m_addr = addr;
+
+    const FieldMapBinaryHeader* header = static_cast<const FieldMapBinaryHeader*>(m_addr);
+
+    std::string error_msg;
+    if (std::memcmp(header->magic, s_magic, sizeof(s_magic)) != 0) {
+        error_msg = "not a binary field map";
+    } else if (header->endian != s_endian) {
+        error_msg = "byte order mismatch";
+    } else if (header->version != s_version) {
+        error_msg = "unsupported version " + std::to_string(header->version);
+    } else if (header->nr < 2 || header->nz < 2) {
+        error_msg = "invalid shape";
+    } else {
+        size_t npoints = static_cast<size_t>(header->nr) * static_cast<size_t>(header->nz);
+        size_t expected = sizeof(FieldMapBinaryHeader) + 2 * npoints * sizeof(double);
+        if (m_length != expected) {
+            error_msg = "size mismatch (expected " + std::to_string(expected)
+                      + " bytes, got " + std::to_string(m_length) + ")";
+        }
+    }
+
+    if (error_msg.size()) {
+        munmap(m_addr, m_length);
+        m_addr = nullptr;
+        m_length = 0;
+        error_msg = "[ERROR] FieldMapBinaryProvider: '" + m_filename + "': " + error_msg;
+        throw std::runtime_error(error_msg);
+    }
+
+    nr = header->nr;
+    nz = header->nz;
+
+    rBinMin = header->rBinMin;
+    rBinMax = header->rBinMax;
+    zBinMin = header->zBinMin;
+    zBinMax = header->zBinMax;
+
+    drBin = (rBinMax-rBinMin) / (nr-1);
+    dzBin = (zBinMax-zBinMin) / (nz-1);
+
+    const double* payload = reinterpret_cast<const double*>(
+        static_cast<const char*>(m_addr) + sizeof(FieldMapBinaryHeader));
+    Brdata = payload;
+    Bzdata = payload + static_cast<size_t>(nr)*nz;
+
+    // the whole map is used by the tracking, so ask the kernel to read it ahead
+    madvise(m_addr, m_length, MADV_WILLNEED);
+
+    std::cout << "FieldMapBinaryProvider: " << m_filename << std::endl;
+    std::cout << "nr: " << nr << std::endl;
+    std::cout << "nz: " << nz << std::endl;
+    std::cout << "rBinMin: " << rBinMin << std::endl;
+    std::cout << "zBinMin: " << zBinMin << std::endl;
+    std::cout << "rBinMax: " << rBinMax << std::endl;
+    std::cout << "zBinMax: " << zBinMax << std::endl;
+    std::cout << "drBin: " << drBin << std::endl;
+    std::cout << "dzBin: " << dzBin << std::endl;
+}
@@ -0,0 +1,93 @@
+#ifndef FieldMapBinaryProvider_h
+#define FieldMapBinaryProvider_h
+
+/*
+ * FieldMapBinaryProvider reads the Br/Bz grids from a compact binary file.
+ *
+ * The file is mapped read-only with mmap, so all the processes on the same
+ * node share the same physical pages and nothing is parsed at startup.
+ *
+ * Layout of the file (native byte order, checked by the 'endian' marker):
+ *
+ *   FieldMapBinaryHeader
+ *   double Br[nz][nr]
+ *   double Bz[nz][nr]
+ *
+ * The files are created from the CSV maps with FieldMapCSV2Bin, or with
+ * FieldMapBinaryProvider::write.
+ */
+
+#include "IFieldMapProvider.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+struct FieldMapBinaryHeader {
+    char     magic[8];  // "CEPCBMAP"
+    uint32_t version;   // format version
+    uint32_t endian;    // 0x01020304 in the byte order of the writer
+    uint32_t nr;        // number of grid points along r, including endpoints
+    uint32_t nz;        // number of grid points along z, including endpoints
+    double   rBinMin;
+    double   rBinMax;
+    double   zBinMin;
+    double   zBinMax;
+};
+
+class FieldMapBinaryProvider: public IFieldMapProvider {
+
+public:
+    static const uint32_t s_version = 1;
+    static const uint32_t s_endian = 0x01020304;
+
+    FieldMapBinaryProvider(const std::string& filename);
+    virtual ~FieldMapBinaryProvider();
+
+    // Meta data about the map
+    virtual int rBinIdx(double r, double& rn);
+    virtual int zBinIdx(double z, double& zn);
+
+    // The Br and Bz
+    virtual void access(int rbin, int zbin, double& Br, double& Bz);
+
+    virtual bool grid(FieldMapGrid& g);
+
+    // Write a binary map. Br/Bz are stored row by row along r: idx = ir + iz*nr
+    static bool write(const std::string& filename,
+                      int nr, int nz,
+                      double rBinMin, double rBinMax,
+                      double zBinMin, double zBinMax,
+                      const std::vector<double>& Br,
+                      const std::vector<double>& Bz);
+
+private:
+    FieldMapBinaryProvider(const FieldMapBinaryProvider&) = delete;
+    FieldMapBinaryProvider& operator=(const FieldMapBinaryProvider&) = delete;
+
+    void init();
+
+private:
+    std::string m_filename;
+
+    void*  m_addr;   // start of the mapped region
+    size_t m_length; // size of the mapped region
+
+    const double* Brdata;
+    const double* Bzdata;
+
+    int nr;
+    int nz;
+
+    double rBinMin;
+    double zBinMin;
+
+    double rBinMax;
+    double zBinMax;
+
+    double drBin;
+    double dzBin;
+};
+
+#endif
@@ -0,0 +1,33 @@
+/*
+ * Convert the Br/Bz CSV maps into the binary format read by
+ * FieldMapBinaryProvider.
+ *
+ * Usage:
+ *   FieldMapCSV2Bin Br.csv Bz.csv output.bin
+ */
+
+#include "FieldMapFileProvider.h"
+
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+int main(int argc, char* argv[]) {
+    if (argc != 4) {
+        std::cerr << "Usage: " << argv[0] << " Br.csv Bz.csv output.bin" << std::endl;
+        return 1;
+    }
+
+    std::string url = std::string("Br=") + argv[1] + ";Bz=" + argv[2];
+
+    try {
+        FieldMapFileProvider provider(url);
+        provider.saveBinary(argv[3]);
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+
+    std::cout << "Binary field map written to " << argv[3] << std::endl;
+    return 0;
+}
@@ -0,0 +1,103 @@
+#include "FieldMapDBProvider.h"
+
+#include <map>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <stdexcept>
+
+FieldMapDBProvider::FieldMapDBProvider(const std::string& url_)
+    : FieldMapDBProvider(resolve(url_)) {
+
+}
+
+FieldMapDBProvider::FieldMapDBProvider(const Entry& entry)
+    : FieldMapBinaryProvider(entry.second), m_version(entry.first) {
+    std::cout << "FieldMapDBProvider: using version '" << m_version << "'" << std::endl;
+}
+
+FieldMapDBProvider::Entry FieldMapDBProvider::resolve(const std::string& url_) {
+    // parse the url
+    //   catalog=/path/to/catalog.txt;version=v2
+    std::map<std::string, std::string> url_parsed;
+
+    std::stringstream url_ss(url_);
+    std::string keyval;
+    while (std::getline(url_ss, keyval, ';')) {
+        if (keyval.empty()) {
+            continue;
+        }
+        size_t idx_sep = keyval.find("=");
+        if (idx_sep == std::string::npos) {
+            std::string error_msg = "[ERROR] FieldMapDBProvider: Please specify label=value. ";
+            throw std::runtime_error(error_msg);
+        }
+        std::string key = keyval.substr(0, idx_sep);
+        if (url_parsed.count(key)) {
+            std::string error_msg = "[ERROR] FieldMapDBProvider: duplicated key '" + key + "'";
+            throw std::runtime_error(error_msg);
+        }
+        url_parsed[key] = keyval.substr(idx_sep+1);
+    }
+
+    if (url_parsed.count("catalog") == 0) {
+        std::string error_msg = "[ERROR] FieldMapDBProvider: missing key 'catalog'";
+        throw std::runtime_error(error_msg);
+    }
+
+    const std::string& catalog = url_parsed["catalog"];
+    std::string version = url_parsed.count("version") ? url_parsed["version"] : "";
+
+    std::ifstream input(catalog);
+    if (!input) {
+        std::string error_msg = "[ERROR] FieldMapDBProvider: can't open catalogue '" + catalog + "'";
+        throw std::runtime_error(error_msg);
+    }
+
+    // the directory of the catalogue, used for relative paths
+    std::string catalog_dir;
+    size_t idx_slash = catalog.rfind('/');
+    if (idx_slash != std::string::npos) {
+        catalog_dir = catalog.substr(0, idx_slash+1);
+    }
+
+    std::vector<Entry> entries;
+    std::string tmpline;
+    while (std::getline(input, tmpline)) {
+        std::stringstream ss(tmpline);
+        std::string ver;
+        std::string path;
+        if (!(ss >> ver) || ver[0] == '#') {
+            continue;
+        }
+        if (!(ss >> path)) {
+            std::string error_msg = "[ERROR] FieldMapDBProvider: missing path for version '" + ver + "' in '" + catalog + "'";
+            throw std::runtime_error(error_msg);
+        }
+        if (path[0] != '/') {
+            path = catalog_dir + path;
+        }
+        entries.push_back(Entry(ver, path));
+    }
+
+    if (entries.empty()) {
+        std::string error_msg = "[ERROR] FieldMapDBProvider: empty catalogue '" + catalog + "'";
+        throw std::runtime_error(error_msg);
+    }
+
+    // default: the latest one
+    if (version.empty()) {
+        return entries.back();
+    }
+
+    for (auto it = entries.rbegin(); it != entries.rend(); ++it) {
+        if (it->first == version) {
+            return *it;
+        }
+    }
+
+    std::string error_msg = "[ERROR] FieldMapDBProvider: version '" + version + "' not found in '" + catalog + "'";
+    throw std::runtime_error(error_msg);
+}
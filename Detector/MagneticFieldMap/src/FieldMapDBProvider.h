@@ -0,0 +1,40 @@
+#ifndef FieldMapDBProvider_h
+#define FieldMapDBProvider_h
+
+/*
+ * FieldMapDBProvider implements the 'db' provider with a local catalogue.
+ *
+ * The url looks like:
+ *   catalog=/path/to/catalog.txt;version=v2
+ *
+ * The catalogue is a text file. Each line is "<version> <path>" and
+ * lines starting with '#' are ignored. A relative path is relative to the
+ * directory of the catalogue. If the version is not given, the last entry
+ * is used. The selected map is a binary map, see FieldMapBinaryProvider.
+ */
+
+#include "FieldMapBinaryProvider.h"
+
+#include <string>
+#include <utility>
+
+class FieldMapDBProvider: public FieldMapBinaryProvider {
+
+public:
+    FieldMapDBProvider(const std::string& url_);
+
+    const std::string& version() const { return m_version; }
+
+private:
+    typedef std::pair<std::string, std::string> Entry; // (version, path)
+
+    FieldMapDBProvider(const Entry& entry);
+
+    // find the entry of the requested version in the catalogue
+    static Entry resolve(const std::string& url_);
+
+private:
+    std::string m_version;
+};
+
+#endif
@@ -1,4 +1,5 @@
 #include "FieldMapFileProvider.h"
+#include "FieldMapBinaryProvider.h"
 
 #include <cmath>
 #include <string>
@@ -62,7 +63,7 @@ int FieldMapFileProvider::zBinIdx(double z, double& zn) {
 void FieldMapFileProvider::access(int rbin, int zbin, double& Br, double& Bz) {
     // the valid bin should between [0, n)
     // if the point is not in the valid region, return 0
-    if ((rbin < 0 || rbin >= nr) || (zbin < 0 || zbin >= nr)) {
+    if ((rbin < 0 || rbin >= nr) || (zbin < 0 || zbin >= nz)) {
         Br = 0;
         Bz = 0;
         return;
@@ -78,6 +79,48 @@ void FieldMapFileProvider::access(int rbin, int zbin, double& Br, double& Bz) {
     Bz = Bzdata[globalidx];
 }
 
+bool FieldMapFileProvider::saveBinary(const std::string& fn) const {
+    if (Brdata.size() != Bzdata.size()) {
+        std::string error_msg = "[ERROR] FieldMapFileProvider: Br and Bz have different shapes. ";
+        throw std::runtime_error(error_msg);
+    }
+
+    // strip the left col (z) and top row (r) of the internal tables
+    std::vector<double> Br;
+    std::vector<double> Bz;
+    Br.reserve(nr*nz);
+    Bz.reserve(nr*nz);
+
+    for (int zbin = 0; zbin < nz; ++zbin) {
+        for (int rbin = 0; rbin < nr; ++rbin) {
+            int globalidx = (rbin+1) + (zbin+1)*(nr+1);
+            Br.push_back(Brdata[globalidx]);
+            Bz.push_back(Bzdata[globalidx]);
+        }
+    }
+
+    return FieldMapBinaryProvider::write(fn, nr, nz,
+                                         rBinMin, rBinMax,
+                                         zBinMin, zBinMax,
+                                         Br, Bz);
+}
+
+bool FieldMapFileProvider::grid(FieldMapGrid& g) {
+    g.nr = nr;
+    g.nz = nz;
+    g.rBinMin = rBinMin;
+    g.rBinMax = rBinMax;
+    g.zBinMin = zBinMin;
+    g.zBinMax = zBinMax;
+    g.drBin = drBin;
+    g.dzBin = dzBin;
+    g.Br = Brdata.data() + (nr+1) + 1;
+    g.Bz = Bzdata.data() + (nr+1) + 1;
+    g.stride = nr+1;
+
+    return true;
+}
+
 // ======================
 // Below are private impl
 // ======================
@@ -18,6 +18,11 @@ public:
     // The Br and Bz
     virtual void access(int rbin, int zbin, double& Br, double& Bz);
 
+    virtual bool grid(FieldMapGrid& g);
+
+    // Convert the loaded CSV map into the binary format (see FieldMapBinaryProvider)
+    bool saveBinary(const std::string& fn) const;
+
 private:
     void init();
 
@@ -2,13 +2,83 @@
 #include "GenericBFieldMapBrBz.h"
 
 #include "FieldMapFileProvider.h"
+#include "FieldMapBinaryProvider.h"
+#include "FieldMapDBProvider.h"
 
 #include <cmath>
+#include <atomic>
+#include <algorithm>
 
 #include "DD4hep/DD4hepUnits.h"
 
+namespace {
+    // The four corners of the last cell used by this thread.
+    struct CellCache {
+        unsigned int id; // the owner map, 0 if empty
+        int ir0;
+        int iz0;
+        // r0z0, r1z0, r0z1, r1z1
+        double Br[4];
+        double Bz[4];
+    };
+
+    thread_local CellCache s_cell = {0, -1, -1, {0, 0, 0, 0}, {0, 0, 0, 0}};
+
+    std::atomic<unsigned int> s_next_id(1);
+
+    // number of points handled together in the batch interface
+    const int s_chunk = 64;
+
+    // bicubic polynomial of one cell: sum a[i*4+j] * rn^i * zn^j
+    inline double bicubic(const double* a, double rn, double zn) {
+        double res = 0.0;
+        for (int i = 3; i >= 0; --i) {
+            res = res*rn + ((a[i*4+3]*zn + a[i*4+2])*zn + a[i*4+1])*zn + a[i*4];
+        }
+        return res;
+    }
+
+    // coefficients of one cell from the values and the derivatives
+    // (in units of bins) at the four corners, ordered as r0z0, r1z0, r0z1, r1z1.
+    //   A = M * F * M^T
+    // with F = | f(0,0)  f(0,1)  fz(0,0)  fz(0,1)  |
+    //          | f(1,0)  f(1,1)  fz(1,0)  fz(1,1)  |
+    //          | fr(0,0) fr(0,1) frz(0,0) frz(0,1) |
+    //          | fr(1,0) fr(1,1) frz(1,0) frz(1,1) |
+    void bicubic_coeffs(const double* f, const double* fr, const double* fz, const double* frz,
+                        double* a) {
+        static const double M[4][4] = {{ 1,  0,  0,  0},
+                                       { 0,  0,  1,  0},
+                                       {-3,  3, -2, -1},
+                                       { 2, -2,  1,  1}};
+        const double F[4][4] = {{ f[0],  f[2],  fz[0],  fz[2]},
+                                { f[1],  f[3],  fz[1],  fz[3]},
+                                {fr[0], fr[2], frz[0], frz[2]},
+                                {fr[1], fr[3], frz[1], frz[3]}};
+        double MF[4][4];
+        for (int i = 0; i < 4; ++i) {
+            for (int j = 0; j < 4; ++j) {
+                MF[i][j] = 0;
+                for (int k = 0; k < 4; ++k) {
+                    MF[i][j] += M[i][k]*F[k][j];
+                }
+            }
+        }
+        for (int i = 0; i < 4; ++i) {
+            for (int j = 0; j < 4; ++j) {
+                a[i*4+j] = 0;
+                for (int k = 0; k < 4; ++k) {
+                    a[i*4+j] += MF[i][k]*M[j][k];
+                }
+            }
+        }
+    }
+}
+
 GenericBFieldMapBrBz::GenericBFieldMapBrBz()
-    : m_provider(nullptr) {
+    : m_provider(nullptr), m_interpolation(BILINEAR),
+      m_hasGrid(false),
+      m_id(s_next_id++) {
     type = dd4hep::CartesianField::MAGNETIC;
 
 }
@@ -19,12 +89,196 @@ void GenericBFieldMapBrBz::fieldComponents(const double* pos, double* field) {
         throw std::runtime_error(error_msg); 
     }
 
+    if (!m_hasGrid) {
+        fieldComponentsProvider(pos, field);
+        return;
+    }
+
+    const FieldMapGrid& g = m_grid;
+
+    // convert pos to r/z
+    double x = pos[0] / dd4hep::m; // convert to meter
+    double y = pos[1] / dd4hep::m;
+    double z = pos[2] / dd4hep::m;
+    double r = sqrt(x*x+y*y);
+    double absz = std::fabs(z);
+
+    // not in the valid return
+    if (!(g.rBinMin <= r && r < g.rBinMax && g.zBinMin <= absz && absz < g.zBinMax)) {
+        return;
+    }
+
+    // position in units of bins.
+    // Divide as the providers do (see rBinIdx/zBinIdx), so that a point on a
+    // bin edge ends up in the same bin as with the provider interface.
+    double fr = (r - g.rBinMin) / g.drBin;
+    double fz = (absz - g.zBinMin) / g.dzBin;
+
+    CellCache& cell = s_cell;
+
+    if (cell.id != m_id
+        || !(cell.ir0 <= fr && fr < cell.ir0 + 1)
+        || !(cell.iz0 <= fz && fz < cell.iz0 + 1)) {
+        // rounding can give the index of the last grid point just below
+        // rBinMax/zBinMax, use the last cell instead.
+        int ir0 = std::min(static_cast<int>(fr), g.nr - 2);
+        int iz0 = std::min(static_cast<int>(fz), g.nz - 2);
+
+        int idx = ir0 + iz0*g.stride;
+
+        cell.id = m_id;
+        cell.ir0 = ir0;
+        cell.iz0 = iz0;
+
+        cell.Br[0] = g.Br[idx];            cell.Bz[0] = g.Bz[idx];
+        cell.Br[1] = g.Br[idx+1];          cell.Bz[1] = g.Bz[idx+1];
+        cell.Br[2] = g.Br[idx+g.stride];   cell.Bz[2] = g.Bz[idx+g.stride];
+        cell.Br[3] = g.Br[idx+g.stride+1]; cell.Bz[3] = g.Bz[idx+g.stride+1];
+    }
+
+    // normalized r/z in the bin, computed as in the providers
+    double rn = (r - (g.rBinMin + cell.ir0*g.drBin)) / g.drBin;
+    double zn = (absz - (g.zBinMin + cell.iz0*g.dzBin)) / g.dzBin;
+
+    double Br = 0.0;
+    double Bz = 0.0;
+
+    if (m_interpolation == BICUBIC) {
+        size_t c = 16*(cell.ir0 + static_cast<size_t>(cell.iz0)*(g.nr-1));
+        Br = bicubic(&m_BrCoeffs[c], rn, zn);
+        Bz = bicubic(&m_BzCoeffs[c], rn, zn);
+    } else {
+        double w00 = (1.0 - rn) * (1.0 - zn);
+        double w10 =        rn  * (1.0 - zn);
+        double w01 = (1.0 - rn) *        zn;
+        double w11 =        rn  *        zn;
+
+        Br = w00*cell.Br[0] + w10*cell.Br[1] + w01*cell.Br[2] + w11*cell.Br[3];
+        Bz = w00*cell.Bz[0] + w10*cell.Bz[1] + w01*cell.Bz[2] + w11*cell.Bz[3];
+    }
+
+    // update the global field
+    // Bx = Br*cos(phi) = Br*x/r, By = Br*sin(phi) = Br*y/r
+    if (r > 0) {
+        field[0] += Br*x/r;
+        field[1] += Br*y/r;
+    }
+    field[2] += Bz;
+}
+
+void GenericBFieldMapBrBz::fieldComponents(int npoints, const double* pos, double* field) {
+    if (!m_provider) {
+        std::string error_msg = "[ERROR] GenericBFieldMapBrBz: No provider! ";
+        throw std::runtime_error(error_msg);
+    }
+
+    if (!m_hasGrid) {
+        for (int i = 0; i < npoints; ++i) {
+            fieldComponentsProvider(pos+3*i, field+3*i);
+        }
+        return;
+    }
+
+    const FieldMapGrid& g = m_grid;
+    const double* Brgrid = g.Br;
+    const double* Bzgrid = g.Bz;
+    const int stride = g.stride;
+    const int ncellr = g.nr - 1;
+
+    const double rBinMin = g.rBinMin;
+    const double rBinMax = g.rBinMax;
+    const double zBinMin = g.zBinMin;
+    const double zBinMax = g.zBinMax;
+    const double drBin = g.drBin;
+    const double dzBin = g.dzBin;
+    const int irmax = g.nr - 2;
+    const int izmax = g.nz - 2;
+
+    // The points are handled in chunks. The first loop only does arithmetic
+    // and can be vectorized by the compiler (the mask is a double, mixing it
+    // with int would prevent it), the second one gathers the corners and
+    // interpolates. The expressions are those of the single point version, so
+    // both give the same field.
+    double x[s_chunk];
+    double y[s_chunk];
+    double r[s_chunk];
+    double rn[s_chunk];
+    double zn[s_chunk];
+    double inside[s_chunk];
+    int ir0[s_chunk];
+    int iz0[s_chunk];
+
+    for (int begin = 0; begin < npoints; begin += s_chunk) {
+        const int n = std::min(s_chunk, npoints - begin);
+        const double* p = pos + 3*begin;
+        double* f = field + 3*begin;
+
+        for (int i = 0; i < n; ++i) {
+            double xi = p[3*i]   / dd4hep::m;
+            double yi = p[3*i+1] / dd4hep::m;
+            double zi = p[3*i+2] / dd4hep::m;
+            double ri = std::sqrt(xi*xi+yi*yi);
+            double absz = std::fabs(zi);
+
+            double in = (rBinMin <= ri && ri < rBinMax && zBinMin <= absz && absz < zBinMax) ? 1.0 : 0.0;
+
+            // outside of the map the first cell is used, the point is skipped later
+            double fr = (ri - rBinMin) * in / drBin;
+            double fz = (absz - zBinMin) * in / dzBin;
+            int ir = static_cast<int>(fr);
+            int iz = static_cast<int>(fz);
+            ir = ir < irmax ? ir : irmax;
+            iz = iz < izmax ? iz : izmax;
+
+            x[i] = xi;
+            y[i] = yi;
+            r[i] = ri;
+            rn[i] = (ri - (rBinMin + ir*drBin)) / drBin;
+            zn[i] = (absz - (zBinMin + iz*dzBin)) / dzBin;
+            inside[i] = in;
+            ir0[i] = ir;
+            iz0[i] = iz;
+        }
+
+        for (int i = 0; i < n; ++i) {
+            if (inside[i] == 0.0) {
+                continue;
+            }
+
+            double Br = 0.0;
+            double Bz = 0.0;
+
+            if (m_interpolation == BICUBIC) {
+                size_t c = 16*(ir0[i] + static_cast<size_t>(iz0[i])*ncellr);
+                Br = bicubic(&m_BrCoeffs[c], rn[i], zn[i]);
+                Bz = bicubic(&m_BzCoeffs[c], rn[i], zn[i]);
+            } else {
+                const int idx = ir0[i] + iz0[i]*stride;
+
+                double w00 = (1.0 - rn[i]) * (1.0 - zn[i]);
+                double w10 =        rn[i]  * (1.0 - zn[i]);
+                double w01 = (1.0 - rn[i]) *        zn[i];
+                double w11 =        rn[i]  *        zn[i];
+
+                Br = w00*Brgrid[idx] + w10*Brgrid[idx+1] + w01*Brgrid[idx+stride] + w11*Brgrid[idx+stride+1];
+                Bz = w00*Bzgrid[idx] + w10*Bzgrid[idx+1] + w01*Bzgrid[idx+stride] + w11*Bzgrid[idx+stride+1];
+            }
+
+            if (r[i] > 0) {
+                f[3*i]   += Br*x[i]/r[i];
+                f[3*i+1] += Br*y[i]/r[i];
+            }
+            f[3*i+2] += Bz;
+        }
+    }
+}
+
+void GenericBFieldMapBrBz::fieldComponentsProvider(const double* pos, double* field) {
     // convert pos to r/z
     double x = pos[0] / dd4hep::m; // convert to meter
     double y = pos[1] / dd4hep::m;
     double z = pos[2] / dd4hep::m;
     double r = sqrt(x*x+y*y);
-    double phi = atan2(y, x);
 
     // std::cout << " r: " << r
     //           << " x: " << x
@@ -98,8 +352,11 @@ void GenericBFieldMapBrBz::fieldComponents(const double* pos, double* field) {
               +        rn  *        zn  * Bz_r1z1;
 
     // update the global field
-    field[0] += Br*cos(phi);
-    field[1] += Br*sin(phi);
+    // Bx = Br*cos(phi) = Br*x/r, By = Br*sin(phi) = Br*y/r
+    if (r > 0) {
+        field[0] += Br*x/r;
+        field[1] += Br*y/r;
+    }
     field[2] += Bz;
 
     return;
@@ -109,10 +366,84 @@ void GenericBFieldMapBrBz::init_provider(const std::string& provider, const std:
     if (provider == "file") {
         std::cout << "Initialize provider with file. " << std::endl;
         m_provider = new FieldMapFileProvider(url);
+    } else if (provider == "binary") {
+        std::cout << "Initialize provider with binary file. " << std::endl;
+        m_provider = new FieldMapBinaryProvider(url);
     } else if (provider == "db") {
-        std::cout << "Initialize provider with file. " << std::endl;
+        std::cout << "Initialize provider with db. " << std::endl;
+        m_provider = new FieldMapDBProvider(url);
     } else {
         std::string error_msg = "[ERROR] GenericBFieldMapBrBz: Unknown provider: " + provider;
         throw std::runtime_error(error_msg); 
     }
+
+    // use the grid directly if the provider exposes it
+    m_hasGrid = m_provider->grid(m_grid)
+             && m_grid.nr >= 2 && m_grid.nz >= 2
+             && m_grid.drBin > 0 && m_grid.dzBin > 0;
+}
+
+void GenericBFieldMapBrBz::set_interpolation(const std::string& mode) {
+    if (mode == "bilinear") {
+        m_interpolation = BILINEAR;
+        m_BrCoeffs.clear();
+        m_BzCoeffs.clear();
+    } else if (mode == "bicubic") {
+        if (!m_hasGrid) {
+            std::string error_msg = "[ERROR] GenericBFieldMapBrBz: bicubic interpolation needs a provider with the whole grid. ";
+            throw std::runtime_error(error_msg);
+        }
+        init_bicubic();
+        m_interpolation = BICUBIC;
+    } else {
+        std::string error_msg = "[ERROR] GenericBFieldMapBrBz: Unknown interpolation: " + mode;
+        throw std::runtime_error(error_msg);
+    }
+}
+
+void GenericBFieldMapBrBz::init_bicubic() {
+    const FieldMapGrid& g = m_grid;
+    const int nr = g.nr;
+    const int nz = g.nz;
+
+    std::cout << "Precompute the bicubic coefficients for "
+              << (nr-1) << "x" << (nz-1) << " cells. " << std::endl;
+
+    // value and derivatives (in units of bins) at the grid points.
+    // central differences inside, one-sided differences at the borders.
+    auto deriv = [&](const double* data, int ir, int iz,
+                     double& f, double& fr, double& fz, double& frz) {
+        auto at = [&](int i, int j) { return data[i + j*g.stride]; };
+
+        int irm = std::max(ir-1, 0);    int irp = std::min(ir+1, nr-1);
+        int izm = std::max(iz-1, 0);    int izp = std::min(iz+1, nz-1);
+
+        f   = at(ir, iz);
+        fr  = (at(irp, iz) - at(irm, iz)) / (irp-irm);
+        fz  = (at(ir, izp) - at(ir, izm)) / (izp-izm);
+        frz = (at(irp, izp) - at(irp, izm) - at(irm, izp) + at(irm, izm))
+            / ((irp-irm)*(izp-izm));
+    };
+
+    m_BrCoeffs.assign(16*static_cast<size_t>(nr-1)*(nz-1), 0.0);
+    m_BzCoeffs.assign(16*static_cast<size_t>(nr-1)*(nz-1), 0.0);
+
+    for (int iz = 0; iz < nz-1; ++iz) {
+        for (int ir = 0; ir < nr-1; ++ir) {
+            size_t c = 16*(ir + static_cast<size_t>(iz)*(nr-1));
+
+            const double* datas[2] = {g.Br, g.Bz};
+            double* coeffs[2] = {&m_BrCoeffs[c], &m_BzCoeffs[c]};
+
+            for (int k = 0; k < 2; ++k) {
+                double f[4], fr[4], fz[4], frz[4];
+                // r0z0, r1z0, r0z1, r1z1
+                for (int corner = 0; corner < 4; ++corner) {
+                    deriv(datas[k], ir + (corner&1), iz + (corner>>1),
+                          f[corner], fr[corner], fz[corner], frz[corner]);
+                }
+                bicubic_coeffs(f, fr, fz, frz, coeffs[k]);
+            }
+        }
+    }
 }
@@ -7,6 +7,22 @@
  * - It also enables the calculation of Br/Bz at position X. 
  * - It will get the map from an abstract class IFieldMapProvider.
  *
+ * If the provider exposes its grid (see FieldMapGrid), the field is
+ * interpolated directly from the grid. The four corners of the last cell are
+ * cached per thread, so consecutive queries in the same cell (e.g. the
+ * steps of one track) only compute the interpolation weights.
+ *
+ * Two interpolation modes are supported on the grid:
+ * - bilinear (default)
+ * - bicubic, with the 16 coefficients of each cell precomputed from the
+ *   values and the finite-difference derivatives at the grid points. It gives
+ *   a smooth field, so a coarser grid reaches the same accuracy.
+ *
+ * The batch fieldComponents(npoints, pos, field) handles the points in
+ * chunks: the bin positions and weights are computed in a loop without
+ * branches or memory gathers that the compiler can vectorize, then the
+ * corners are gathered. It gives the same field as the single point version.
+ *
  * -- Tao Lin <lintao AT ihep.ac.cn>
  */
 
@@ -14,6 +30,9 @@
 
 #include "IFieldMapProvider.h"
 
+#include <string>
+#include <vector>
+
 
 class GenericBFieldMapBrBz: public dd4hep::CartesianField::Object {
 public:
@@ -22,14 +41,43 @@ public:
 
     virtual void fieldComponents(const double* pos, double* field);
 
+    // Batch interface:
+    // pos and field are arrays of npoints (x,y,z) triplets.
+    // As in the single point version, the field is added to 'field'.
+    void fieldComponents(int npoints, const double* pos, double* field);
+
 public:
     // following are interfaces to configure this field map
     void init_provider(const std::string& provider, const std::string& url);
+    // [bilinear, bicubic]. Must be called after init_provider.
+    void set_interpolation(const std::string& mode);
+
+private:
+    // the single point interpolation through the virtual interface of provider
+    void fieldComponentsProvider(const double* pos, double* field);
+
+    void init_bicubic();
 
 private:
 
     IFieldMapProvider* m_provider;
+
+    enum Interpolation {
+        BILINEAR,
+        BICUBIC
+    };
+    Interpolation m_interpolation;
+
+    // 16 coefficients per cell, cell index = ir + iz*(nr-1)
+    std::vector<double> m_BrCoeffs;
+    std::vector<double> m_BzCoeffs;
+
+    // the grid of the provider, valid if m_hasGrid.
+    bool m_hasGrid;
+    FieldMapGrid m_grid;
+
+    // identify this map in the thread local cell cache
+    unsigned int m_id;
 };
 
 #endif
-
@@ -3,12 +3,18 @@
  * 
  * The properties for the GenericBFieldMapBrBz
  * - provider (attribute)
- *   - [file, db]
+ *   - [file, binary, db]
  * - source (tag)
  *   - the attributes include: 
  *     - url
  *       - file path for the 'file' mode.
- *       - DB instance ... for the 'db' mode.
+ *         Br=/path/to/Br.csv;Bz=/path/to/Bz.csv
+ *       - file path for the 'binary' mode (see FieldMapCSV2Bin).
+ *         /path/to/map.bin
+ *       - catalogue and version for the 'db' mode.
+ *         catalog=/path/to/catalog.txt;version=v1
+ * - interpolation (attribute, optional)
+ *   - [bilinear, bicubic], bilinear by default
  * - rhoMin, rhoMax, zMin, zMax
  * 
  * -- Tao Lin <lintao AT ihep.ac.cn>
@@ -70,6 +76,12 @@ static dd4hep::Ref_t create_GenericBFieldMapBrBz(dd4hep::Detector& ,
 
     ptr->init_provider(provider, url);
 
+    // - interpolation
+    if (xmlParameter.hasAttr(_Unicode(interpolation))) {
+        std::string interpolation = xmlParameter.attr<std::string>(_Unicode(interpolation));
+        ptr->set_interpolation(interpolation);
+    }
+
     obj.assign(ptr, xmlParameter.nameStr(), xmlParameter.typeStr());
 
     return obj;
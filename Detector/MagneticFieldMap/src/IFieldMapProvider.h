@@ -7,11 +7,35 @@
  * will use this bin index to get the values at (r0,z0), (r1,z0), (r0,z1), (r1,z1).
  * The interpolation is not computated IFieldMapProvider. Please see GenericBFieldMapBrBz. 
  *
+ * A provider keeping the whole map in memory can also expose it as a FieldMapGrid.
+ * Then GenericBFieldMapBrBz reads the grid directly instead of calling the
+ * virtual methods for each point.
+ *
  * -- Tao Lin <lintao AT ihep.ac.cn>
  */
 
+struct FieldMapGrid {
+    int nr; // number of grid points, including the two endpoints
+    int nz;
+
+    double rBinMin;
+    double rBinMax;
+    double zBinMin;
+    double zBinMax;
+
+    double drBin;
+    double dzBin;
+
+    // value at (rbin, zbin) is Br[rbin + zbin*stride]
+    const double* Br;
+    const double* Bz;
+    int stride;
+};
+
 class IFieldMapProvider {
 public:
+    virtual ~IFieldMapProvider() {}
+
     // Meta data about the map
     // return rn/zn is the normalized value in the bin. the value is [0,1]
     virtual int rBinIdx(double r, double& rn) = 0;
@@ -20,6 +44,9 @@ public:
     // The Br and Bz
     virtual void access(int rbin, int zbin, double& Br, double& Bz) = 0;
 
+    // The whole grid. Return false if the provider can't expose it.
+    virtual bool grid(FieldMapGrid& /*g*/) { return false; }
+
 };
 
 #endif
@@ -0,0 +1,142 @@
+/*
+ * Microbenchmark of GenericBFieldMapBrBz::fieldComponents against the
+ * previous implementation (FieldMapTest::referenceField: virtual provider
+ * calls and atan2/cos/sin for each point).
+ *
+ * The single point interface and the batch interface (fieldComponents(npoints,
+ * pos, field), all points in one call) are timed for the bilinear and the
+ * bicubic interpolation.
+ *
+ * Two access patterns are timed:
+ * - track: consecutive points a few mm apart, as the steps of a track,
+ * - random: independent points all over the map.
+ *
+ * Usage:
+ *   BenchFieldMapBrBz [npoints]
+ */
+
+#include "GenericBFieldMapBrBz.h"
+#include "FieldMapBinaryProvider.h"
+#include "FieldMapTestUtils.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+    template<typename F>
+    double time_per_point(F eval, const std::vector<double>& pos, double& checksum) {
+        const int npoints = pos.size()/3;
+        double field[3] = {0, 0, 0};
+
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < npoints; ++i) {
+            eval(&pos[3*i], field);
+        }
+        auto stop = std::chrono::steady_clock::now();
+
+        checksum = field[0] + field[1] + field[2];
+        return std::chrono::duration<double, std::nano>(stop - start).count() / npoints;
+    }
+
+    double time_per_point_batch(GenericBFieldMapBrBz& map, const std::vector<double>& pos,
+                                std::vector<double>& field, double& checksum) {
+        const int npoints = pos.size()/3;
+        field.assign(pos.size(), 0.);
+
+        auto start = std::chrono::steady_clock::now();
+        map.fieldComponents(npoints, pos.data(), field.data());
+        auto stop = std::chrono::steady_clock::now();
+
+        checksum = 0;
+        for (double f: field) {
+            checksum += f;
+        }
+        return std::chrono::duration<double, std::nano>(stop - start).count() / npoints;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    const int npoints = argc > 1 ? std::atoi(argv[1]) : 2000000;
+    const std::string filename = "BenchFieldMapBrBz.bin";
+
+    // a map with the size of the CEPC maps, 1 cm bins
+    FieldMapTest::Solenoid solenoid;
+    FieldMapTest::writeSolenoidMap(filename, solenoid, 401, 701, 4.0, 7.0);
+
+    FieldMapBinaryProvider provider(filename);
+    GenericBFieldMapBrBz bilinear;
+    bilinear.init_provider("binary", filename);
+    GenericBFieldMapBrBz bicubic;
+    bicubic.init_provider("binary", filename);
+    bicubic.set_interpolation("bicubic");
+
+    std::mt19937 gen(4711);
+    std::uniform_real_distribution<double> uni(-1., 1.);
+
+    // track: helix-like steps of ~5 mm
+    std::vector<double> track(3*static_cast<size_t>(npoints));
+    // random: uniform in the map
+    std::vector<double> random(3*static_cast<size_t>(npoints));
+
+    double phi = 0, r = 0, z = 0, dphi = 0, dz = 0;
+    for (int i = 0; i < npoints; ++i) {
+        if (i % 2000 == 0) {
+            phi = M_PI*uni(gen);
+            r = 0;
+            z = 0;
+            dphi = 0.0005*uni(gen);
+            dz = 0.003*uni(gen);
+        }
+        r += 0.004;
+        if (r > 3.9) r = 0;
+        phi += dphi;
+        z += dz;
+        track[3*i]   = r*std::cos(phi)*dd4hep::m;
+        track[3*i+1] = r*std::sin(phi)*dd4hep::m;
+        track[3*i+2] = z*dd4hep::m;
+
+        random[3*i]   = 2.8*uni(gen)*dd4hep::m;
+        random[3*i+1] = 2.8*uni(gen)*dd4hep::m;
+        random[3*i+2] = 6.9*uni(gen)*dd4hep::m;
+    }
+
+    auto reference = [&](const double* pos, double* field) { FieldMapTest::referenceField(provider, pos, field); };
+    auto grid      = [&](const double* pos, double* field) { bilinear.fieldComponents(pos, field); };
+    auto cubic     = [&](const double* pos, double* field) { bicubic.fieldComponents(pos, field); };
+
+    std::printf("%-10s %12s %12s %12s %12s %12s   [ns/point]\n", "pattern", "reference",
+                "bilinear", "bil. batch", "bicubic", "bic. batch");
+
+    const std::vector<double>* patterns[2] = {&track, &random};
+    const char* names[2] = {"track", "random"};
+    std::vector<double> field;
+    for (int k = 0; k < 2; ++k) {
+        double c0 = 0, c1 = 0, c2 = 0, c3 = 0, c4 = 0;
+        double t0 = time_per_point(reference, *patterns[k], c0);
+        double t1 = time_per_point(grid, *patterns[k], c1);
+        double t2 = time_per_point_batch(bilinear, *patterns[k], field, c2);
+        double t3 = time_per_point(cubic, *patterns[k], c3);
+        double t4 = time_per_point_batch(bicubic, *patterns[k], field, c4);
+        std::printf("%-10s %12.2f %12.2f %12.2f %12.2f %12.2f\n", names[k], t0, t1, t2, t3, t4);
+
+        // the summed bilinear fields must agree with the reference, and the
+        // batch fields with the single point ones
+        if (std::fabs(c0 - c1) > 1e-9*std::fabs(c0)
+            || std::fabs(c1 - c2) > 1e-9*std::fabs(c1)
+            || std::fabs(c3 - c4) > 1e-9*std::fabs(c3)) {
+            std::cout << "ERROR: checksums differ: reference " << c0 << ", bilinear " << c1 << "/" << c2
+                      << ", bicubic " << c3 << "/" << c4 << std::endl;
+            std::remove(filename.c_str());
+            return 1;
+        }
+    }
+
+    std::remove(filename.c_str());
+    return 0;
+}
@@ -0,0 +1,111 @@
+#ifndef FieldMapTestUtils_h
+#define FieldMapTestUtils_h
+
+/*
+ * Helpers shared by the tests and the benchmark of the field map:
+ * - an analytic solenoid field,
+ * - writing it as a binary map (see FieldMapBinaryProvider),
+ * - the reference interpolation through the provider interface, as
+ *   GenericBFieldMapBrBz::fieldComponents did before reading the grid directly.
+ */
+
+#include "IFieldMapProvider.h"
+#include "FieldMapBinaryProvider.h"
+
+#include <cmath>
+#include <string>
+#include <vector>
+
+#include "DD4hep/DD4hepUnits.h"
+
+namespace FieldMapTest {
+
+    // Field of a finite solenoid (central field B0 [T], half length L [m],
+    // radius a [m]), expanded around the axis up to r^3:
+    //   Bz(r,z) = Bz0(z) - r^2/4 Bz0''(z)
+    //   Br(r,z) = -r/2 Bz0'(z) + r^3/16 Bz0'''(z)
+    // with the on-axis field Bz0(z) = B0/2 (u(z+L) - u(z-L)), u(s) = s/sqrt(s^2+a^2).
+    struct Solenoid {
+        double B0 = 3.0;
+        double L  = 3.5;
+        double a  = 3.2;
+
+        void field(double r, double z, double& Br, double& Bz) const {
+            double d[4] = {0, 0, 0, 0};
+            derivs(z+L, d, +1);
+            derivs(z-L, d, -1);
+            Bz = d[0] - r*r/4*d[2];
+            Br = -r/2*d[1] + r*r*r/16*d[3];
+        }
+
+    private:
+        // add sign * B0/2 * (u, u', u'', u''') at s
+        void derivs(double s, double* d, int sign) const {
+            double a2 = a*a;
+            double q = s*s + a2;
+            double sq = std::sqrt(q);
+            double c = sign * B0/2;
+            d[0] += c * s/sq;
+            d[1] += c * a2/(q*sq);
+            d[2] += c * (-3*a2*s)/(q*q*sq);
+            d[3] += c * (-3*a2*(a2-4*s*s))/(q*q*q*sq);
+        }
+    };
+
+    // Sample the solenoid on a nr x nz grid over [0,rmax] x [0,zmax] (in m)
+    // and write it as a binary map.
+    inline void writeSolenoidMap(const std::string& filename, const Solenoid& sol,
+                                 int nr, int nz, double rmax, double zmax) {
+        std::vector<double> Br(static_cast<size_t>(nr)*nz);
+        std::vector<double> Bz(static_cast<size_t>(nr)*nz);
+        for (int iz = 0; iz < nz; ++iz) {
+            for (int ir = 0; ir < nr; ++ir) {
+                double r = rmax*ir/(nr-1);
+                double z = zmax*iz/(nz-1);
+                sol.field(r, z, Br[ir+iz*nr], Bz[ir+iz*nr]);
+            }
+        }
+        FieldMapBinaryProvider::write(filename, nr, nz, 0., rmax, 0., zmax, Br, Bz);
+    }
+
+    // Bilinear interpolation through the virtual provider interface, with
+    // phi from atan2 (the implementation before the direct grid access).
+    inline void referenceField(IFieldMapProvider& provider, const double* pos, double* field) {
+        double x = pos[0] / dd4hep::m;
+        double y = pos[1] / dd4hep::m;
+        double z = pos[2] / dd4hep::m;
+        double r = sqrt(x*x+y*y);
+        double phi = atan2(y, x);
+
+        double rn = 0.0;
+        double zn = 0.0;
+        int ir0 = provider.rBinIdx(r, rn);
+        int iz0 = provider.zBinIdx(z, zn);
+        if (ir0 < 0 || iz0 < 0) {
+            return;
+        }
+
+        double Br[4] = {0, 0, 0, 0};
+        double Bz[4] = {0, 0, 0, 0};
+        provider.access(ir0,   iz0,   Br[0], Bz[0]);
+        provider.access(ir0+1, iz0,   Br[1], Bz[1]);
+        provider.access(ir0,   iz0+1, Br[2], Bz[2]);
+        provider.access(ir0+1, iz0+1, Br[3], Bz[3]);
+
+        double BrI = (1.0 - rn) * (1.0 - zn) * Br[0]
+                   +        rn  * (1.0 - zn) * Br[1]
+                   + (1.0 - rn) *        zn  * Br[2]
+                   +        rn  *        zn  * Br[3];
+        double BzI = (1.0 - rn) * (1.0 - zn) * Bz[0]
+                   +        rn  * (1.0 - zn) * Bz[1]
+                   + (1.0 - rn) *        zn  * Bz[2]
+                   +        rn  *        zn  * Bz[3];
+
+        field[0] += BrI*cos(phi);
+        field[1] += BrI*sin(phi);
+        field[2] += BzI;
+    }
+
+}
+
+#endif
@@ -0,0 +1,155 @@
+/*
+ * Check that GenericBFieldMapBrBz, reading the grid directly with its cell
+ * cache, gives the same field as the interpolation through the provider
+ * interface (FieldMapTest::referenceField). In particular points exactly on
+ * the bin edges must end up in the same bin.
+ *
+ * The batch interface must give the same field as the single point version,
+ * for the bilinear and the bicubic interpolation.
+ */
+
+#include "GenericBFieldMapBrBz.h"
+#include "FieldMapBinaryProvider.h"
+#include "FieldMapTestUtils.h"
+
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+#include <random>
+#include <vector>
+
+namespace {
+    int s_nfailed = 0;
+
+    void compare(GenericBFieldMapBrBz& field, IFieldMapProvider& provider,
+                 double x, double y, double z, double tol, std::vector<double>* points = nullptr) {
+        double pos[3] = {x*dd4hep::m, y*dd4hep::m, z*dd4hep::m};
+        if (points) {
+            points->insert(points->end(), pos, pos+3);
+        }
+        double f[3] = {0, 0, 0};
+        double ref[3] = {0, 0, 0};
+
+        field.fieldComponents(pos, f);
+        FieldMapTest::referenceField(provider, pos, ref);
+
+        // Bz doesn't depend on phi and must be identical
+        bool ok = f[2] == ref[2]
+               && std::fabs(f[0]-ref[0]) <= tol
+               && std::fabs(f[1]-ref[1]) <= tol;
+        if (!ok) {
+            ++s_nfailed;
+            if (s_nfailed <= 10) {
+                std::printf("MISMATCH at (%.17g, %.17g, %.17g): (%.17g, %.17g, %.17g) vs (%.17g, %.17g, %.17g)\n",
+                            x, y, z, f[0], f[1], f[2], ref[0], ref[1], ref[2]);
+            }
+        }
+    }
+
+    // the batch interface against the single point version on the same points
+    void compareBatch(GenericBFieldMapBrBz& field, const std::vector<double>& points,
+                      const char* mode) {
+        const int npoints = points.size()/3;
+        std::vector<double> batch(points.size(), 0.);
+        std::vector<double> single(points.size(), 0.);
+
+        field.fieldComponents(npoints, points.data(), batch.data());
+        for (int i = 0; i < npoints; ++i) {
+            field.fieldComponents(&points[3*i], &single[3*i]);
+        }
+
+        for (size_t i = 0; i < points.size(); ++i) {
+            if (std::fabs(batch[i] - single[i]) > 1e-14) {
+                ++s_nfailed;
+                if (s_nfailed <= 10) {
+                    std::printf("BATCH MISMATCH (%s) at point %zu, component %zu: %.17g vs %.17g\n",
+                                mode, i/3, i%3, batch[i], single[i]);
+                }
+            }
+        }
+    }
+}
+
+int main() {
+    const std::string filename = "TestFieldMapBinEdges.bin";
+
+    // bin widths that are not exactly representable
+    const int nr = 20;
+    const int nz = 34;
+    const double rmax = 1.9;
+    const double zmax = 3.3;
+
+    FieldMapTest::Solenoid solenoid;
+    FieldMapTest::writeSolenoidMap(filename, solenoid, nr, nz, rmax, zmax);
+
+    GenericBFieldMapBrBz field;
+    field.init_provider("binary", filename);
+
+    FieldMapBinaryProvider provider(filename);
+
+    const double dr = rmax/(nr-1);
+    const double dz = zmax/(nz-1);
+
+    // 1. points on the bin edges and their neighbours, on the x axis so that
+    //    r = |x| exactly. The last edge (rmax, zmax) is outside the map.
+    int npoints = 0;
+    std::vector<double> points;
+    for (int iz = 0; iz < nz-1; ++iz) {
+        for (int ir = 0; ir < nr-1; ++ir) {
+            double redges[3] = {ir*dr, std::nextafter(ir*dr, 0.), std::nextafter(ir*dr, rmax)};
+            double zedges[3] = {iz*dz, std::nextafter(iz*dz, 0.), std::nextafter(iz*dz, zmax)};
+            for (double r: redges) {
+                for (double z: zedges) {
+                    compare(field, provider, r, 0., z, 1e-14, &points);
+                    compare(field, provider, -r, 0., -z, 1e-14, &points);
+                    npoints += 2;
+                }
+            }
+        }
+    }
+
+    // 2. random points, also outside of the map, in a sequence of small steps
+    //    (cell cache hits) and of jumps (cache misses).
+    std::mt19937 gen(12345);
+    std::uniform_real_distribution<double> uni(-1., 1.);
+    double x = 0, y = 0, z = 0;
+    for (int i = 0; i < 200000; ++i) {
+        bool jump = i % 50 == 0;
+        double step = jump ? 2.2 : 0.01;
+        x = jump ? step*uni(gen) : x + step*uni(gen);
+        y = jump ? step*uni(gen) : y + step*uni(gen);
+        z = jump ? 2*step*uni(gen) : z + step*uni(gen);
+        compare(field, provider, x, y, z, 1e-12, &points);
+        ++npoints;
+    }
+
+    // 3. two maps used alternately by the same thread must not share the cache
+    GenericBFieldMapBrBz field2;
+    field2.init_provider("binary", filename);
+    for (int i = 0; i < 1000; ++i) {
+        double xi = 1.5*uni(gen), yi = 1.5*uni(gen), zi = 3*uni(gen);
+        compare(field, provider, xi, yi, zi, 1e-12);
+        compare(field2, provider, xi, yi, zi, 1e-12);
+        npoints += 2;
+    }
+
+    // 4. the batch interface on all points of 1. and 2., and on the axis (r = 0).
+    //    The number of points is not a multiple of the chunk size.
+    for (int i = 0; i < 7; ++i) {
+        double p[3] = {0., 0., (i-3)*0.7*dd4hep::m};
+        points.insert(points.end(), p, p+3);
+    }
+    compareBatch(field, points, "bilinear");
+
+    GenericBFieldMapBrBz cubic;
+    cubic.init_provider("binary", filename);
+    cubic.set_interpolation("bicubic");
+    compareBatch(cubic, points, "bicubic");
+
+    std::remove(filename.c_str());
+
+    std::cout << "TestFieldMapBinEdges: " << npoints << " points, "
+              << s_nfailed << " mismatches" << std::endl;
+
+    return s_nfailed == 0 ? 0 : 1;
+}
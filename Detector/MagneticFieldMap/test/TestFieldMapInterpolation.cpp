@@ -0,0 +1,124 @@
+/*
+ * Compare the bilinear and the bicubic interpolation of GenericBFieldMapBrBz
+ * against an analytic solenoid field (FieldMapTest::Solenoid).
+ *
+ * The map is sampled with a coarse and a fine grid (half the bin size). The
+ * bicubic interpolation on the coarse grid must be more accurate than the
+ * bilinear one on the fine grid, and both must be below fixed limits.
+ */
+
+#include "GenericBFieldMapBrBz.h"
+#include "FieldMapTestUtils.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+#include <random>
+#include <string>
+
+namespace {
+    struct Errors {
+        double maxBr = 0;
+        double maxBz = 0;
+        double rmsB = 0;
+    };
+
+    // the map covers r < rmax, |z| < zmax [m]
+    Errors errors(GenericBFieldMapBrBz& field, const FieldMapTest::Solenoid& solenoid,
+                  double rmax, double zmax) {
+        Errors err;
+        std::mt19937 gen(2024);
+        std::uniform_real_distribution<double> uni(0., 1.);
+
+        const int npoints = 100000;
+        for (int i = 0; i < npoints; ++i) {
+            double r = rmax*uni(gen);
+            double phi = 2*M_PI*uni(gen);
+            double z = zmax*(2*uni(gen)-1);
+
+            double pos[3] = {r*std::cos(phi)*dd4hep::m, r*std::sin(phi)*dd4hep::m, z*dd4hep::m};
+            double f[3] = {0, 0, 0};
+            field.fieldComponents(pos, f);
+
+            double Br = 0, Bz = 0;
+            solenoid.field(r, std::fabs(z), Br, Bz);
+
+            // Br of the map is symmetric in z (the map only knows |z|), so
+            // compare with the field at |z|.
+            double dBx = f[0] - Br*std::cos(phi);
+            double dBy = f[1] - Br*std::sin(phi);
+            double dBz = f[2] - Bz;
+
+            err.maxBr = std::max(err.maxBr, std::sqrt(dBx*dBx+dBy*dBy));
+            err.maxBz = std::max(err.maxBz, std::fabs(dBz));
+            err.rmsB += dBx*dBx + dBy*dBy + dBz*dBz;
+        }
+        err.rmsB = std::sqrt(err.rmsB/npoints);
+        return err;
+    }
+}
+
+int main() {
+    const double rmax = 4.0;
+    const double zmax = 7.0;
+
+    FieldMapTest::Solenoid solenoid;
+
+    // 20 cm and 10 cm bins
+    const int ncoarse[2] = {21, 36};
+    const int nfine[2] = {41, 71};
+
+    Errors res[2][2]; // [grid][mode]
+    const char* grids[2] = {"coarse", "fine"};
+    const char* modes[2] = {"bilinear", "bicubic"};
+
+    for (int g = 0; g < 2; ++g) {
+        const int* n = g == 0 ? ncoarse : nfine;
+        std::string filename = std::string("TestFieldMapInterpolation_") + grids[g] + ".bin";
+        FieldMapTest::writeSolenoidMap(filename, solenoid, n[0], n[1], rmax, zmax);
+
+        for (int m = 0; m < 2; ++m) {
+            GenericBFieldMapBrBz field;
+            field.init_provider("binary", filename);
+            field.set_interpolation(modes[m]);
+
+            // the last bins are not valid (r < rmax, |z| < zmax)
+            res[g][m] = errors(field, solenoid, rmax*0.999, zmax*0.999);
+
+            std::printf("%-6s grid %-8s: max |dBr| = %.3g T, max |dBz| = %.3g T, rms |dB| = %.3g T\n",
+                        grids[g], modes[m], res[g][m].maxBr, res[g][m].maxBz, res[g][m].rmsB);
+        }
+
+        std::remove(filename.c_str());
+    }
+
+    bool ok = true;
+
+    // the bicubic interpolation on the coarse grid beats the bilinear one on the fine grid
+    if (!(res[0][1].rmsB < res[1][0].rmsB && res[0][1].maxBz < res[1][0].maxBz)) {
+        std::cout << "ERROR: bicubic (coarse) is not more accurate than bilinear (fine)" << std::endl;
+        ok = false;
+    }
+
+    // refining the grid improves the bicubic interpolation more than the bilinear one
+    if (!(res[0][1].rmsB/res[1][1].rmsB > res[0][0].rmsB/res[1][0].rmsB)) {
+        std::cout << "ERROR: bicubic does not converge faster than bilinear" << std::endl;
+        ok = false;
+    }
+
+    // absolute limits on the rms for the 3 T solenoid [T], about twice the
+    // values at the time of writing ({8.2e-4, 7.5e-5}, {2.1e-4, 1.3e-5})
+    const double limits[2][2] = {{1.6e-3, 1.5e-4}, {4.0e-4, 3.0e-5}};
+    for (int g = 0; g < 2; ++g) {
+        for (int m = 0; m < 2; ++m) {
+            if (!(res[g][m].rmsB < limits[g][m])) {
+                std::cout << "ERROR: " << grids[g] << " grid " << modes[m] << ": rms " << res[g][m].rmsB
+                          << " T above the limit of " << limits[g][m] << " T" << std::endl;
+                ok = false;
+            }
+        }
+    }
+
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,121 @@
+#!/usr/bin/env python
+#
+# Benchmark of the wire modes of the DriftChamber geometry (DC_construct_wire):
+# the construction time is printed by the driver ("elapsed time"), the step
+# rate by StepRateAnaElemTool at the end of the job.
+#
+# The mode and the number of events are set with envvars:
+#   DC_CONSTRUCT_WIRE=2 EVTMAX=100 ./run.sh Examples/options/bench_detsim_DC_wiremodes.py
+# or for all the modes:
+#   Detector/DetDriftChamber/scripts/bench-wire-modes.sh
+
+import os
+import re
+import sys
+
+from Gaudi.Configuration import *
+
+wire_mode = int(os.environ.get("DC_CONSTRUCT_WIRE", 1))
+evtmax = int(os.environ.get("EVTMAX", 100))
+
+##############################################################################
+# Random Number Svc
+##############################################################################
+from Configurables import RndmGenSvc, HepRndm__Engine_CLHEP__RanluxEngine_
+
+seed = [42]
+
+rndmengine = HepRndm__Engine_CLHEP__HepJamesRandom_("RndmGenSvc.Engine") # The default engine in Geant4
+rndmengine.SetSingleton = True
+rndmengine.Seeds = seed
+
+rndmgensvc = RndmGenSvc("RndmGenSvc")
+rndmgensvc.Engine = rndmengine.name()
+
+##############################################################################
+# Event Data Svc
+##############################################################################
+from Configurables import k4DataSvc
+dsvc = k4DataSvc("EventDataSvc")
+
+##############################################################################
+# Geometry Svc
+##############################################################################
+# det.xml with the wire mode replaced, written to the working directory.
+# The included files are referred by absolute paths.
+
+if not os.getenv("DETDRIFTCHAMBERROOT"):
+    print("Can't find the geometry. Please setup envvar DETDRIFTCHAMBERROOT." )
+    sys.exit(-1)
+
+compact_dir = os.path.join(os.getenv("DETDRIFTCHAMBERROOT"), "compact")
+with open(os.path.join(compact_dir, "det.xml")) as f:
+    compact = f.read()
+
+compact = re.sub(r'(<constant name="DC_construct_wire" value=")[^"]*(")',
+                 r'\g<1>%d\g<2>'%wire_mode, compact)
+compact = re.sub(r'(<gdmlFile\s+ref=")([^"/]*)(")',
+                 lambda m: m.group(1) + os.path.join(compact_dir, m.group(2)) + m.group(3), compact)
+
+geometry_path = os.path.abspath("det_wiremode%d.xml"%wire_mode)
+with open(geometry_path, "w") as f:
+    f.write(compact)
+
+from Configurables import GeomSvc
+geosvc = GeomSvc("GeomSvc")
+geosvc.compact = geometry_path
+
+##############################################################################
+# Physics Generator
+##############################################################################
+from Configurables import GenAlgo
+from Configurables import GtGunTool
+
+gun = GtGunTool("GtGunTool")
+gun.Particles = ["mu-"]
+gun.EnergyMins = [10.] # GeV
+gun.EnergyMaxs = [10.] # GeV
+gun.ThetaMins = [30] # deg
+gun.ThetaMaxs = [150.] # deg
+gun.PhiMins = [0] # deg
+gun.PhiMaxs = [360.] # deg
+
+genalg = GenAlgo("GenAlgo")
+genalg.GenTools = ["GtGunTool"]
+
+##############################################################################
+# Detector Simulation
+##############################################################################
+from Configurables import DetSimSvc
+detsimsvc = DetSimSvc("DetSimSvc")
+
+from Configurables import DetSimAlg
+detsimalg = DetSimAlg("DetSimAlg")
+detsimalg.RandomSeeds = seed
+
+from Configurables import StepRateAnaElemTool
+steprate_tool = StepRateAnaElemTool("StepRateAnaElemTool")
+steprate_tool.VolumePrefix = "DriftChamber"
+
+detsimalg.AnaElems = [
+    "StepRateAnaElemTool"
+]
+detsimalg.RootDetElem = "WorldDetElemTool"
+
+from Configurables import DriftChamberSensDetTool
+driftchamber_sensdettool = DriftChamberSensDetTool("DriftChamberSensDetTool")
+driftchamber_sensdettool.DedxSimTool = "DummyDedxSimTool"
+
+from Configurables import DummyDedxSimTool
+dedx_simtool = DummyDedxSimTool("DummyDedxSimTool")
+
+##############################################################################
+# ApplicationMgr
+##############################################################################
+
+from Configurables import ApplicationMgr
+ApplicationMgr( TopAlg = [genalg, detsimalg],
+                EvtSel = 'NONE',
+                EvtMax = evtmax,
+                ExtSvc = [rndmengine, rndmgensvc, dsvc, geosvc],
+)
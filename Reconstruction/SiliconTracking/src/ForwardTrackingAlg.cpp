@@ -28,10 +28,14 @@
 #include "ILDImpl/FTDHit01.h"
 #include "ILDImpl/FTDNeighborPetalSecCon.h"
 #include "ILDImpl/FTDSectorConnector.h"
+#include "ILDImpl/FTDRawTrackFinder.h"
 #include "Tools/KiTrackMarlinTools.h"
 //#include "Tools/KiTrackMarlinCEDTools.h"
 #include "Tools/FTDHelixFitter.h"
 
+#include <algorithm>
+#include <set>
+
 using namespace MarlinTrk ;
 
 // Used to fedine the quality of the track output collection
@@ -125,6 +129,19 @@ StatusCode ForwardTrackingAlg::initialize(){
   debug() << "SectorSystemFTD is using " << nLayers << " layers (including one for the IP), " << nModules << " petals and " << nSensors << " sensors." << endmsg;
    
   _sectorSystemFTD = new SectorSystemFTD( nLayers, nModules , nSensors );
+  
+  // With several phi partitions the regions must overlap by the petals a track can cross, or tracks get lost
+  if( _nPhiPartitions < 1 ){
+    error() << "NumberOfPhiPartitions must be at least 1, but is " << _nPhiPartitions.value() << endmsg;
+    return StatusCode::FAILURE;
+  }
+  unsigned minPhiPartitionOverlap = FTDRawTrackFinder( _sectorSystemFTD , _criteriaNames , _critMinima , _critMaxima , 
+                                                       unsigned( _maxConnectionsAutomaton ) ).getMinPhiPartitionOverlap();
+  if( _nPhiPartitions > 1 && _phiPartitionOverlap >= 0 && unsigned( _phiPartitionOverlap ) < minPhiPartitionOverlap ){
+    error() << "PhiPartitionOverlap( " << _phiPartitionOverlap.value() << " ) is smaller than the " << minPhiPartitionOverlap 
+            << " petals a track can cross: tracks would be lost. Use at least this value, or -1 to set it automatically." << endmsg;
+    return StatusCode::FAILURE;
+  }
 
   // Get the B Field in z direction
   _Bz = gearMgr->getBField().at( gear::Vector3D(0., 0., 0.) ).z();    //The B field in z direction
@@ -320,122 +337,23 @@ StatusCode ForwardTrackingAlg::execute(){
     /**********************************************************************************************/
     /*                SegmentBuilder and Cellular Automaton                                       */
     /**********************************************************************************************/
-    unsigned round = 0; // the round we are in
-    std::vector < RawTrack > rawTracks;
-
-    // The following while loop ideally only runs once. (So we do round 0 and everything works)
-    // It will repeat as long as the Automaton creates too many connections and as long as there are new criteria
-    // parameters to use to cut down the problem.
-    // Ideally already in round 0, there is a reasonable number of connections (not more than _maxConnectionsAutomaton), 
-    // so the loop will be left. If however there are too many connections we stay in the loop and use 
-    // (hopefully) tighter cut offs (if provided in the steering). This should prevent combinatorial breakdown
-    // for very evil events.
-    while( setCriteria( round ) ){
-      round++; // count up the round we are in
-               
-      /**********************************************************************************************/
-      /*                Build the segments                                                          */
-      /**********************************************************************************************/
-      debug() << "\t\t---SegementBuilder---" << endmsg;
-         
-      //Create a segmentbuilder
-      SegmentBuilder segBuilder( _map_sector_hits );
-      
-      segBuilder.addCriteria ( _crit2Vec ); // Add the criteria on when to connect two hits. The vector has been filled by the method setCriteria
-         
-      //Also load hit connectors
-      unsigned layerStepMax = 1; // how many layers to go at max
-      unsigned petalStepMax = 1; // how many petals to go at max
-      unsigned lastLayerToIP = 5;// layer 1,2,3 and 4 get connected directly to the IP
-      FTDSectorConnector secCon( _sectorSystemFTD , layerStepMax , petalStepMax , lastLayerToIP );
-               
-      segBuilder.addSectorConnector ( & secCon ); // Add the sector connector (so the SegmentBuilder knows what hits from different sectors it is allowed to look for connections)
-               
-      // And get out the Cellular Automaton with the 1-segments 
-      Automaton automaton = segBuilder.get1SegAutomaton();
-      
-      // Check if there are not too many connections
-      if( automaton.getNumberOfConnections() > unsigned( _maxConnectionsAutomaton ) ){
-	debug() << "Redo the Automaton with different parameters, because there are too many connections:" << endmsg
-		<< "\tconnections( " << automaton.getNumberOfConnections() << " ) > MaxConnectionsAutomaton( " << _maxConnectionsAutomaton << " )" << endmsg;
-	continue;
-      }
-               
-      /**********************************************************************************************/
-      /*                Automaton                                                                   */
-      /**********************************************************************************************/
-      debug() << "\t\t---Automaton---" << endmsg;
-      
-      //if( _useCED ) KiTrackMarlin::drawAutomatonSegments( automaton ); // draws the 1-segments (i.e. hits)
-               
-      /*******************************/
-      /*      2-hit segments         */
-      /*******************************/
-      debug() << "\t\t--2-hit-Segments--" << endmsg;
-         
-      //debug() << "Automaton has " << automaton.getTracks( 3 ).size() << " track candidates" << endmsg; //should be commented out, because it takes time
-         
-      automaton.clearCriteria();
-      automaton.addCriteria( _crit3Vec );  // Add the criteria for 3 hits (i.e. 2 2-hit segments )
-               
-      // Let the automaton lengthen its 1-hit-segments to 2-hit-segments
-      automaton.lengthenSegments();
-               
-      // So now we have 2-hit-segments and are ready to perform the Cellular Automaton.
-      
-      // Perform the automaton
-      automaton.doAutomaton();
-               
-      // Clean segments with bad states
-      automaton.cleanBadStates();
-              
-      // Reset the states of all segments
-      automaton.resetStates();
-      
-      //debug() << "Automaton has " << automaton.getTracks( 3 ).size() << " track candidates" << endmsg; //should be commented out, because it takes time
-                  
-      // Check if there are not too many connections
-      if( automaton.getNumberOfConnections() > unsigned( _maxConnectionsAutomaton ) ){
-	debug() << "Redo the Automaton with different parameters, because there are too many connections:" << endmsg
-		<< "\tconnections( " << automaton.getNumberOfConnections() << " ) > MaxConnectionsAutomaton( " << _maxConnectionsAutomaton << " )" << endmsg;
-	continue;
-      }
-         
-      /*******************************/
-      /*      3-hit segments         */
-      /*******************************/
-      debug() << "\t\t--3-hit-Segments--" << endmsg;
-         
-      automaton.clearCriteria();
-      automaton.addCriteria( _crit4Vec );      
-      
-      // Lengthen the 2-hit-segments to 3-hits-segments
-      automaton.lengthenSegments();
-      
-      // Perform the Cellular Automaton
-      automaton.doAutomaton();
-      
-      //Clean segments with bad states
-      automaton.cleanBadStates();
-               
-      //Reset the states of all segments
-      automaton.resetStates();
-                  
-      //debug() << "Automaton has " << automaton.getTracks( 3 ).size() << " track candidates" << endmsg; //should be commented out, because it takes time
-      
-      // Check if there are not too many connections
-      if( automaton.getNumberOfConnections() > unsigned( _maxConnectionsAutomaton ) ){
-	debug() << "Redo the Automaton with different parameters, because there are too many connections:" << endmsg
-		<< "\tconnections( " << automaton.getNumberOfConnections() << " ) > MaxConnectionsAutomaton( " << _maxConnectionsAutomaton << " )" << endmsg;
-	continue;
+    debug() << "\t\t---SegementBuilder and Automaton---" << endmsg;
+    
+    // With NumberOfThreads > 1 the regions of the FTD (at least the two sides) are processed concurrently
+    FTDRawTrackFinder rawTrackFinder( _sectorSystemFTD , _criteriaNames , _critMinima , _critMaxima , unsigned( _maxConnectionsAutomaton ) );
+    rawTrackFinder.setPhiPartitions( _nPhiPartitions , _phiPartitionOverlap < 0 ? rawTrackFinder.getMinPhiPartitionOverlap() : unsigned( _phiPartitionOverlap ) );
+    rawTrackFinder.setNumberOfThreads( _nThreads );
+    
+    std::vector < RawTrack > rawTracks = rawTrackFinder.getRawTracks( _map_sector_hits );
+    
+    const std::vector< unsigned >& nRounds = rawTrackFinder.getNumberOfRounds();
+    for( unsigned iRegion=0; iRegion < nRounds.size(); iRegion++ ){
+      if( nRounds[iRegion] > 1 ){
+        debug() << "Region " << iRegion << ": the Automaton was redone " << nRounds[iRegion] - 1 << " time(s) with different parameters, "
+                << "because there were too many connections ( > MaxConnectionsAutomaton( " << _maxConnectionsAutomaton << " ) )" << endmsg;
       }
-         
-      // get the raw tracks (raw track = just a vector of hits, the most rudimentary form of a track)
-      rawTracks = automaton.getTracks( 3 );
-      
-      break; // if we reached this place all went well and we don't need another round --> exit the loop
     }
-      
+    
     debug() << "Automaton returned " << rawTracks.size() << " raw tracks " << endmsg;
         
     /**********************************************************************************************/
@@ -597,8 +515,9 @@ StatusCode ForwardTrackingAlg::execute(){
       debug() << "Use SubsetHopfieldNN for getting the best subset" << endmsg ;
          
       SubsetHopfieldNN< ITrack* > subset;
+      subset.setNumberOfThreads( _nThreads );
       subset.add( trackCandidates );
-      subset.calculateBestSet( comp, trackQI );
+      subset.calculateBestSet( comp, trackQI, TrackHits() );
       tracks = subset.getAccepted();
       rejected = subset.getRejected();
     }
@@ -687,13 +606,6 @@ StatusCode ForwardTrackingAlg::execute(){
 }
 
 StatusCode ForwardTrackingAlg::finalize(){
-  for ( unsigned i=0; i< _crit2Vec.size(); i++) delete _crit2Vec[i];
-  for ( unsigned i=0; i< _crit3Vec.size(); i++) delete _crit3Vec[i];
-  for ( unsigned i=0; i< _crit4Vec.size(); i++) delete _crit4Vec[i];
-  _crit2Vec.clear();
-  _crit3Vec.clear();
-  _crit4Vec.clear();
-   
   delete _sectorSystemFTD;
   _sectorSystemFTD = NULL;
   
@@ -852,59 +764,6 @@ std::vector < RawTrack > ForwardTrackingAlg::getRawTracksPlusOverlappingHits( Ra
   return rawTracksPlus;
 }
 
-bool ForwardTrackingAlg::setCriteria( unsigned round ){
-  
-  // delete the old ones
-  for ( unsigned i=0; i< _crit2Vec.size(); i++) delete _crit2Vec[i];
-  for ( unsigned i=0; i< _crit3Vec.size(); i++) delete _crit3Vec[i];
-  for ( unsigned i=0; i< _crit4Vec.size(); i++) delete _crit4Vec[i];
-  _crit2Vec.clear();
-  _crit3Vec.clear();
-  _crit4Vec.clear();
-  
-  bool newValuesGotUsed = false; // if new values are used
-  for( unsigned i=0; i<_criteriaNames.size(); i++ ){
-    std::string critName = _criteriaNames[i];
-
-    float min = _critMinima[critName].back();
-    float max = _critMaxima[critName].back();
-
-    // use the value corresponding to the round, if there are no new ones for this criterion, just do nothing (the previous value stays in place)
-    if( round + 1 <= _critMinima[critName].size() ){
-      min =  _critMinima[critName][round];
-      newValuesGotUsed = true;
-    }
-      
-    if( round + 1 <= _critMaxima[critName].size() ){
-      max =  _critMaxima[critName][round];
-      newValuesGotUsed = true;
-    }
-
-    ICriterion* crit = Criteria::createCriterion( critName, min , max );
-
-    // Some debug output about the created criterion
-    std::string type = crit->getType();
-    
-    debug() <<  "Added: Criterion " << critName << " (type =  " << type 
-	    << " ). Min = " << min
-	    << ", Max = " << max
-	    << ", round " << round << endmsg;
-        
-    // Add the new criterion to the corresponding vector
-    if( type == "2Hit" ){
-      _crit2Vec.push_back( crit );
-    }
-    else if( type == "3Hit" ){
-      _crit3Vec.push_back( crit );
-    }
-    else if( type == "4Hit" ){
-      _crit4Vec.push_back( crit );
-    }
-    else delete crit;
-  }
-
-  return newValuesGotUsed;
-}
 
 void ForwardTrackingAlg::finaliseTrack( edm4hep::MutableTrack* trackImpl ){
      
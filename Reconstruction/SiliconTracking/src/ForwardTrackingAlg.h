@@ -94,6 +94,24 @@ typedef std::vector< IHit* > RawTrack;
  * prevents it) <br>
  * (default value 1000)
  * 
+ * @param NumberOfThreads The number of threads running the Cellular Automaton on the independent regions of the FTD
+ * and solving the best subset, 0 means the hardware concurrency. With more than one thread the two sides of the FTD
+ * are always separate regions, also with one phi partition. The rounds with tighter cut offs are then decided for each
+ * side, which only changes the tracks of events where MaxConnectionsAutomaton is exceeded <br>
+ * (default value is 1) <br>
+ * 
+ * @param NumberOfPhiPartitions Into how many ranges of petals every side of the FTD is split. Together with the two sides
+ * this gives the regions, where the Cellular Automaton runs independently, and MaxConnectionsAutomaton applies to each region.
+ * With 1 and one thread, one Cellular Automaton gets all hits, as before. If the ranges together with PhiPartitionOverlap
+ * reach all petals, only the two sides are split. This is a no-op for the CEPC FTD (16 petals, 5 disks): up to 5 partitions
+ * give one region per side, and with more every region still gets at least 13 of the 16 petals of its side <br>
+ * (default value is 1) <br>
+ * 
+ * @param PhiPartitionOverlap How many petals on each side of its range a region shares with its neighbours. Must be at least
+ * the number of petals a track can cross (one per layer), smaller values are rejected; -1 sets it to this number.
+ * Only used for NumberOfPhiPartitions > 1. <br>
+ * (default value is -1) <br>
+ * 
  * @author Robin Glattauer HEPHY, Wien
  *
  */
@@ -202,25 +220,6 @@ class ForwardTrackingAlg : public GaudiAlgorithm {
    */
   void finaliseTrack( edm4hep::MutableTrack* track );
   
-  /* Sets the cut off values for all the criteria
-   * 
-   * This method is necessary for cases where the CA just finds too much.
-   * Therefore it is possible to enter a whole list of cut off values for every criterion (for every min and every max to be more precise),
-   * that are then used one after the other. 
-   * If the CA finds way too many connections, we can thus make the cuts tighter and rerun it. If there are still too many
-   * connections, just tighten them again.
-   * 
-   * This method will set the according values. It will read the passed (as steering parameter) cut off values, create
-   * criteria from them and store them in the corresponding vectors.
-   * 
-   * If there are no new cut off values for a criterion, the last one remains.
-   * 
-   * @return whether any new cut off value was set. false == there are no new cutoff values anymore
-   * 
-   * @param round The number of the round we are in. I.e. the nth time we run the Cellular Automaton.
-   */
-  bool setCriteria( unsigned round );
-  
   /* @return Info on the content of _map_sector_hits. Says how many hits are in each sector */
   std::string getInfo_map_sector_hits();
       
@@ -249,6 +248,9 @@ class ForwardTrackingAlg : public GaudiAlgorithm {
    * the automaton with tighter cuts or stop it entirely. */
   Gaudi::Property<int>    _maxConnectionsAutomaton{this, "MaxConnectionsAutomaton", 100000};
   Gaudi::Property<int>    _maxHitsPerSector{this, "MaxHitsPerSector", 1000};
+  Gaudi::Property<int>    _nThreads{this, "NumberOfThreads", 1};
+  Gaudi::Property<int>    _nPhiPartitions{this, "NumberOfPhiPartitions", 1};
+  Gaudi::Property<int>    _phiPartitionOverlap{this, "PhiPartitionOverlap", -1};
   Gaudi::Property<bool>   _MSOn{this, "MultipleScatteringOn", true};
   Gaudi::Property<bool>   _ElossOn{this, "EnergyLossOn", true};
   Gaudi::Property<bool>   _SmoothOn{this, "SmoothOn", false};
@@ -268,15 +270,6 @@ class ForwardTrackingAlg : public GaudiAlgorithm {
   /** Map containing the name of a criterion and a vector of the maximum cut offs for it */
   //std::map< std::string , std::vector<float> > _critMaxima;
   
-  /** A vector of criteria for 2 hits (2 1-hit segments) */
-  std::vector <ICriterion*> _crit2Vec;
-  
-  /** A vector of criteria for 3 hits (2 2-hit segments) */
-  std::vector <ICriterion*> _crit3Vec;
-  
-  /** A vector of criteria for 4 hits (2 3-hit segments) */
-  std::vector <ICriterion*> _crit4Vec;
-  
   const SectorSystemFTD* _sectorSystemFTD;
   
   bool _useCED;
@@ -314,6 +307,13 @@ class TrackCompatibilityShare1SP{
   }
 };
 
+/** A functor to return the hits of a track: only tracks sharing a hit need to be checked with TrackCompatibilityShare1SP */
+class TrackHits{
+ public:
+   
+  inline std::vector< IHit* > operator()( ITrack* track ){ return track->getHits(); }
+};
+
 /** A functor to return the quality of a track, which is currently the chi2 probability. */
 class TrackQIChi2Prob{
  public:
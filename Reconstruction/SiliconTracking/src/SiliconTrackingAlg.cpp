@@ -12,8 +12,10 @@
 
 #include <iostream>
 #include <algorithm>
+#include <atomic>
 #include <cmath>
 #include <climits>
+#include <thread>
 
 #include <gear/GEAR.h>
 #include <gear/GearMgr.h>
@@ -151,8 +153,13 @@ StatusCode  SiliconTrackingAlg::initialize() {
   cutOnR = 1000.*cutOnR;
   _cutOnOmega = 1/cutOnR;
   
+  TripletCuts tripletCuts = { _chi2FitCut, _chi2WRPhiTriplet, _chi2WZTriplet, _cutOnOmega, _cutOnD0, _cutOnZ0 };
+  _tripletCuts = tripletCuts;
+  
   _output_track_col_quality = 0;
   
+  _nTripletsFitted = _nTripletsRejected = 0;
+  
   return GaudiAlgorithm::initialize();
 }
 
@@ -188,11 +195,11 @@ StatusCode SiliconTrackingAlg::execute(){
     
     debug() << "      phi          theta        layer      nh o :   m :   i  :: o*m*i " << endmsg; 
     
-    for (int iPhi=0; iPhi<_nDivisionsInPhi; ++iPhi) { 
-      for (int iTheta=0; iTheta<_nDivisionsInTheta;++iTheta) {
-        ProcessOneSector(iPhi,iTheta); // Process one VXD sector     
-      }
-    }
+    int nThreads = _nThreads > 0 ? int(_nThreads) : int(std::thread::hardware_concurrency());
+    ProcessSectors(nThreads);
+    
+    // only the VXD+SIT triplets have been counted so far in this event
+    _nTripletsFitted += _ntriplets;
     
     debug() << "End of Processing VXD and SIT sectors" << endmsg;
     
@@ -363,25 +370,9 @@ void SiliconTrackingAlg::CleanUp() {
   
   _tracksWithNHitsContainer.clear();
   
-  for (int il=0;il<_nLayers;++il) {
-    for (int ip=0;ip<_nDivisionsInPhi;++ip) {
-      for (int it=0;it<_nDivisionsInTheta; ++it) {
-        unsigned int iCode = il + _nLayers*ip + _nLayers*_nDivisionsInPhi*it;      
-        
-        if( iCode >= _sectors.size()){          
-          error() << "iCode index out of range: iCode =   " << iCode << " _sectors.size() = " << _sectors.size() << " exit(1) called from file " << __FILE__ << " line " << __LINE__<< endmsg;
-          continue;
-        }
-        
-        TrackerHitExtendedVec& hitVec = _sectors[iCode];
-        int nH = int(hitVec.size());
-        for (int iH=0; iH<nH; ++iH) {
-          TrackerHitExtended * hit = hitVec[iH];
-          delete hit;
-        }
-      }
-    }
-  }
+  // the VXD+SIT hits are owned by the arena
+  _sectorHitVec.clear();
+  _sectorHitArena.clear();
   
   for (int iS=0;iS<2;++iS) {
     for (unsigned int layer=0;layer<_nlayersFTD;++layer) {
@@ -635,8 +626,8 @@ int SiliconTrackingAlg::InitialiseFTD() {
 int SiliconTrackingAlg::InitialiseVTX() {
   _nTotalVTXHits = 0;
   _nTotalSITHits = 0;
-  _sectors.clear();
-  _sectors.resize(_nLayers*_nDivisionsInPhi*_nDivisionsInTheta);
+  _sectorHitArena.clear();
+  _sectorHitCodes.clear();
   int success = 1;
   // Reading out VTX Hits Collection
   //^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^  
@@ -677,7 +668,8 @@ int SiliconTrackingAlg::InitialiseVTX() {
         error() << "SiliconTrackingAlg: VXD Hit measurment vectors U is not in the global X-Y plane. \n\n exit(1) called from file " << __FILE__ << " and line " << __LINE__ << endmsg;
         exit(1);
       }
-      TrackerHitExtended * hitExt = new TrackerHitExtended(hit);
+      _sectorHitArena.push_back(TrackerHitExtended(hit));
+      TrackerHitExtended * hitExt = &_sectorHitArena.back();
       //debug() << "Saved TrackerHit id in TrackerHitExtended " << ielem << ": " << hitExt->getTrackerHit().id() << std::endl;
             
       // SJA:FIXME: just use planar res for now
@@ -715,7 +707,7 @@ int SiliconTrackingAlg::InitialiseVTX() {
       int iPhi = int(Phi/_dPhi);
       int iTheta = int ((cosTheta + double(1.0))/_dTheta);
       int iCode = layer + _nLayers*iPhi + _nLayers*_nDivisionsInPhi*iTheta;      
-      _sectors[iCode].push_back( hitExt );
+      _sectorHitCodes.push_back( iCode );
       
       debug() << " VXD Hit " <<  hit.id() << " added : @ " << pos[0] << " " << pos[1] << " " << pos[2] << " drphi " << hitExt->getResolutionRPhi() << " dz " << hitExt->getResolutionZ() << "  iPhi = " << iPhi <<  " iTheta "  << iTheta << " iCode = " << iCode << "  layer = " << layer << endmsg;  
       
@@ -845,7 +837,8 @@ int SiliconTrackingAlg::InitialiseVTX() {
         }
         // now that the hit type has been established carry on and create a 
         
-        TrackerHitExtended * hitExt = new TrackerHitExtended(trkhit);
+        _sectorHitArena.push_back(TrackerHitExtended(trkhit));
+        TrackerHitExtended * hitExt = &_sectorHitArena.back();
         
         // SJA:FIXME: just use planar res for now
         hitExt->setResolutionRPhi(drphi);
@@ -874,7 +867,7 @@ int SiliconTrackingAlg::InitialiseVTX() {
         int iPhi = int(Phi/_dPhi);
         int iTheta = int ((cosTheta + double(1.0))/_dTheta);
         int iCode = layer + _nLayers*iPhi + _nLayers*_nDivisionsInPhi*iTheta;      
-        _sectors[iCode].push_back( hitExt );
+        _sectorHitCodes.push_back( iCode );
         
         debug() << " SIT Hit " <<  trkhit.id() << " added : @ " << pos[0] << " " << pos[1] << " " << pos[2] << " drphi " << hitExt->getResolutionRPhi() << " dz " << hitExt->getResolutionZ() << "  iPhi = " << iPhi <<  " iTheta "  << iTheta << " iCode = " << iCode << "  layer = " << layer << endmsg;  
         
@@ -883,21 +876,54 @@ int SiliconTrackingAlg::InitialiseVTX() {
   }
   
   
-  for (unsigned i=0; i<_sectors.size(); ++i) {
-    int nhits = _sectors[i].size();
-    if( nhits != 0 ) debug() << " Number of Hits in VXD/SIT Sector " << i << " = " << _sectors[i].size() << endmsg;
+  SortSectorHits();
+  
+  debug() << "VXD initialized" << endmsg;
+  return success; 
+}
+
+void SiliconTrackingAlg::SortSectorHits() {
+  
+  /**
+   Sorts the hits of _sectorHitArena into the sectors given by _sectorHitCodes and drops the sectors with too many hits.
+   */
+  
+  // counting sort of the hits by sector, keeping their order within a sector
+  int nSectors = _nLayers*_nDivisionsInPhi*_nDivisionsInTheta;
+  int nArenaHits = int(_sectorHitArena.size());
+  _sectorOffsets.assign(nSectors+1, 0);
+  for (int ihit=0; ihit<nArenaHits; ++ihit) ++_sectorOffsets[_sectorHitCodes[ihit]+1];
+  
+  for (int i=0; i<nSectors; ++i) {
+    int nhits = _sectorOffsets[i+1];
+    if( nhits != 0 ) debug() << " Number of Hits in VXD/SIT Sector " << i << " = " << nhits << endmsg;
     if (nhits > _max_hits_per_sector) {
-      for (unsigned ihit=0; ihit<_sectors[i].size(); ++ihit) {
-        delete _sectors[i][ihit];
-      }
-      _sectors[i].clear();
-      if( nhits != 0 ) error()  << " \n ### Number of Hits in VXD/SIT Sector " << i << " = " << nhits << " : Limit is set to " << _max_hits_per_sector << " : This sector will be dropped from track search, and QualityCode set to \"Poor\" " << endmsg;
+      _sectorOffsets[i+1] = 0;
+      error()  << " \n ### Number of Hits in VXD/SIT Sector " << i << " = " << nhits << " : Limit is set to " << _max_hits_per_sector << " : This sector will be dropped from track search, and QualityCode set to \"Poor\" " << endmsg;
       
       _output_track_col_quality = _output_track_col_quality_POOR;
     }
   }
-  debug() << "VXD initialized" << endmsg;
-  return success; 
+  for (int i=0; i<nSectors; ++i) _sectorOffsets[i+1] += _sectorOffsets[i];
+  
+  _sectorHitVec.assign(_sectorOffsets[nSectors], NULL);
+  std::vector<int> next(_sectorOffsets.begin(), _sectorOffsets.end()-1);
+  for (int ihit=0; ihit<nArenaHits; ++ihit) {
+    int iCode = _sectorHitCodes[ihit];
+    // the hits of a dropped sector are left out
+    if (next[iCode] < _sectorOffsets[iCode+1]) _sectorHitVec[next[iCode]++] = &_sectorHitArena[ihit];
+  }
+  
+  // copy the hit coordinates sector by sector for the triplet prefilter
+  if (_prefilterTriplets) {
+    int nSectorHitVec = int(_sectorHitVec.size());
+    _sectorHits.resize(nSectorHitVec);
+    for (int ihit=0; ihit<nSectorHitVec; ++ihit) {
+      TrackerHitExtended * hitExt = _sectorHitVec[ihit];
+      _sectorHits.set(ihit, hitExt->getTrackerHit().getPosition()[0], hitExt->getTrackerHit().getPosition()[1],
+                      hitExt->getTrackerHit().getPosition()[2], hitExt->getResolutionZ());
+    }
+  }
 }
 
 StatusCode  SiliconTrackingAlg::finalize(){
@@ -907,15 +933,88 @@ StatusCode  SiliconTrackingAlg::finalize(){
   //delete _trksystem ; _trksystem = 0;
   //delete _histos ; _histos = 0;
   info() << "Processed " << _nEvt << " events " << endmsg;
+  info() << "VXD+SIT triplets fitted: " << _nTripletsFitted << ", rejected by the prefilter: " << _nTripletsRejected << endmsg;
   info() << lcio::ILDCellID0::encoder_string << " " << UTIL::ILDCellID0::encoder_string << endmsg;
   return GaudiAlgorithm::finalize();
 }
 
 
-void SiliconTrackingAlg::ProcessOneSector(int iPhi, int iTheta) {
+void SiliconTrackingAlg::ProcessSectors(int nThreads) {
+  
+  /**
+   Finds the VXD+SIT triplets of all sectors and adds their tracks to the track candidates.
+   With several threads the sectors are processed concurrently and merged in the order of the
+   sequential loop, the candidates do not depend on the number of threads (TestSiliconTrackingSectors).
+   */
+  
+  int nSectors = _nDivisionsInPhi*_nDivisionsInTheta;
+  nThreads = std::min(nThreads,nSectors);
+  
+  if (nThreads <= 1) {
+    SectorContext context;
+    context.useAssignedTracks = true;
+    context.debugOn = msgLevel(MSG::DEBUG);
+    context.nTriplets = 0;
+    context.nRejected = 0;
+    SectorTripletVec triplets;
+    for (int iPhi=0; iPhi<_nDivisionsInPhi; ++iPhi) { 
+      for (int iTheta=0; iTheta<_nDivisionsInTheta;++iTheta) {
+        ProcessOneSector(iPhi,iTheta,context,triplets); // Process one VXD sector     
+        MergeSectorTriplets(triplets);
+      }
+    }
+    _ntriplets += context.nTriplets;
+    _nTripletsRejected += context.nRejected;
+  }
+  else {
+    // the sectors only read the hits, the tracks are attached to the hits when the sectors are merged
+    std::vector<SectorTripletVec> sectorTriplets(nSectors);
+    std::vector<SectorContext> contexts(nThreads);
+    std::atomic<int> next(0);
+    
+    auto worker = [&](int iThread) {
+      SectorContext & context = contexts[iThread];
+      context.useAssignedTracks = false;
+      context.debugOn = false;
+      context.nTriplets = 0;
+      context.nRejected = 0;
+      int iSector;
+      while ( (iSector = next++) < nSectors ) {
+        ProcessOneSector(iSector/_nDivisionsInTheta,iSector%_nDivisionsInTheta,context,sectorTriplets[iSector]);
+      }
+    };
+    
+    std::vector<std::thread> threads;
+    threads.reserve(nThreads-1);
+    for (int t=1;t<nThreads;++t) threads.emplace_back(worker,t);
+    worker(0);
+    for (unsigned t=0;t<threads.size();++t) threads[t].join();
+    
+    for (int t=0;t<nThreads;++t) {
+      _ntriplets += contexts[t].nTriplets;
+      _nTripletsRejected += contexts[t].nRejected;
+    }
+    
+    // merge in the order of the sequential loop over phi and theta
+    for (int iSector=0; iSector<nSectors; ++iSector) {
+      MergeSectorTriplets(sectorTriplets[iSector]);
+    }
+  }
+}
+
+void SiliconTrackingAlg::ProcessOneSector(int iPhi, int iTheta, SectorContext & context, SectorTripletVec & triplets) {
+  
+  /**
+   Finds the triplets of the sector and builds their tracks. Nothing is attached to the hits:
+   the triplets are stored in the order of the search and added to the track candidates 
+   by MergeSectorTriplets, so that sectors can be processed concurrently.
+   */
   
   int counter = 0 ;
   
+  triplets.clear();
+  context.sectorTracks.clear();
+  
   int iPhi_Up    = iPhi + 1;
   int iPhi_Low   = iPhi - 1;
   int iTheta_Up  = iTheta + 1; 
@@ -941,16 +1040,17 @@ void SiliconTrackingAlg::ProcessOneSector(int iPhi, int iTheta) {
     // index of theta-phi bin of outer most layer
     int iCode = nLR[0] + _nLayers*iPhi +  _nLayers*_nDivisionsInPhi*iTheta;
     
-    //std::cout << "size of vector = " << _sectors.size() << " iCode = " << iCode << std::endl;
+    //std::cout << "size of vector = " << _sectorOffsets.size()-1 << " iCode = " << iCode << std::endl;
     
     // get the all the hits in the outer most theta-phi bin 
     
-    TrackerHitExtendedVec& hitVecOuter =  _sectors[iCode];
+    TrackerHitExtended * const * hitVecOuter = sectorHits(iCode);
     
-    int nHitsOuter = int(hitVecOuter.size());
+    int nHitsOuter = nSectorHits(iCode);
+    int firstOuter = _sectorOffsets[iCode];
     if (nHitsOuter > 0) {
       
-      //std::cout << " " << iPhi << " " << iTheta << " " << nLR[0] << " " << nLR[1] << " " << nLR[2] << " size of vector = " << hitVecOuter.size() << std::endl;
+      //std::cout << " " << iPhi << " " << iTheta << " " << nLR[0] << " " << nLR[1] << " " << nLR[2] << " size of vector = " << nHitsOuter << std::endl;
       
       for (int ipMiddle=iPhi_Low; ipMiddle<iPhi_Up+1;ipMiddle++) { // loop over phi in the Middle
         
@@ -966,9 +1066,10 @@ void SiliconTrackingAlg::ProcessOneSector(int iPhi, int iTheta) {
           iCode = nLR[1] + _nLayers*iPhiMiddle +  _nLayers*_nDivisionsInPhi*itMiddle;
           
           // get the all the hits in the current middle theta-phi bin 
-          TrackerHitExtendedVec& hitVecMiddle = _sectors[iCode];
+          TrackerHitExtended * const * hitVecMiddle = sectorHits(iCode);
           
-          int nHitsMiddle = int(hitVecMiddle.size());
+          int nHitsMiddle = nSectorHits(iCode);
+          int firstMiddle = _sectorOffsets[iCode];
           
           // determine which inner theta-phi bins to look in
           
@@ -1027,13 +1128,15 @@ void SiliconTrackingAlg::ProcessOneSector(int iPhi, int iTheta) {
                 iCode = nLR[2] + _nLayers*iPhiInner +  _nLayers*_nDivisionsInPhi*itInner;
                 
                 // get hit for inner bin
-                TrackerHitExtendedVec& hitVecInner = _sectors[iCode];
+                TrackerHitExtended * const * hitVecInner = sectorHits(iCode);
                 
-                int nHitsInner = int(hitVecInner.size());
+                int nHitsInner = nSectorHits(iCode);
+                int firstInner = _sectorOffsets[iCode];
+                if (int(context.pass.size()) < nHitsInner) context.pass.resize(nHitsInner);
                 
                 if (nHitsInner > 0) {
                   
-                  debug() << " " 
+                  if (context.debugOn) debug() << " " 
                   << std::setw(3) << iPhi       << " "   << std::setw(3) << ipMiddle << " "      << std::setw(3) << ipInner << "   " 
                   << std::setw(3) << iTheta     << " "   << std::setw(3) << itMiddle << " "      << std::setw(3) << itInner << "  " 
                   << std::setw(3) << nLR[0]     << " "   << std::setw(3) << nLR[1]   << " "      << std::setw(3) << nLR[2]  << "     " 
@@ -1046,20 +1149,55 @@ void SiliconTrackingAlg::ProcessOneSector(int iPhi, int iTheta) {
                     TrackerHitExtended * outerHit = hitVecOuter[iOuter];
                     for (int iMiddle=0;iMiddle<nHitsMiddle;iMiddle++) { // loop over hits in the middle sector
                       TrackerHitExtended * middleHit = hitVecMiddle[iMiddle];
+                      
+                      if (_prefilterTriplets) {
+                        prefilterTriplets(_sectorHits,_tripletCuts,firstOuter+iOuter,firstMiddle+iMiddle,firstInner,firstInner+nHitsInner,&context.pass[0]);
+                      }
+                      
                       for (int iInner=0;iInner<nHitsInner;iInner++) { // loop over hits in the inner sector
                         TrackerHitExtended * innerHit = hitVecInner[iInner];
-                        HelixClass helix;
-			// test fit to triplet
-                        TrackExtended * trackAR = TestTriplet(outerHit,middleHit,innerHit,helix);
-			if ( trackAR != NULL ) {
-                          int nHits = BuildTrack(outerHit,middleHit,innerHit,helix,nLR[2],
-                                                 iPhiLowInner,iPhiUpInner,
-                                                 iThetaLowInner,iThetaUpInner,trackAR);
+                        
+                        // the fit of the triplet would not pass the cuts
+                        if ( _prefilterTriplets && !context.pass[iInner] ) {
+                          ++context.nRejected;
+                          continue;
+                        }
+                        
+                        // an accepted track of a previous sector already contains all three hits
+                        if ( context.useAssignedTracks && TripletIsAssigned(outerHit,middleHit,innerHit) ) continue;
+                        
+                        SectorTriplet triplet = { outerHit, middleHit, innerHit, nLR[2],
+                                                  iPhiLowInner, iPhiUpInner, iThetaLowInner, iThetaUpInner,
+                                                  NULL, 0 };
+                        
+                        // if a track of this sector contains all three hits, the triplet is only
+                        // fitted when merging and if that track has been rejected
+                        bool contained = false;
+                        std::map<TrackerHitExtended*, std::vector<int> >::const_iterator outerTracks  = context.sectorTracks.find(outerHit);
+                        std::map<TrackerHitExtended*, std::vector<int> >::const_iterator middleTracks = context.sectorTracks.find(middleHit);
+                        std::map<TrackerHitExtended*, std::vector<int> >::const_iterator innerTracks  = context.sectorTracks.find(innerHit);
+                        if ( outerTracks != context.sectorTracks.end() && middleTracks != context.sectorTracks.end() && innerTracks != context.sectorTracks.end() ) {
+                          for (unsigned i=0; i<outerTracks->second.size() && !contained; ++i) {
+                            int iTriplet = outerTracks->second[i];
+                            contained = std::binary_search(middleTracks->second.begin(), middleTracks->second.end(), iTriplet)
+                              && std::binary_search(innerTracks->second.begin(), innerTracks->second.end(), iTriplet);
+                          }
+                        }
+                        
+                        if ( !contained ) {
+                          ++context.nTriplets;
+                          // test fit to triplet and build the track
+                          if ( !BuildSectorTriplet(triplet,context.fitter,context.debugOn) ) continue;
                           
-                          _tracksWithNHitsContainer.getTracksWithNHitsVec(nHits).push_back(trackAR);
+                          int iTriplet = int(triplets.size());
+                          TrackerHitExtendedVec& hvec = triplet.track->getTrackerHitExtendedVec();
+                          for (unsigned ih=0; ih<hvec.size(); ++ih) context.sectorTracks[hvec[ih]].push_back(iTriplet);
                           
                           counter ++ ;
                         }
+                        
+                        triplets.push_back(triplet);
+                        
                       } // endloop over hits in the inner sector
                     } // endloop over hits in the middle sector
                   } // endloop over hits in the outer sector
@@ -1075,6 +1213,51 @@ void SiliconTrackingAlg::ProcessOneSector(int iPhi, int iTheta) {
   //debug() << " process one sectector theta,phi " << iTheta << ", " << iPhi << "  number of loops : " << counter << endmsg  ;
 }
 
+void SiliconTrackingAlg::MergeSectorTriplets(SectorTripletVec & triplets) {
+  
+  /**
+   Adds the tracks of a sector to the track candidates, in the order in which the triplets were found.
+   A triplet is discarded if an accepted track already contains its three hits, as it is in TestTriplet.
+   */
+  
+  for (unsigned i=0; i<triplets.size(); ++i) {
+    
+    SectorTriplet & triplet = triplets[i];
+    
+    if ( TripletIsAssigned(triplet.outerHit,triplet.middleHit,triplet.innerHit) ) {
+      debug() << " MergeSectorTriplets: an existing track already contains all three hits: Do not create new track from these hits " << endmsg ;
+      delete triplet.track;
+      continue;
+    }
+    
+    // the track of the sector which contained the triplet has been rejected
+    if ( triplet.track == NULL ) {
+      ++_ntriplets;
+      if ( !BuildSectorTriplet(triplet,*_fastfitter,msgLevel(MSG::DEBUG)) ) continue;
+    }
+    
+    TrackerHitExtendedVec& hvec = triplet.track->getTrackerHitExtendedVec();
+    for (unsigned ih=0; ih<hvec.size(); ++ih) hvec[ih]->addTrackExtended(triplet.track);
+    
+    _tracksWithNHitsContainer.getTracksWithNHitsVec(triplet.nHits).push_back(triplet.track);
+  }
+  
+  triplets.clear();
+}
+
+bool SiliconTrackingAlg::BuildSectorTriplet(SectorTriplet & triplet, MarlinTrk::HelixFit & fitter, bool debugOn) {
+  
+  HelixClass helix;
+  // test fit to triplet
+  triplet.track = FitTriplet(triplet.outerHit,triplet.middleHit,triplet.innerHit,helix,fitter,debugOn);
+  if ( triplet.track == NULL ) return false;
+  
+  triplet.nHits = BuildTrack(triplet.outerHit,triplet.middleHit,triplet.innerHit,helix,triplet.innerLayer,
+                             triplet.iPhiLow,triplet.iPhiUp,
+                             triplet.iThetaLow,triplet.iThetaUp,triplet.track,fitter,debugOn);
+  return true;
+}
+
 TrackExtended * SiliconTrackingAlg::TestTriplet(TrackerHitExtended * outerHit, 
                                                        TrackerHitExtended * middleHit,
                                                        TrackerHitExtended * innerHit,
@@ -1082,6 +1265,32 @@ TrackExtended * SiliconTrackingAlg::TestTriplet(TrackerHitExtended * outerHit,
   /*
    Methods checks if the triplet of hits satisfies helix hypothesis
    */
+  if ( TripletIsAssigned(outerHit,middleHit,innerHit) ) {
+    // an existing track already contains all three hits
+    // return a null pointer
+    debug() << " TestTriplet: an existing track already contains all three hits: Do not create new track from these hits " << endmsg ;
+    return 0;
+  }
+  
+  // increase triplet count
+  ++_ntriplets;
+  
+  TrackExtended * trackAR = FitTriplet(outerHit,middleHit,innerHit,helix,*_fastfitter,msgLevel(MSG::DEBUG));
+  
+  if ( trackAR != NULL ) {
+    outerHit->addTrackExtended(trackAR);
+    middleHit->addTrackExtended(trackAR);
+    innerHit->addTrackExtended(trackAR);
+  }
+  
+  return trackAR;
+  
+}
+
+bool SiliconTrackingAlg::TripletIsAssigned(TrackerHitExtended * outerHit, 
+                                           TrackerHitExtended * middleHit,
+                                           TrackerHitExtended * innerHit) {
+  
   // get the tracks already associated with the triplet
   TrackExtendedVec& trackOuterVec  = outerHit->getTrackExtendedVec();
   TrackExtendedVec& trackMiddleVec = middleHit->getTrackExtendedVec();
@@ -1117,31 +1326,37 @@ TrackExtended * SiliconTrackingAlg::TestTriplet(TrackerHitExtended * outerHit,
           // no need to check against middle, it is idendical to outer here
           if ( *outerIter == *innerIter ) {
             // an existing track already contains all three hits
-            // return a null pointer
-            debug() << " TestTriplet: track " << *outerIter << " already contains all three hits: Do not create new track from these hits " << endmsg ;
-            return 0;            
+            return true;
           }
           
         }// for inner
       }// for outer    
     }// for middle
   }// if all vectors are not empty
+  
+  return false;
+}
+
+TrackExtended * SiliconTrackingAlg::FitTriplet(TrackerHitExtended * outerHit, 
+                                               TrackerHitExtended * middleHit,
+                                               TrackerHitExtended * innerHit,
+                                               HelixClass & helix,
+                                               MarlinTrk::HelixFit & fitter, bool debugOn) {
+  /*
+   Fits the triplet and applies the cuts, the hits are not modified.
+   Only uses the message stream if debugOn is set.
+   */
   //    float dZ = FastTripletCheck(innerHit, middleHit, outerHit);
   
   //    if (fabs(dZ) > _minDistCutAttach)
   //      return trackAR;    
   
-  // increase triplet count
-  ++_ntriplets;
-
   // get the hit coordinates and errors
   double xh[3];
   double yh[3];
   float  zh[3];
   double wrh[3];
   float  wzh[3];
-  float  rh[3];
-  float  ph[3];
   
   float par[5];
   float epar[15];
@@ -1164,23 +1379,12 @@ TrackExtended * SiliconTrackingAlg::TestTriplet(TrackerHitExtended * outerHit,
   zh[2] = float(innerHit->getTrackerHit().getPosition()[2]);
   wrh[2] = double(1.0/(innerHit->getResolutionRPhi()*innerHit->getResolutionRPhi()));
   wzh[2] = 1.0/(innerHit->getResolutionZ()*innerHit->getResolutionZ());
-  // calculate r and phi for all hits
-  for (int ih=0; ih<3; ih++) {
-    rh[ih] = float(sqrt(xh[ih]*xh[ih]+yh[ih]*yh[ih]));
-    ph[ih] = atan2(yh[ih],xh[ih]);
-    if (ph[ih] < 0.) 
-      ph[ih] = TWOPI + ph[ih]; 
-  }
   
-  int NPT = 3;
-  int iopt = 2;
-  float chi2RPhi;
-  float chi2Z;
+  if (debugOn) debug() << " TestTriplet: Use fastHelixFit " << endmsg ;  
   
-  debug() << " TestTriplet: Use fastHelixFit " << endmsg ;  
-  
-  _fastfitter->fastHelixFit(NPT, xh, yh, rh, ph, wrh, zh, wzh,iopt, par, epar, chi2RPhi, chi2Z);
-  par[3] = par[3]*par[0]/fabs(par[0]);
+  // fast helix fit and cuts of the triplet, the chi2 is weighted by a factor for both rphi and z
+  float Chi2;
+  int failedCut = fitTriplet(fitter, _tripletCuts, xh, yh, zh, wrh, wzh, par, epar, Chi2);
 
   // get helix parameters
   float omega = par[0];
@@ -1189,9 +1393,7 @@ TrackExtended * SiliconTrackingAlg::TestTriplet(TrackerHitExtended * outerHit,
   float d0 = par[3];
   float z0 = par[4];
 
-  // chi2 is weighted here by a factor for both rphi and z
-  float Chi2 = chi2RPhi*_chi2WRPhiTriplet+chi2Z*_chi2WZTriplet;
-  int ndf = 2*NPT-5;
+  int ndf = 2*3-5;
 
   
   // check the truth information for the triplet
@@ -1371,24 +1573,24 @@ TrackExtended * SiliconTrackingAlg::TestTriplet(TrackerHitExtended * outerHit,
 
   int quality_code = triplet_code * 10 ;
 
-  if ( Chi2/float(ndf) > _chi2FitCut ) {
-    debug() << "Chi2/ndf = " << Chi2/float(ndf) << " , cut = " << _chi2FitCut << endmsg;
+  if ( failedCut == 1 ) {
+    if (debugOn) debug() << "Chi2/ndf = " << Chi2/float(ndf) << " , cut = " << _chi2FitCut << endmsg;
     failed = true;
     quality_code += 1;
-  } else if (fabs(d0) > _cutOnD0 ) {
-    debug() << "d0 = " << d0 << " , cut = " << _cutOnD0  << endmsg;
+  } else if ( failedCut == 2 ) {
+    if (debugOn) debug() << "d0 = " << d0 << " , cut = " << _cutOnD0  << endmsg;
     failed = true;
     quality_code += 2;
-  } else if (fabs(z0) > _cutOnZ0 ) {
-    debug() << "z0 = " << z0 << " , cut = " << _cutOnZ0  << endmsg;
+  } else if ( failedCut == 3 ) {
+    if (debugOn) debug() << "z0 = " << z0 << " , cut = " << _cutOnZ0  << endmsg;
     failed = true;
     quality_code += 3;
-  } else if ( fabs(omega)>_cutOnOmega)  {
-    debug() << "omega = " << omega << " , cut = " << _cutOnOmega << endmsg;
+  } else if ( failedCut == 4 )  {
+    if (debugOn) debug() << "omega = " << omega << " , cut = " << _cutOnOmega << endmsg;
     failed = true;
     quality_code += 4;
   } else {
-    debug() << "Success !!!!!!!" << endmsg;
+    if (debugOn) debug() << "Success !!!!!!!" << endmsg;
   }
   /*
   if (_createDiagnosticsHistograms) _histos->fill1D(DiagnosticsHistograms::htriplets, quality_code);
@@ -1410,9 +1612,6 @@ TrackExtended * SiliconTrackingAlg::TestTriplet(TrackerHitExtended * outerHit,
   trackAR->addTrackerHitExtended(outerHit);
   trackAR->addTrackerHitExtended(middleHit);
   trackAR->addTrackerHitExtended(innerHit);
-  outerHit->addTrackExtended(trackAR);
-  middleHit->addTrackExtended(trackAR);
-  innerHit->addTrackExtended(trackAR);    
   trackAR->setD0(d0);
   trackAR->setZ0(z0);
   trackAR->setPhi(phi0);
@@ -1434,7 +1633,8 @@ int SiliconTrackingAlg::BuildTrack(TrackerHitExtended * outerHit,
                                           int innerLayer,
                                           int iPhiLow, int iPhiUp,
                                           int iThetaLow, int iThetaUp, 
-                                          TrackExtended * trackAR) {
+                                          TrackExtended * trackAR,
+                                          MarlinTrk::HelixFit & fitter, bool debugOn) {
   /**
    Method for building up track in the VXD. Method starts from the found triplet and performs
    sequential attachment of hits in other layers, which have hits within the search window.
@@ -1442,10 +1642,12 @@ int SiliconTrackingAlg::BuildTrack(TrackerHitExtended * outerHit,
    Given that we know we are now jumping over layers due to the doublet nature of the VXD, we 
    could optimise this to look for the hits in interleaving layers as well. 
    Currently a fast fit is being done for each additional hit, it could be more efficient to try and use kaltest?
+   The hits are not modified: the track is attached to them when it is accepted in MergeSectorTriplets.
+   Only uses the message stream if debugOn is set.
    
    */
   
-  debug() << " BuildTrack starting " << endmsg;
+  if (debugOn) debug() << " BuildTrack starting " << endmsg;
   
   for (int layer = innerLayer-1; layer>=0; layer--) { // loop over remaining layers
     float distMin = 1.0e+20;
@@ -1464,9 +1666,9 @@ int SiliconTrackingAlg::BuildTrack(TrackerHitExtended * outerHit,
         int iCode = layer + _nLayers*iPhiInner +  _nLayers*_nDivisionsInPhi*itInner;
         
         // get the hits from this bin
-        TrackerHitExtendedVec& hitVecInner = _sectors[iCode];
+        TrackerHitExtended * const * hitVecInner = sectorHits(iCode);
         
-        int nHitsInner = int(hitVecInner.size());
+        int nHitsInner = nSectorHits(iCode);
         
         // loop over hits in the Inner sector
         for (int iInner=0;iInner<nHitsInner;iInner++) { 
@@ -1543,7 +1745,7 @@ int SiliconTrackingAlg::BuildTrack(TrackerHitExtended * outerHit,
       
       //debug() << "######## number of hits to fit with _fastfitter = " << NPT << endmsg; 
       
-      _fastfitter->fastHelixFit(NPT, xh, yh, rh, ph, wrh, zh, wzh,iopt, par, epar, chi2RPhi, chi2Z);
+      fitter.fastHelixFit(NPT, xh, yh, rh, ph, wrh, zh, wzh,iopt, par, epar, chi2RPhi, chi2Z);
       par[3] = par[3]*par[0]/fabs(par[0]);
       
       
@@ -1570,9 +1772,8 @@ int SiliconTrackingAlg::BuildTrack(TrackerHitExtended * outerHit,
       validCombination = Chi2/float(ndf) < _chi2FitCut;
       
       if ( validCombination ) {
-        // assign hit to track and track to hit, update the track parameters
+        // assign hit to track, update the track parameters
         trackAR->addTrackerHitExtended(assignedhit);
-        assignedhit->addTrackExtended(trackAR);
         float omega = par[0];
         float tanlambda = par[1];
         float phi0 = par[2];
@@ -1593,7 +1794,7 @@ int SiliconTrackingAlg::BuildTrack(TrackerHitExtended * outerHit,
   } // endloop over remaining layers
   TrackerHitExtendedVec& hvec = trackAR->getTrackerHitExtendedVec();  
   int nTotalHits = int(hvec.size());
-  debug() << "######## number of hits to return = " << nTotalHits << endmsg; 
+  if (debugOn) debug() << "######## number of hits to return = " << nTotalHits << endmsg; 
   return nTotalHits;
 }
 
@@ -1871,8 +2072,8 @@ void SiliconTrackingAlg::AttachRemainingVTXHitsFast() {
     for (int ip=0;ip<_nDivisionsInPhi;++ip) {
       for (int it=0;it<_nDivisionsInTheta; ++it) {
         int iCode = il + _nLayers*ip + _nLayers*_nDivisionsInPhi*it;      
-        TrackerHitExtendedVec& hitVec = _sectors[iCode];
-        int nH = int(hitVec.size());
+        TrackerHitExtended * const * hitVec = sectorHits(iCode);
+        int nH = nSectorHits(iCode);
         for (int iH=0; iH<nH; ++iH) {
           TrackerHitExtended * hitExt = hitVec[iH];
           TrackExtendedVec& trackVec = hitExt->getTrackExtendedVec();
@@ -2004,8 +2205,8 @@ void SiliconTrackingAlg::AttachRemainingVTXHitsSlow() {
     for (int ip=0;ip<_nDivisionsInPhi;++ip) {
       for (int it=0;it<_nDivisionsInTheta; ++it) {
         int iCode = il + _nLayers*ip + _nLayers*_nDivisionsInPhi*it;      
-        TrackerHitExtendedVec& hitVec = _sectors[iCode];
-        int nH = int(hitVec.size());
+        TrackerHitExtended * const * hitVec = sectorHits(iCode);
+        int nH = nSectorHits(iCode);
         for (int iH=0; iH<nH; ++iH) {
           TrackerHitExtended * hit = hitVec[iH];
           TrackExtendedVec& trackVec = hit->getTrackExtendedVec();
@@ -15,6 +15,7 @@
 //#include "lcio.h"
 #include <string>
 #include <vector>
+#include <map>
 #include <cmath>
 //#include <IMPL/TrackImpl.h>
 #include "DataHelper/ClusterExtended.h"
@@ -23,6 +24,8 @@
 #include "DataHelper/HelixClass.h"
 
 #include "TrackSystemSvc/IMarlinTrack.h"
+#include "TrackSystemSvc/HelixFit.h"
+#include "TripletPrefilter.h"
 
 #include <UTIL/BitField64.h>
 #include <UTIL/ILDConf.h>
@@ -181,6 +184,13 @@ class HelixClass;
  * @param UseSIT When this flag is set to 1, SIT is included in pattern recognition. When this flag is set
  * to 0, SIT is excluded from the procedure of pattern recognition <br>
  * (default value is 1) <br>
+ * @param NumberOfThreads number of threads processing the VXD+SIT sectors, 0 means the hardware concurrency.
+ * The track candidates are merged in the order of the sectors, so the result does not depend on it <br>
+ * (default value is 1) <br>
+ * @param PrefilterTriplets if set, the VXD+SIT triplets are only fitted if the circle through the three hits and 
+ * the straight line in s-z, computed as in the fast helix fit, pass the cuts on omega, d0, z0 and chi2 (with a margin of 10%).
+ * The triplets accepted by the fit are unchanged (TestTripletPrefilter) <br>
+ * (default value is true) <br>
  * <br>
  * @author A. Raspereza (MPI Munich)<br>
  */
@@ -252,6 +262,8 @@ class SiliconTrackingAlg : public GaudiAlgorithm {
   Gaudi::Property<bool> _ElossOn{this, "EnergyLossOn", true};
   Gaudi::Property<bool> _SmoothOn{this, "SmoothOn", true};
   Gaudi::Property<float> _helix_max_r{this, "HelixMaxR", 2000.};
+  Gaudi::Property<int> _nThreads{this, "NumberOfThreads", 1};
+  Gaudi::Property<bool> _prefilterTriplets{this, "PrefilterTriplets", true};
   
   //std::vector<int> _colours;  
   
@@ -298,9 +310,28 @@ class SiliconTrackingAlg : public GaudiAlgorithm {
   DataHandle<edm4hep::TrackCollection> _outColHdl{"SiTracks", Gaudi::DataHandle::Writer, this};
   //DataHandle<edm4hep::LCRelationCollection> _outRelColHdl{"TrackerHitRelations", Gaudi::DataHandle::Reader, this};
   
-  std::vector<TrackerHitExtendedVec> _sectors;
+  /// VXD+SIT hits sorted by sector, rebuilt every event by a counting sort: the hits of the 
+  /// sector iCode = layer + nLayers*iPhi + nLayers*nPhi*iTheta are at [_sectorOffsets[iCode], _sectorOffsets[iCode+1])
+  /// of _sectorHitVec, in the order of the input collections
+  std::vector<int> _sectorOffsets;
+  TrackerHitExtendedVec _sectorHitVec;
+  /// storage of the TrackerHitExtended of the VXD+SIT hits and their sector, its capacity is kept between events
+  std::vector<TrackerHitExtended> _sectorHitArena;
+  std::vector<int> _sectorHitCodes;
+  
+  TrackerHitExtended * const * sectorHits(int iCode) const { return _sectorHitVec.data() + _sectorOffsets[iCode]; }
+  int nSectorHits(int iCode) const { return _sectorOffsets[iCode+1] - _sectorOffsets[iCode]; }
+  
   std::vector<TrackerHitExtendedVec> _sectorsFTD;
   
+  /// Coordinates of the VXD+SIT hits for the triplet prefilter, in the order of _sectorHitVec
+  TripletHitArrays _sectorHits;
+  /// Cuts of FitTriplet
+  TripletCuts _tripletCuts;
+  
+  long long _nTripletsFitted;   // VXD+SIT triplets fitted in all events
+  long long _nTripletsRejected; // VXD+SIT triplets rejected by the prefilter in all events
+  
   /**
    * A helper class to allow good code readability by accessing tracks with N hits.
    * As the smalest valid track contains three hits, but the first index in a vector is 0,
@@ -338,15 +369,55 @@ class SiliconTrackingAlg : public GaudiAlgorithm {
   
   TracksWithNHitsContainer _tracksWithNHitsContainer;
   
+  /// Triplet found in a VXD+SIT sector with the track built from it.
+  /// The track is NULL if the triplet is contained in an earlier track of the same sector;
+  /// it is then only fitted when the sector is merged, if that track was rejected.
+  struct SectorTriplet {
+    TrackerHitExtended * outerHit;
+    TrackerHitExtended * middleHit;
+    TrackerHitExtended * innerHit;
+    int innerLayer;
+    int iPhiLow, iPhiUp, iThetaLow, iThetaUp; // bins of the inner layers searched by BuildTrack
+    TrackExtended * track;
+    int nHits;
+  };
+  typedef std::vector<SectorTriplet> SectorTripletVec;
+  
+  /// Working context of a thread processing sectors
+  struct SectorContext {
+    MarlinTrk::HelixFit fitter;
+    bool useAssignedTracks; // check the tracks attached to the hits, only if the sectors are processed sequentially
+    bool debugOn;           // the message stream may only be used by a single thread
+    int nTriplets;          // number of triplets fitted
+    int nRejected;          // number of triplets rejected by the prefilter
+    std::vector<char> pass; // prefilter result for the hits of the inner sector
+    std::map<TrackerHitExtended*, std::vector<int> > sectorTracks; // hit -> index of the triplets of the current sector with a track containing it
+  };
+  
   int InitialiseVTX();
   int InitialiseFTD();
-  void ProcessOneSector(int iSectorPhi, int iSectorTheta);
+  void SortSectorHits();
+  void ProcessSectors(int nThreads);
+  void ProcessOneSector(int iPhi, int iTheta, SectorContext & context, SectorTripletVec & triplets);
+  void MergeSectorTriplets(SectorTripletVec & triplets);
   void CleanUp();
   TrackExtended * TestTriplet(TrackerHitExtended * outerHit, 
                               TrackerHitExtended * middleHit,
                               TrackerHitExtended * innerHit,
                               HelixClass & helix);
   
+  bool TripletIsAssigned(TrackerHitExtended * outerHit, 
+                         TrackerHitExtended * middleHit,
+                         TrackerHitExtended * innerHit);
+  
+  TrackExtended * FitTriplet(TrackerHitExtended * outerHit, 
+                             TrackerHitExtended * middleHit,
+                             TrackerHitExtended * innerHit,
+                             HelixClass & helix,
+                             MarlinTrk::HelixFit & fitter, bool debugOn);
+  
+  bool BuildSectorTriplet(SectorTriplet & triplet, MarlinTrk::HelixFit & fitter, bool debugOn);
+  
   int BuildTrack(TrackerHitExtended * outerHit, 
                  TrackerHitExtended * middleHit,
                  TrackerHitExtended * innerHit,
@@ -354,7 +425,8 @@ class SiliconTrackingAlg : public GaudiAlgorithm {
                  int innerlayer,
                  int iPhiLow, int iPhiUp,
                  int iTheta, int iThetaUp,
-                 TrackExtended * trackAR);
+                 TrackExtended * trackAR,
+                 MarlinTrk::HelixFit & fitter, bool debugOn);
   
   void Sorting( TrackExtendedVec & trackVec);
   void CreateTrack(TrackExtended * trackAR );
@@ -178,7 +178,8 @@ StatusCode TrackSubsetAlg::execute(){
   //SubsetSimple<edm4hep::Track* > subset;
   subset.add( tracks_p );
   subset.setOmega( _omega );
-  subset.calculateBestSet( comp, trackQI );
+  subset.setNumberOfThreads( _nThreads );
+  subset.calculateBestSet( comp, trackQI, TrackHits() );
 
   auto accepted = subset.getAccepted();
   auto rejected = subset.getRejected();
@@ -38,6 +38,9 @@
  * @param Omega The parameter omega for the HNN. Controls the influence of the quality indicator. Between 0 and 1:
  * 1 means high influence of quality indicator, 0 means no influence. 
  * 
+ * @param NumberOfThreads number of threads iterating the groups of overlapping tracks of the HNN,
+ * 0 means the hardware concurrency. The groups are coupled through the sum of their states as in a single network.
+ * 
  * @author Robin Glattauer, HEPHY
  * 
  */
@@ -74,6 +77,7 @@ class TrackSubsetAlg : public GaudiAlgorithm {
   Gaudi::Property<float> _initialTrackError_tanL{this, "InitialTrackErrorTanL",1e2};
   Gaudi::Property<double> _maxChi2PerHit{this, "MaxChi2PerHit", 1e2};
   Gaudi::Property<double> _omega{this, "Omega", 0.75};
+  Gaudi::Property<int> _nThreads{this, "NumberOfThreads", 1};
   
   float _bField;
   
@@ -98,6 +102,14 @@ class TrackCompatibility{
 };
 
 
+/** A functor to return the hits of a track: only tracks sharing a hit need to be checked with TrackCompatibility */
+class TrackHits{
+ public:
+  inline std::vector<edm4hep::TrackerHit> operator()( edm4hep::Track* track ){
+    return std::vector<edm4hep::TrackerHit>( track->trackerHits_begin(), track->trackerHits_end() );
+  }
+};
+
 /** A functor to return the quality of a track, which is currently the chi2 probability. */
 class TrackQI{
  public:
@@ -0,0 +1,180 @@
+#ifndef SILICONTRACKING_TRIPLETPREFILTER
+#define SILICONTRACKING_TRIPLETPREFILTER
+
+#include "TrackSystemSvc/HelixFit.h"
+
+#include <cmath>
+#include <vector>
+
+/** Cuts of SiliconTrackingAlg on the fast helix fit of a VXD+SIT triplet.
+ */
+struct TripletCuts {
+  float chi2FitCut; // on (chi2RPhi*chi2WRPhi + chi2Z*chi2WZ)/ndf
+  float chi2WRPhi;
+  float chi2WZ;
+  float omega;
+  float d0;
+  float z0;
+
+  /// 0 if the fit passes the cuts, otherwise the first failed cut: 1 chi2/ndf, 2 d0, 3 z0, 4 omega
+  int failed(float chi2OverNDF, float d0Fit, float z0Fit, float omegaFit) const {
+    if ( chi2OverNDF > chi2FitCut ) return 1;
+    if ( fabs(d0Fit) > d0 ) return 2;
+    if ( fabs(z0Fit) > z0 ) return 3;
+    if ( fabs(omegaFit) > omega ) return 4;
+    return 0;
+  }
+};
+
+/** Fast helix fit of three hits as in SiliconTrackingAlg::FitTriplet.
+ *  Fills par (omega, tanLambda, phi0, d0, z0), epar and the weighted chi2 (ndf = 1)
+ *  and returns the failed cut as TripletCuts::failed.
+ */
+inline int fitTriplet(MarlinTrk::HelixFit & fitter, const TripletCuts & cuts,
+                      const double x[3], const double y[3], const float z[3], const double wrphi[3], const float wz[3],
+                      float par[5], float epar[15], float & chi2) {
+
+  double xh[3], yh[3], wrh[3];
+  float zh[3], wzh[3], rh[3], ph[3];
+
+  for (int ih=0; ih<3; ih++) {
+    xh[ih] = x[ih];
+    yh[ih] = y[ih];
+    zh[ih] = z[ih];
+    wrh[ih] = wrphi[ih];
+    wzh[ih] = wz[ih];
+    rh[ih] = float(sqrt(xh[ih]*xh[ih]+yh[ih]*yh[ih]));
+    ph[ih] = atan2(yh[ih],xh[ih]);
+    if (ph[ih] < 0.)
+      ph[ih] = 2*M_PI + ph[ih];
+  }
+
+  int NPT = 3;
+  int iopt = 2;
+  float chi2RPhi;
+  float chi2Z;
+
+  fitter.fastHelixFit(NPT, xh, yh, rh, ph, wrh, zh, wzh, iopt, par, epar, chi2RPhi, chi2Z);
+  par[3] = par[3]*par[0]/fabs(par[0]);
+
+  // chi2 is weighted here by a factor for both rphi and z
+  chi2 = chi2RPhi*cuts.chi2WRPhi + chi2Z*cuts.chi2WZ;
+  int ndf = 2*NPT-5;
+
+  return cuts.failed(chi2/float(ndf), par[3], par[4], par[0]);
+}
+
+/** Coordinates of hits as given to the fast helix fit, for prefilterTriplets().
+ */
+struct TripletHitArrays {
+  std::vector<double> x, y;
+  std::vector<float>  z, r, wz;
+
+  void resize(unsigned n) {
+    x.resize(n);
+    y.resize(n);
+    z.resize(n);
+    r.resize(n);
+    wz.resize(n);
+  }
+
+  void set(unsigned i, double xHit, double yHit, double zHit, float resolutionZ) {
+    x[i]  = xHit;
+    y[i]  = yHit;
+    z[i]  = float(zHit);
+    r[i]  = float(sqrt(xHit*xHit+yHit*yHit));
+    wz[i] = 1.0/(resolutionZ*resolutionZ);
+  }
+};
+
+/** Sets pass[i] for the hits iInnerBegin+i, which may form a triplet with the outer and middle hit.
+ *  The circle through the three hits is the one of the fast helix fit and the arc lengths, the straight
+ *  line in s-z and its chi2 are computed as in HelixFit, from the same float values. A triplet is only
+ *  rejected if omega, d0, z0 or the chi2 in s-z (a lower bound of the chi2 of the fit) exceeds the cuts
+ *  of fitTriplet() by more than 10%. The z part is skipped when it depends strongly on rounding:
+ *  a hit close to the point of closest approach or a circle centred close to the origin.
+ *  The triplets accepted by fitTriplet() must all pass (TestTripletPrefilter).
+ */
+inline void prefilterTriplets(const TripletHitArrays & hits, const TripletCuts & cuts,
+                              int iOuter, int iMiddle, int iInnerBegin, int iInnerEnd, char * pass) {
+
+  const double margin = 1.1;
+  const double chi2ZCut = cuts.chi2WZ > 0 && cuts.chi2WRPhi >= 0 ? margin*cuts.chi2FitCut/cuts.chi2WZ : HUGE_VAL;
+  const double omegaCut = margin*cuts.omega;
+  const double d0Cut = margin*cuts.d0;
+  const double z0Cut = margin*cuts.z0;
+
+  const double * x  = &hits.x[0];
+  const double * y  = &hits.y[0];
+  const float  * z  = &hits.z[0];
+  const float  * r  = &hits.r[0];
+  const float  * wz = &hits.wz[0];
+
+  const double xA = x[iOuter],  yA = y[iOuter];
+  const double bx = x[iMiddle]-xA, by = y[iMiddle]-yA;
+  const double b2 = bx*bx + by*by;
+
+  for (int i=iInnerBegin; i<iInnerEnd; ++i) {
+
+    // circle through the three hits, relative to the outer hit
+    double cx = x[i]-xA, cy = y[i]-yA;
+    double c2 = cx*cx + cy*cy;
+    double d  = 2.0*(bx*cy - by*cx);
+    double ux = (cy*b2 - by*c2)/d;
+    double uy = (bx*c2 - cx*b2)/d;
+    double radius = sqrt(ux*ux + uy*uy);
+    double xc = xA + ux, yc = yA + uy;
+    double dist = sqrt(xc*xc + yc*yc);   // distance of the centre to the origin
+
+    // as in HelixFit: omega includes the offset of the fit, d0 = (1-dist/radius)/omega
+    double omega = 1.0/radius + 0.0000000001;
+    double d0 = (1.0 - dist/radius)/omega;
+
+    // arc lengths from the point of closest approach, with the values rounded to float as in HelixFit
+    float omegaF = float(omega);
+    float d0F = float(d0);
+    double den = 1.0 - double(omegaF)*double(d0F);
+
+    const int ih[3] = { iOuter, iMiddle, i };
+    double s[3];
+    bool nearPCA = false;
+    for (int k=0; k<3; ++k) {
+      float rk = r[ih[k]];
+      float r2 = rk*rk - d0F*d0F;
+      nearPCA = nearPCA || fabs(r2) < 0.01f*rk*rk;
+      double e = 0.5*omegaF*sqrt(fabs(r2/den));
+      e = e > 0.99990 ? 0.99990 : e;
+      s[k] = 2.0*asin(e)/omega;
+    }
+
+    // straight line fit in s-z
+    double sumw = 0., sums = 0., sumss = 0., sumz = 0., sumsz = 0.;
+    for (int k=0; k<3; ++k) {
+      double w = wz[ih[k]];
+      sumw  += w;
+      sums  += s[k]*w;
+      sumss += s[k]*s[k]*w;
+      sumz  += z[ih[k]]*w;
+      sumsz += z[ih[k]]*s[k]*w;
+    }
+    double denom = sumw*sumss - sums*sums;
+    double dzds  = (sumw*sumsz - sums*sumz)/denom;
+    double z0    = (sumss*sumz - sums*sumsz)/denom;
+    double chi2Z = 0.;
+    for (int k=0; k<3; ++k) {
+      double dz = z0 + dzds*s[k] - z[ih[k]];
+      chi2Z += wz[ih[k]]*dz*dz;
+    }
+
+    // collinear hits give no circle: leave the decision to the fit
+    bool circle = std::isfinite(omega) && std::isfinite(d0);
+    bool lineSZ = circle && !nearPCA && fabs(den) > 1.0e-3 && std::isfinite(chi2Z) && std::isfinite(z0);
+
+    bool reject = ( circle && ( omega > omegaCut || fabs(d0) > d0Cut ) )
+      || ( lineSZ && ( chi2Z > chi2ZCut || fabs(z0) > z0Cut ) );
+
+    pass[i-iInnerBegin] = !reject;
+  }
+}
+
+#endif
@@ -0,0 +1,260 @@
+// The VXD+SIT sectors of SiliconTrackingAlg processed by several threads must give the same track candidates
+// as the sequential loop over the sectors: the same tracks, with the same hits, parameters, chi2 and
+// covariance, in the same order, and the same tracks attached to the hits. The toy events have few
+// divisions in phi and theta and tracks that cross them: helices from the IP and displaced ones, low pt
+// tracks, straight tracks and noise hits, so that the triplets of a track are found in several sectors.
+
+#include "SiliconTrackingAlg.h"
+
+#include "GaudiKernel/Bootstrap.h"
+#include "GaudiKernel/IAppMgrUI.h"
+#include "GaudiKernel/IProperty.h"
+#include "GaudiKernel/ISvcLocator.h"
+#include "GaudiKernel/SmartIF.h"
+
+#include "edm4hep/MutableTrackerHit.h"
+
+#include <climits>
+#include <cmath>
+#include <iostream>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+  int nFailed = 0;
+
+  void expect(bool ok, const std::string& what) {
+    if (ok) return;
+    ++nFailed;
+    std::cout << "FAILED: " << what << std::endl;
+  }
+
+  // VXD (double layers) and SIT, mm: the layers 0 to 8 of the default LayerCombinations
+  const std::vector<double> layerRadius = {16., 18., 37., 39., 58., 60., 152.9, 300.9, 449.9};
+  const std::vector<float> resolutionRPhi = {0.0028f, 0.0028f, 0.006f, 0.006f, 0.004f, 0.004f, 0.0072f, 0.0072f, 0.0072f};
+  const std::vector<float> resolutionZ = {0.0028f, 0.0028f, 0.006f, 0.006f, 0.004f, 0.004f, 0.086f, 0.086f, 0.086f};
+
+  const double bField = 3.0; // T
+
+  struct Hit {
+    int layer;
+    double x, y, z;
+  };
+
+  // point of a helix at the radius r: centre (xc,yc), radius R, turning with sign q from the point of
+  // closest approach to the origin - false if the helix does not reach r
+  bool helixAtRadius(double xc, double yc, double R, int q, double z0, double tanLambda, double r,
+                     double& x, double& y, double& z) {
+    double D = sqrt(xc*xc + yc*yc);
+    if ( r < fabs(D - R) || r > D + R ) return false;
+    double a0 = atan2(-yc, -xc);
+    double lo = 0., hi = M_PI;
+    for (int it = 0; it < 100; ++it) {
+      double t = 0.5*(lo + hi);
+      double px = xc + R*cos(a0 + q*t), py = yc + R*sin(a0 + q*t);
+      if ( sqrt(px*px + py*py) < r ) lo = t;
+      else hi = t;
+    }
+    double t = 0.5*(lo + hi);
+    x = xc + R*cos(a0 + q*t);
+    y = yc + R*sin(a0 + q*t);
+    z = z0 + tanLambda*R*t;
+    return true;
+  }
+
+  std::vector<Hit> toyEvent(std::mt19937& gen, int nTracks, int nNoise) {
+    std::uniform_real_distribution<double> uni(0., 1.);
+    std::normal_distribution<double> gauss(0., 1.);
+    std::vector<Hit> hits;
+
+    for (int t = 0; t < nTracks; ++t) {
+      // from tracks curling through several phi sectors up to straight ones
+      double pt = 0.06*pow(10., 2.*uni(gen));
+      double R = pt/(0.3*bField)*1000.;
+      int q = uni(gen) < 0.5 ? 1 : -1;
+      double d0 = (uni(gen) < 0.8 ? 0.05 : 5.)*(2.*uni(gen) - 1.);
+      double z0 = (uni(gen) < 0.8 ? 0.1 : 20.)*(2.*uni(gen) - 1.);
+      double tanLambda = 2.*(2.*uni(gen) - 1.);
+      double beta = 2.*M_PI*uni(gen);
+      double xc = (R + d0)*cos(beta), yc = (R + d0)*sin(beta);
+
+      for (unsigned layer = 0; layer < layerRadius.size(); ++layer) {
+        double x, y, z;
+        if ( !helixAtRadius(xc, yc, R, q, z0, tanLambda, layerRadius[layer], x, y, z) || fabs(z) > 500. ) continue;
+        double r = layerRadius[layer];
+        double phi = atan2(y, x) + resolutionRPhi[layer]*gauss(gen)/r;
+        Hit hit = { int(layer), r*cos(phi), r*sin(phi), z + resolutionZ[layer]*gauss(gen) };
+        hits.push_back(hit);
+      }
+    }
+
+    for (int i = 0; i < nNoise; ++i) {
+      int layer = int(uni(gen)*layerRadius.size());
+      double phi = 2.*M_PI*uni(gen);
+      double r = layerRadius[layer];
+      Hit hit = { layer, r*cos(phi), r*sin(phi), 500.*(2.*uni(gen) - 1.) };
+      hits.push_back(hit);
+    }
+
+    return hits;
+  }
+
+  // a track candidate: the indices of its hits in the event and its parameters
+  struct Candidate {
+    std::vector<int> hits;
+    std::vector<float> parameters; // d0, z0, phi, tanLambda, omega, chi2, ndf and the covariance
+
+    // the covariance of a badly conditioned fit can contain NaN
+    bool operator==(const Candidate& other) const {
+      if (hits != other.hits || parameters.size() != other.parameters.size()) return false;
+      for (unsigned i = 0; i < parameters.size(); ++i)
+        if (parameters[i] != other.parameters[i] && !(std::isnan(parameters[i]) && std::isnan(other.parameters[i]))) return false;
+      return true;
+    }
+  };
+
+  struct Result {
+    std::vector<Candidate> candidates;              // in the order of the candidate container
+    std::vector< std::vector<int> > assignedTracks; // per hit: the candidates attached to it
+    long long nTripletsFitted;
+  };
+
+  // runs the VXD+SIT sectors of SiliconTrackingAlg on the hits of an event
+  class SectorTest : public SiliconTrackingAlg {
+  public:
+    SectorTest(ISvcLocator* svcLoc, int nDivisions) : SiliconTrackingAlg("SectorTest", svcLoc) {
+      // as in initialize(), with the geometry above
+      _nLayersVTX = 6;
+      _nLayersSIT = 3;
+      _nLayers = 9;
+      _nDivisionsInPhi = nDivisions;
+      _nDivisionsInTheta = nDivisions;
+      _tracksWithNHitsContainer.resize(_nHitsChi2);
+      _dPhi = TWOPI/_nDivisionsInPhi;
+      _dTheta = 2.0/_nDivisionsInTheta;
+      _bField = bField;
+      _cutOnOmega = 1./(1000.*_cutOnPt/(0.3*_bField));
+      TripletCuts tripletCuts = { _chi2FitCut, _chi2WRPhiTriplet, _chi2WZTriplet, _cutOnOmega, _cutOnD0, _cutOnZ0 };
+      _tripletCuts = tripletCuts;
+      _output_track_col_quality = 0;
+    }
+
+    ~SectorTest() {
+      _tracksWithNHitsContainer.clear();
+      // deleted in finalize()
+      delete _fastfitter;
+      delete _encoder;
+    }
+
+    void setPrefilter(bool prefilter) { _prefilterTriplets = prefilter; }
+
+    Result run(const std::vector<Hit>& hits, int nThreads) {
+      _tracksWithNHitsContainer.clear();
+      _sectorHitArena.clear();
+      _sectorHitCodes.clear();
+      _ntriplets = 0;
+
+      // as in InitialiseVTX()
+      for (const Hit& toy : hits) {
+        edm4hep::MutableTrackerHit hit;
+        hit.setPosition({ toy.x, toy.y, toy.z });
+        _sectorHitArena.push_back(TrackerHitExtended(hit));
+        TrackerHitExtended& hitExt = _sectorHitArena.back();
+        hitExt.setResolutionRPhi(resolutionRPhi[toy.layer]);
+        hitExt.setResolutionZ(resolutionZ[toy.layer]);
+        hitExt.setType(int(INT_MAX));
+        hitExt.setDet(int(INT_MAX));
+
+        double radius = sqrt(toy.x*toy.x + toy.y*toy.y + toy.z*toy.z);
+        double cosTheta = toy.z/radius;
+        double Phi = atan2(toy.y, toy.x);
+        if (Phi < 0.) Phi = Phi + TWOPI;
+        int iPhi = int(Phi/_dPhi);
+        int iTheta = int((cosTheta + double(1.0))/_dTheta);
+        _sectorHitCodes.push_back(toy.layer + _nLayers*iPhi + _nLayers*_nDivisionsInPhi*iTheta);
+      }
+      SortSectorHits();
+
+      ProcessSectors(nThreads);
+
+      Result result;
+      result.nTripletsFitted = _ntriplets;
+      std::map<TrackExtended*, int> index;
+      for (int nHits = 3; nHits <= _nHitsChi2; ++nHits) {
+        TrackExtendedVec& tracks = _tracksWithNHitsContainer.getTracksWithNHitsVec(nHits);
+        for (TrackExtended* track : tracks) {
+          Candidate candidate;
+          for (TrackerHitExtended* hit : track->getTrackerHitExtendedVec()) candidate.hits.push_back(int(hit - &_sectorHitArena[0]));
+          candidate.parameters = { track->getD0(), track->getZ0(), track->getPhi(), track->getTanLambda(), track->getOmega(),
+                                   track->getChi2(), float(track->getNDF()) };
+          candidate.parameters.insert(candidate.parameters.end(), track->getCovMatrix(), track->getCovMatrix() + 15);
+          index[track] = int(result.candidates.size());
+          result.candidates.push_back(candidate);
+        }
+      }
+      for (TrackerHitExtended& hit : _sectorHitArena) {
+        std::vector<int> assigned;
+        for (TrackExtended* track : hit.getTrackExtendedVec()) assigned.push_back(index.count(track) ? index[track] : -1);
+        result.assignedTracks.push_back(assigned);
+      }
+      return result;
+    }
+  };
+
+  void compare(const Result& serial, const Result& parallel, const std::string& what) {
+    unsigned nDifferent = 0;
+    for (unsigned i = 0; i < serial.candidates.size() && i < parallel.candidates.size(); ++i)
+      nDifferent += !(serial.candidates[i] == parallel.candidates[i]);
+    expect(serial.candidates.size() == parallel.candidates.size(), what + ": " + std::to_string(parallel.candidates.size()) +
+           " track candidates instead of " + std::to_string(serial.candidates.size()));
+    expect(nDifferent == 0, what + ": " + std::to_string(nDifferent) + " different track candidates");
+    expect(serial.assignedTracks == parallel.assignedTracks, what + ": different tracks attached to the hits");
+  }
+
+  void testEvents(SectorTest& alg, int nEvents, int nTracks, int nNoise, const std::string& what) {
+    std::mt19937 gen(4242);
+    long long nCandidates = 0, nTripletsSerial = 0, nTripletsParallel = 0;
+    for (int event = 0; event < nEvents; ++event) {
+      std::vector<Hit> hits = toyEvent(gen, nTracks, nNoise);
+      Result serial = alg.run(hits, 1);
+      nCandidates += serial.candidates.size();
+      nTripletsSerial += serial.nTripletsFitted;
+      for (int nThreads : { 2, 3, 8 }) {
+        Result parallel = alg.run(hits, nThreads);
+        compare(serial, parallel, what + " event " + std::to_string(event) + ", " + std::to_string(nThreads) + " threads");
+        if (nThreads == 8) nTripletsParallel += parallel.nTripletsFitted;
+      }
+    }
+
+    std::cout << what << ": " << nCandidates << " track candidates, " << nTripletsSerial << " triplets fitted with one thread, "
+              << nTripletsParallel << " with 8 threads" << std::endl;
+
+    expect(nCandidates > nEvents*nTracks/2, what + ": too few track candidates to be a test");
+  }
+}
+
+int main() {
+  SmartIF<IProperty> propMgr(Gaudi::createApplicationMgr());
+  SmartIF<IAppMgrUI> appMgr(propMgr);
+  propMgr->setProperty("JobOptionsType", "NONE").ignore();
+  appMgr->configure().ignore();
+
+  for (int nDivisions : { 4, 12 }) {
+    SectorTest alg(Gaudi::svcLocator(), nDivisions);
+    const std::string divisions = std::to_string(nDivisions) + "x" + std::to_string(nDivisions) + " sectors";
+    testEvents(alg, 4, 20, 40, divisions);
+    testEvents(alg, 2, 80, 200, divisions + ", dense events");
+    alg.setPrefilter(false);
+    testEvents(alg, 2, 20, 40, divisions + ", no prefilter");
+  }
+
+  if (nFailed) {
+    std::cout << "FAILED: " << nFailed << " checks" << std::endl;
+    return 1;
+  }
+  std::cout << "OK" << std::endl;
+  return 0;
+}
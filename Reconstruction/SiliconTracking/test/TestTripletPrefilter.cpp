@@ -0,0 +1,212 @@
+// The triplet prefilter of SiliconTrackingAlg must not reject a VXD+SIT triplet that the fast helix
+// fit of FitTriplet accepts. All triplets of hits in three different layers of toy events are tested:
+// helices from the IP and displaced ones with omega, d0, z0 and the chi2 around the cuts, straight
+// tracks (collinear hits), noise hits and hits at the same phi. The prefilter has to reject a good
+// part of the triplets to be of use.
+
+#include "TripletPrefilter.h"
+
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+  int nFailed = 0;
+
+  void expect(bool ok, const std::string& what) {
+    if (ok) return;
+    ++nFailed;
+    std::cout << "FAILED: " << what << std::endl;
+  }
+
+  // VXD (double layers) and SIT, mm
+  const std::vector<double> layerRadius = {16., 18., 37., 39., 58., 60., 152.9, 300.9};
+  const std::vector<float> resolutionRPhi = {0.0028f, 0.0028f, 0.006f, 0.006f, 0.004f, 0.004f, 0.0072f, 0.0072f};
+  const std::vector<float> resolutionZ = {0.0028f, 0.0028f, 0.006f, 0.006f, 0.004f, 0.004f, 0.086f, 0.086f};
+
+  const double bField = 3.0; // T
+
+  struct Hit {
+    int layer;
+    double x, y, z;
+  };
+
+  // point of a helix at the radius r: centre (xc,yc), radius R, turning with sign q from the point of
+  // closest approach to the origin - false if the helix does not reach r
+  bool helixAtRadius(double xc, double yc, double R, int q, double z0, double tanLambda, double r,
+                     double& x, double& y, double& z) {
+    double D = sqrt(xc*xc + yc*yc);
+    if ( r < fabs(D - R) || r > D + R ) return false;
+    double a0 = atan2(-yc, -xc);
+    // the distance to the origin grows from |D-R| to D+R over half a turn
+    double lo = 0., hi = M_PI;
+    for (int it = 0; it < 100; ++it) {
+      double t = 0.5*(lo + hi);
+      double px = xc + R*cos(a0 + q*t), py = yc + R*sin(a0 + q*t);
+      if ( sqrt(px*px + py*py) < r ) lo = t;
+      else hi = t;
+    }
+    double t = 0.5*(lo + hi);
+    x = xc + R*cos(a0 + q*t);
+    y = yc + R*sin(a0 + q*t);
+    z = z0 + tanLambda*R*t;
+    return true;
+  }
+
+  // smears the hit in r-phi and z by 'scale' times the resolution
+  void addHit(std::vector<Hit>& hits, std::mt19937& gen, int layer, double x, double y, double z, double scale) {
+    std::normal_distribution<double> gauss(0., 1.);
+    double r = sqrt(x*x + y*y);
+    double phi = atan2(y, x) + scale*resolutionRPhi[layer]*gauss(gen)/r;
+    Hit hit = { layer, r*cos(phi), r*sin(phi), z + scale*resolutionZ[layer]*gauss(gen) };
+    hits.push_back(hit);
+  }
+
+  std::vector<Hit> toyEvent(std::mt19937& gen, int nTracks, int nNoise) {
+    std::uniform_real_distribution<double> uni(0., 1.);
+    std::vector<Hit> hits;
+
+    for (int t = 0; t < nTracks; ++t) {
+      // pt from below the cut of 0.05 GeV up to straight tracks
+      double pt = 0.03*pow(10., 3.*uni(gen));
+      double R = pt/(0.3*bField)*1000.;
+      int q = uni(gen) < 0.5 ? 1 : -1;
+      double d0 = (uni(gen) < 0.7 ? 0.05 : 20.)*(2.*uni(gen) - 1.);
+      double z0 = (uni(gen) < 0.7 ? 0.1 : 150.)*(2.*uni(gen) - 1.);
+      double tanLambda = 3.*(2.*uni(gen) - 1.);
+      double beta = 2.*M_PI*uni(gen);
+      double xc = (R + d0)*cos(beta), yc = (R + d0)*sin(beta);
+      // hits up to far outside of the resolution: the chi2 around the cut
+      double scale = pow(10., 3.*uni(gen) - 0.5);
+
+      for (unsigned layer = 0; layer < layerRadius.size(); ++layer) {
+        double x, y, z;
+        if ( helixAtRadius(xc, yc, R, q, z0, tanLambda, layerRadius[layer], x, y, z) && fabs(z) < 300. )
+          addHit(hits, gen, layer, x, y, z, scale);
+      }
+    }
+
+    // straight lines from the IP and from a displaced point
+    for (int t = 0; t < nTracks/4; ++t) {
+      double phi = 2.*M_PI*uni(gen);
+      double tanLambda = 2.*(2.*uni(gen) - 1.);
+      double x0 = t%2 ? 0. : 5.*uni(gen), z0 = t%2 ? 0. : 50.*uni(gen);
+      for (unsigned layer = 0; layer < layerRadius.size(); ++layer) {
+        double r = layerRadius[layer];
+        Hit hit = { int(layer), x0 + r*cos(phi), r*sin(phi), z0 + tanLambda*r };
+        hits.push_back(hit);
+      }
+    }
+
+    for (int i = 0; i < nNoise; ++i) {
+      int layer = int(uni(gen)*layerRadius.size());
+      double phi = 2.*M_PI*uni(gen);
+      double r = layerRadius[layer];
+      Hit hit = { layer, r*cos(phi), r*sin(phi), 300.*(2.*uni(gen) - 1.) };
+      hits.push_back(hit);
+    }
+
+    return hits;
+  }
+
+  struct Counts {
+    long long triplets = 0;
+    long long accepted = 0; // by the fit
+    long long rejected = 0; // by the prefilter
+    long long wrong = 0;    // accepted by the fit and rejected by the prefilter
+  };
+
+  void testEvent(const std::vector<Hit>& hits, const TripletCuts& cuts, Counts& counts, const std::string& what) {
+    const int nHits = hits.size();
+
+    TripletHitArrays arrays;
+    arrays.resize(nHits);
+    for (int i = 0; i < nHits; ++i)
+      arrays.set(i, hits[i].x, hits[i].y, hits[i].z, resolutionZ[hits[i].layer]);
+
+    MarlinTrk::HelixFit fitter;
+    std::vector<char> pass(nHits);
+    long long wrong = counts.wrong;
+
+    for (int iOuter = 0; iOuter < nHits; ++iOuter) {
+      for (int iMiddle = 0; iMiddle < nHits; ++iMiddle) {
+        if ( hits[iMiddle].layer >= hits[iOuter].layer ) continue;
+
+        prefilterTriplets(arrays, cuts, iOuter, iMiddle, 0, nHits, &pass[0]);
+
+        for (int iInner = 0; iInner < nHits; ++iInner) {
+          if ( hits[iInner].layer >= hits[iMiddle].layer ) continue;
+
+          const int ih[3] = { iOuter, iMiddle, iInner };
+          double x[3], y[3], wrphi[3];
+          float z[3], wz[3];
+          for (int k = 0; k < 3; ++k) {
+            const Hit& hit = hits[ih[k]];
+            x[k] = hit.x;
+            y[k] = hit.y;
+            z[k] = float(hit.z);
+            wrphi[k] = double(1.0/(resolutionRPhi[hit.layer]*resolutionRPhi[hit.layer]));
+            wz[k] = 1.0/(resolutionZ[hit.layer]*resolutionZ[hit.layer]);
+          }
+
+          float par[5], epar[15], chi2;
+          bool accepted = fitTriplet(fitter, cuts, x, y, z, wrphi, wz, par, epar, chi2) == 0;
+
+          ++counts.triplets;
+          counts.accepted += accepted;
+          counts.rejected += !pass[iInner];
+
+          if ( accepted && !pass[iInner] ) {
+            if ( ++counts.wrong <= 10 )
+              std::cout << what << ": accepted triplet rejected: layers " << hits[iOuter].layer << " "
+                        << hits[iMiddle].layer << " " << hits[iInner].layer << " omega " << par[0] << " d0 " << par[3]
+                        << " z0 " << par[4] << " chi2 " << chi2 << std::endl;
+          }
+        }
+      }
+    }
+
+    expect(counts.wrong == wrong, what + ": triplets accepted by the fit are rejected by the prefilter");
+  }
+
+  // minRejected: the fraction of the triplets that the prefilter has to reject
+  void testCuts(const TripletCuts& cuts, double minRejected, const std::string& what) {
+    std::mt19937 gen(12345);
+    Counts counts;
+    for (int event = 0; event < 4; ++event) {
+      std::vector<Hit> hits = toyEvent(gen, 16, 24);
+      testEvent(hits, cuts, counts, what + " event " + std::to_string(event));
+    }
+
+    std::cout << what << ": " << counts.triplets << " triplets, " << counts.accepted << " accepted by the fit, "
+              << counts.rejected << " rejected by the prefilter" << std::endl;
+
+    expect(counts.accepted > 500, what + ": too few accepted triplets to be a test");
+    expect(counts.rejected > minRejected*counts.triplets, what + ": the prefilter rejects too few triplets");
+  }
+}
+
+int main() {
+  // cuts of SiliconTrackingAlg: Chi2FitCut, Chi2WRphiTriplet, Chi2WZTriplet, omega of CutOnPt = 0.05 GeV, CutOnD0, CutOnZ0
+  const float omegaCut = 1./(0.05/(0.3*bField)*1000.);
+  TripletCuts defaultCuts = { 120.f, 1.f, 0.5f, omegaCut, 100.f, 100.f };
+  testCuts(defaultCuts, 0.9, "default cuts");
+
+  // tight cuts: all of them are close to the toy tracks
+  TripletCuts tightCuts = { 10.f, 1.f, 1.f, 4.f*omegaCut, 5.f, 5.f };
+  testCuts(tightCuts, 0.9, "tight cuts");
+
+  // no weight of the chi2 in z: no cut in s-z
+  TripletCuts noZCuts = { 120.f, 1.f, 0.f, omegaCut, 100.f, 100.f };
+  testCuts(noZCuts, 0.3, "chi2 without z");
+
+  if (nFailed) {
+    std::cout << "FAILED: " << nFailed << " checks" << std::endl;
+    return 1;
+  }
+  std::cout << "OK" << std::endl;
+  return 0;
+}
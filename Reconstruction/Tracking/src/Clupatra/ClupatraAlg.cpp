@@ -41,8 +41,6 @@
 #include "TrackSystemSvc/IMarlinTrkSystem.h"
 #include "TrackSystemSvc/MarlinTrkUtils.h"
 
-#include "RuntimeMap.h"
-
 #include "edm4hep/TrackerHitCollection.h"
 #include "edm4hep/TrackCollection.h"
 // #include "edm4hep/TrackerHitPlane.h"
@@ -62,12 +60,6 @@ using namespace clupatra_new ;
    };
    */
 
-RuntimeMap<edm4hep::Track, clupatra_new::TrackInfoStruct*> TrackInfo_of_edm4hepTrack;
-RuntimeMap<edm4hep::Track, MarlinTrk::IMarlinTrack*> MarTrk_of_edm4hepTrack;
-RuntimeMap<MarlinTrk::IMarlinTrack*, clupatra_new::CluTrack*> CluTrk_of_MarTrack;
-RuntimeMap<edm4hep::TrackerHit, clupatra_new::Hit*> GHitof;
-RuntimeMap<clupatra_new::CluTrack*, MarlinTrk::IMarlinTrack*> MarTrkof;
-
 gear::GearMgr* gearMgr; 
 #define WRITE_PICKED_DEBUG_TRACKS false
 
@@ -302,6 +294,9 @@ StatusCode ClupatraAlg::execute() {
 
 	int nHit = col->size() ;
 
+	// relation from the edm4hep hits to the clustering hits - valid for this event only
+	HitRelation GHitof( col ) ;
+
 	clupaHits.resize( nHit ) ;       // creates clupa hits (w/ default c'tor)
 	nncluHits.reserve( nHit ) ;
 
@@ -323,7 +318,7 @@ StatusCode ClupatraAlg::execute() {
 
 		//-------
 		// FIXME: Here we should have a resolution
-		GHitof(th) = gh ;  // assign the clupa hit to the LCIO hit for memory mgmt
+		GHitof.set( th, gh ) ;  // assign the clupa hit to the LCIO hit for memory mgmt
 
 		ch->edm4hepHit = th ;
 
@@ -458,9 +453,10 @@ StatusCode ClupatraAlg::execute() {
 			sclu.setOwner() ;
 
 			// FIXME Mingrui
-			debug() << "   call cluster_sorted with " <<  hits.size() << " hits " << endmsg;
+			debug() << "   call cluster_grid with " <<  hits.size() << " hits " << endmsg;
 
-			nncl.cluster_sorted( hits.begin(), hits.end() , std::back_inserter( sclu ), dist , _minCluSize ) ;
+			HitGrid grid( dist ) ;
+			nncl.cluster_grid( hits.begin(), hits.end() , std::back_inserter( sclu ), dist , grid , _minCluSize ) ;
 
 			const static int merge_seeds = true ;
 
@@ -486,7 +482,8 @@ StatusCode ClupatraAlg::execute() {
 
 				HitDistance distLarge( nloop * dcut * _cutIncrease ) ;
 
-				nncl.cluster_sorted( seedhits.begin(), seedhits.end() , std::back_inserter( sclu ), distLarge , _minCluSize ) ;
+				HitGrid gridLarge( distLarge ) ;
+				nncl.cluster_grid( seedhits.begin(), seedhits.end() , std::back_inserter( sclu ), distLarge , gridLarge , _minCluSize ) ;
 
 			} //------------------------------------------------------------------------------------------
 
@@ -579,7 +576,7 @@ StatusCode ClupatraAlg::execute() {
 				   Debug FIXME Mingrui
 				   */
 				// reset the pointer to the KalTest track - as we are done with this track
-				MarTrkof(*icv) = 0;
+				setMarTrk( *icv, 0 ) ;
 
 				delete mTrk ;
 			}
@@ -637,7 +634,8 @@ StatusCode ClupatraAlg::execute() {
 
 
 			HitDistance distSmall( _distCut ) ;
-			nncl.cluster( hits.begin(), hits.end() , std::back_inserter( loclu ),  distSmall , _minCluSize ) ;
+			HitGrid gridSmall( distSmall ) ;
+			nncl.cluster_grid( hits.begin(), hits.end() , std::back_inserter( loclu ),  distSmall , gridSmall , _minCluSize ) ;
 
 			// Write debug collection using STL transform() function on the clusters
 			/* Debug FIXME Mingrui
@@ -814,7 +812,6 @@ StatusCode ClupatraAlg::execute() {
 		trk->smooth() ;
 		edm4hep::MutableTrack edm4hepTrk = converter( *icv ) ;
 		tsCol_tmp.push_back( new ClupaPlcioTrack(edm4hepTrk) ) ;
-		MarTrk_of_edm4hepTrack(edm4hepTrk) = 0 ;
 		delete trk ;
 	}
 
@@ -834,8 +831,7 @@ StatusCode ClupatraAlg::execute() {
 	MakePLCIOElement<ClupaPlcioTrack> trkMakeElement ;
 
 	for( int i=0,N=tsCol_tmp.size() ;  i<N ; ++i ) {
-	  edm4hep::MutableTrack track = tsCol_tmp.at(i)->edm4hepTrack;
-	  computeTrackInfo(track) ;
+	  computeTrackInfo( tsCol_tmp.at(i) ) ;
 	}
 
 	//===============================================================================================
@@ -861,7 +857,7 @@ StatusCode ClupatraAlg::execute() {
 
 			        edm4hep::Track trk = tsCol_tmp.at(i)->edm4hepTrack;
 
-				const TrackInfoStruct* ti = TrackInfo_of_edm4hepTrack(trk);
+				const TrackInfoStruct* ti = &tsCol_tmp.at(i)->info ;
 
 				bool isIncompleteSegment =   !ti->isCurler  && ( !ti->startsInner || ( !ti->isCentral && !ti->isForward )  ) ;
 
@@ -947,9 +943,8 @@ StatusCode ClupatraAlg::execute() {
 				mTrk->smooth() ;
 				edm4hep::MutableTrack track = converter( &hits ) ;
 				tsCol_tmp.push_back( new ClupaPlcioTrack(track) ) ;
-				MarTrk_of_edm4hepTrack(track) = 0 ;
 				delete mTrk ;
-				computeTrackInfo( track ) ;
+				computeTrackInfo( tsCol_tmp.back() ) ;
 
 				// FIXME: Mingrui
 				// streamlog_out( DEBUG4 ) << "   ******  created new track : " << " : " << lcshort( (Track*) track )  << std::endl ;
@@ -984,7 +979,7 @@ StatusCode ClupatraAlg::execute() {
 			if( type[ lcio::ILDTrackTypeBit::SEGMENT ] )
 				continue ;   // ignore previously merged track segments
 
-			const TrackInfoStruct* ti = TrackInfo_of_edm4hepTrack(trk) ;
+			const TrackInfoStruct* ti = &tsCol_tmp.at(i)->info ;
 
 			bool isCompleteTrack =   ti && !ti->isCurler  && ( ti->startsInner &&  (  ti->isCentral || ti->isForward ) );
 
@@ -1042,17 +1037,21 @@ StatusCode ClupatraAlg::execute() {
 
 			TrackClusterer::cluster_type*  curSegClu = *it ;
 
-			std::list<edm4hep::MutableTrack> mergedTrk ;
+			std::list<ClupaPlcioTrack*> mergedSeg ;
 
 			for( TrackClusterer::cluster_type::iterator itC = curSegClu->begin() ; itC != curSegClu->end() ; ++ itC ){
 
 			  //debug() << lcshort(  (*itC)->first ) << endmsg;
 			  //debug() << getOmega((*itC)->first->edm4hepTrack) << endmsg;
-			  mergedTrk.push_back( (*itC)->first->edm4hepTrack ) ;
+			  mergedSeg.push_back( (*itC)->first ) ;
 			}
 
 
-			mergedTrk.sort( TrackZSort() ) ;
+			mergedSeg.sort( TrackZSort() ) ;
+
+			std::list<edm4hep::MutableTrack> mergedTrk ;
+			for( std::list<ClupaPlcioTrack*>::iterator itS = mergedSeg.begin() ; itS != mergedSeg.end() ; ++itS )
+			  mergedTrk.push_back( (*itS)->edm4hepTrack ) ;
 
 			//================================================================================
 
@@ -1102,8 +1101,6 @@ StatusCode ClupatraAlg::execute() {
 				if (hasTrackStateAt(lastTrk, lcio::TrackState::AtCalorimeter )) trk.addToTrackStates(getTrackStateAt(lastTrk, lcio::TrackState::AtCalorimeter));
 
 
-				MarTrk_of_edm4hepTrack(trk) = MarTrk_of_edm4hepTrack(firstTrk) ;
-
 				// FIXME: Mingrui Maybe this info not needed
 				//int hitsInFit  =  firstTrk->getSubdetectorHitNumbers()[ 2 * lcio::ILDDetID::TPC - 1 ] ;
 				trk.setChi2(     firstTrk.getChi2()     ) ;
@@ -1192,10 +1189,6 @@ StatusCode ClupatraAlg::execute() {
 
 				        edm4hep::MutableTrack t =  trk;
 
-					TrackInfo_of_edm4hepTrack(t) = 0 ; // set extension to 0 to prevent double free ...
-
-					MarTrk_of_edm4hepTrack(t) = 0 ; // dynamic_cast<Track*>( (*it)->first )->ext<MarTrk>() ;
-
 					// FIXME Mingrui debug
 					// streamlog_out( DEBUG2 ) << "   create new track from existing LCIO track  - ptr to MarlinTrk : " << t->ext<MarTrk>()  << std::endl ;
 
@@ -1260,22 +1253,15 @@ StatusCode ClupatraAlg::execute() {
 
 	_nEvt++ ;
 
-	TrackInfo_of_edm4hepTrack.clear();
-	MarTrk_of_edm4hepTrack.clear();
-	CluTrk_of_MarTrack.clear();
-	MarTrkof.clear();
-	GHitof.clear();
-
 	return StatusCode::SUCCESS;
 }
 
 // ####### 001
 /*************************************************************************************************/
 
-void ClupatraAlg::computeTrackInfo(  edm4hep::Track lTrk  ){
+void ClupatraAlg::computeTrackInfo(  ClupaPlcioTrack* t  ){
 
-	if( ! TrackInfo_of_edm4hepTrack(lTrk) )
-		TrackInfo_of_edm4hepTrack(lTrk) = new TrackInfoStruct ;
+	edm4hep::Track lTrk = t->edm4hepTrack ;
 
 	float r_inner = _gearTPC->getPlaneExtent()[0] ;
 	float r_outer = _gearTPC->getPlaneExtent()[1] ;
@@ -1314,7 +1300,7 @@ void ClupatraAlg::computeTrackInfo(  edm4hep::Track lTrk  ){
 	gear::Vector3D lhPos(tsL.referencePoint[0], tsL.referencePoint[1], tsL.referencePoint[2]) ;
 
 
-	TrackInfoStruct* ti = TrackInfo_of_edm4hepTrack(lTrk);
+	TrackInfoStruct* ti = &t->info ;
 
 	ti->startsInner =  std::abs( fhPos.rho() - r_inner )     <  _trackStartsInnerDist ;        // first hit close to inner field cage
 	ti->isCentral   =  std::abs( lhPos.rho() - r_outer )     <  _trackEndsOuterCentralDist ;   // last hit close to outer field cage
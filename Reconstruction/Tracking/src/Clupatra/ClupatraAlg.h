@@ -14,7 +14,6 @@
 #include <string>
 
 #include "gear/TPCModule.h"
-#include "RuntimeMap.h"
 #include "clupatra_new.h"
 #include "Tracking/TrackingHelper.h"
 
@@ -104,7 +103,7 @@ class ClupatraAlg : public GaudiAlgorithm {
 
   /** helper method to compute a few track segment parameters (start and end points, z spread,...)
    */
-  void computeTrackInfo(edm4hep::Track lTrk) ;
+  void computeTrackInfo(clupatra_new::ClupaPlcioTrack* t) ;
 
 
   StatusCode pickUpSiTrackerHits(edm4hep::TrackCollection* trackCol) ;
@@ -2,6 +2,7 @@
 #ifndef NNClusterer_h
 #define NNClusterer_h 1
 
+#include <atomic>
 #include <list>
 #include <vector>
 
@@ -130,11 +131,16 @@ namespace nnclu {
 
     int ID ; //DEBUG
 
-    Cluster() : ID(0) {}
+    /** Object attached to this cluster by the user, e.g. a track fit - not owned.
+     *  Replaces the runtime extensions of LCRTRelations.
+     */
+    void* Ext ;
+
+    Cluster() : ID(0), Ext(0) {}
 
     /** C'tor that takes the first element */
-    Cluster( Element<T>* element)  {
-      static int SID=0 ;  //DEBUG
+    Cluster( Element<T>* element) : Ext(0) {
+      static std::atomic<int> SID(0) ;  //DEBUG
       ID = SID++ ;      //DEBUG
       addElement( element ) ;
     }
@@ -348,6 +354,109 @@ namespace nnclu {
       }
     }
 
+
+    /** Same clustering as cluster() - but the predicate is only evaluated for the pairs of elements returned by
+     *  the neighbour search 'grid', e.g. a spatial grid of the elements, that has to return a superset of the pairs
+     *  for which the predicate is true. Grid has to provide the methods:
+     *    void fill( const std::vector<element_type*>& elements ) ;
+     *    void neighbours( unsigned i, std::vector<unsigned>& nb ) ; // indices j > i of the neighbours of element i - ascending
+     *  The pairs are evaluated in the same order as in cluster() and merged with a union-find on contiguous arrays,
+     *  so the clusters and their order are identical to the ones of cluster(). The elements of a cluster are
+     *  in the order of the input. Falls back to cluster() if an element already belongs to a cluster.
+     */
+    template <class In, class Out, class Pred, class Grid >
+    void cluster_grid( In first, In last, Out result, Pred& pred , Grid& grid, const unsigned minSize=1) {
+
+      std::vector<element_type*> elements( first, last ) ;
+
+      const unsigned n = elements.size() ;
+
+      for( unsigned i=0 ; i < n ; ++i ){
+        if( elements[i]->second != 0 ){
+          cluster( first, last, result, pred, minSize ) ;
+          return ;
+        }
+      }
+
+      grid.fill( elements ) ;
+
+      std::vector<unsigned> parent( n ) ;
+      std::vector<unsigned> size( n , 1 ) ;
+      // index of the cluster of a root element in the order of creation in cluster() - -1 if the element is still free
+      std::vector<int> slot( n , -1 ) ;
+      int nSlot = 0 ;
+
+      for( unsigned i=0 ; i < n ; ++i )
+        parent[i] = i ;
+
+      std::vector<unsigned> nb ;
+
+      for( unsigned i=0 ; i < n ; ++i ){
+
+        grid.neighbours( i , nb ) ;
+
+        for( unsigned k=0, nNb=nb.size() ; k < nNb ; ++k ){
+
+          const unsigned j = nb[k] ;
+
+          if( ! pred( elements[i] , elements[j] ) )
+            continue ;
+
+          unsigned ri = findRoot( parent, i ) ;
+          unsigned rj = findRoot( parent, j ) ;
+
+          if( ri == rj )  // same cluster
+            continue ;
+
+          // the cluster of the first element survives a merge - a new cluster is created if both are free
+          int s = ( slot[ri] != -1 ?  slot[ri] : ( slot[rj] != -1 ?  slot[rj] : nSlot++ ) ) ;
+
+          if( size[ri] < size[rj] ){
+            unsigned r = ri ; ri = rj ; rj = r ;
+          }
+          parent[rj] = ri ;
+          size[ri] += size[rj] ;
+          slot[ri] = s ;
+        }
+      }
+
+      // create the clusters that are large enough
+      std::vector<cluster_type*> clusters( nSlot , (cluster_type*) 0 ) ;
+
+      for( unsigned i=0 ; i < n ; ++i ){
+
+        unsigned r = findRoot( parent, i ) ;
+
+        if( slot[r] == -1 || !( size[r] > minSize-1 ) )
+          continue ;
+
+        cluster_type*& cl = clusters[ slot[r] ] ;
+
+        if( cl == 0 )
+          cl = new cluster_type( elements[i] ) ;
+        else
+          cl->addElement( elements[i] ) ;
+      }
+
+      for( int s=0 ; s < nSlot ; ++s ){
+
+        if( clusters[s] != 0 )
+          result++ = clusters[s] ;
+      }
+    }
+
+  protected:
+
+    /** Root of the set of element i - with path halving */
+    static unsigned findRoot( std::vector<unsigned>& parent, unsigned i ){
+
+      while( parent[i] != i ){
+        parent[i] = parent[ parent[i] ] ;
+        i = parent[i] ;
+      }
+      return i ;
+    }
+
   };
   //-----------------------------------------------------------------------------------------------------------------------
 
@@ -0,0 +1,193 @@
+#include "clupatra_grid.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+namespace clupatra_new{
+
+	namespace{
+
+		const double twoPi = 2. * M_PI ;
+
+		// the cells are slightly larger than the reach of the cuts - protects against rounding
+		const double cellMargin = 1.01 ;
+
+		inline uint64_t cellKey( int row, int phiBin, int uBin ){
+			return ( uint64_t( row & 0xffff ) << 48 ) | ( uint64_t( phiBin & 0x1fffff ) << 27 ) | uint64_t( uBin & 0x7ffffff ) ;
+		}
+	}
+
+	void HitGrid::Cells::init( double phiReach, double uMin_, double uMax_, double uReach ){
+
+		double w = std::max( phiReach * cellMargin , twoPi / ( 1 << 16 ) ) ;
+		nPhi = ( w < twoPi / 3. ?  int( twoPi / w ) : 1 ) ;
+
+		uMin = uMin_ ;
+		uWidth = std::max( uReach * cellMargin , ( uMax_ - uMin_ ) / ( 1 << 26 ) ) ;
+		if( uWidth <= 0. )
+			uWidth = 1. ;
+	}
+
+	void HitGrid::Cells::fill( const std::vector<Hit*>& hits, const std::vector<int>& rows, const std::vector<double>& u ){
+
+		const unsigned n = hits.size() ;
+
+		phiBin.resize( n ) ;
+		uBin.resize( n ) ;
+
+		std::vector< std::pair<uint64_t,unsigned> > keys( n ) ;
+
+		for( unsigned i=0 ; i < n ; ++i ){
+
+			int pb = int( ( hits[i]->first->pos.phi() + M_PI ) / twoPi * nPhi ) ;
+			phiBin[i] = std::min( std::max( pb, 0 ) , nPhi - 1 ) ;
+			uBin[i] = int( ( u[i] - uMin ) / uWidth ) ;
+
+			keys[i] = std::make_pair( cellKey( rows[i], phiBin[i], uBin[i] ) , i ) ;
+		}
+
+		// sorted by cell and index: the hits of a cell are contiguous and in the order of the input
+		std::sort( keys.begin(), keys.end() ) ;
+
+		index.resize( n ) ;
+		range.clear() ;
+		range.reserve( n ) ;
+
+		for( unsigned k=0 ; k < n ; ){
+
+			unsigned b = k ;
+			while( k < n && keys[k].first == keys[b].first ){
+				index[k] = keys[k].second ;
+				++k ;
+			}
+			range[ keys[b].first ] = std::make_pair( b , k ) ;
+		}
+	}
+
+	void HitGrid::Cells::append( int row, int pb, int ub, unsigned i, std::vector<unsigned>& nb ) const {
+
+		int phiBins[3] = { pb, ( pb + nPhi - 1 ) % nPhi , ( pb + 1 ) % nPhi } ;
+		const int nPhiBins = ( nPhi > 1 ? 3 : 1 ) ;
+
+		for( int ip=0 ; ip < nPhiBins ; ++ip ){
+			for( int iu = ub - 1 ; iu <= ub + 1 ; ++iu ){
+
+				std::unordered_map< uint64_t, std::pair<unsigned,unsigned> >::const_iterator it = range.find( cellKey( row, phiBins[ip], iu ) ) ;
+				if( it == range.end() )
+					continue ;
+
+				const unsigned* first = &index[0] + it->second.first ;
+				const unsigned* last  = &index[0] + it->second.second ;
+
+				for( const unsigned* j = std::upper_bound( first, last, i ) ; j != last ; ++j )
+					nb.push_back( *j ) ;
+			}
+		}
+	}
+
+	void HitGrid::fill( const std::vector<Hit*>& hits ){
+
+		const unsigned n = hits.size() ;
+
+		_row.resize( n ) ;
+		_rowReach.clear() ;
+
+		if( n == 0 )
+			return ;
+
+		std::vector<double> z( n ), cosTheta( n ) ;
+
+		int maxRow = 0 ;
+		double rhoMin = DBL_MAX ;
+		double sinThetaMin = 1. ;
+		double zMin = DBL_MAX ;
+		double zMax = -DBL_MAX ;
+
+		for( unsigned i=0 ; i < n ; ++i ){
+
+			const gear::Vector3D& p = hits[i]->first->pos ;
+
+			_row[i] = hits[i]->first->layer ;
+			maxRow = std::max( maxRow, _row[i] ) ;
+
+			double r = p.r() ;
+			z[i] = p.z() ;
+			cosTheta[i] = ( r > 0. ?  p.z() / r  : 0. ) ;
+
+			rhoMin = std::min( rhoMin, p.rho() ) ;
+			sinThetaMin = std::min( sinThetaMin, ( r > 0. ?  p.rho() / r : 0. ) ) ;
+			zMin = std::min( zMin, z[i] ) ;
+			zMax = std::max( zMax, z[i] ) ;
+		}
+
+		//---- rows within the distance cut, from the radial extent of the hits in the rows
+		//     (hits in the same row are never merged)
+		std::vector<double> rhoLo( maxRow + 1 , DBL_MAX ) ;
+		std::vector<double> rhoHi( maxRow + 1 , -DBL_MAX ) ;
+
+		for( unsigned i=0 ; i < n ; ++i ){
+			double rho = hits[i]->first->pos.rho() ;
+			rhoLo[ _row[i] ] = std::min( rhoLo[ _row[i] ] , rho ) ;
+			rhoHi[ _row[i] ] = std::max( rhoHi[ _row[i] ] , rho ) ;
+		}
+
+		_rowReach.resize( maxRow + 1 ) ;
+
+		for( int r0=0 ; r0 <= maxRow ; ++r0 ){
+
+			if( rhoLo[r0] > rhoHi[r0] )
+				continue ;
+
+			for( int r1=0 ; r1 <= maxRow ; ++r1 ){
+
+				if( r1 == r0 || rhoLo[r1] > rhoHi[r1] )
+					continue ;
+
+				double gap = std::max( rhoLo[r1] - rhoHi[r0] , rhoLo[r0] - rhoHi[r1] ) ;
+
+				if( gap < _dCut * cellMargin )
+					_rowReach[r0].push_back( r1 ) ;
+			}
+		}
+
+		//---- distance cut:  | dz | < d  and  | dphi | < 2 asin( d / 2 rho_min )
+		double phiReach = ( rhoMin > 0. && _dCut < 2. * rhoMin ?  2. * std::asin( _dCut / ( 2. * rhoMin ) ) : twoPi ) ;
+
+		_zCells.init( phiReach, zMin, zMax, _dCut ) ;
+		_zCells.fill( hits, _row, z ) ;
+
+		//---- angle cut: the unit vectors differ by less than c = sqrt( 2 ( 1 - cosAlphaCut ) ), hence
+		//     | dcos(theta) | < c  and  | dphi | < 2 asin( c / 2 sin(theta)_min )
+		if( _caCut > 0. ){
+
+			double c = std::sqrt( 2. * std::max( 1. - _caCut , 0. ) + 1.e-12 ) ;
+
+			double phiAngleReach = ( sinThetaMin > 0. && c < 2. * sinThetaMin ?  2. * std::asin( c / ( 2. * sinThetaMin ) ) : twoPi ) ;
+
+			_angleCells.init( phiAngleReach, -1., 1., c ) ;
+			_angleCells.fill( hits, _row, cosTheta ) ;
+		}
+	}
+
+	void HitGrid::neighbours( unsigned i, std::vector<unsigned>& nb ) const {
+
+		nb.clear() ;
+
+		const int row = _row[i] ;
+
+		const std::vector<int>& rows = _rowReach[ row ] ;
+
+		for( unsigned k=0 ; k < rows.size() ; ++k )
+			_zCells.append( rows[k], _zCells.phiBin[i], _zCells.uBin[i], i, nb ) ;
+
+		if( _caCut > 0. ){
+			_angleCells.append( row - 1, _angleCells.phiBin[i], _angleCells.uBin[i], i, nb ) ;
+			_angleCells.append( row + 1, _angleCells.phiBin[i], _angleCells.uBin[i], i, nb ) ;
+		}
+
+		// evaluate the pairs in the order of the input
+		std::sort( nb.begin(), nb.end() ) ;
+		nb.erase( std::unique( nb.begin(), nb.end() ) , nb.end() ) ;
+	}
+}
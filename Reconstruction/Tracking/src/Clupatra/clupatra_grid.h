@@ -0,0 +1,131 @@
+#ifndef clupatra_grid_h
+#define clupatra_grid_h
+
+#include <cmath>
+#include <vector>
+#include <unordered_map>
+#include <stdint.h>
+
+#include "NNClusterer.h"
+
+#include "gear/GEAR.h"
+
+#include "edm4hep/TrackerHit.h"
+
+/** The hits of the NN clustering of Clupatra, the distance predicate and the neighbour search of
+ *  Clusterer::cluster_grid() - without the dependencies of clupatra_new.h on LCIO and the fitter.
+ */
+namespace clupatra_new{
+
+	/** Small wrapper extension of the LCIO Hit
+	*/
+	struct ClupaHit {
+
+		ClupaHit() :layer(-1),
+		zIndex(-1),
+		phiIndex(-1),
+		edm4hepHit(0),
+		pos(0.,0.,0.) {}
+		int layer ;
+		int zIndex ;
+		int phiIndex ;
+		edm4hep::TrackerHit edm4hepHit ;
+		gear::Vector3D pos ;
+
+	};
+
+	//  inline lcio::TrackerHit* lcioHit( const ClupaHit* h) { return h->lcioHit ; }
+
+
+	//------------------ typedefs for elements and clusters ---------
+
+	typedef nnclu::NNClusterer< ClupaHit > Clusterer ;
+
+	typedef Clusterer::element_type Hit ;
+	typedef Clusterer::cluster_type CluTrack ;
+
+	typedef Clusterer::element_vector HitVec ;
+	typedef Clusterer::cluster_vector CluTrackVec ;
+
+	//------------------------------------------------------------------------------------------
+
+	/** Predicate class for 'distance' of NN clustering. */
+	class HitDistance{
+		public:
+
+			HitDistance(float dCut, float caCut = -1.0 ) : _dCutSquared( dCut*dCut ) , _caCut( caCut ) {}
+
+			/** Merge condition: true if distance  is less than dCut */
+			inline bool operator()( Hit* h0, Hit* h1){
+
+				if( std::abs( h0->Index0 - h1->Index0 ) > 1 ) return false ;
+
+				if( h0->first->layer == h1->first->layer )
+					return false ;
+
+				if(  _caCut > 0.  && std::abs( h0->first->layer - h1->first->layer ) == 1 ){
+
+					gear::Vector3D& p0 =  h0->first->pos   ;
+					gear::Vector3D& p1 =  h1->first->pos   ;
+
+					double cosAlpha = p0.dot( p1 ) / p0.r() / p1.r()  ;
+
+					// merge hits that seem to come from stiff track from the IP
+					//fixme: make parameter
+					if( cosAlpha > _caCut ) return true ;
+				}
+
+				return ( h0->first->pos - h1->first->pos).r2()  < _dCutSquared ;
+			}
+
+			float dCut() const { return std::sqrt( _dCutSquared ) ; }
+			float caCut() const { return _caCut ; }
+
+		protected:
+			HitDistance() ;
+			float _dCutSquared, _caCut  ;
+	} ;
+
+	//------------------------------------------------------------------------------------------
+
+	/** Neighbour search for the NN clustering of hits with HitDistance, used with Clusterer::cluster_grid().
+	 *  The hits are stored contiguously in cells of a (pad row, phi, z) grid with a cell size given by the
+	 *  distance cut. neighbours() returns the hits in the rows and cells that are within the distance cut.
+	 *  If the cut on the angle is used, the hits in the adjacent rows that are within this angle are found
+	 *  in a second grid in (pad row, phi, cos(theta)).
+	 */
+	class HitGrid{
+		public:
+			HitGrid( const HitDistance& dist ) : _dCut( dist.dCut() ), _caCut( dist.caCut() ) {}
+
+			void fill( const std::vector<Hit*>& hits ) ;
+
+			/** Indices j > i of the hits that can be merged with hit i - in ascending order */
+			void neighbours( unsigned i, std::vector<unsigned>& nb ) const ;
+
+		protected:
+			HitGrid() ;
+
+			/** Hits sorted by cell (row, phi bin, bin in a second coordinate) */
+			struct Cells{
+				void init( double phiReach, double uMin, double uMax, double uReach ) ;
+				void fill( const std::vector<Hit*>& hits, const std::vector<int>& rows, const std::vector<double>& u ) ;
+				/** Append the hits j > i of the row in the cells next to (phiBin, uBin) */
+				void append( int row, int phiBin, int uBin, unsigned i, std::vector<unsigned>& nb ) const ;
+
+				int nPhi ;
+				double uMin, uWidth ;
+				std::vector<int> phiBin, uBin ;                // per hit
+				std::vector<unsigned> index ;                  // hit indices sorted by cell
+				std::unordered_map< uint64_t, std::pair<unsigned,unsigned> > range ;  // cell -> range in index
+			} ;
+
+			float _dCut, _caCut ;
+			std::vector<int> _row ;                    // per hit
+			std::vector< std::vector<int> > _rowReach ;  // rows within the distance cut of a row
+			Cells _zCells ;      // (row, phi, z)
+			Cells _angleCells ;  // (row, phi, cos(theta)) - if the angle cut is used
+	} ;
+}
+
+#endif
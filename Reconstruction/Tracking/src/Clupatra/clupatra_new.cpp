@@ -28,19 +28,16 @@ namespace lcio{
 }
 
 extern gear::GearMgr* gearMgr; // = _gear->getGearMgr();
-extern RuntimeMap<clupatra_new::CluTrack*, MarlinTrk::IMarlinTrack*> MarTrkof;
-extern RuntimeMap<edm4hep::Track, MarlinTrk::IMarlinTrack*> MarTrk_of_edm4hepTrack;
-extern RuntimeMap<edm4hep::Track, clupatra_new::TrackInfoStruct*> TrackInfo_of_edm4hepTrack;
 
 namespace clupatra_new{
 
-	bool TrackZSort::operator()( edm4hep::Track l, edm4hep::Track r){
-		return (  std::abs( TrackInfo_of_edm4hepTrack(l)->zAvg )   <   std::abs( TrackInfo_of_edm4hepTrack(r)->zAvg )  ) ;
+	bool TrackZSort::operator()( const ClupaPlcioTrack* l, const ClupaPlcioTrack* r){
+		return (  std::abs( l->info.zAvg )   <   std::abs( r->info.zAvg )  ) ;
 	}
 
-	void ComputeTrackerInfo::operator()( edm4hep::MutableTrack o )
+	void ComputeTrackerInfo::operator()( ClupaPlcioTrack* o )
 	{
-		edm4hep::MutableTrack lTrk  = o ;
+		edm4hep::MutableTrack lTrk  = o->edm4hepTrack ;
 
 		// compute z-extend of this track segment
 		// const edm4hep::TrackerHitVec& hv = lTrk->getTrackerHits() ;
@@ -61,12 +58,9 @@ namespace clupatra_new{
 			zMin = d  ;
 		}
 
-		if( ! TrackInfo_of_edm4hepTrack(lTrk) )
-			TrackInfo_of_edm4hepTrack(lTrk) =  new TrackInfoStruct ;
-
-		TrackInfo_of_edm4hepTrack(lTrk)->zMin = zMin ;
-		TrackInfo_of_edm4hepTrack(lTrk)->zMax = zMax ;
-		TrackInfo_of_edm4hepTrack(lTrk)->zAvg = zAvg ;
+		o->info.zMin = zMin ;
+		o->info.zMax = zMax ;
+		o->info.zAvg = zAvg ;
 
 	}
 	bool TrackCircleDistance:: operator()( nnclu::Element<ClupaPlcioTrack>* h0, nnclu::Element<ClupaPlcioTrack>* h1){
@@ -74,8 +68,8 @@ namespace clupatra_new{
 		edm4hep::Track trk0 = h0->first->edm4hepTrack ;
 		edm4hep::Track trk1 = h1->first->edm4hepTrack ;
 
-		const TrackInfoStruct* ti0 =  TrackInfo_of_edm4hepTrack(trk0);
-		const TrackInfoStruct* ti1 =  TrackInfo_of_edm4hepTrack(trk1);
+		const TrackInfoStruct* ti0 =  &h0->first->info ;
+		const TrackInfoStruct* ti1 =  &h1->first->info ;
 
 
 		/* FIXME debug Mingrui
@@ -238,14 +232,13 @@ namespace clupatra_new{
 	//-------------------------------------------------------------------------------
 
 
+
 	int addHitsAndFilter( CluTrack* clu, HitListVector& hLV , double dChi2Max, double chi2Cut, unsigned maxStep, ZIndex& zIndex, bool backward,
 			MarlinTrk::IMarlinTrkSystem* trkSys ) {
 
 
 		int nHitsAdded = 0 ;
 
-		const double bfield = gearMgr->getBField().at( gear::Vector3D(0.,0.0,0.) ).z() ;
-
 		// Support for more than one module
 		static const gear::TPCParameters*  gearTPC = &(gearMgr->getTPCParameters());
 		// The ternary operator is used to make the trick with the static variable which
@@ -269,7 +262,7 @@ namespace clupatra_new{
 
 		Chi2_RPhi_Z_Hit ch2rzh ;
 
-		IMarlinTrack* trk =  MarTrkof(clu);
+		IMarlinTrack* trk =  marTrkOf(clu);
 // {
 // edm4hep::TrackState ts;
 // double chi2; int ndf;
@@ -313,6 +306,8 @@ namespace clupatra_new{
 
 			firstHit = (*it)->first->edm4hepHit ;
 
+			const double bfield = gearMgr->getBField().at( gear::Vector3D(0.,0.0,0.) ).z() ;
+
 			int smoothed  = trk->smooth( firstHit ) ;
 
 			double chi2 ;
@@ -489,7 +484,7 @@ namespace clupatra_new{
 
 		Chi2_RPhi_Z_Hit ch2rzh ;
 
-		IMarlinTrack* trk =  MarTrkof(clu) ;
+		IMarlinTrack* trk =  marTrkOf(clu) ;
 
 		UTIL::BitField64 encoder( UTIL::ILDCellID0::encoder_string ) ;
 
@@ -1226,7 +1221,7 @@ start:
 			return trk ;
 		}
 
-		MarTrkof(clu) = trk ;
+		setMarTrk( clu, trk ) ;
 
 		clu->sort( LayerSortOut() ) ;
 
@@ -1286,9 +1281,24 @@ start:
 
 			// streamlog_out( DEBUG4 ) << "  >>>>>>  IMarlinTrkFitter :  small number of hits used in fit " << hitsInFit.size() << "/" << nHit << " = "
 			// << ( 1.*hitsInFit.size()) / (1.*nHit )  << " refit with larger max chi2 increment:  " << maxChi2 <<  std::endl ;
-			delete trk ;
 
-			goto start ;   // ;-)
+			// the refit filters the same hits in the same order from the same initial state: it resumes
+			// from the last site before the first outlier that passes the larger chi2 cut
+			code = trk->refit( maxChi2 ) ;
+
+			if( code == MarlinTrk::IMarlinTrack::error ){
+
+				delete trk ;
+
+				goto start ;   // ;-)
+			}
+
+			if( code != MarlinTrk::IMarlinTrack::success ){
+
+				std::cout << "  >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>> IMarlinTrkFitter :  problem fitting track "
+				          << " error code : " << MarlinTrk::errorCode( code )
+				          << std::endl ;
+			}
 		}
 		//----------------------------------------------------------------------
 
@@ -1301,7 +1311,7 @@ start:
 
 	edm4hep::MutableTrack PLCIOTrackConverter::operator() (CluTrack* c) {
 	  
-		static lcio::BitField64 encoder( lcio::ILDCellID0::encoder_string ) ;
+		lcio::BitField64 encoder( lcio::ILDCellID0::encoder_string ) ;
 
 		edm4hep::MutableTrack trk;
 
@@ -1320,9 +1330,7 @@ start:
 			nHit++ ;
 		}
 
-		MarlinTrk::IMarlinTrack* mtrk = MarTrkof(c);
-
-		MarTrk_of_edm4hepTrack(trk) = mtrk ;
+		MarlinTrk::IMarlinTrack* mtrk = marTrkOf(c);
 
 		trk.setDEdx( ( nHit ? e/nHit : -1. )  ) ;
 
@@ -1333,8 +1341,6 @@ start:
 		   trk->subdetectorHitNumbers()[ 2*lcio::ILDDetID::TPC - 1 ] =  nHit ;
 		   */
 
-		RuntimeMap<edm4hep::TrackerHit, int> DChi2_of_hit;
-
 		if( mtrk != 0 && ! c->empty() ){
 
 
@@ -1349,8 +1355,6 @@ start:
 				// store the delta chi2 for the given hit
 				for(unsigned i=0, N=hitsInFit.size() ; i<N ; ++i){
 
-					DChi2_of_hit(hitsInFit[i].first) = hitsInFit[i].second ;
-
 					//IMPL::TrackerHitImpl* thi = dynamic_cast<IMPL::TrackerHitImpl*> ( hitsInFit[i].first ) ;
 					//thi->setQualityBit( UTIL::ILDTrkHitQualityBit::USED_IN_FIT , 1 )  ;
 				}
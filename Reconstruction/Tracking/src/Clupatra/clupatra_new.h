@@ -1,7 +1,6 @@
 #ifndef clupatra_new_h
 #define clupatra_new_h
 
-#include "RuntimeMap.h"
 #include "Tracking/TrackingHelper.h"
 
 #include <cmath>
@@ -10,9 +9,13 @@
 #include <math.h>
 #include <sstream>
 #include <memory>
+#include <vector>
+#include <unordered_map>
+#include <stdint.h>
 #include "assert.h"
 
 #include "NNClusterer.h"
+#include "clupatra_grid.h"
 
 #include "lcio.h"
 #include "EVENT/TrackerHit.h"
@@ -25,6 +28,7 @@
 
 #include "edm4hep/TrackState.h"
 #include "edm4hep/MutableTrack.h"
+#include "edm4hep/TrackerHitCollection.h"
 
 
 #include "TrackSystemSvc/IMarlinTrack.h"
@@ -50,43 +54,41 @@ namespace lcio{
 
 namespace clupatra_new{
 
-	/** Small wrapper extension of the LCIO Hit
-	*/
-	struct ClupaHit {
-
-		ClupaHit() :layer(-1),
-		zIndex(-1),
-		phiIndex(-1),
-		edm4hepHit(0),
-		pos(0.,0.,0.) {}
-		int layer ;
-		int zIndex ;
-		int phiIndex ;
-		edm4hep::TrackerHit edm4hepHit ;
-		gear::Vector3D pos ;
-
-	};
-
-	//  inline lcio::TrackerHit* lcioHit( const ClupaHit* h) { return h->lcioHit ; }
+	typedef std::list<Hit*>        HitList ;
+	typedef std::vector< HitList > HitListVector ;
 
+	//------------------------------------------------------------------------------------------
 
-	//------------------ typedefs for elements and clusters ---------
+	/** The KalTest track attached to the cluster by the IMarlinTrkFitter (LCIO runtime extension MarTrk) - 0 if none.
+	 */
+	inline MarlinTrk::IMarlinTrack* marTrkOf( const CluTrack* clu ) { return static_cast<MarlinTrk::IMarlinTrack*>( clu->Ext ) ; }
 
-	typedef nnclu::NNClusterer< ClupaHit > Clusterer ;
+	inline void setMarTrk( CluTrack* clu, MarlinTrk::IMarlinTrack* trk ) { clu->Ext = trk ; }
 
-	typedef Clusterer::element_type Hit ;
-	typedef Clusterer::cluster_type CluTrack ;
+	//------------------------------------------------------------------------------------------
 
-	typedef Clusterer::element_vector HitVec ;
-	typedef Clusterer::cluster_vector CluTrackVec ;
+	/** Relation from the edm4hep hits of the TPC hit collection to their clustering hits for one event
+	 *  (LCIO runtime extension GHit). The relation is a dense array indexed with the position of the hit
+	 *  in the collection, so that there is no global state and the lookup is O(1).
+	 */
+	class HitRelation{
+		public:
+			HitRelation( const edm4hep::TrackerHitCollection* col ) : _colID( col->getID() ), _hits( col->size(), 0 ) {}
 
-	typedef std::list<Hit*>        HitList ;
-	typedef std::vector< HitList > HitListVector ;
+			void set( const edm4hep::TrackerHit& th, Hit* h ) { _hits.at( th.getObjectID().index ) = h ; }
 
-	struct ClupaPlcioTrack {
-		edm4hep::MutableTrack edm4hepTrack ;
-                ClupaPlcioTrack(edm4hep::MutableTrack edm4hepTrack) : edm4hepTrack(edm4hepTrack) {}
-	};
+			/** The clustering hit of th - 0 if th is not a hit of the collection or has no clustering hit */
+			Hit* operator()( const edm4hep::TrackerHit& th ) const {
+				const podio::ObjectID id = th.getObjectID() ;
+				if( id.collectionID != _colID || id.index < 0 || unsigned( id.index ) >= _hits.size() )
+					return 0 ;
+				return _hits[ id.index ] ;
+			}
+		protected:
+			HitRelation() ;
+			unsigned _colID ;
+			std::vector<Hit*> _hits ;
+	} ;
 
 	// typedef GenericHitVec<ClupaHit>      GHitVec ;
 	// typedef GenericClusterVec<ClupaHit>  GClusterVec ;
@@ -167,40 +169,6 @@ namespace clupatra_new{
 
 	//------------------------------------------------------------------------------------------
 
-	/** Predicate class for 'distance' of NN clustering. */
-	class HitDistance{
-		public:
-
-			HitDistance(float dCut, float caCut = -1.0 ) : _dCutSquared( dCut*dCut ) , _caCut( caCut ) {}
-
-			/** Merge condition: true if distance  is less than dCut */
-			inline bool operator()( Hit* h0, Hit* h1){
-
-				if( std::abs( h0->Index0 - h1->Index0 ) > 1 ) return false ;
-
-				if( h0->first->layer == h1->first->layer )
-					return false ;
-
-				if(  _caCut > 0.  && std::abs( h0->first->layer - h1->first->layer ) == 1 ){
-
-					gear::Vector3D& p0 =  h0->first->pos   ;
-					gear::Vector3D& p1 =  h1->first->pos   ;
-
-					double cosAlpha = p0.dot( p1 ) / p0.r() / p1.r()  ;
-
-					// merge hits that seem to come from stiff track from the IP
-					//fixme: make parameter
-					if( cosAlpha > _caCut ) return true ;
-				}
-
-				return ( h0->first->pos - h1->first->pos).r2()  < _dCutSquared ;
-			}
-		protected:
-			HitDistance() ;
-			float _dCutSquared, _caCut  ;
-	} ;
-
-
 	// /** Predicate class for 'distance' of NN clustering. */
 
 	// struct HitDistance{  float _dCutSquared ;
@@ -354,10 +322,19 @@ namespace clupatra_new{
 	} ;
 	// struct TrackInfo : lcrtrel::LCOwnedExtension<TrackInfo, TrackInfoStruct> {} ;
 	typedef TrackInfoStruct TrackInfo;
+
+	/** Track segment of the current event with its TrackInfo (LCIO runtime extension TrackInfo).
+	*/
+	struct ClupaPlcioTrack {
+		edm4hep::MutableTrack edm4hepTrack ;
+		TrackInfoStruct info ;
+                ClupaPlcioTrack(edm4hep::MutableTrack edm4hepTrack) : edm4hepTrack(edm4hepTrack) {}
+	};
+
 	/** Helper class to compute track segment properties.
 	*/
 	struct ComputeTrackerInfo{
-		void operator()( edm4hep::MutableTrack o );
+		void operator()( ClupaPlcioTrack* o );
 	};
 
 	//=======================================================================================
@@ -541,7 +518,7 @@ namespace clupatra_new{
 	};
 
 	struct TrackZSort {  // sort tracks wtr to abs(z_average )
-		bool operator()( edm4hep::Track l, edm4hep::Track r);
+		bool operator()( const ClupaPlcioTrack* l, const ClupaPlcioTrack* r);
 	};
 
 
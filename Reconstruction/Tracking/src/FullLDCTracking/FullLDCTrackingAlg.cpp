@@ -1,4 +1,5 @@
 #include "FullLDCTrackingAlg.h"
+#include "TrackSorting.h"
 
 #include "DataHelper/Navigation.h"
 #include "Tracking/TrackingHelper.h"
@@ -11,7 +12,9 @@
 
 #include <iostream>
 #include <algorithm>
+#include <atomic>
 #include <memory>
+#include <thread>
 
 #include <math.h>
 #include <map>
@@ -58,6 +61,173 @@ typedef std::vector<edm4hep::TrackerHit> TrackerHitVec;
 using namespace edm4hep ;
 using namespace MarlinTrk ;
 
+namespace {
+  
+  /** Index of hits in bins of rho and phi around the z axis, used to find the hits close to a track helix
+   *  in the Assign*HitsToTracks methods. HelixClass::getDistanceToPoint is never smaller than the distance DistXY
+   *  of the hit to the circle of the helix in the xy projection, so only hits with DistXY < dcut can pass a cut
+   *  on it. candidates() returns a superset of these hits, the exact cut is still applied by the caller.
+   */
+  class HitRhoPhiIndex {
+  public:
+    
+    HitRhoPhiIndex(const TrackerHitExtendedVec& hitVec);
+    
+    /** indices of the hits which may be closer than dcut to the circle (xc,yc,radius), in increasing order */
+    void candidates(float xc, float yc, float radius, float dcut, std::vector<int>& hits) const;
+    
+  private:
+    
+    void addBin(int iRho, int iPhi, std::vector<int>& hits) const {
+      int bin = iRho*_nPhi + iPhi;
+      hits.insert(hits.end(), _index.begin()+_first[bin], _index.begin()+_first[bin+1]);
+    }
+    
+    int _nHits;
+    int _nRho;
+    int _nPhi;
+    double _rhoMin;
+    double _rhoWidth;
+    std::vector<int> _first;   // the hits of bin b are _index[_first[b]] ... _index[_first[b+1]-1]
+    std::vector<int> _index;
+    std::vector<int> _unbinned;  // hits with a position that is not finite, always candidates
+  };
+  
+  HitRhoPhiIndex::HitRhoPhiIndex(const TrackerHitExtendedVec& hitVec) : _nHits(int(hitVec.size())), _nRho(1), _nPhi(1), _rhoMin(0.), _rhoWidth(1.) {
+    
+    std::vector<double> rho(_nHits), phi(_nHits);
+    double rhoMax = 0.;
+    _rhoMin = 1.e+30;
+    
+    for (int iH=0;iH<_nHits;++iH) {
+      edm4hep::TrackerHit hit = hitVec[iH]->getTrackerHit();
+      double x = float(hit.getPosition()[0]);
+      double y = float(hit.getPosition()[1]);
+      rho[iH] = sqrt(x*x+y*y);
+      phi[iH] = atan2(y,x);
+      if (std::isfinite(rho[iH])) {
+        _rhoMin = std::min(_rhoMin,rho[iH]);
+        rhoMax = std::max(rhoMax,rho[iH]);
+      }
+    }
+    if (_rhoMin > rhoMax) _rhoMin = rhoMax;
+    
+    // a few hits per bin on average
+    int nBins = std::max(1,_nHits/4);
+    _nRho = std::max(1,std::min(32,int(sqrt(nBins/8.))));
+    _nPhi = std::max(1,std::min(512,nBins/_nRho));
+    if (rhoMax > _rhoMin) _rhoWidth = (rhoMax-_rhoMin)/_nRho;
+    
+    // counting sort of the hits into the bins
+    std::vector<int> bin(_nHits,-1);
+    _first.assign(_nRho*_nPhi+1,0);
+    for (int iH=0;iH<_nHits;++iH) {
+      if (!std::isfinite(rho[iH]) || !std::isfinite(phi[iH])) {
+        _unbinned.push_back(iH);
+        continue;
+      }
+      int iRho = std::min(_nRho-1,std::max(0,int((rho[iH]-_rhoMin)/_rhoWidth)));
+      int iPhi = std::min(_nPhi-1,std::max(0,int((phi[iH]+M_PI)/(2.*M_PI)*_nPhi)));
+      bin[iH] = iRho*_nPhi + iPhi;
+      ++_first[bin[iH]+1];
+    }
+    for (int b=0;b<_nRho*_nPhi;++b) _first[b+1] += _first[b];
+    
+    _index.resize(_first.back());
+    std::vector<int> fill(_first.begin(),_first.end()-1);
+    for (int iH=0;iH<_nHits;++iH) {
+      if (bin[iH] >= 0) _index[fill[bin[iH]]++] = iH;
+    }
+  }
+  
+  void HitRhoPhiIndex::candidates(float xc, float yc, float radius, float dcut, std::vector<int>& hits) const {
+    
+    hits.assign(_unbinned.begin(),_unbinned.end());
+    
+    double d = sqrt(double(xc)*xc+double(yc)*yc);
+    
+    if (!std::isfinite(d) || !std::isfinite(radius) || !std::isfinite(dcut)) {
+      hits.clear();
+      for (int iH=0;iH<_nHits;++iH) hits.push_back(iH);
+      return;
+    }
+    
+    // the annulus |DistXY| < cut around the circle, widened for the rounding of DistXY in float
+    double cut = 1.001*dcut + 1.e-4*(radius+d) + 1.e-3;
+    double rLo = std::max(0.,radius-cut);
+    double rHi = radius+cut;
+    double phiC = atan2(double(yc),double(xc));
+    const double dPhiMargin = 1.e-3;
+    
+    std::vector<char> phiBins(_nPhi);
+    
+    for (int iRho=0;iRho<_nRho;++iRho) {
+      
+      double rhoA = _rhoMin + iRho*_rhoWidth;
+      double rhoB = rhoA + _rhoWidth;
+      double margin = 1.e-4*rhoB + 1.e-3;
+      rhoA = std::max(1.e-6,rhoA-margin);
+      rhoB += margin;
+      
+      // the points of the annulus are at a distance from the origin within [rLo-d, rHi+d] and above d-rHi
+      if (rhoB < std::max(rLo-d,d-rHi) || rhoA > rHi+d) continue;
+      
+      std::fill(phiBins.begin(),phiBins.end(),0);
+      
+      if (d < 1.e-3) {
+        std::fill(phiBins.begin(),phiBins.end(),1);
+      }
+      else {
+        // angle alpha between a point at distance rho from the origin and distance r from the centre and the centre:
+        // cos(alpha) = (rho^2 + d^2 - r^2)/(2 rho d), which decreases with r and is convex or increasing in rho
+        auto cosAlpha = [d](double rho, double r) { return (rho*rho + d*d - r*r)/(2.*rho*d); };
+        
+        double cosMax = std::max(cosAlpha(rhoA,rLo),cosAlpha(rhoB,rLo));
+        double rhoStar = d*d > rHi*rHi ? sqrt(d*d-rHi*rHi) : rhoA;
+        rhoStar = std::min(rhoB,std::max(rhoA,rhoStar));
+        double cosMin = std::min(std::min(cosAlpha(rhoA,rHi),cosAlpha(rhoB,rHi)),cosAlpha(rhoStar,rHi));
+        
+        if (cosMin > 1. || cosMax < -1.) continue;
+        
+        double alphaLo = acos(std::min(1.,cosMax)) - dPhiMargin;
+        double alphaHi = acos(std::max(-1.,cosMin)) + dPhiMargin;
+        
+        // the two phi intervals on both sides of the direction of the centre
+        for (int side=-1;side<=1;side+=2) {
+          double phiA = side > 0 ? phiC + alphaLo : phiC - alphaHi;
+          double phiB = side > 0 ? phiC + alphaHi : phiC - alphaLo;
+          int iA = int(floor((phiA+M_PI)/(2.*M_PI)*_nPhi));
+          int iB = int(floor((phiB+M_PI)/(2.*M_PI)*_nPhi));
+          if (iB-iA >= _nPhi-1) iB = iA + _nPhi-1;
+          for (int i=iA;i<=iB;++i) phiBins[((i%_nPhi)+_nPhi)%_nPhi] = 1;
+        }
+      }
+      
+      for (int iPhi=0;iPhi<_nPhi;++iPhi) {
+        if (phiBins[iPhi]) addBin(iRho,iPhi,hits);
+      }
+    }
+    
+    std::sort(hits.begin(),hits.end());
+  }
+  
+  /** track-hit pair of the Assign*HitsToTracks methods, with the indices of the track and the hit */
+  struct IndexedTrackHitPair {
+    int iT;
+    int iH;
+    float distance;
+  };
+  
+  /** ordered by distance - equal distances in the order in which the pairs were found by looping over hits and then tracks */
+  inline bool operator<(const IndexedTrackHitPair& a, const IndexedTrackHitPair& b) {
+    if (a.distance != b.distance) return a.distance < b.distance;
+    if (a.iH != b.iH) return a.iH < b.iH;
+    return a.iT < b.iT;
+  }
+  
+}
+
+
 /** debug printout helper method */
 std::string toString( int iTrk, edm4hep::Track tpcTrack, float bField=3.5 ) {
   
@@ -1339,57 +1509,108 @@ void FullLDCTrackingAlg::MergeTPCandSiTracks() {
   
   debug() << " MergeTPCandSiTracks called nTPC tracks " << nTPCTracks << " - nSiTracks " << nSiTracks << endmsg;
   
+  // CompareTrkII only accepts |omegaSi - omegaTPC| < _dOmegaForMerging*|omegaTPC|, so the Si tracks are sorted in omega 
+  // and each TPC track is only compared to the Si tracks in this window - widened to be safe against rounding.
+  // Tracks with omega nan or inf never pass CompareTrkII.
+  std::vector< std::pair<float,int> > siOmega;
+  siOmega.reserve(nSiTracks);
+  for (int iSi=0;iSi<nSiTracks;++iSi) {
+    float omega = _allSiTracks[iSi]->getOmega();
+    if (std::isfinite(omega)) siOmega.push_back(std::make_pair(omega,iSi));
+  }
+  std::sort(siOmega.begin(),siOmega.end());
+  
+  // the pairs to fit, in the order of the loops over TPC and Si tracks
+  std::vector< std::pair<int,int> > candidates;
+  std::vector<int> siInWindow;
+  
   for (int iTPC=0;iTPC<nTPCTracks;++iTPC) {
     TrackExtended * tpcTrackExt = _allTPCTracks[iTPC];
-    for (int iSi=0;iSi<nSiTracks;++iSi) {
+    
+    float omegaTPC = tpcTrackExt->getOmega();
+    if (!std::isfinite(omegaTPC)) continue;
+    
+    float window = 1.001*_dOmegaForMerging*fabs(omegaTPC);
+    std::vector< std::pair<float,int> >::const_iterator first = std::lower_bound(siOmega.begin(),siOmega.end(),std::make_pair(omegaTPC-window,INT_MIN));
+    std::vector< std::pair<float,int> >::const_iterator last  = std::upper_bound(first,siOmega.cend(),std::make_pair(omegaTPC+window,INT_MAX));
+    
+    siInWindow.clear();
+    for (std::vector< std::pair<float,int> >::const_iterator it=first;it!=last;++it) siInWindow.push_back(it->second);
+    std::sort(siInWindow.begin(),siInWindow.end());
+    
+    for (unsigned i=0;i<siInWindow.size();++i) {
+      int iSi = siInWindow[i];
       TrackExtended * siTrackExt = _allSiTracks[iSi];
       int iComp = 0;
       float angle = 0;
-
-      debug() << " compare tpc trk " << toString( iTPC,  tpcTrackExt->getTrack(), _bField  ) << endmsg;
-      debug() << "    to si trk    " << toString( iSi,   siTrackExt->getTrack(),  _bField  ) << endmsg;
+      
+      if (msgLevel(MSG::DEBUG)) {
+        debug() << " compare tpc trk " << toString( iTPC,  tpcTrackExt->getTrack(), _bField  ) << endmsg;
+        debug() << "    to si trk    " << toString( iSi,   siTrackExt->getTrack(),  _bField  ) << endmsg;
+      }
       
       float dOmega = CompareTrkII(siTrackExt,tpcTrackExt,_d0CutForMerging,_z0CutForMerging,iComp,angle);
       
       if ( (dOmega<_dOmegaForMerging) && (angle<_angleForMerging) && !VetoMerge(tpcTrackExt,siTrackExt)) {
-	
-        debug() << " call CombineTracks for tpc trk " << tpcTrackExt << " si trk " << siTrackExt << endmsg;
-	
-        TrackExtended *combinedTrack = CombineTracks(tpcTrackExt,siTrackExt,_maxAllowedPercentageOfOutliersForTrackCombination, false);
-	
-        debug() << " combinedTrack returns " << combinedTrack << endmsg;
-        
-        if (combinedTrack != NULL) {
-
-
-          _allCombinedTracks.push_back( combinedTrack );
-          _candidateCombinedTracks.insert(tpcTrackExt);
-          _candidateCombinedTracks.insert(siTrackExt);
-
-	  //          streamlog_out(DEBUG3) << " combinedTrack successfully added to _allCombinedTracks : " << toString( 0,combinedTrack->getTrack(), _bField  )  << endmsg;
-          debug() << " *** combinedTrack successfully added to _allCombinedTracks : tpc " << iTPC << " si " << iSi   << endmsg;
-	  
-          if (_debug >= 3 ) {
-            int iopt = 1;
-            // PrintOutMerging(tpcTrackExt,siTrackExt,iopt);
-          }
-        }
-	else{
-          if (_debug >= 3 ) {
-            int iopt = 6;
-            // PrintOutMerging(tpcTrackExt,siTrackExt,iopt);
-          }
-        }
-      }
-      else {
-        if (_debug >= 3 ) {
-          int iopt = 6;
-          // PrintOutMerging(tpcTrackExt,siTrackExt,iopt);
-        }
+        candidates.push_back(std::make_pair(iTPC,iSi));
       }
     }
   }
   
+  // the fits of the candidates are independent: run them concurrently, each writes only its own CombinedFit
+  int nCandidates = int(candidates.size());
+  
+  std::vector<CombinedFit> fits(nCandidates);
+  std::vector<char> prepared(nCandidates);
+  
+  for (int i=0;i<nCandidates;++i) {
+    prepared[i] = PrepareCombinedFit(_allTPCTracks[candidates[i].first],_allSiTracks[candidates[i].second],fits[i]);
+  }
+  
+  std::atomic<int> next(0);
+  auto worker = [&]() {
+    int i;
+    while ( (i = next++) < nCandidates ) {
+      if (prepared[i]) RunCombinedFit(fits[i]);
+    }
+  };
+  
+  int nThreads = _nThreads > 0 ? int(_nThreads) : int(std::thread::hardware_concurrency());
+  nThreads = std::min(nThreads,nCandidates);
+  
+  if (nThreads <= 1) {
+    worker();
+  }
+  else {
+    std::vector<std::thread> threads;
+    threads.reserve(nThreads-1);
+    for (int t=1;t<nThreads;++t) threads.emplace_back(worker);
+    worker();
+    for (unsigned t=0;t<threads.size();++t) threads[t].join();
+  }
+  
+  // the combined tracks are created and their hits flagged in the order of the candidates, as with sequential fits
+  for (int i=0;i<nCandidates;++i) {
+    int iTPC = candidates[i].first;
+    int iSi  = candidates[i].second;
+    TrackExtended * tpcTrackExt = _allTPCTracks[iTPC];
+    TrackExtended * siTrackExt  = _allSiTracks[iSi];
+    
+    debug() << " call CombineTracks for tpc trk " << tpcTrackExt << " si trk " << siTrackExt << endmsg;
+    
+    TrackExtended *combinedTrack = prepared[i] ? FinishCombinedFit(tpcTrackExt,siTrackExt,_maxAllowedPercentageOfOutliersForTrackCombination,false,fits[i]) : NULL;
+    
+    debug() << " combinedTrack returns " << combinedTrack << endmsg;
+    
+    if (combinedTrack != NULL) {
+      
+      _allCombinedTracks.push_back( combinedTrack );
+      _candidateCombinedTracks.insert(tpcTrackExt);
+      _candidateCombinedTracks.insert(siTrackExt);
+      
+      debug() << " *** combinedTrack successfully added to _allCombinedTracks : tpc " << iTPC << " si " << iSi   << endmsg;
+    }
+  }
   
 }
 
@@ -1484,10 +1705,26 @@ void FullLDCTrackingAlg::MergeTPCandSiTracksII() {
 // if testCombinationOnly is true then hits will not be assigned to the tracks 
 TrackExtended * FullLDCTrackingAlg::CombineTracks(TrackExtended * tpcTrack, TrackExtended * siTrack, float maxAllowedOutliers, bool testCombinationOnly) {
   
-  TrackExtended * OutputTrack = NULL;
+  CombinedFit fit;
+  
+  if ( ! PrepareCombinedFit(tpcTrack, siTrack, fit) ) return 0;
+  
+  RunCombinedFit(fit);
+  
+  return FinishCombinedFit(tpcTrack, siTrack, maxAllowedOutliers, testCombinationOnly, fit);
   
-  TrackerHitExtendedVec siHitVec = siTrack->getTrackerHitExtendedVec();
-  TrackerHitExtendedVec tpcHitVec = tpcTrack->getTrackerHitExtendedVec();
+}
+
+/*
+ 
+ collect and sort the hits of the two tracks and set up the initial track state - returns false if there are less than 3 hits 
+ 
+ */
+
+bool FullLDCTrackingAlg::PrepareCombinedFit(TrackExtended * tpcTrack, TrackExtended * siTrack, CombinedFit & fit) {
+  
+  TrackerHitExtendedVec& siHitVec = siTrack->getTrackerHitExtendedVec();
+  TrackerHitExtendedVec& tpcHitVec = tpcTrack->getTrackerHitExtendedVec();
   
   int nSiHits = int(siHitVec.size());
   int nTPCHits = int(tpcHitVec.size());
@@ -1496,7 +1733,8 @@ TrackExtended * FullLDCTrackingAlg::CombineTracks(TrackExtended * tpcTrack, Trac
   //std::cout << "FullLDCTrackingAlg::CombineTracks nSiHits = " << nSiHits << endmsg;
   //std::cout << "FullLDCTrackingAlg::CombineTracks nTPCHits = " << nTPCHits << endmsg;
   
-  TrackerHitVec trkHits;
+  TrackerHitVec& trkHits = fit.hits;
+  trkHits.clear();
   trkHits.reserve(nHits);
   
   for (int ih=0;ih<nSiHits;++ih) {
@@ -1519,12 +1757,9 @@ TrackExtended * FullLDCTrackingAlg::CombineTracks(TrackExtended * tpcTrack, Trac
     }
   }
   
-  double chi2_D;
-  int ndf;
-  
   if( trkHits.size() < 3 ) {
     
-    return 0 ;
+    return false ;
     
   }
   
@@ -1550,13 +1785,8 @@ TrackExtended * FullLDCTrackingAlg::CombineTracks(TrackExtended * tpcTrack, Trac
   
   debug() << "FullLDCTrackingAlg::CombineTracks: Start Fitting: AddHits: number of hits to fit " << trkHits.size() << endmsg;
   
-  std::auto_ptr<MarlinTrk::IMarlinTrack> marlin_trk_autop(_trksystem->createTrack());
-  MarlinTrk::IMarlinTrack& marlin_trk = *marlin_trk_autop.get();
+  edm4hep::TrackState& pre_fit = fit.preFit;
   
-  edm4hep::TrackState pre_fit ;
-
-  int errorCode = IMarlinTrack::success;
-
   try{
     pre_fit = getTrackStateAt(tpcTrack->getTrack(), 3/*lcio::TrackState::AtLastHit*/);
   }
@@ -1585,23 +1815,60 @@ TrackExtended * FullLDCTrackingAlg::CombineTracks(TrackExtended * tpcTrack, Trac
   
   pre_fit.covMatrix = covMatrix;
   
-  errorCode = MarlinTrk::createFit( trkHits, &marlin_trk, &pre_fit, _bField, IMarlinTrack::backward , _maxChi2PerHit );
+  return true;
   
-  if ( errorCode != IMarlinTrack::success ) {
-    debug() << "FullLDCTrackingAlg::CombineTracks: creation of fit fails with error " << errorCode << endmsg;
+}
+
+void FullLDCTrackingAlg::RunCombinedFit(CombinedFit & fit) const {
+  
+  fit.propagateCode = IMarlinTrack::error;
+  fit.chi2 = 0;
+  fit.ndf = 0;
+  fit.outliers.clear();
+  
+  std::unique_ptr<MarlinTrk::IMarlinTrack> marlin_trk(_trksystem->createTrack());
+  
+  fit.createFitCode = MarlinTrk::createFit( fit.hits, marlin_trk.get(), &fit.preFit, _bField, IMarlinTrack::backward , _maxChi2PerHit );
+  
+  if ( fit.createFitCode != IMarlinTrack::success ) return;
+  
+  edm4hep::Vector3d point(0.,0.,0.); // nominal IP
+  
+  fit.propagateCode = marlin_trk->propagate(point, fit.trkState, fit.chi2, fit.ndf ) ;
+  
+  if ( fit.propagateCode != IMarlinTrack::success ) return;
+  
+  marlin_trk->getOutliers(fit.outliers);
+  
+}
+
+TrackExtended * FullLDCTrackingAlg::FinishCombinedFit(TrackExtended * tpcTrack, TrackExtended * siTrack, float maxAllowedOutliers, bool testCombinationOnly, CombinedFit & fit) {
+  
+  TrackExtended * OutputTrack = NULL;
+  
+  TrackerHitExtendedVec& siHitVec = siTrack->getTrackerHitExtendedVec();
+  TrackerHitExtendedVec& tpcHitVec = tpcTrack->getTrackerHitExtendedVec();
+  
+  int nSiHits = int(siHitVec.size());
+  int nTPCHits = int(tpcHitVec.size());
+  
+  const TrackerHitVec& trkHits = fit.hits;
+  
+  if ( fit.createFitCode != IMarlinTrack::success ) {
+    debug() << "FullLDCTrackingAlg::CombineTracks: creation of fit fails with error " << fit.createFitCode << endmsg;
     return 0;
   }
   debug() << "createFit finished" << endmsg;
-  edm4hep::Vector3d point(0.,0.,0.); // nominal IP
-  
-  edm4hep::TrackState trkState ;
-  errorCode = marlin_trk.propagate(point, trkState, chi2_D, ndf ) ;
   
-  if ( errorCode != IMarlinTrack::success ) {
-    debug() << "FullLDCTrackingAlg::CombineTracks: propagate to IP fails with error " << errorCode << endmsg;
+  if ( fit.propagateCode != IMarlinTrack::success ) {
+    debug() << "FullLDCTrackingAlg::CombineTracks: propagate to IP fails with error " << fit.propagateCode << endmsg;
     return 0;
   }
   
+  const edm4hep::TrackState& trkState = fit.trkState;
+  double chi2_D = fit.chi2;
+  int ndf = fit.ndf;
+  
   if ( ndf < 0  ) {
     debug() << "FullLDCTrackingAlg::CombineTracks: Fit failed NDF is less that zero  " << ndf << endmsg;
     return 0;
@@ -1616,8 +1883,7 @@ TrackExtended * FullLDCTrackingAlg::CombineTracks(TrackExtended * tpcTrack, Trac
     
   debug() << "FullLDCTrackingAlg::CombineTracks: Check for outliers " << endmsg;
   
-  std::vector<std::pair<edm4hep::TrackerHit, double> > outliers ;
-  marlin_trk.getOutliers(outliers);
+  const std::vector<std::pair<edm4hep::TrackerHit, double> >& outliers = fit.outliers;
   
   float outlier_pct = outliers.size()/float(trkHits.size()) ;
   
@@ -1783,21 +2049,7 @@ TrackExtended * FullLDCTrackingAlg::CombineTracks(TrackExtended * tpcTrack, Trac
 
 void FullLDCTrackingAlg::SortingTrackHitPairs(TrackHitPairVec & trackHitPairVec) {
   
-  int sizeOfVector = int(trackHitPairVec.size());
-  TrackHitPair *one,*two,*Temp;
-  
-  for (int i = 0 ; i < sizeOfVector-1; i++)
-    for (int j = 0; j < sizeOfVector-i-1; j++) {
-      one = trackHitPairVec[j];
-      two = trackHitPairVec[j+1];
-      float oneQ = one->getDistance();
-      float twoQ = two->getDistance();
-      if( oneQ > twoQ ) {
-        Temp = trackHitPairVec[j];
-        trackHitPairVec[j] = trackHitPairVec[j+1];
-        trackHitPairVec[j+1] = Temp;
-      }
-    }  
+  sortByDistance(trackHitPairVec);
   
 }
 
@@ -1809,21 +2061,8 @@ void FullLDCTrackingAlg::SortingTrackHitPairs(TrackHitPairVec & trackHitPairVec)
 
 void FullLDCTrackingAlg::Sorting(TrackExtendedVec & trackVec) {
   
-  int sizeOfVector = int(trackVec.size());
-  TrackExtended *one,*two,*Temp;
-  
-  for (int i = 0 ; i < sizeOfVector-1; i++)
-    for (int j = 0; j < sizeOfVector-i-1; j++) {
-      one = trackVec[j];
-      two = trackVec[j+1];
-      float oneQ = one->getChi2()/float(one->getNDF());
-      float twoQ = two->getChi2()/float(two->getNDF());
-      if( oneQ > twoQ ) {
-        Temp = trackVec[j];
-        trackVec[j] = trackVec[j+1];
-        trackVec[j+1] = Temp;
-      }
-    }
+  sortByChi2OverNDF(trackVec);
+  
 }
 
 /*
@@ -3452,47 +3691,52 @@ void FullLDCTrackingAlg::AssignOuterHitsToTracks(TrackerHitExtendedVec hitVec, f
   int nHits = int(hitVec.size());
   int nTrk = int(_trkImplVec.size());
   
-  // create maps to record which tracks and tracker hits are flagged for assignment
-  std::map <TrackExtended*,bool> flagTrack;
-  std::map <TrackerHitExtended*,bool> flagHit;
+  // record which tracks and tracker hits are flagged for assignment
+  std::vector<char> flagTrack(nTrk,false);
+  std::vector<char> flagHit(nHits,false);
 
   // vector to hold the matchups and the distance of closest approach.
-  TrackHitPairVec pairs;
-
-  flagTrack.clear();
-  flagHit.clear();
-  pairs.clear();
+  std::vector<IndexedTrackHitPair> pairs;
   
-  // loop over all hits under consideration ...
+  std::vector< std::vector<float> > hitPositions(nHits, std::vector<float>(3));
   for (int iH=0;iH<nHits;++iH) {
-
-    float pos[3];
+    edm4hep::TrackerHit hit = hitVec[iH]->getTrackerHit();
+    for (int ip=0;ip<3;++ip) {
+      hitPositions[iH][ip] = float(hit.getPosition()[ip]);
+    }
+  }
+  
+  // only the hits close to the helix in the xy projection are tried
+  HitRhoPhiIndex hitIndex(hitVec);
+  std::vector<int> hitsNearHelix;
+  
+  // loop over all tracks ...
+  for (int iT=0;iT<nTrk;++iT) {
     
-    TrackerHitExtended * trkHitExt = hitVec[iH];
-    edm4hep::TrackerHit hit = trkHitExt->getTrackerHit();
+    TrackExtended * trkExt = _trkImplVec[iT];
+    float tanLambda = trkExt->getTanLambda();
     
-    for (int ip=0;ip<3;++ip) {
-      pos[ip] = float(hit.getPosition()[ip]);
+    // use the previously created trackextrapolations for the
+    HelixClass * helix = _trackExtrapolatedHelix[trkExt];
+    
+    // skip if the extrapolations failed
+    if (helix==0) {
+      debug() << "helix extrapolation failed for trkExt" << endmsg;
+      continue;
     }
-            
-    // loop over all tracks in same z-half ...
-    for (int iT=0;iT<nTrk;++iT) {
+    
+    hitIndex.candidates(helix->getXC(),helix->getYC(),helix->getRadius(),dcut,hitsNearHelix);
+    
+    // ... and the hits under consideration in same z-half
+    for (unsigned i=0;i<hitsNearHelix.size();++i) {
+      
+      int iH = hitsNearHelix[i];
+      const std::vector<float>& pos = hitPositions[iH];
       
-      TrackExtended * trkExt = _trkImplVec[iT];
-      float tanLambda = trkExt->getTanLambda();
       float product = pos[2]*tanLambda;
       // check that the hit and track are in the same z-half, which won't work for the rare cases of something going backwards ...
       
       if (product>0) {
-      
-        // use the previously created trackextrapolations for the
-        HelixClass * helix = _trackExtrapolatedHelix[trkExt];
-        
-        // skip if the extrapolations failed
-        if (helix==0) {
-          debug() << "helix extrapolation failed for trkExt" << endmsg;
-          continue;
-        }
         
         float distance = helix->getDistanceToPoint(pos,dcut);
         
@@ -3503,11 +3747,10 @@ void FullLDCTrackingAlg::AssignOuterHitsToTracks(TrackerHitExtendedVec hitVec, f
           debug() << "for helix extrapolation " << helix << " distance = " << distance << endmsg;
           
           // ... if so create the association and flag the hit and track
-          TrackHitPair * trkHitPair =
-          new TrackHitPair(trkExt,trkHitExt,distance);
+          IndexedTrackHitPair trkHitPair = { iT, iH, distance };
           pairs.push_back(trkHitPair);
-          flagTrack[trkExt] = true;
-          flagHit[trkHitExt] = true;
+          flagTrack[iT] = true;
+          flagHit[iH] = true;
 
         }
       }
@@ -3521,18 +3764,16 @@ void FullLDCTrackingAlg::AssignOuterHitsToTracks(TrackerHitExtendedVec hitVec, f
   if (nPairs>0) {
 
     // sort the pairs on distance 
-    SortingTrackHitPairs(pairs);
+    std::sort(pairs.begin(),pairs.end());
 
     for (int iP=0;iP<nPairs;++iP) {
 
-      TrackHitPair * trkHitPair = pairs[iP];
-      TrackExtended * trkExt = trkHitPair->getTrackExtended();
-      TrackerHitExtended * trkHitExt = 
-
-      trkHitPair->getTrackerHitExtended();
+      const IndexedTrackHitPair& trkHitPair = pairs[iP];
+      TrackExtended * trkExt = _trkImplVec[trkHitPair.iT];
+      TrackerHitExtended * trkHitExt = hitVec[trkHitPair.iH];
 
       // check if the track or hit is still free to be combined
-      if (flagTrack[trkExt] && flagHit[trkHitExt]) {
+      if (flagTrack[trkHitPair.iT] && flagHit[trkHitPair.iH]) {
 
         if (refit==0) { // just set the association
           trkExt->addTrackerHitExtended( trkHitExt );
@@ -3710,20 +3951,13 @@ void FullLDCTrackingAlg::AssignOuterHitsToTracks(TrackerHitExtendedVec hitVec, f
           trkExt->addTrackerHitExtended( trkHitExt );
           trkHitExt->setTrackExtended( trkExt );
           trkHitExt->setUsedInFit( true );
-          flagTrack[trkExt] = false;
-          flagHit[trkHitExt] = false;
+          flagTrack[trkHitPair.iT] = false;
+          flagHit[trkHitPair.iH] = false;
                     
           debug() << "AssignOuterHitsToTracks: Hit " << trkHitExt << " successfully assigned to track " << trkExt << endmsg;
 	}
       }
     }
-    
-    for (int iP=0;iP<nPairs;++iP) {
-      TrackHitPair * trkHitPair = pairs[iP];
-      delete trkHitPair;
-    }
-    
-    pairs.clear();
   }
 }
 
@@ -3851,6 +4085,10 @@ void FullLDCTrackingAlg::AssignTPCHitsToTracks(TrackerHitExtendedVec hitVec,
     HitSign[iH]=std::signbit(temppos[2]);
   }
   
+  // only the hits close to the helix in the xy projection can be closer than dcut
+  HitRhoPhiIndex hitIndex(hitVec);
+  std::vector<int> hitsNearHelix;
+  
   debug() << "AssignTPCHitsToTracks: Starting loop " << nTrk << " tracks   and  " << nHits << " hits" << endmsg;
   
   for (int iT=0;iT<nTrk;++iT) { // loop over all tracks
@@ -3873,7 +4111,10 @@ void FullLDCTrackingAlg::AssignTPCHitsToTracks(TrackerHitExtendedVec hitVec,
       helix.Initialize_Canonical(phi0,d0,z0,omega,tanLambda,_bField);
       float OnePFivehalfPeriodZ = 1.5*fabs(acos(-1.)*tanLambda/omega);
       
-      for (int iH=0;iH<nHits;++iH) { // loop over leftover TPC hits
+      hitIndex.candidates(helix.getXC(),helix.getYC(),helix.getRadius(),dcut,hitsNearHelix);
+      
+      for (unsigned i=0;i<hitsNearHelix.size();++i) { // loop over leftover TPC hits
+        int iH = hitsNearHelix[i];
         
         //check if the hit and the track or on the same side
         //xor return 1, if hits are different
@@ -3980,52 +4221,57 @@ void FullLDCTrackingAlg::AssignSiHitsToTracks(TrackerHitExtendedVec hitVec,
   
   debug() << "AssignSiHitsToTracks : Number of hits to assign " <<  hitVec.size() << " : Number of available tracks = " << nTrk << endmsg;
   
-  std::map <TrackExtended*,bool> flagTrack;
-  std::map <TrackerHitExtended*,bool> flagHit;
-  TrackHitPairVec pairs;
-  flagTrack.clear();
-  flagHit.clear();
-  pairs.clear();
+  std::vector<char> flagTrack(nTrk,false);
+  std::vector<char> flagHit(nHits,false);
+  std::vector<IndexedTrackHitPair> pairs;
   
+  std::vector< std::vector<float> > hitPositions(nHits, std::vector<float>(3));
   for (int iH=0;iH<nHits;++iH) {
-    
-    float pos[3];
-    TrackerHitExtended * trkHitExt = hitVec[iH];
-    edm4hep::TrackerHit hit = trkHitExt->getTrackerHit();
-    
+    edm4hep::TrackerHit hit = hitVec[iH]->getTrackerHit();
     for (int ip=0;ip<3;++ip) {
-      pos[ip] = float(hit.getPosition()[ip]);
+      hitPositions[iH][ip] = float(hit.getPosition()[ip]);
     }
+  }
+  
+  // only the hits close to the helix in the xy projection are tried
+  HitRhoPhiIndex hitIndex(hitVec);
+  std::vector<int> hitsNearHelix;
+  
+  for (int iT=0;iT<nTrk;++iT) {
     
-    for (int iT=0;iT<nTrk;++iT) {
+    TrackExtended * trkExt = _allNonCombinedTPCTracks[iT];
+    
+    float d0 = trkExt->getD0();
+    float z0 = trkExt->getZ0();
+    float phi0 = trkExt->getPhi();
+    float omega = trkExt->getOmega();
+    float tanLambda = trkExt->getTanLambda();
+    
+    HelixClass helix;
+    helix.Initialize_Canonical(phi0,d0,z0,omega,tanLambda,_bField);
+    
+    hitIndex.candidates(helix.getXC(),helix.getYC(),helix.getRadius(),dcut,hitsNearHelix);
+    
+    for (unsigned i=0;i<hitsNearHelix.size();++i) {
       
-      TrackExtended * trkExt = _allNonCombinedTPCTracks[iT];
+      int iH = hitsNearHelix[i];
+      const std::vector<float>& pos = hitPositions[iH];
       
-      float tanLambda = trkExt->getTanLambda();
       float product = pos[2]*tanLambda;
       
       debug() << "AssignSiHitsToTracks : product =  " << product << " z hit = " << pos[2] <<  endmsg;
       
       if (product>0) {
         
-        float d0 = trkExt->getD0();
-        float z0 = trkExt->getZ0();
-        float phi0 = trkExt->getPhi();
-        float omega = trkExt->getOmega();
-        tanLambda = trkExt->getTanLambda();
-        
-        HelixClass helix;
-        helix.Initialize_Canonical(phi0,d0,z0,omega,tanLambda,_bField);
         float distance = helix.getDistanceToPoint(pos,dcut);
         
         debug() << "AssignSiHitsToTracks : distance =  " << distance << " cut = " << dcut << endmsg;
         
         if (distance<dcut) {
-          TrackHitPair * trkHitPair = 
-          new TrackHitPair(trkExt,trkHitExt,distance);
+          IndexedTrackHitPair trkHitPair = { iT, iH, distance };
           pairs.push_back(trkHitPair);
-          flagTrack[trkExt] = true;
-          flagHit[trkHitExt] = true;
+          flagTrack[iT] = true;
+          flagHit[iH] = true;
         }
       }
     }
@@ -4037,17 +4283,15 @@ void FullLDCTrackingAlg::AssignSiHitsToTracks(TrackerHitExtendedVec hitVec,
   
   if (nPairs>0) {
     
-    SortingTrackHitPairs(pairs);
+    std::sort(pairs.begin(),pairs.end());
     
     for (int iP=0;iP<nPairs;++iP) {
       
-      TrackHitPair * trkHitPair = pairs[iP];
-      TrackExtended * trkExt = trkHitPair->getTrackExtended();
-      TrackerHitExtended * trkHitExt = 
+      const IndexedTrackHitPair& trkHitPair = pairs[iP];
+      TrackExtended * trkExt = _allNonCombinedTPCTracks[trkHitPair.iT];
+      TrackerHitExtended * trkHitExt = hitVec[trkHitPair.iH];
       
-      trkHitPair->getTrackerHitExtended();
-      
-      if (flagTrack[trkExt] && flagHit[trkHitExt]) {
+      if (flagTrack[trkHitPair.iT] && flagHit[trkHitPair.iH]) {
         // get the hits already assigned to the track
         TrackerHitExtendedVec hitsInTrack = trkExt->getTrackerHitExtendedVec();
         
@@ -4216,20 +4460,12 @@ void FullLDCTrackingAlg::AssignSiHitsToTracks(TrackerHitExtendedVec hitVec,
         trkExt->addTrackerHitExtended( trkHitExt );
         trkHitExt->setTrackExtended( trkExt );
         trkHitExt->setUsedInFit( true );
-        flagTrack[trkExt] = false;
-        flagHit[trkHitExt] = false;
+        flagTrack[trkHitPair.iT] = false;
+        flagHit[trkHitPair.iH] = false;
                 
         debug() << "AssignSiHitsToTracks: Hit " << trkHitExt << " successfully assigned to track " << trkExt << endmsg;
       }
     }
-    
-    for (int iP=0;iP<nPairs;++iP) {
-      TrackHitPair * trkHitPair = pairs[iP];
-      delete trkHitPair;
-    }
-    
-    pairs.clear();
-    
   }
 }
 
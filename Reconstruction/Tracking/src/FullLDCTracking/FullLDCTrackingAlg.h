@@ -251,6 +251,9 @@ namespace MarlinTrk {
  * @param maxFractionOfOutliersCutHighPtMerge cut on maximum fraction of outliers 
  * when considering merger of high Pt tracks <br>
  * (default is 0.95 ) <br>
+ * @param NumberOfThreads number of threads fitting the Si-TPC track combinations 
+ * in MergeTPCandSiTracks, 0 means the hardware concurrency <br>
+ * (default is 1 ) <br>
  
  
  * @author A. Raspereza (MPI Munich)<br>
@@ -274,6 +277,24 @@ protected:
 
   TrackExtended* CombineTracks(TrackExtended* tpcTrk, TrackExtended* siTrk, float maxAllowedOutliers, bool testCombinationOnly);
 
+  /** Input and result of the Kalman fit of the hits of a TPC and a Si track, the steps of CombineTracks
+   */
+  struct CombinedFit {
+    std::vector<edm4hep::TrackerHit> hits;   // hits of both tracks sorted in r
+    edm4hep::TrackState preFit;
+    int createFitCode;
+    int propagateCode;
+    edm4hep::TrackState trkState;            // at the IP
+    double chi2;
+    int ndf;
+    std::vector<std::pair<edm4hep::TrackerHit, double> > outliers;
+  };
+
+  bool PrepareCombinedFit(TrackExtended* tpcTrk, TrackExtended* siTrk, CombinedFit& fit);
+  /** the fit itself - does not log, so that it can be called from several threads */
+  void RunCombinedFit(CombinedFit& fit) const;
+  TrackExtended* FinishCombinedFit(TrackExtended* tpcTrk, TrackExtended* siTrk, float maxAllowedOutliers, bool testCombinationOnly, CombinedFit& fit);
+
   // TrackExtended* TrialCombineTracks(TrackExtended* tpcTrk, TrackExtended* siTrk);
 
   void Sorting(TrackExtendedVec& trackVec);
@@ -394,6 +415,7 @@ protected:
   Gaudi::Property<float> _vetoMergeMomentumCut{this, "VetoMergeMomentumCut", 2.5};
   Gaudi::Property<float> _maxAllowedPercentageOfOutliersForTrackCombination{this, "MaxAllowedPercentageOfOutliersForTrackCombination", 0.3};
   Gaudi::Property<int>   _maxAllowedSiHitRejectionsForTrackCombination{this, "MaxAllowedSiHitRejectionsForTrackCombination", 2};
+  Gaudi::Property<int>   _nThreads{this, "NumberOfThreads", 1};
 
   //float _dPCutForForcedMerging;
   
@@ -0,0 +1,40 @@
+#ifndef FULLLDCTRACKING_TRACKSORTING
+#define FULLLDCTRACKING_TRACKSORTING
+
+#include "DataHelper/TrackExtended.h"
+#include "DataHelper/TrackHitPair.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+/** Sorts the pairs by ascending distance, pairs with equal distance keep their order.
+ *  Same order as the former bubble sort of FullLDCTrackingAlg.
+ */
+inline void sortByDistance(TrackHitPairVec& trackHitPairVec) {
+  std::stable_sort(trackHitPairVec.begin(), trackHitPairVec.end(),
+                   [](TrackHitPair* one, TrackHitPair* two) { return one->getDistance() < two->getDistance(); });
+}
+
+/** Sorts the tracks by ascending chi2/ndf, tracks with equal chi2/ndf keep their order.
+ *  chi2/ndf is computed once per track; a NaN (chi2=ndf=0) sorts after all other values,
+ *  in input order.
+ */
+inline void sortByChi2OverNDF(TrackExtendedVec& trackVec) {
+  struct TrackQuality { float quality; TrackExtended* track; };
+
+  std::vector<TrackQuality> sorted;
+  sorted.reserve(trackVec.size());
+  for (TrackExtended* track : trackVec)
+    sorted.push_back({ track->getChi2()/float(track->getNDF()), track });
+
+  std::stable_sort(sorted.begin(), sorted.end(), [](const TrackQuality& one, const TrackQuality& two) {
+    if (std::isnan(one.quality)) return false;
+    return std::isnan(two.quality) || one.quality < two.quality;
+  });
+
+  for (size_t i = 0; i < sorted.size(); ++i)
+    trackVec[i] = sorted[i].track;
+}
+
+#endif
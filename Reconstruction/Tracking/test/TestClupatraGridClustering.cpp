@@ -0,0 +1,207 @@
+// The NN clustering of Clupatra with the neighbour search of HitGrid (Clusterer::cluster_grid) must
+// give the same clusters, in the same order, as the pairwise Clusterer::cluster on toy TPC events -
+// with and without the cut on the angle and with a minimal cluster size. The time of cluster_grid
+// has to grow about linearly with the number of hits at a constant hit density.
+
+#include "clupatra_grid.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace clupatra_new;
+
+namespace {
+
+  int nFailed = 0;
+
+  void expect(bool ok, const std::string& what) {
+    if (ok) return;
+    ++nFailed;
+    std::cout << "FAILED: " << what << std::endl;
+  }
+
+  const int nRows = 100;
+  const double rhoFirstRow = 400.;  // mm
+  const double rowPitch = 6.;       // mm
+
+  // hits of nTracks curved tracks from the IP in the pad rows and some noise hits
+  std::vector<std::unique_ptr<ClupaHit>> toyEvent(int nTracks, unsigned seed) {
+    std::mt19937 gen(seed);
+    std::uniform_real_distribution<double> uni(0., 1.);
+    std::normal_distribution<double> smear(0., 1.);
+
+    const double zHalfLength = 2000.;  // mm
+
+    std::vector<std::unique_ptr<ClupaHit>> hits;
+
+    for (int t = 0; t < nTracks; ++t) {
+      double phi0 = 2. * M_PI * uni(gen) - M_PI;
+      double curv = 4.e-4 * (2. * uni(gen) - 1.);  // dphi/drho
+      double cotTheta = 2. * (2. * uni(gen) - 1.);
+      double z0 = 10. * smear(gen);
+      int lastRow = nRows / 2 + int(uni(gen) * nRows / 2);
+
+      for (int row = 0; row < lastRow; ++row) {
+        double rho = rhoFirstRow + row * rowPitch;
+        double phi = phi0 + curv * (rho - rhoFirstRow) + 0.2 / rho * smear(gen);
+        double z = z0 + cotTheta * rho + 0.5 * smear(gen);
+
+        hits.emplace_back(new ClupaHit);
+        hits.back()->layer = row;
+        hits.back()->pos = gear::Vector3D(rho * std::cos(phi), rho * std::sin(phi), z);
+      }
+    }
+
+    for (int i = 0, nNoise = 10 * nTracks; i < nNoise; ++i) {
+      int row = int(uni(gen) * nRows);
+      double rho = rhoFirstRow + row * rowPitch;
+      double phi = 2. * M_PI * uni(gen) - M_PI;
+      double z = zHalfLength * (2. * uni(gen) - 1.);
+
+      hits.emplace_back(new ClupaHit);
+      hits.back()->layer = row;
+      hits.back()->pos = gear::Vector3D(rho * std::cos(phi), rho * std::sin(phi), z);
+    }
+
+    std::shuffle(hits.begin(), hits.end(), gen);
+
+    return hits;
+  }
+
+  // the clustering hits of the event, optionally in bins of z
+  void makeHits(const std::vector<std::unique_ptr<ClupaHit>>& event, HitVec& hits, double zBin) {
+    hits.setOwner();
+    for (const auto& ch : event) {
+      int index0 = (zBin > 0. ? int(std::floor(ch->pos.z() / zBin)) : 0);
+      hits.push_back(new Hit(ch.get(), index0));
+    }
+  }
+
+  // the clusters as lists of the hits they contain
+  std::vector<std::vector<ClupaHit*>> partition(const Clusterer::cluster_list& clusters) {
+    std::vector<std::vector<ClupaHit*>> result;
+    for (CluTrack* clu : clusters) {
+      std::vector<ClupaHit*> members;
+      for (Hit* h : *clu) members.push_back(h->first);
+      std::sort(members.begin(), members.end());
+      result.push_back(members);
+    }
+    return result;
+  }
+
+  void testSamePartition(int nTracks, unsigned seed, float dCut, float caCut, unsigned minSize, double zBin) {
+    const std::string what = "nTracks=" + std::to_string(nTracks) + " dCut=" + std::to_string(dCut) +
+                             " caCut=" + std::to_string(caCut) + " minSize=" + std::to_string(minSize) +
+                             " zBin=" + std::to_string(zBin);
+
+    std::vector<std::unique_ptr<ClupaHit>> event = toyEvent(nTracks, seed);
+
+    HitDistance dist(dCut, caCut);
+    Clusterer nncl;
+
+    HitVec hitsPairwise;
+    makeHits(event, hitsPairwise, zBin);
+    Clusterer::cluster_list pairwise;
+    pairwise.setOwner();
+    nncl.cluster(hitsPairwise.begin(), hitsPairwise.end(), std::back_inserter(pairwise), dist, minSize);
+
+    HitVec hitsGrid;
+    makeHits(event, hitsGrid, zBin);
+    Clusterer::cluster_list grid;
+    grid.setOwner();
+    HitGrid hitGrid(dist);
+    nncl.cluster_grid(hitsGrid.begin(), hitsGrid.end(), std::back_inserter(grid), dist, hitGrid, minSize);
+
+    expect(!pairwise.empty(), what + ": no clusters found");
+    expect(partition(pairwise) == partition(grid), what + ": different clusters");
+
+    // the hits of a cluster of cluster_grid point back to it, the hits of dropped clusters are free
+    bool consistent = true;
+    unsigned nClustered = 0;
+    for (CluTrack* clu : grid) {
+      for (Hit* h : *clu) consistent = consistent && h->second == clu;
+      nClustered += clu->size();
+    }
+    unsigned nInCluster = 0;
+    for (Hit* h : hitsGrid) nInCluster += (h->second != 0);
+    expect(consistent && nClustered == nInCluster, what + ": hits not consistent with the clusters");
+  }
+
+  double timeGrid(int nTracks, float dCut, float caCut, unsigned& nHits) {
+    std::vector<std::unique_ptr<ClupaHit>> event = toyEvent(nTracks, 4711);
+    nHits = event.size();
+
+    HitDistance dist(dCut, caCut);
+    Clusterer nncl;
+
+    // best of a few repetitions against the noise of the machine
+    double best = 1.e99;
+    for (int rep = 0; rep < 3; ++rep) {
+      HitVec hits;
+      makeHits(event, hits, 0.);
+      Clusterer::cluster_list clusters;
+      clusters.setOwner();
+
+      auto start = std::chrono::steady_clock::now();
+      HitGrid hitGrid(dist);
+      nncl.cluster_grid(hits.begin(), hits.end(), std::back_inserter(clusters), dist, hitGrid, 1);
+      std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+      best = std::min(best, elapsed.count());
+    }
+    return best;
+  }
+
+  void testLinearScaling() {
+    const float dCut = 20.;
+    const float caCut = 0.9995;
+
+    std::vector<int> nTracks = {50, 100, 200, 400, 800};
+    std::vector<double> timePerHit;
+
+    std::cout << "cluster_grid:  tracks      hits   time/hit [ns]" << std::endl;
+    for (int n : nTracks) {
+      unsigned nHits = 0;
+      double t = timeGrid(n, dCut, caCut, nHits);
+      timePerHit.push_back(t / nHits);
+      std::cout << "              " << std::setw(7) << n << std::setw(10) << nHits << std::setw(16)
+                << 1.e9 * timePerHit.back() << std::endl;
+    }
+
+    // 16 times more hits: the time per hit of the pairwise clustering grows by 16. The one of cluster_grid
+    // grows with the number of neighbours in the cells, i.e. with the hit density in the fixed volume
+    // of the TPC, and with the cache misses of the larger event - a factor of about 3.
+    expect(timePerHit.back() < 6. * timePerHit.front(), "time of cluster_grid grows faster than linearly");
+  }
+}
+
+int main() {
+  // the cuts of ClupatraAlg: the distance cut in the loops and of the merging of small clusters
+  for (unsigned seed = 1; seed <= 3; ++seed) {
+    testSamePartition(100, seed, 20., 0.9995, 1, 0.);
+    testSamePartition(100, seed, 20., -1., 1, 0.);
+    testSamePartition(100, seed, 24., -1., 4, 0.);
+    testSamePartition(100, seed, 10., 0.9995, 7, 0.);
+  }
+  // few and many hits, hits in bins of z (Index0)
+  testSamePartition(1, 7, 20., 0.9995, 1, 0.);
+  testSamePartition(200, 8, 20., 0.9995, 1, 0.);
+  testSamePartition(100, 9, 20., 0.9995, 1, 100.);
+
+  testLinearScaling();
+
+  if (nFailed) {
+    std::cout << "FAILED: " << nFailed << " checks" << std::endl;
+    return 1;
+  }
+  std::cout << "OK" << std::endl;
+  return 0;
+}
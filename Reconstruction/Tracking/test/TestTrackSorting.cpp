@@ -0,0 +1,156 @@
+// Regression test of the sorting of FullLDCTrackingAlg: the tracks by chi2/ndf and the
+// track-hit pairs by distance must keep the order of the former bubble sorts, which
+// swapped neighbours only on a strict '>' (ties keep their input order). A NaN chi2/ndf
+// (chi2 = ndf = 0) goes after all other tracks, in input order.
+
+#include "TrackSorting.h"
+
+#include <cmath>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace {
+
+  int nFailed = 0;
+
+  void expect(bool ok, const std::string& what) {
+    if (ok) return;
+    ++nFailed;
+    std::cout << "FAILED: " << what << std::endl;
+  }
+
+  // the former FullLDCTrackingAlg::Sorting
+  void bubbleSortByChi2OverNDF(TrackExtendedVec& trackVec) {
+    int sizeOfVector = int(trackVec.size());
+    for (int i = 0 ; i < sizeOfVector-1; i++)
+      for (int j = 0; j < sizeOfVector-i-1; j++) {
+        float oneQ = trackVec[j]->getChi2()/float(trackVec[j]->getNDF());
+        float twoQ = trackVec[j+1]->getChi2()/float(trackVec[j+1]->getNDF());
+        if( oneQ > twoQ ) std::swap(trackVec[j], trackVec[j+1]);
+      }
+  }
+
+  // the former FullLDCTrackingAlg::SortingTrackHitPairs
+  void bubbleSortByDistance(TrackHitPairVec& trackHitPairVec) {
+    int sizeOfVector = int(trackHitPairVec.size());
+    for (int i = 0 ; i < sizeOfVector-1; i++)
+      for (int j = 0; j < sizeOfVector-i-1; j++) {
+        if( trackHitPairVec[j]->getDistance() > trackHitPairVec[j+1]->getDistance() )
+          std::swap(trackHitPairVec[j], trackHitPairVec[j+1]);
+      }
+  }
+
+  // owns the tracks of a test case
+  struct Tracks {
+    std::vector<std::unique_ptr<TrackExtended>> owned;
+    TrackExtendedVec vec;
+
+    void add(float chi2, int ndf) {
+      owned.emplace_back(new TrackExtended());
+      owned.back()->setChi2(chi2);
+      owned.back()->setNDF(ndf);
+      vec.push_back(owned.back().get());
+    }
+  };
+
+  bool isNaN(TrackExtended* track) {
+    return std::isnan(track->getChi2()/float(track->getNDF()));
+  }
+
+  // hand-written case: ties and NaN
+  void testTiesAndNaN() {
+    Tracks t;
+    t.add(4.f, 2);    // 0: 2
+    t.add(3.f, 3);    // 1: 1
+    t.add(0.f, 0);    // 2: NaN
+    t.add(2.f, 2);    // 3: 1, tie with 1
+    t.add(1.f, 2);    // 4: 0.5
+    t.add(5.f, 0);    // 5: +inf
+    t.add(0.f, 0);    // 6: NaN
+    t.add(0.f, 7);    // 7: 0
+    t.add(6.f, 6);    // 8: 1, tie with 1 and 3
+
+    TrackExtendedVec sorted = t.vec;
+    sortByChi2OverNDF(sorted);
+
+    const int expected[] = { 7, 4, 1, 3, 8, 0, 5, 2, 6 };
+    for (size_t i = 0; i < sorted.size(); ++i)
+      expect(sorted[i] == t.vec[expected[i]], "ties and NaN: position " + std::to_string(i));
+  }
+
+  // random keys with many ties: same order as the bubble sort
+  void testRandomTracks(std::mt19937& rng) {
+    std::uniform_int_distribution<int> chi2(0, 20);
+    std::uniform_int_distribution<int> ndf(1, 4);
+    for (int n : { 0, 1, 2, 3, 10, 100, 500 }) {
+      Tracks t;
+      for (int i = 0; i < n; ++i) t.add(float(chi2(rng)), ndf(rng));
+
+      TrackExtendedVec sorted = t.vec;
+      TrackExtendedVec reference = t.vec;
+      sortByChi2OverNDF(sorted);
+      bubbleSortByChi2OverNDF(reference);
+      expect(sorted == reference, "tracks: order of " + std::to_string(n) + " random tracks");
+    }
+  }
+
+  // random keys with NaN: the other tracks in the order of the bubble sort,
+  // then the NaN tracks in input order
+  void testRandomTracksWithNaN(std::mt19937& rng) {
+    std::uniform_int_distribution<int> chi2(0, 10);
+    std::uniform_int_distribution<int> ndf(0, 3);
+    for (int n : { 1, 5, 50, 300 }) {
+      Tracks t;
+      for (int i = 0; i < n; ++i) t.add(float(chi2(rng)), ndf(rng));
+
+      TrackExtendedVec reference;
+      TrackExtendedVec nans;
+      for (TrackExtended* track : t.vec) (isNaN(track) ? nans : reference).push_back(track);
+      bubbleSortByChi2OverNDF(reference);
+      reference.insert(reference.end(), nans.begin(), nans.end());
+
+      TrackExtendedVec sorted = t.vec;
+      sortByChi2OverNDF(sorted);
+      expect(sorted == reference, "tracks: order of " + std::to_string(n) + " random tracks with NaN");
+    }
+  }
+
+  // random distances with many ties: same order as the bubble sort
+  void testRandomPairs(std::mt19937& rng) {
+    std::uniform_int_distribution<int> distance(0, 15);
+    for (int n : { 0, 1, 2, 10, 100, 500 }) {
+      std::vector<std::unique_ptr<TrackHitPair>> owned;
+      TrackHitPairVec pairs;
+      for (int i = 0; i < n; ++i) {
+        owned.emplace_back(new TrackHitPair(nullptr, nullptr, 0.25f*distance(rng)));
+        pairs.push_back(owned.back().get());
+      }
+
+      TrackHitPairVec sorted = pairs;
+      TrackHitPairVec reference = pairs;
+      sortByDistance(sorted);
+      bubbleSortByDistance(reference);
+      expect(sorted == reference, "pairs: order of " + std::to_string(n) + " random pairs");
+    }
+  }
+}
+
+int main() {
+  std::mt19937 rng(4321);
+
+  testTiesAndNaN();
+  testRandomTracks(rng);
+  testRandomTracksWithNaN(rng);
+  testRandomPairs(rng);
+
+  if (nFailed) {
+    std::cout << "FAILED: " << nFailed << " checks" << std::endl;
+    return 1;
+  }
+  std::cout << "OK" << std::endl;
+  return 0;
+}
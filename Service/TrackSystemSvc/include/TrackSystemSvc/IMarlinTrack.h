@@ -79,6 +79,14 @@ namespace MarlinTrk{
     virtual int fit( double maxChi2Increment=DBL_MAX ) = 0 ;
     
     
+    /** refit the hits of the last fit() with another maxChi2Increment, returns error code as fit().
+     *  the result is the one of a new track fitted with this maxChi2Increment, but the fit resumes from the
+     *  last site before the first hit that the new cut decides differently. Returns IMarlinTrack::error,
+     *  if the track cannot be refitted - it was not fitted with fit(), was smoothed or changed since.
+     */
+    virtual int refit( double maxChi2Increment ) = 0 ;
+    
+    
     /** update the current fit using the supplied hit, return code via int. Provides the Chi2 increment to the fit from adding the hit via reference. 
      *  the given hit will not be added if chi2increment > maxChi2Increment. 
      */
@@ -51,8 +51,10 @@ class IMarlinTrkSystem {
     static const unsigned  usedEdx  = 2 ;
     /** Use smoothing when calling fit( bool fitDirection ) */
     static const unsigned  useSmoothing = 3 ;
+    /** Use the gain formalism with the Joseph form covariance update in the filter step */
+    static const unsigned  useGainFormFilter = 4 ;
     //---
-    static const unsigned  size     = 4 ;
+    static const unsigned  size     = 5 ;
     
   } ;
   
@@ -12,9 +12,12 @@ class ITrackSystemSvc: virtual public IService {
   
   virtual ~ITrackSystemSvc() = default;
   
-  //Get the track manager
+  //Get the track manager of the calling thread for the address. The track manager of the
+  //address on another thread is created with the options of the existing one, and initialised
+  //if that is, so it should be configured and initialised before the first parallel use.
   virtual MarlinTrk::IMarlinTrkSystem* getTrackSystem(void* address=0) = 0;
   
+  //Remove the track managers of the address on all threads
   virtual void removeTrackSystem(void* address=0) = 0;
 };
 
@@ -22,6 +22,7 @@ namespace UTIL {
 
 namespace MarlinTrk{
   class IMarlinTrack ;
+  class IMarlinTrkSystem ;
 }
 
 
@@ -77,6 +78,37 @@ namespace MarlinTrk{
       edm4hep::TrackState* atLastHit=0,
       edm4hep::TrackState* atCaloFace=0);
   
+  /** One track of createFinalisedLCIOTracks: the hits to fit, the initial helix with its covariance matrix
+   *  and the TrackImpl to record the fit. If pre_fit is NULL the prefit is made from the hits with createPrefit
+   *  and the covariance matrix given to createFinalisedLCIOTracks. */
+  struct FitRequest {
+    std::vector<edm4hep::TrackerHit>* hit_list ;
+    edm4hep::TrackState* pre_fit ;
+    edm4hep::MutableTrack* track ;
+  };
+  
+  /** Fits a batch of tracks as createFinalisedLCIOTrack does for each of them, using nthreads threads 
+   *  (0: hardware concurrency). The error code of each request is returned in error_codes, in input order.
+   *  If a fit throws, the exception of the first such request is rethrown once all the fits are done.
+   *  
+   *  With more than one thread the caller must make sure that
+   *  - trkSystem is initialised, and createTrack() and the tracks it creates only read shared state: this
+   *    holds for MarlinKalTest, whose geometry is not modified after init() and whose KalTest workspaces
+   *    are per thread,
+   *  - the requests do not share their hit lists, prefits or tracks,
+   *  - the hits, and the collections Navigation resolves the raw hits of composite space points from,
+   *    are not modified during the call.
+   *  The results do not depend on the number of threads. */
+  void createFinalisedLCIOTracks(
+      IMarlinTrkSystem* trkSystem,
+      std::vector<FitRequest>& requests,
+      std::vector<int>& error_codes,
+      bool fit_backwards,
+      const std::array<float,15>& initial_cov_for_prefit,
+      float bfield_z,
+      double maxChi2Increment=DBL_MAX,
+      unsigned nthreads=1);
+  
   /** Set the subdetector hit numbers for the TrackImpl */
   void addHitNumbersToTrack(edm4hep::MutableTrack* track, std::vector<edm4hep::TrackerHit>& hit_list, bool hits_in_fit, UTIL::BitField64& cellID_encoder);
 
@@ -25,6 +25,7 @@ namespace MarlinTrk{
     _cfg.registerOption( IMarlinTrkSystem::CFG::useQMS,  "useMultipleScattering", true) ;
     _cfg.registerOption( IMarlinTrkSystem::CFG::usedEdx, "useEnergyLoss", true) ;
     _cfg.registerOption( IMarlinTrkSystem::CFG::useSmoothing, "useSmoothingInFit", false) ;
+    _cfg.registerOption( IMarlinTrkSystem::CFG::useGainFormFilter, "useGainFormFilter", false) ;
     
     
   }
@@ -39,15 +39,36 @@
 
 namespace MarlinTrk{
   
-  MarlinKalTest::MarlinKalTest( const gear::GearMgr& gearMgr, IGeomSvc* geoSvc) : 
-  _ipLayer(NULL) ,
-  _gearMgr( &gearMgr ),
-  _geoSvc(geoSvc){
+  MarlinKalTest::Geometry::Geometry() : det(0), ipLayer(0) {
     
-    //streamlog_out( DEBUG4 ) << "  MarlinKalTest - initializing the detector ..." << std::endl ;
+    det = new TKalDetCradle ; // from kaltest. TKalDetCradle inherits from TObjArray ... 
+    det->SetOwner( true ) ; // takes care of deleting subdetector in the end ...
     
-    _det = new TKalDetCradle ; // from kaltest. TKalDetCradle inherits from TObjArray ... 
-    _det->SetOwner( true ) ; // takes care of deleting subdetector in the end ...
+  }
+  
+  MarlinKalTest::Geometry::~Geometry() {
+    delete det ;
+  }
+  
+  
+  std::shared_ptr<const MarlinKalTest::Geometry> MarlinKalTest::GeometryCache::get( bool msOn, bool energyLossOn, const std::function<std::shared_ptr<const Geometry>()>& build ) {
+    
+    std::lock_guard<std::mutex> lock( _mutex ) ;
+    
+    std::shared_ptr<const Geometry>& geometry = _geometries[ std::make_pair( msOn, energyLossOn ) ] ;
+    if( ! geometry ) geometry = build() ;
+    
+    return geometry ;
+  }
+  
+  
+  MarlinKalTest::MarlinKalTest( const gear::GearMgr& gearMgr, IGeomSvc* geoSvc, std::shared_ptr<GeometryCache> geometryCache) : 
+  _ipLayer(NULL) ,
+  _gearMgr( &gearMgr ),
+  _geoSvc(geoSvc),
+  _det(NULL),
+  _geometryCache(geometryCache),
+  _useGainFormFilter(false){
     
     is_initialised = false; 
     
@@ -64,15 +85,16 @@ namespace MarlinTrk{
     _diagnostics.end();
 #endif
     
-    delete _det ;
+    // the detector cradle is owned by _geometry
   }
   
   
-  void MarlinKalTest::init() {
+  std::shared_ptr<const MarlinKalTest::Geometry> MarlinKalTest::buildGeometry( bool msOn, bool energyLossOn ) const {
     
-    std::cout << "debug: MarlinKalTest - call  this init " << std::endl ;
     //ILDSITKalDetector* sitdet = new ILDSITKalDetector( *_gearMgr, _geoSvc )  ;
     
+    std::shared_ptr<Geometry> geometry = std::make_shared<Geometry>() ;
+    
     MeasurementSurfaceStore& surfstore = _gearMgr->getMeasurementSurfaceStore();
     
     // Check if the store is filled if not fill it. NOTE: In the case it is filled we just take what we are given and in debug print a message
@@ -91,8 +113,8 @@ namespace MarlinTrk{
       try{
         kaldet::LCTPCKalDetector* tpcdet = new kaldet::LCTPCKalDetector( *_gearMgr )  ;
         // store the measurement layer id's for the active layers
-        this->storeActiveMeasurementModuleIDs(tpcdet);
-        _det->Install( *tpcdet ) ;
+        this->storeActiveMeasurementModuleIDs(tpcdet, *geometry);
+        geometry->det->Install( *tpcdet ) ;
       }
       catch( gear::UnknownParameterException& e){
         //streamlog_out( MESSAGE ) << "  MarlinKalTest - TPC missing in gear file: TPC Not Built " << std::endl ;
@@ -103,10 +125,10 @@ namespace MarlinTrk{
       try{
         ILDSupportKalDetector* supportdet = new ILDSupportKalDetector( *_gearMgr, _geoSvc )  ;
         // get the dedicated ip layer
-        _ipLayer = supportdet->getIPLayer() ;
+        geometry->ipLayer = supportdet->getIPLayer() ;
         // store the measurement layer id's for the active layers, Calo is defined as active
-        this->storeActiveMeasurementModuleIDs(supportdet);
-        _det->Install( *supportdet ) ;
+        this->storeActiveMeasurementModuleIDs(supportdet, *geometry);
+        geometry->det->Install( *supportdet ) ;
       }
       catch( gear::UnknownParameterException& e){
 	std::cout << "Error: " << "MarlinKalTest - Support Material missing in gear file: Cannot proceed as propagations and extrapolations for cannonical track states are impossible: exit(1) called" << std::endl ;
@@ -116,8 +138,8 @@ namespace MarlinTrk{
       try{
         ILDVXDKalDetector* vxddet = new ILDVXDKalDetector( *_gearMgr, _geoSvc )  ;
         // store the measurement layer id's for the active layers
-        this->storeActiveMeasurementModuleIDs(vxddet);
-        _det->Install( *vxddet ) ;
+        this->storeActiveMeasurementModuleIDs(vxddet, *geometry);
+        geometry->det->Install( *vxddet ) ;
       }
       catch( gear::UnknownParameterException& e){
 	std::cout << "Warning: " << "  MarlinKalTest - VXD missing in gear file: VXD Material Not Built " << std::endl ;
@@ -127,8 +149,8 @@ namespace MarlinTrk{
       try{
         ILDSITKalDetector* sitdet = new ILDSITKalDetector( *_gearMgr, _geoSvc )  ;
         // store the measurement layer id's for the active layers 
-        this->storeActiveMeasurementModuleIDs(sitdet);
-        _det->Install( *sitdet ) ;
+        this->storeActiveMeasurementModuleIDs(sitdet, *geometry);
+        geometry->det->Install( *sitdet ) ;
         SIT_found = true ;
       }
       catch( gear::UnknownParameterException& e){
@@ -139,8 +161,8 @@ namespace MarlinTrk{
         try{
           ILDSITCylinderKalDetector* sitdet = new ILDSITCylinderKalDetector( *_gearMgr )  ;
           // store the measurement layer id's for the active layers
-          this->storeActiveMeasurementModuleIDs(sitdet);
-          _det->Install( *sitdet ) ;
+          this->storeActiveMeasurementModuleIDs(sitdet, *geometry);
+          geometry->det->Install( *sitdet ) ;
         }
         catch( gear::UnknownParameterException& e){
 	  std::cout << "Warning: " << "  MarlinKalTest - Simple Cylinder Based SIT missing in gear file: Simple Cylinder Based SIT Not Built " << std::endl ;
@@ -150,8 +172,8 @@ namespace MarlinTrk{
       try{
         ILDSETKalDetector* setdet = new ILDSETKalDetector( *_gearMgr, _geoSvc )  ;
         // store the measurement layer id's for the active layers
-        this->storeActiveMeasurementModuleIDs(setdet);
-        _det->Install( *setdet ) ;
+        this->storeActiveMeasurementModuleIDs(setdet, *geometry);
+        geometry->det->Install( *setdet ) ;
       }
       catch( gear::UnknownParameterException& e){
 	std::cout << "Warning: " << "  MarlinKalTest - SET missing in gear file: SET Not Built " << std::endl ;
@@ -161,8 +183,8 @@ namespace MarlinTrk{
       try{
         ILDFTDKalDetector* ftddet = new ILDFTDKalDetector( *_gearMgr, _geoSvc )  ;
         // store the measurement layer id's for the active layers 
-        this->storeActiveMeasurementModuleIDs(ftddet);
-        _det->Install( *ftddet ) ;    
+        this->storeActiveMeasurementModuleIDs(ftddet, *geometry);
+        geometry->det->Install( *ftddet ) ;    
         FTD_found = true ;
       }
       catch( gear::UnknownParameterException& e){
@@ -173,8 +195,8 @@ namespace MarlinTrk{
         try{
           ILDFTDDiscBasedKalDetector* ftddet = new ILDFTDDiscBasedKalDetector( *_gearMgr )  ;
           // store the measurement layer id's for the active layers
-          this->storeActiveMeasurementModuleIDs(ftddet);
-          _det->Install( *ftddet ) ;
+          this->storeActiveMeasurementModuleIDs(ftddet, *geometry);
+          geometry->det->Install( *ftddet ) ;
         }
         catch( gear::UnknownParameterException& e){
 	  std::cout << "Warning: " << "  MarlinKalTest - Simple Disc Based FTD missing in gear file: Simple Disc Based FTD Not Built " << std::endl ;
@@ -184,8 +206,8 @@ namespace MarlinTrk{
       try{
         ILDTPCKalDetector* tpcdet = new ILDTPCKalDetector( *_gearMgr, _geoSvc )  ;
         // store the measurement layer id's for the active layers
-        this->storeActiveMeasurementModuleIDs(tpcdet);
-        _det->Install( *tpcdet ) ;
+        this->storeActiveMeasurementModuleIDs(tpcdet, *geometry);
+        geometry->det->Install( *tpcdet ) ;
       }
       catch( gear::UnknownParameterException& e){   
 	std::cout << "Warning: " << "  MarlinKalTest - TPC missing in gear file: TPC Not Built " << std::endl ;
@@ -193,15 +215,44 @@ namespace MarlinTrk{
       
     }
 
-    _det->Close() ;          // close the cradle
-    _det->Sort() ;           // sort meas. layers from inside to outside
+    geometry->det->Close() ;          // close the cradle
+    geometry->det->Sort() ;           // sort meas. layers from inside to outside
+    
+    //streamlog_out( DEBUG4 ) << "  MarlinKalTest - number of layers = " << geometry->det->GetEntriesFast() << std::endl ;
+    
+    if( msOn ) geometry->det->SwitchOnMS() ;
+    else       geometry->det->SwitchOffMS() ;
+    
+    if( energyLossOn ) geometry->det->SwitchOnDEDX() ;
+    else               geometry->det->SwitchOffDEDX() ;
+    
+    return geometry ;
     
-    //streamlog_out( DEBUG4 ) << "  MarlinKalTest - number of layers = " << _det->GetEntriesFast() << std::endl ;
+  }
+  
+  
+  void MarlinKalTest::init() {
+    
+    std::cout << "debug: MarlinKalTest - call  this init " << std::endl ;
     
     //streamlog_out( DEBUG4 ) << "Options: " << std::endl << this->getOptions() << std::endl ;
     
-    this->includeMultipleScattering( getOption(IMarlinTrkSystem::CFG::useQMS) ) ;  
-    this->includeEnergyLoss( getOption(IMarlinTrkSystem::CFG::usedEdx) ) ; 
+    const bool msOn = getOption(IMarlinTrkSystem::CFG::useQMS) ;
+    const bool energyLossOn = getOption(IMarlinTrkSystem::CFG::usedEdx) ;
+    
+    // the geometry is built once per material treatment and shared by all the systems using the cache
+    if( _geometryCache ) {
+      _geometry = _geometryCache->get( msOn, energyLossOn, [this, msOn, energyLossOn]() { return this->buildGeometry( msOn, energyLossOn ) ; } ) ;
+    }
+    else {
+      _geometry = this->buildGeometry( msOn, energyLossOn ) ;
+    }
+    
+    _det = _geometry->det ;
+    _ipLayer = _geometry->ipLayer ;
+    
+    // the filter formalism is set on each track created by this system
+    _useGainFormFilter = getOption(IMarlinTrkSystem::CFG::useGainFormFilter) ;
     
     
     is_initialised = true; 
@@ -219,28 +270,6 @@ namespace MarlinTrk{
     return new MarlinTrk::MarlinKalTestTrack(this) ;
   }
   
-  void MarlinKalTest::includeMultipleScattering( bool msOn ) {
-    
-    if( msOn == true ) {
-      _det->SwitchOnMS();
-    }
-    else{
-      _det->SwitchOffMS();
-    } 
-    
-  } 
-  
-  void MarlinKalTest::includeEnergyLoss( bool energyLossOn ) {
-    
-    if( energyLossOn == true ) {
-      _det->SwitchOnDEDX();
-    }
-    else{
-      _det->SwitchOffDEDX();
-    } 
-    
-  } 
-  
   void MarlinKalTest::getSensitiveMeasurementModulesForLayer( int layerID, std::vector< const ILDVMeasLayer *>& measmodules) const {
     
     if( ! measmodules.empty() ) {
@@ -265,13 +294,14 @@ namespace MarlinTrk{
     std::pair<std::multimap<Int_t, const ILDVMeasLayer *>::const_iterator, std::multimap<Int_t, const ILDVMeasLayer *>::const_iterator> ii;  
     
     // set the module and sensor bit ranges to zero as these are not used in the map 
-    lcio::BitField64 bf(  UTIL::ILDCellID0::encoder_string ) ;
-    bf.setValue( layerID ) ;
-    bf[lcio::ILDCellID0::module] = 0 ;
-    bf[lcio::ILDCellID0::sensor] = 0 ;
-    layerID = bf.lowWord();
+    // the mask is computed once: this is called for every layer a track is stepped through
+    static const unsigned long long moduleSensorMask = [](){
+      lcio::BitField64 bf(  UTIL::ILDCellID0::encoder_string ) ;
+      return bf[lcio::ILDCellID0::module].mask() | bf[lcio::ILDCellID0::sensor].mask() ;
+    }() ;
+    layerID = int( layerID & ~moduleSensorMask ) ;
     
-    ii = this->_active_measurement_modules_by_layer.equal_range(layerID); // set the first and last entry in ii;
+    ii = _geometry->active_measurement_modules_by_layer.equal_range(layerID); // set the first and last entry in ii;
     
     for(it = ii.first; it != ii.second; ++it) {
       //    streamlog_out( DEBUG0 ) <<"Key = "<< it->first <<"    Value = "<<it->second << std::endl ;
@@ -291,7 +321,7 @@ namespace MarlinTrk{
     }
     
     std::pair<std::multimap<int, const ILDVMeasLayer *>::const_iterator, std::multimap<Int_t, const ILDVMeasLayer *>::const_iterator> ii;
-    ii = this->_active_measurement_modules.equal_range(moduleID); // set the first and last entry in ii;
+    ii = _geometry->active_measurement_modules.equal_range(moduleID); // set the first and last entry in ii;
     
     std::multimap<int,const ILDVMeasLayer *>::const_iterator it; //Iterator to be used along with ii
     
@@ -303,7 +333,7 @@ namespace MarlinTrk{
   }
   
   
-  void MarlinKalTest::storeActiveMeasurementModuleIDs(TVKalDetector* detector) {
+  void MarlinKalTest::storeActiveMeasurementModuleIDs(TVKalDetector* detector, Geometry& geometry) const {
     
     Int_t nLayers = detector->GetEntriesFast() ;
     
@@ -325,14 +355,14 @@ namespace MarlinTrk{
         while ( it!=ml->getCellIDs().end() ) {
           
           int sensitive_element_id = *it;
-          this->_active_measurement_modules.insert(std::pair<int,const ILDVMeasLayer*>( sensitive_element_id, ml ));        
+          geometry.active_measurement_modules.insert(std::pair<int,const ILDVMeasLayer*>( sensitive_element_id, ml ));        
           ++it;
           
         }
         
         int subdet_layer_id = ml->getLayerID() ;
         
-        this->_active_measurement_modules_by_layer.insert(std::pair<int ,const ILDVMeasLayer*>(subdet_layer_id,ml));
+        geometry.active_measurement_modules_by_layer.insert(std::pair<int ,const ILDVMeasLayer*>(subdet_layer_id,ml));
         
         //streamlog_out(DEBUG0) << "MarlinKalTest::storeActiveMeasurementLayerIDs added active layer with "
         //<< " LayerID = " << subdet_layer_id << " and DetElementIDs  " ;
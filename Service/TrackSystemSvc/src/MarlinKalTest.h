@@ -18,6 +18,11 @@
 #include "TVector3.h"
 
 #include <cmath>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <utility>
 #include <vector>
 #include "DetInterface/IGeomSvc.h"
 
@@ -47,8 +52,42 @@ namespace MarlinTrk{
     static const bool OrderIncoming  = false ;
     
     
-    /** Default c'tor, initializes the geometry from GEAR. */
-    MarlinKalTest( const gear::GearMgr& gearMgr, IGeomSvc* geoSvc = 0) ;
+    /** Detector geometry used by the fitter: the KalTest detector cradle and the maps of the
+     *  active measurement modules. It is not modified after it has been built, so that it
+     *  can be shared by several MarlinKalTest instances fitting concurrently.
+     */
+    struct Geometry {
+      Geometry() ;
+      ~Geometry() ;
+      
+      TKalDetCradle* det ;
+      const ILDCylinderMeasLayer* ipLayer ;
+      std::multimap< int,const ILDVMeasLayer *> active_measurement_modules ;
+      std::multimap< int,const ILDVMeasLayer *> active_measurement_modules_by_layer ;
+      
+    private:
+      Geometry( const Geometry& ) ;
+      Geometry& operator=( const Geometry& ) ;
+    } ;
+    
+    /** Geometries shared between MarlinKalTest instances, one per material treatment 
+     *  (multiple scattering, energy loss) as these switches are held by the detector cradle.
+     */
+    class GeometryCache {
+    public:
+      /** return the geometry for the given switches, built with build() if not yet done */
+      std::shared_ptr<const Geometry> get( bool msOn, bool energyLossOn, const std::function<std::shared_ptr<const Geometry>()>& build ) ;
+      
+    private:
+      std::mutex _mutex ;
+      std::map< std::pair<bool,bool>, std::shared_ptr<const Geometry> > _geometries ;
+    } ;
+    
+    
+    /** Default c'tor, initializes the geometry from GEAR. 
+     *  If a cache is given, the geometry is taken from it and shared with the other users of the cache.
+     */
+    MarlinKalTest( const gear::GearMgr& gearMgr, IGeomSvc* geoSvc = 0, std::shared_ptr<GeometryCache> geometryCache = std::shared_ptr<GeometryCache>() ) ;
     
     /** d'tor */
     ~MarlinKalTest() ;
@@ -59,16 +98,16 @@ namespace MarlinTrk{
     /** instantiate its implementation of the IMarlinTrack */
     IMarlinTrack* createTrack();
     
-  protected:
+    /** true once init() has been called */
+    bool isInitialised() const { return is_initialised ; }
     
-    /** take multiple scattering into account during the fit */
-    void includeMultipleScattering(bool on);
+  protected:
     
-    /** take energy loss into account during the fit */
-    void includeEnergyLoss(bool on);
+    /** build the detector cradle, taking into account multiple scattering and energy loss as requested */
+    std::shared_ptr<const Geometry> buildGeometry(bool msOn, bool energyLossOn) const;
     
     /** Store active measurement module IDs for a given TVKalDetector needed for navigation  */
-    void storeActiveMeasurementModuleIDs(TVKalDetector* detector);  
+    void storeActiveMeasurementModuleIDs(TVKalDetector* detector, Geometry& geometry) const;  
     
     /** Store active measurement module IDs needed for navigation  */
     void getSensitiveMeasurementModules(int detElementID, std::vector< const ILDVMeasLayer *>& measmodules) const; 
@@ -94,11 +133,13 @@ namespace MarlinTrk{
     const gear::GearMgr* _gearMgr ;
     IGeomSvc* _geoSvc;
     
-    TKalDetCradle* _det ;            // the detector cradle
+    TKalDetCradle* _det ;            // the detector cradle, owned by _geometry
+    
+    std::shared_ptr<const Geometry> _geometry ;
     
-    std::multimap< int,const ILDVMeasLayer *> _active_measurement_modules;
+    std::shared_ptr<GeometryCache> _geometryCache ;
     
-    std::multimap< int,const ILDVMeasLayer *> _active_measurement_modules_by_layer;
+    bool _useGainFormFilter ;        // filter formalism of the tracks of this system, see TVKalSite::EFilterMode
     
   } ;
 }
@@ -80,6 +80,7 @@ namespace MarlinTrk {
     
     _kaltrack = new TKalTrack() ;
     _kaltrack->SetOwner() ;
+    _kaltrack->SetFilterMode( _ktest->_useGainFormFilter ? TVKalSite::kGainJoseph : TVKalSite::kWeightedMeans ) ;
     
     _kalhits = new TObjArray() ;
     _kalhits->SetOwner() ;
@@ -706,7 +707,7 @@ namespace MarlinTrk {
     }
     else {
       this->addHit(trkhit, kalhit, ml ) ; 
-      _hit_used_for_sites[trkhit] = site ;
+      this->setSiteForLCIOHit( trkhit, site ) ;
       _hit_chi2_values.push_back(std::make_pair(trkhit, chi2increment));
     }
     
@@ -791,12 +792,100 @@ namespace MarlinTrk {
       
     }
     
+    _fit_chi2_increments.clear() ;
+    
+    return this->filterHits( 0, maxChi2Increment ) ;
+    
+  }
+  
+  
+  
+  int MarlinKalTestTrack::refit( double maxChi2Increment ) {
+    
+    if ( ! _initialised ) {
+      
+      throw MarlinTrk::Exception("Track fit not initialised");   
+      
+    }
+    
+    // the sites and the bookkeeping must be those of the last fit()
+    const unsigned nsteps = _fit_chi2_increments.size() ;
+    unsigned nused = 0 ;
+    for( unsigned i = 0 ; i < nsteps ; ++i ) nused += _fit_chi2_increments[i].second ;
+    
+    if( nsteps != unsigned( _kalhits->GetEntriesFast() ) || _kaltrack->GetEntriesFast() != int( nused ) + 1 
+        || _hit_used_for_sites.size() != nused || _hit_chi2_values.size() != nused 
+        || _outlier_chi2_values.size() != nsteps - nused ) {
+      return error ;
+    }
+    
+    // up to the first hit that the new cut decides differently, a new fit would give the same sites:
+    // hits discarded for any reason other than the Chi2 cut are discarded with any cut
+    unsigned first = 0 ;
+    unsigned nsites = 0 ;
+    for( ; first < nsteps ; ++first ) {
+      
+      const double chi2increment = _fit_chi2_increments[first].first ;
+      const bool used = _fit_chi2_increments[first].second ;
+      
+      if( used != ( chi2increment < maxChi2Increment ) && ( used || chi2increment != DBL_MAX ) ) break ;
+      
+      nsites += used ;
+      
+    }
+    
+    if( first == nsteps ) return _hit_used_for_sites.empty() == false ? success : all_sites_fail_fit ;
+    
+    // the smoothing changed the chi2 increments of the sites
+    if( _smoothed ) return error ;
+    
+    // ---------------------------
+    //  Remove the sites and hits from the first hit decided differently on
+    // ---------------------------
+    
+    _kaltrack->CutBackTo( nsites ) ;
+    
+    for( unsigned i = nsites ; i < nused ; ++i ) {
+      _hit_used_for_sites_index.erase( _hit_used_for_sites[i].first ) ;
+    }
+    _hit_used_for_sites.erase( _hit_used_for_sites.begin() + nsites, _hit_used_for_sites.end() ) ;
+    _hit_chi2_values.erase( _hit_chi2_values.begin() + nsites, _hit_chi2_values.end() ) ;
+    _outlier_chi2_values.erase( _outlier_chi2_values.begin() + ( first - nsites ), _outlier_chi2_values.end() ) ;
+    
+    _hit_not_used_for_sites.clear() ;
+    for( unsigned i = 0 ; i < _outlier_chi2_values.size() ; ++i ) {
+      _hit_not_used_for_sites.insert( _outlier_chi2_values[i].first ) ;
+    }
+    
+    if( _hitIndexAtPositiveNDF > int( nsites ) ) {
+      _trackHitAtPositiveNDF = edm4hep::TrackerHit(0) ;
+      _hitIndexAtPositiveNDF = 0 ;
+    }
+    
+    _fit_chi2_increments.erase( _fit_chi2_increments.begin() + first, _fit_chi2_increments.end() ) ;
+    
+    return this->filterHits( first, maxChi2Increment ) ;
+    
+  }
+  
+  
+  
+  int MarlinKalTestTrack::filterHits( unsigned first, double maxChi2Increment ) {
+    
     // ---------------------------
     //  Prepare hit iterrator for adding hits to kaltrack
     // ---------------------------
     
     TIter next(_kalhits, _fitDirection); 
     
+    for( unsigned i = 0 ; i < first ; ++i ) next() ;
+    
+    const unsigned nhits = _kalhits->GetEntriesFast() - first ;
+    _hit_used_for_sites.reserve( _hit_used_for_sites.size() + nhits ) ;
+    _hit_used_for_sites_index.reserve( _hit_used_for_sites_index.size() + nhits ) ;
+    _hit_chi2_values.reserve( _hit_chi2_values.size() + nhits ) ;
+    _fit_chi2_increments.reserve( _fit_chi2_increments.size() + nhits ) ;
+    
     // ---------------------------
     //  Start Kalman Filter
     // ---------------------------
@@ -813,7 +902,7 @@ namespace MarlinTrk {
       edm4hep::TrackerHit trkhit = kalhit->getLCIOTrackerHit();
       
       if( error_code == 0 ){ // add trkhit to map associating trkhits and sites
-        _hit_used_for_sites[trkhit] = site;
+        this->setSiteForLCIOHit( trkhit, site ) ;
         _hit_chi2_values.push_back(std::make_pair(trkhit, chi2increment));
 
         // set the values for the point at which the fit becomes constained 
@@ -848,10 +937,12 @@ namespace MarlinTrk {
         //streamlog_out( DEBUG2 ) << ">>>>>>>>>>>  fit(): Number of Outliers : "
         //<< _outlier_chi2_values.size() << std::endl;
 
-        _hit_not_used_for_sites.push_back(trkhit) ;
+        _hit_not_used_for_sites.insert(trkhit) ;
         
       }
       
+      _fit_chi2_increments.push_back(std::make_pair(chi2increment, error_code == 0));
+      
     } // end of Kalman filter
     
     if( _ktest->getOption(  MarlinTrk::IMarlinTrkSystem::CFG::useSmoothing ) ){
@@ -908,8 +999,6 @@ namespace MarlinTrk {
       return bad_intputs ;
     }
         
-    std::map<edm4hep::TrackerHit, TKalTrackSite*>::const_iterator it;
-        
     TKalTrackSite* site = 0 ;
     int error_code = getSiteFromLCIOHit(trkhit, site);
     
@@ -1207,6 +1296,9 @@ namespace MarlinTrk {
     
     TMatrixD c0(trkState.GetCovMat());  
     
+    // the layers take the particle mass from the current system in Transport and CalcQms
+    TVKalSystem::TScopedInstance current( _kaltrack ) ;
+    
     // the last layer crossed by the track before point 
     if( ! ml ){
       ml = _ktest->getLastMeasLayer(helix, tpoint);
@@ -1664,19 +1756,11 @@ namespace MarlinTrk {
   
   int MarlinKalTestTrack::getSiteFromLCIOHit( edm4hep::TrackerHit& trkhit, TKalTrackSite*& site ) const {
     
-    std::map<edm4hep::TrackerHit,TKalTrackSite*>::const_iterator it;
+    auto it = _hit_used_for_sites_index.find(trkhit) ;  
     
-    it = _hit_used_for_sites.find(trkhit) ;  
-    
-    if( it == _hit_used_for_sites.end() ) { // hit not associated with any site
-      
-      bool found = false;
+    if( it == _hit_used_for_sites_index.end() ) { // hit not associated with any site
       
-      for( unsigned int i = 0; i < _hit_not_used_for_sites.size(); ++i) {
-        if( trkhit == _hit_not_used_for_sites[i] ) found = true ;
-      }
-      
-      if( found ) {
+      if( _hit_not_used_for_sites.count(trkhit) ) {
         //streamlog_out( DEBUG2 )  << "MarlinKalTestTrack::getSiteFromLCIOHit: hit was rejected during filtering" << std::endl ;
         return site_discarded ;
       }
@@ -1686,7 +1770,7 @@ namespace MarlinTrk {
       }
     } 
     
-    site = it->second;
+    site = _hit_used_for_sites[it->second].second;
     
     
     //streamlog_out( DEBUG1 )  << "MarlinKalTestTrack::getSiteFromLCIOHit: site " << site << " found for hit " << trkhit << std::endl ;
@@ -1694,4 +1778,18 @@ namespace MarlinTrk {
     
   }
   
+  
+  void MarlinKalTestTrack::setSiteForLCIOHit( const edm4hep::TrackerHit& trkhit, TKalTrackSite* site ) {
+    
+    auto inserted = _hit_used_for_sites_index.insert( std::make_pair( trkhit, unsigned(_hit_used_for_sites.size()) ) ) ;
+    
+    if( inserted.second ) {
+      _hit_used_for_sites.push_back( std::make_pair( trkhit, site ) ) ;
+    }
+    else { // the hit was already used: keep its position and update the site
+      _hit_used_for_sites[inserted.first->second].second = site ;
+    }
+    
+  }
+  
 } // end of namespace MarlinTrk 
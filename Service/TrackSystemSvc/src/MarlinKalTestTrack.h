@@ -7,6 +7,11 @@
 #include <TObjArray.h>
 
 #include <cmath>
+#include <functional>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
 
 #include "TMatrixD.h"
 
@@ -83,6 +88,12 @@ namespace MarlinTrk{
     int fit( double maxChi2Increment=DBL_MAX ) ;
   
   
+    /** refit the hits of the last fit() with another maxChi2Increment, resuming from the last site 
+     *  before the first hit that the new cut decides differently
+     */
+    int refit( double maxChi2Increment ) ;
+  
+  
     /** smooth all track states 
      */
     int smooth() ;
@@ -295,10 +306,27 @@ namespace MarlinTrk{
      */
     void ToLCIOTrackState( const THelicalTrack& helix, const TMatrixD& cov, edm4hep::TrackState& ts, double& chi2, int& ndf ) const ;
     
+    /** filter the hits from the first one in the order of the fit on, as fit() does
+     */
+    int filterHits( unsigned first, double maxChi2Increment ) ;
+    
     /** get the measurement site associated with the given lcio TrackerHit trkhit
      */
     int getSiteFromLCIOHit( edm4hep::TrackerHit& trkhit, TKalTrackSite*& site ) const ;
     
+    /** record the site used for the given hit
+     */
+    void setSiteForLCIOHit( const edm4hep::TrackerHit& trkhit, TKalTrackSite* site ) ;
+    
+    /** hash of a hit on its ObjectID, the equality is still the one of the handles
+     */
+    struct TrackerHitHash {
+      std::size_t operator()( const edm4hep::TrackerHit& trkhit ) const {
+        const podio::ObjectID id = trkhit.getObjectID() ;
+        return std::hash<unsigned long long>()( ( static_cast<unsigned long long>( static_cast<unsigned>(id.collectionID) ) << 32 ) | static_cast<unsigned>(id.index) ) ;
+      }
+    } ;
+    
     
     
     /** helper function to restrict the range of the azimuthal angle to ]-pi,pi]*/
@@ -336,17 +364,21 @@ namespace MarlinTrk{
      */
     bool _smoothed ;
     
-    /** map to store relation between lcio hits and measurement sites
+    /** relation between lcio hits and measurement sites, in the order the sites were added
+     */
+    std::vector< std::pair<edm4hep::TrackerHit, TKalTrackSite*> > _hit_used_for_sites ;
+    
+    /** index of the lcio hits in _hit_used_for_sites
      */
-    std::map<edm4hep::TrackerHit, TKalTrackSite*> _hit_used_for_sites ;
+    std::unordered_map<edm4hep::TrackerHit, unsigned, TrackerHitHash> _hit_used_for_sites_index ;
   
     /** map to store relation between lcio hits kaltest hits
      */
-    std::map<edm4hep::TrackerHit, ILDVTrackHit*> _lcio_hits_to_kaltest_hits ;
+    std::unordered_map<edm4hep::TrackerHit, ILDVTrackHit*, TrackerHitHash> _lcio_hits_to_kaltest_hits ;
     
-    /** vector to store lcio hits rejected for measurement sites
+    /** lcio hits rejected for measurement sites
      */
-    std::vector<edm4hep::TrackerHit> _hit_not_used_for_sites ;
+    std::unordered_set<edm4hep::TrackerHit, TrackerHitHash> _hit_not_used_for_sites ;
     
     /** vector to store the chi-sqaure increment for measurement sites
      */
@@ -356,6 +388,10 @@ namespace MarlinTrk{
      */
     std::vector< std::pair<edm4hep::TrackerHit, double> > _outlier_chi2_values ;
     
+    /** chi2 increments of the hits in the order of the last fit() and whether the hits were used for a site
+     */
+    std::vector< std::pair<double, bool> > _fit_chi2_increments ;
+    
   } ;
 }
 #endif
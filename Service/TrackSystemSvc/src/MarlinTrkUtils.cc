@@ -2,8 +2,14 @@
 
 #include <vector>
 #include <algorithm>
+#include <atomic>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
 
 #include "TrackSystemSvc/IMarlinTrack.h"
+#include "TrackSystemSvc/IMarlinTrkSystem.h"
 #include "TrackSystemSvc/HelixTrack.h"
 
 #include "DataHelper/Navigation.h"
@@ -26,6 +32,11 @@
 
 #define MIN_NDF 6
 
+namespace {
+  // Navigation caches the hits it looks up, the fits of createFinalisedLCIOTracks run concurrently
+  std::mutex s_navigationMutex;
+}
+
 namespace MarlinTrk {
   
 
@@ -163,6 +174,74 @@ namespace MarlinTrk {
   
   
   
+  void createFinalisedLCIOTracks( IMarlinTrkSystem* trkSystem, std::vector<FitRequest>& requests, std::vector<int>& error_codes, bool fit_backwards, const std::array<float,15>& initial_cov_for_prefit, float bfield_z, double maxChi2Increment, unsigned nthreads){
+    
+    if( trkSystem == 0 ){
+      throw std::runtime_error("MarlinTrk::createFinalisedLCIOTracks: IMarlinTrkSystem == NULL ");
+    }
+    
+    const unsigned nrequests = requests.size() ;
+    
+    error_codes.assign( nrequests, IMarlinTrack::error ) ;
+    std::vector<std::exception_ptr> exceptions( nrequests ) ;
+    
+    // each request writes only its own track, error code and exception, so the result does not depend on the scheduling
+    std::atomic<unsigned> next( 0 ) ;
+    
+    auto worker = [&]() {
+      unsigned i ;
+      while( ( i = next++ ) < nrequests ) {
+        
+        FitRequest& request = requests[i] ;
+        
+        try{
+          
+          if( request.hit_list == 0 ){
+            throw std::runtime_error("MarlinTrk::createFinalisedLCIOTracks: hit list == NULL ");
+          }
+          
+          std::unique_ptr<IMarlinTrack> marlinTrk( trkSystem->createTrack() ) ;
+          
+          if( request.pre_fit ) {
+            error_codes[i] = createFinalisedLCIOTrack( marlinTrk.get(), *request.hit_list, request.track, fit_backwards, request.pre_fit, bfield_z, maxChi2Increment ) ;
+          }
+          else {
+            error_codes[i] = createFinalisedLCIOTrack( marlinTrk.get(), *request.hit_list, request.track, fit_backwards, initial_cov_for_prefit, bfield_z, maxChi2Increment ) ;
+          }
+          
+        }
+        catch(...){
+          exceptions[i] = std::current_exception() ;
+        }
+        
+      }
+    } ;
+    
+#ifdef MARLINTRK_DIAGNOSTICS_ON
+    nthreads = 1 ; // the diagnostics are not thread safe
+#endif
+    
+    if( nthreads == 0 ) nthreads = std::max( 1u, std::thread::hardware_concurrency() ) ;
+    nthreads = std::min( nthreads, nrequests ) ;
+    
+    if( nthreads <= 1 ) {
+      worker() ;
+    }
+    else {
+      std::vector<std::thread> threads ;
+      threads.reserve( nthreads - 1 ) ;
+      for( unsigned t = 1; t < nthreads; ++t ) threads.emplace_back( worker ) ;
+      worker() ;
+      for( auto& thread : threads ) thread.join() ;
+    }
+    
+    for( auto& exception : exceptions ) {
+      if( exception ) std::rethrow_exception( exception ) ;
+    }
+    
+  }
+  
+  
   int createFit( std::vector<edm4hep::TrackerHit>& hit_list, IMarlinTrack* marlinTrk, edm4hep::TrackState* pre_fit, float bfield_z, bool fit_backwards, double maxChi2Increment){
     
     
@@ -222,7 +301,11 @@ namespace MarlinTrk {
 	//exit(1);
         int nRawHit = trkHit.rawHits_size();
         for( unsigned k=0; k< nRawHit; k++ ){
-          edm4hep::TrackerHit rawHit = Navigation::Instance()->GetTrackerHit(trkHit.getRawHits(k));
+          edm4hep::TrackerHit rawHit;
+          {
+            std::lock_guard<std::mutex> lock(s_navigationMutex);
+            rawHit = Navigation::Instance()->GetTrackerHit(trkHit.getRawHits(k));
+          }
 	  if( marlinTrk->addHit( rawHit ) == IMarlinTrack::success ){
 	    isSuccessful = true; //if at least one hit from the spacepoint gets added
             ++ndof_added;
@@ -430,7 +513,11 @@ namespace MarlinTrk {
 	// get strip hits 
         int nRawHit = trkHit.rawHits_size();
         for( unsigned k=0; k< nRawHit; k++ ){
-	  edm4hep::TrackerHit rawHit = Navigation::Instance()->GetTrackerHit(trkHit.getRawHits(k));
+	  edm4hep::TrackerHit rawHit;
+	  {
+	    std::lock_guard<std::mutex> lock(s_navigationMutex);
+	    rawHit = Navigation::Instance()->GetTrackerHit(trkHit.getRawHits(k));
+	  }
 	  bool is_outlier = false;
 	  // here we loop over outliers as this will be faster than looping over the used hits
           for ( unsigned ohit = 0; ohit < outliers.size(); ++ohit) {
@@ -15,7 +15,9 @@ TrackSystemSvc::~TrackSystemSvc(){
 }
 
 MarlinTrk::IMarlinTrkSystem* TrackSystemSvc::getTrackSystem(void* address){
-  std::map<void*, MarlinTrk::IMarlinTrkSystem*>::iterator it=m_trackSystems.find(address);
+  std::lock_guard<std::mutex> lock(m_mutex);
+  const Key key(address, std::this_thread::get_id());
+  std::map<Key, MarlinTrk::MarlinKalTest*>::iterator it=m_trackSystems.find(key);
   if(it==m_trackSystems.end()){
     gear::GearMgr* mgr=0; 
     auto _gear = service<IGearSvc>("GearSvc");
@@ -36,39 +38,61 @@ MarlinTrk::IMarlinTrkSystem* TrackSystemSvc::getTrackSystem(void* address){
     }
     debug() << "GearMgr=" << mgr << " GeomSvc=" << _geoSvc << endmsg;
     //MarlinTrk::IMarlinTrkSystem* sys = new MarlinTrk::MarlinKalTest( *mgr, _geoSvc );
-    MarlinTrk::IMarlinTrkSystem* sys = new MarlinTrk::MarlinKalTest(*mgr);
-    m_trackSystems[address] = sys;
-    debug() << "Track system created successfully for " << address << endmsg;
+    if(!m_geometries) m_geometries = std::make_shared<MarlinTrk::MarlinKalTest::GeometryCache>();
+    MarlinTrk::MarlinKalTest* sys = new MarlinTrk::MarlinKalTest(*mgr, 0, m_geometries);
+
+    // the system of this address on another thread has been configured by its user:
+    // take over its options, and initialise the new one as well if it is initialised
+    for(it=m_trackSystems.begin();it!=m_trackSystems.end();it++){
+      if(it->first.first!=address) continue;
+      for(unsigned option=1;option<MarlinTrk::IMarlinTrkSystem::CFG::size;option++){
+        sys->setOption(option, it->second->getOption(option));
+      }
+      if(it->second->isInitialised()) sys->init();
+      break;
+    }
+
+    m_trackSystems[key] = sys;
+    debug() << "Track system created successfully for " << address << " on thread " << key.second << endmsg;
     return sys;
   }
   return it->second;
 }
 
 StatusCode TrackSystemSvc::initialize(){
-  for(std::map<void*, MarlinTrk::IMarlinTrkSystem*>::iterator it=m_trackSystems.begin();it!=m_trackSystems.end();it++){
+  for(std::map<Key, MarlinTrk::MarlinKalTest*>::iterator it=m_trackSystems.begin();it!=m_trackSystems.end();it++){
     delete it->second;
   }
   m_trackSystems.clear();
+  m_geometries = std::make_shared<MarlinTrk::MarlinKalTest::GeometryCache>();
 
-  m_trackSystems[0] = getTrackSystem(0);
+  getTrackSystem(0);
 
   
   return StatusCode::SUCCESS;
 }
 
 void TrackSystemSvc::removeTrackSystem(void* address){
-  std::map<void*, MarlinTrk::IMarlinTrkSystem*>::iterator it=m_trackSystems.find(address);
-  if ( it!=m_trackSystems.end() ) {
-    delete it->second;
-    m_trackSystems.erase(it);
+  std::lock_guard<std::mutex> lock(m_mutex);
+  // the systems of all the threads
+  std::map<Key, MarlinTrk::MarlinKalTest*>::iterator it=m_trackSystems.begin();
+  while ( it!=m_trackSystems.end() ) {
+    if ( it->first.first==address ) {
+      delete it->second;
+      it = m_trackSystems.erase(it);
+    }
+    else it++;
   }
   return;
 }
 
 StatusCode TrackSystemSvc::finalize(){
-  for(std::map<void*, MarlinTrk::IMarlinTrkSystem*>::iterator it=m_trackSystems.begin();it!=m_trackSystems.end();it++){
+  std::lock_guard<std::mutex> lock(m_mutex);
+  for(std::map<Key, MarlinTrk::MarlinKalTest*>::iterator it=m_trackSystems.begin();it!=m_trackSystems.end();it++){
     delete it->second;
   }
+  m_trackSystems.clear();
+  m_geometries.reset();
   
   return StatusCode::SUCCESS;
 }
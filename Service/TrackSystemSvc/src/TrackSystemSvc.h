@@ -4,6 +4,14 @@
 #include "TrackSystemSvc/ITrackSystemSvc.h"
 #include <GaudiKernel/Service.h>
 
+#include "MarlinKalTest.h"
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+
 class TrackSystemSvc : public extends<Service, ITrackSystemSvc>{
  public:
   TrackSystemSvc(const std::string& name, ISvcLocator* svc);
@@ -16,7 +24,12 @@ class TrackSystemSvc : public extends<Service, ITrackSystemSvc>{
   StatusCode finalize() override;
 
  private:
-  std::map<void*, MarlinTrk::IMarlinTrkSystem*> m_trackSystems;
+  // one track system (fitting context) per requesting address, e.g. per algorithm instance, and thread.
+  // The detector geometry is built once and shared by all of them.
+  typedef std::pair<void*, std::thread::id> Key;
+  std::map<Key, MarlinTrk::MarlinKalTest*> m_trackSystems;
+  std::shared_ptr<MarlinTrk::MarlinKalTest::GeometryCache> m_geometries;
+  std::mutex m_mutex;
 };
 
 #endif
@@ -0,0 +1,291 @@
+/*
+ * Check that MarlinTrk::createFinalisedLCIOTracks gives the same tracks and error codes
+ * with one and with several threads, and the same as createFinalisedLCIOTrack called
+ * track by track. The fits are made by a deterministic toy IMarlinTrack, so that the
+ * tracks must be identical; a request whose fit throws must be reported as in the serial
+ * loop.
+ */
+
+#include "TrackSystemSvc/MarlinTrkUtils.h"
+#include "TrackSystemSvc/IMarlinTrack.h"
+#include "TrackSystemSvc/IMarlinTrkSystem.h"
+
+#include "edm4hep/MutableTrack.h"
+#include "edm4hep/MutableTrackerHit.h"
+#include "edm4hep/TrackState.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdio>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+
+  const unsigned s_failingCellID = 999999; // cellID of the hit making a fit throw
+
+  // A fit that only depends on the hits and the initial state
+  class ToyTrack : public MarlinTrk::IMarlinTrack {
+  public:
+    int addHit(edm4hep::TrackerHit& hit) {
+      // drop some hits as a fitter would
+      if( hit.getCellID()%11 == 5 ) return site_discarded ;
+      _hits.push_back(hit) ;
+      return success ;
+    }
+    int initialise( bool ) { return error ; }
+    int initialise( const edm4hep::TrackState& ts, double, bool ) {
+      _state = ts ;
+      return success ;
+    }
+    int fit( double maxChi2Increment=DBL_MAX ) {
+      _inFit.clear() ;
+      _outliers.clear() ;
+      double sumx = 0, sumy = 0, sumz = 0 ;
+      for( auto& hit : _hits ){
+        if( hit.getCellID() == s_failingCellID ) {
+          throw std::runtime_error( "ToyTrack::fit: failing hit at x = " + std::to_string( int( hit.getPosition()[0] ) ) ) ;
+        }
+        const double chi2 = std::fmod( std::fabs( hit.getPosition()[0]*hit.getPosition()[1] ), 13. ) ;
+        if( chi2 > maxChi2Increment ) {
+          _outliers.push_back( std::make_pair( hit, chi2 ) ) ;
+          continue ;
+        }
+        _inFit.push_back( std::make_pair( hit, chi2 ) ) ;
+        _chi2 += chi2 ;
+        sumx += hit.getPosition()[0] ;
+        sumy += hit.getPosition()[1] ;
+        sumz += hit.getPosition()[2] ;
+      }
+      if( _inFit.size() < 3 ) return all_sites_fail_fit ;
+      const double n = _inFit.size() ;
+      _state.D0        += 1.e-3*sumx/n ;
+      _state.phi       += 1.e-4*sumy/n ;
+      _state.Z0        += 1.e-3*sumz/n ;
+      _state.omega     *= 1. + 1.e-5*sumx/n ;
+      _state.tanLambda *= 1. + 1.e-5*sumz/n ;
+      // the hits in fit are returned in reverse order of the fit, as MarlinKalTestTrack does
+      std::reverse( _inFit.begin(), _inFit.end() ) ;
+      return success ;
+    }
+    int refit( double ) { return error ; }
+    int addAndFit( edm4hep::TrackerHit&, double&, double=DBL_MAX ) { return error ; }
+    int testChi2Increment( edm4hep::TrackerHit&, double& ) { return error ; }
+    int smooth() { return success ; }
+    int smooth( edm4hep::TrackerHit& ) { return success ; }
+    int getTrackState( edm4hep::TrackState& ts, double& chi2, int& ndf ) {
+      ts = _state ;
+      chi2 = _chi2 ;
+      return getNDF( ndf ) ;
+    }
+    int getTrackState( edm4hep::TrackerHit& hit, edm4hep::TrackState& ts, double& chi2, int& ndf ) {
+      getTrackState( ts, chi2, ndf ) ;
+      ts.referencePoint = edm4hep::Vector3f( hit.getPosition()[0], hit.getPosition()[1], hit.getPosition()[2] ) ;
+      return success ;
+    }
+    int getHitsInFit( std::vector<std::pair<edm4hep::TrackerHit, double> >& hits ) {
+      hits = _inFit ;
+      return success ;
+    }
+    int getOutliers( std::vector<std::pair<edm4hep::TrackerHit, double> >& hits ) {
+      hits = _outliers ;
+      return success ;
+    }
+    int getNDF( int& ndf ) {
+      ndf = 2*int( _inFit.size() ) - 5 ;
+      return success ;
+    }
+    int getTrackerHitAtPositiveNDF( edm4hep::TrackerHit& trkhit ) {
+      trkhit = _inFit.back().first ;
+      return success ;
+    }
+    int propagate( const edm4hep::Vector3d& point, edm4hep::TrackState& ts, double& chi2, int& ndf ) {
+      getTrackState( ts, chi2, ndf ) ;
+      ts.referencePoint = edm4hep::Vector3f( point.x, point.y, point.z ) ;
+      ts.D0 -= 1.e-4*point.x ;
+      return success ;
+    }
+    int propagate( const edm4hep::Vector3d& point, edm4hep::TrackerHit&, edm4hep::TrackState& ts, double& chi2, int& ndf ) {
+      return propagate( point, ts, chi2, ndf ) ;
+    }
+    int propagateToLayer( int, edm4hep::TrackState&, double&, int&, int&, int=modeClosest ) { return no_intersection ; }
+    int propagateToLayer( int, edm4hep::TrackerHit&, edm4hep::TrackState&, double&, int&, int&, int=modeClosest ) { return no_intersection ; }
+    int propagateToDetElement( int, edm4hep::TrackState&, double&, int&, int=modeClosest ) { return no_intersection ; }
+    int propagateToDetElement( int, edm4hep::TrackerHit&, edm4hep::TrackState&, double&, int&, int=modeClosest ) { return no_intersection ; }
+    int extrapolate( const edm4hep::Vector3d&, edm4hep::TrackState&, double&, int& ) { return error ; }
+    int extrapolate( const edm4hep::Vector3d&, edm4hep::TrackerHit&, edm4hep::TrackState&, double&, int& ) { return error ; }
+    int extrapolateToLayer( int, edm4hep::TrackState&, double&, int&, int&, int=modeClosest ) { return no_intersection ; }
+    int extrapolateToLayer( int, edm4hep::TrackerHit&, edm4hep::TrackState&, double&, int&, int&, int=modeClosest ) { return no_intersection ; }
+    int extrapolateToDetElement( int, edm4hep::TrackState&, double&, int&, int=modeClosest ) { return no_intersection ; }
+    int extrapolateToDetElement( int, edm4hep::TrackerHit&, edm4hep::TrackState&, double&, int&, int=modeClosest ) { return no_intersection ; }
+    int intersectionWithLayer( int, edm4hep::Vector3d&, int&, int=modeClosest ) { return no_intersection ; }
+    int intersectionWithLayer( int, edm4hep::TrackerHit&, edm4hep::Vector3d&, int&, int=modeClosest ) { return no_intersection ; }
+    int intersectionWithDetElement( int, edm4hep::Vector3d&, int=modeClosest ) { return no_intersection ; }
+    int intersectionWithDetElement( int, edm4hep::TrackerHit&, edm4hep::Vector3d&, int=modeClosest ) { return no_intersection ; }
+
+  private:
+    std::vector<edm4hep::TrackerHit> _hits ;
+    std::vector<std::pair<edm4hep::TrackerHit, double> > _inFit ;
+    std::vector<std::pair<edm4hep::TrackerHit, double> > _outliers ;
+    edm4hep::TrackState _state ;
+    double _chi2 = 0 ;
+  };
+
+  class ToySystem : public MarlinTrk::IMarlinTrkSystem {
+  public:
+    void init() {}
+    MarlinTrk::IMarlinTrack* createTrack() { return new ToyTrack ; }
+  };
+
+  int s_nfailed = 0 ;
+
+  void expect( bool ok, const std::string& what, unsigned itrk ) {
+    if( ok ) return ;
+    ++s_nfailed ;
+    if( s_nfailed <= 20 ) std::printf("MISMATCH track %u: %s\n", itrk, what.c_str()) ;
+  }
+
+  void compare( const edm4hep::TrackState& a, const edm4hep::TrackState& b, unsigned itrk ) {
+    expect( a.location == b.location, "track state location", itrk ) ;
+    expect( a.D0 == b.D0 && a.phi == b.phi && a.omega == b.omega && a.Z0 == b.Z0 && a.tanLambda == b.tanLambda,
+            "track parameters", itrk ) ;
+    expect( a.referencePoint[0] == b.referencePoint[0] && a.referencePoint[1] == b.referencePoint[1]
+            && a.referencePoint[2] == b.referencePoint[2], "reference point", itrk ) ;
+    expect( a.covMatrix == b.covMatrix, "covariance matrix", itrk ) ;
+  }
+
+  void compare( const edm4hep::MutableTrack& a, const edm4hep::MutableTrack& b, unsigned itrk ) {
+    expect( a.getChi2() == b.getChi2(), "chi2", itrk ) ;
+    expect( a.getNdf() == b.getNdf(), "ndf", itrk ) ;
+    expect( a.getRadiusOfInnermostHit() == b.getRadiusOfInnermostHit(), "radius of innermost hit", itrk ) ;
+    expect( a.trackerHits_size() == b.trackerHits_size(), "number of hits", itrk ) ;
+    for( unsigned i=0; i<a.trackerHits_size() && i<b.trackerHits_size(); ++i ){
+      expect( a.getTrackerHits(i) == b.getTrackerHits(i), "hit", itrk ) ;
+    }
+    expect( a.trackStates_size() == b.trackStates_size(), "number of track states", itrk ) ;
+    for( unsigned i=0; i<a.trackStates_size() && i<b.trackStates_size(); ++i ){
+      compare( a.getTrackStates(i), b.getTrackStates(i), itrk ) ;
+    }
+  }
+
+  // hits along a helix from the origin, at radii from 50 to 1800 mm
+  std::vector<edm4hep::TrackerHit> makeHits( std::mt19937& rng, unsigned& cellID, std::vector<edm4hep::MutableTrackerHit>& store ) {
+    std::uniform_real_distribution<double> flat( 0., 1. ) ;
+    const double R = 1000. + 5000.*flat(rng) ;         // radius of the circle
+    const double phi0 = 2.*M_PI*flat(rng) ;
+    const double tanL = -1. + 2.*flat(rng) ;
+    const double charge = flat(rng) < 0.5 ? -1. : 1. ;
+    const unsigned nhits = 4 + unsigned(30*flat(rng)) ;
+
+    std::vector<edm4hep::TrackerHit> hits ;
+    for( unsigned i=0; i<nhits; ++i ){
+      const double r = 50. + 1750.*i/nhits ;
+      const double alpha = 2.*std::asin( std::min( 1., r/(2.*R) ) ) ; // turning angle at radius r
+      const double x = R*( std::sin(phi0 + charge*alpha) - std::sin(phi0) )*charge ;
+      const double y = -R*( std::cos(phi0 + charge*alpha) - std::cos(phi0) )*charge ;
+      const double z = tanL*R*alpha ;
+
+      edm4hep::MutableTrackerHit hit ;
+      hit.setCellID( cellID++ ) ;
+      hit.setType( 0 ) ;
+      hit.setPosition( edm4hep::Vector3d( x + 0.01*(flat(rng)-0.5), y + 0.01*(flat(rng)-0.5), z ) ) ;
+      store.push_back( hit ) ;
+      hits.push_back( hit ) ;
+    }
+    return hits ;
+  }
+
+  struct Batch {
+    std::vector<std::vector<edm4hep::TrackerHit> > hits ;
+    std::vector<edm4hep::MutableTrack> tracks ;
+    std::vector<MarlinTrk::FitRequest> requests ;
+
+    explicit Batch( const std::vector<std::vector<edm4hep::TrackerHit> >& h ) : hits( h ), tracks( h.size() ) {
+      for( unsigned i=0; i<hits.size(); ++i ){
+        requests.push_back( MarlinTrk::FitRequest{ &hits[i], 0, &tracks[i] } ) ;
+      }
+    }
+  };
+}
+
+int main() {
+
+  const float bfield_z = 3.0 ;
+  const double maxChi2Increment = 10. ;
+  const unsigned ntracks = 500 ;
+
+  std::array<float,15> initial_cov{} ;
+  initial_cov[0] = 1.e6 ; initial_cov[2] = 1.e2 ; initial_cov[5] = 1.e-4 ; initial_cov[9] = 1.e6 ; initial_cov[14] = 1.e2 ;
+
+  std::mt19937 rng( 2023 ) ;
+  unsigned cellID = 0 ;
+  std::vector<edm4hep::MutableTrackerHit> store ;
+  std::vector<std::vector<edm4hep::TrackerHit> > hits ;
+  for( unsigned i=0; i<ntracks; ++i ) hits.push_back( makeHits( rng, cellID, store ) ) ;
+
+  ToySystem system ;
+
+  // serial reference, track by track
+  std::vector<edm4hep::MutableTrack> reference( ntracks ) ;
+  std::vector<int> reference_codes( ntracks ) ;
+  for( unsigned i=0; i<ntracks; ++i ){
+    std::vector<edm4hep::TrackerHit> hit_list = hits[i] ;
+    std::unique_ptr<MarlinTrk::IMarlinTrack> marlinTrk( system.createTrack() ) ;
+    reference_codes[i] = MarlinTrk::createFinalisedLCIOTrack( marlinTrk.get(), hit_list, &reference[i], MarlinTrk::IMarlinTrack::backward, initial_cov, bfield_z, maxChi2Increment ) ;
+  }
+
+  unsigned nsuccess = 0 ;
+  for( int code : reference_codes ) if( code == MarlinTrk::IMarlinTrack::success ) ++nsuccess ;
+  std::printf("%u tracks, %u fitted successfully\n", ntracks, nsuccess) ;
+
+  for( unsigned nthreads : { 1u, 2u, 4u, 8u } ){
+    Batch batch( hits ) ;
+    std::vector<int> codes ;
+    MarlinTrk::createFinalisedLCIOTracks( &system, batch.requests, codes, MarlinTrk::IMarlinTrack::backward, initial_cov, bfield_z, maxChi2Increment, nthreads ) ;
+
+    expect( codes.size() == ntracks, "number of error codes", 0 ) ;
+    for( unsigned i=0; i<ntracks && i<codes.size(); ++i ){
+      expect( codes[i] == reference_codes[i], "error code with " + std::to_string(nthreads) + " threads", i ) ;
+      compare( batch.tracks[i], reference[i], i ) ;
+    }
+  }
+
+  // a fit throwing: the exception of the first failing request is rethrown after the others are fitted
+  std::vector<std::vector<edm4hep::TrackerHit> > failing = hits ;
+  for( unsigned i : { 137u, 311u } ){
+    edm4hep::MutableTrackerHit hit ;
+    hit.setCellID( s_failingCellID ) ;
+    hit.setPosition( edm4hep::Vector3d( 1000. + i, 1000., 0. ) ) ;
+    store.push_back( hit ) ;
+    failing[i].push_back( hit ) ;
+  }
+  for( unsigned nthreads : { 1u, 4u } ){
+    Batch batch( failing ) ;
+    std::vector<int> codes ;
+    std::string message ;
+    try{
+      MarlinTrk::createFinalisedLCIOTracks( &system, batch.requests, codes, MarlinTrk::IMarlinTrack::backward, initial_cov, bfield_z, maxChi2Increment, nthreads ) ;
+    }
+    catch( std::runtime_error& e ){
+      message = e.what() ;
+    }
+    expect( message.find( "x = 1137" ) != std::string::npos,
+            "exception of the first failing fit with " + std::to_string(nthreads) + " threads: " + message, 137 ) ;
+    // the other requests are done anyway
+    for( unsigned i : { 0u, 200u, ntracks-1 } ){
+      expect( codes[i] == reference_codes[i], "error code after an exception", i ) ;
+      compare( batch.tracks[i], reference[i], i ) ;
+    }
+  }
+
+  if( s_nfailed ){
+    std::printf("FAILED: %d mismatches\n", s_nfailed) ;
+    return 1 ;
+  }
+  std::printf("OK\n") ;
+  return 0 ;
+}
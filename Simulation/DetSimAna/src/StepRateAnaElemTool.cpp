@@ -0,0 +1,60 @@
+#include "StepRateAnaElemTool.h"
+
+#include "G4Step.hh"
+#include "G4StepPoint.hh"
+#include "G4VPhysicalVolume.hh"
+
+#include <algorithm>
+
+DECLARE_COMPONENT(StepRateAnaElemTool)
+
+void
+StepRateAnaElemTool::BeginOfEventAction(const G4Event*) {
+    m_eventStart = std::chrono::steady_clock::now();
+}
+
+void
+StepRateAnaElemTool::EndOfEventAction(const G4Event*) {
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - m_eventStart;
+    m_seconds += elapsed.count();
+    ++m_nEvents;
+}
+
+void
+StepRateAnaElemTool::UserSteppingAction(const G4Step* aStep) {
+    ++m_nSteps;
+
+    if (m_volumePrefix.value().empty()) {
+        return;
+    }
+
+    G4VPhysicalVolume* volume = aStep->GetPreStepPoint()->GetPhysicalVolume();
+    if (volume && volume->GetName().compare(0, m_volumePrefix.value().size(), m_volumePrefix.value()) == 0) {
+        ++m_nStepsInVolume;
+    }
+}
+
+StatusCode
+StepRateAnaElemTool::initialize() {
+    StatusCode sc;
+
+    return sc;
+}
+
+StatusCode
+StepRateAnaElemTool::finalize() {
+    StatusCode sc;
+
+    info() << "Events: " << m_nEvents
+           << ", steps: " << m_nSteps
+           << ", time in events: " << m_seconds << " s" << endmsg;
+    if (m_seconds > 0) {
+        info() << "Step rate: " << m_nSteps/m_seconds << " steps/s, "
+               << "time per event: " << m_seconds/std::max(m_nEvents, 1L) << " s" << endmsg;
+    }
+    if (!m_volumePrefix.value().empty()) {
+        info() << "Steps in volumes '" << m_volumePrefix.value() << "*': " << m_nStepsInVolume << endmsg;
+    }
+
+    return sc;
+}
@@ -0,0 +1,48 @@
+#ifndef StepRateAnaElemTool_h
+#define StepRateAnaElemTool_h
+
+/*
+ * StepRateAnaElemTool counts the Geant4 steps and measures the time spent in
+ * the events, to benchmark the simulation of different geometry options.
+ *
+ * The steps in volumes whose name starts with VolumePrefix are also counted
+ * separately, e.g. "DriftChamber" for the drift chamber.
+ * The summary is printed at finalize.
+ */
+
+#include <chrono>
+#include <string>
+
+#include "GaudiKernel/AlgTool.h"
+#include "DetSimInterface/IAnaElemTool.h"
+
+class StepRateAnaElemTool: public extends<AlgTool, IAnaElemTool> {
+
+public:
+
+    using extends::extends;
+
+    /// IAnaElemTool interface
+    // Event
+    virtual void BeginOfEventAction(const G4Event*) override;
+    virtual void EndOfEventAction(const G4Event*) override;
+
+    // Stepping
+    virtual void UserSteppingAction(const G4Step*) override;
+
+    /// Overriding initialize and finalize
+    StatusCode initialize() override;
+    StatusCode finalize() override;
+
+private:
+    Gaudi::Property<std::string> m_volumePrefix{this, "VolumePrefix", ""};
+
+    std::chrono::steady_clock::time_point m_eventStart;
+    double m_seconds = 0;
+
+    long m_nEvents = 0;
+    long m_nSteps = 0;
+    long m_nStepsInVolume = 0;
+};
+
+#endif
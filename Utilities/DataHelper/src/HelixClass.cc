@@ -509,7 +509,7 @@ float HelixClass::getDistanceToPoint(float * xPoint, float * Distance) {
 //When we are not interested in the exact distance, we can check if we are
 //already far enough away in XY, before we start calculating in Z as the
 //distance will only increase
-float HelixClass::getDistanceToPoint(const std::vector<float>& xPoint, float distCut) {
+float HelixClass::getDistanceToPoint(const float* xPoint, float distCut) {
   //calculate distance to XYprojected centre of Helix, comparing this with distance to radius around centre gives DistXY
   float tempx = xPoint[0]-_xCentre;
   float tempy = xPoint[1]-_yCentre;
@@ -547,13 +547,12 @@ float HelixClass::getDistanceToPoint(const std::vector<float>& xPoint, float dis
   }
   float DistZ = - tempz - _charge*tanradius*(_const_2pi*((float)nCircles) - phidiff);
   return sqrt(DistXY*DistXY+DistZ*DistZ);
-}//getDistanceToPoint(vector,float)
-
-float HelixClass::getDistanceToPoint(const float* xPoint, float distCut) {
-  std::vector<float> xPosition(xPoint, xPoint + 3 );//We are expecting three coordinates, must be +3, last element is excluded!
-  return getDistanceToPoint(xPosition, distCut);
 }//getDistanceToPoint(float*,float)
 
+float HelixClass::getDistanceToPoint(const std::vector<float>& xPoint, float distCut) {
+  return getDistanceToPoint(&xPoint[0], distCut);
+}//getDistanceToPoint(vector,float)
+
 
 
 void HelixClass::setHelixEdges(float * xStart, float * xEnd) {
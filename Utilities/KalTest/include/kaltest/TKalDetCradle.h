@@ -20,6 +20,8 @@
 //*                              Transport() to do their functions.
 //*   2010/04/06  K.Fujii        Modified Transport() to allow a 1-dim hit,
 //*                              for which pivot is at the xpected hit.
+//*                              Added the layer index used by Transport()
+//*                              to skip layers the helix cannot reach.
 //*
 //*************************************************************************
 
@@ -27,9 +29,12 @@
 #include "TAttElement.h"   // from Utils
 #include "TKalMatrix.h"    // from KalTrackLib
 
+#include <vector>          // from STL
+
 class TKalTrackSite;
 class TVKalDetector;
 class TVMeasLayer;
+class TVSurface;
 
 //_____________________________________________________________________
 //  ------------------------------
@@ -72,7 +77,22 @@ public:
 private:
    void Update();
 
+   // Navigation data of a layer, filled by Update() in the sorted order.
+   // For surfaces of revolution (cylinder, hyperboloid) the radial range
+   // [fRmin,fRmax] around the axis at (fXa,fYa) is known; a helix whose
+   // circle does not cover it cannot cross the layer.
+   struct LayerIndex {
+      const TVSurface   *fSurfacePtr;  // surface of the layer
+      const TVMeasLayer *fMeasLayerPtr;// the layer itself
+      Bool_t             fIsBounded;   // radial range known
+      Double_t           fXa;          // x of the layer axis
+      Double_t           fYa;          // y of the layer axis
+      Double_t           fRmin;        // min. radius w.r.t. the axis
+      Double_t           fRmax;        // max. radius w.r.t. the axis
+   };
+
 private:
+   std::vector<LayerIndex> fLayerIndex; //! navigation data, index = layer index
    Bool_t    fIsMSON;         //! switch for multiple scattering
    Bool_t    fIsDEDXON;       //! switch for energy loss
    Bool_t    fDone;           //! flag to tell if sorting done
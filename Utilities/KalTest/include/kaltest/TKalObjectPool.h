@@ -0,0 +1,198 @@
+#ifndef TKALOBJECTPOOL_H
+#define TKALOBJECTPOOL_H
+//*************************************************************************
+//* ======================
+//*  TKalObjectPool Class
+//* ======================
+//*
+//* (Description)
+//*   Free list allocator for the small objects created in large numbers
+//*   by the Kalman filter (sites and states). Memory is taken from the
+//*   system in chunks of many slots; a deleted object returns its slot
+//*   to the free list of the current thread, so the objects of the next
+//*   track (or event) reuse it without calling the system allocator.
+//*   When a thread exits, its free slots go back to a list shared by all
+//*   threads, from which the other threads refill before taking a new
+//*   chunk. Chunks are never returned to the system.
+//*
+//*   A class uses the pool by forwarding its operator new/delete:
+//*     void *operator new   (size_t sz)          { return TKalObjectPool<T>::Alloc(sz); }
+//*     void  operator delete(void *p, size_t sz) { TKalObjectPool<T>::Free(p, sz);     }
+//*   Requests of a different size (derived classes) go to TStorage.
+//*   The memory is filled as TStorage::ObjectAlloc does, so that
+//*   TObject::IsOnHeap() is kTRUE for pooled objects.
+//* (Requires)
+//*     TStorage
+//* (Provides)
+//*     class TKalObjectPool<T>
+//*
+//*************************************************************************
+
+#include "TStorage.h"
+
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <new>
+#include <vector>
+
+//_____________________________________________________________________
+//  ------------------------------
+//  Pool of slots of sizeof(T)
+//  ------------------------------
+//
+template <class T>
+class TKalObjectPool {
+public:
+   // Statistics of the current thread
+   struct Stats {
+      Long64_t fNAlloc;      // allocations served by the pool
+      Long64_t fNFree;       // slots returned to the pool
+      Long64_t fNChunks;     // chunks taken from the system
+   };
+
+   static void *Alloc(size_t sz)
+   {
+      if (sz != sizeof(T)) return TStorage::ObjectAlloc(sz);
+
+      FreeList &fl = Local();
+      Slot *sp;
+      if (fl.fExited) {
+         // called during the destruction of the thread: use the shared list
+         sp = Global().Take(fl.fStats.fNChunks);
+         if (sp->fNext) Global().Give(sp->fNext);
+      } else {
+         if (!fl.fHead) fl.fHead = Global().Take(fl.fStats.fNChunks);
+         sp = fl.fHead;
+         fl.fHead = sp->fNext;
+      }
+      ++fl.fStats.fNAlloc;
+
+      std::memset(sp, 0x99, sz);  // as TStorage::ObjectAlloc
+      return sp;
+   }
+
+   static void Free(void *p, size_t sz)
+   {
+      if (!p) return;
+      if (sz != sizeof(T)) { TStorage::ObjectDealloc(p); return; }
+
+      FreeList &fl = Local();
+      Slot *sp  = static_cast<Slot *>(p);
+      if (fl.fExited) {
+         sp->fNext = 0;
+         Global().Give(sp);
+      } else {
+         sp->fNext = fl.fHead;
+         fl.fHead  = sp;
+      }
+      ++fl.fStats.fNFree;
+   }
+
+   static const Stats &GetStats() { return Local().fStats; }
+
+   // Chunks taken from the system by all the threads
+   static Long64_t GetNChunks() { return Global().GetNChunks(); }
+
+private:
+   enum { kNslots = 512 };   // slots per chunk
+
+   union Slot {
+      Slot          *fNext;
+      std::max_align_t fAlign;
+      char           fData[sizeof(T)];
+   };
+
+   // Free slots shared by all the threads: a slot can be freed by another
+   // thread than the one it was allocated by, and the free list of a thread
+   // is given back here when the thread exits, so the chunks must outlive
+   // the threads.
+   class Depot {
+   public:
+      Depot() : fHead(0), fNChunks(0) {}
+
+      // Up to kNslots free slots, from a new chunk if there are none left
+      Slot *Take(Long64_t &nchunks)
+      {
+         {
+            std::lock_guard<std::mutex> lock(fMutex);
+            if (fHead) {
+               Slot *first = fHead;
+               Slot *last  = fHead;
+               for (Int_t i = 1; i < kNslots && last->fNext; i++) last = last->fNext;
+               fHead = last->fNext;
+               last->fNext = 0;
+               return first;
+            }
+         }
+
+         Slot *cp = static_cast<Slot *>(std::malloc(kNslots * sizeof(Slot)));
+         if (!cp) throw std::bad_alloc();
+         for (Int_t i = 0; i < kNslots - 1; i++) cp[i].fNext = &cp[i+1];
+         cp[kNslots-1].fNext = 0;
+         ++nchunks;
+
+         std::lock_guard<std::mutex> lock(fMutex);
+         ++fNChunks;
+         return cp;
+      }
+
+      // Return a null terminated list of free slots
+      void Give(Slot *first)
+      {
+         if (!first) return;
+         Slot *last = first;
+         while (last->fNext) last = last->fNext;
+
+         std::lock_guard<std::mutex> lock(fMutex);
+         last->fNext = fHead;
+         fHead = first;
+      }
+
+      Long64_t GetNChunks()
+      {
+         std::lock_guard<std::mutex> lock(fMutex);
+         return fNChunks;
+      }
+
+   private:
+      std::mutex  fMutex;
+      Slot       *fHead;      // shared free list
+      Long64_t    fNChunks;   // chunks taken from the system
+   };
+
+   static Depot &Global()
+   {
+      // never deleted: objects may still be freed during static destruction
+      static Depot *gDepot = new Depot;
+      return *gDepot;
+   }
+
+   struct FreeList {
+      FreeList() : fHead(0), fExited(kFALSE)
+      {
+         fStats.fNAlloc = fStats.fNFree = fStats.fNChunks = 0;
+      }
+
+      // the thread exits: make its free slots available to the others
+      ~FreeList()
+      {
+         Global().Give(fHead);
+         fHead   = 0;
+         fExited = kTRUE;
+      }
+
+      Slot   *fHead;
+      Bool_t  fExited;   // objects deleted later go to the shared list
+      Stats   fStats;
+   };
+
+   static FreeList &Local()
+   {
+      static thread_local FreeList fl;
+      return fl;
+   }
+};
+
+#endif
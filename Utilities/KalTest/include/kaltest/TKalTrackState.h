@@ -18,6 +18,7 @@
 //*   2005/08/13  K.Fujii           Removed CalcProcessNoise method.
 //*   2010/04/06  K.Fujii           Modified MoveTo to allow a 1-dim hit,
 //*                                 for which pivot is at the xpected hit.
+//*                                 Allocated from a TKalObjectPool.
 //*
 //*************************************************************************
 
@@ -25,6 +26,7 @@
 #include "THelicalTrack.h"      // from GeomLib
 #include "TStraightTrack.h"     // from GeomLib
 #include "KalTrackDim.h"        // from KalTrackLib
+#include "TKalObjectPool.h"     // from KalLib
 
 class TKalTrackSite;
 
@@ -49,6 +51,12 @@ public:
    TKalTrackState(const TKalMatrix &sv, const TKalMatrix &c,
                   const TVKalSite &site, Int_t type = 0, Int_t p = kSdim);
    virtual ~TKalTrackState() {}
+
+   // Allocation from the pool of states
+   void *operator new   (size_t sz)           { return TKalObjectPool<TKalTrackState>::Alloc(sz); }
+   void *operator new   (size_t sz, void *vp) { return TObject::operator new(sz, vp);           }
+   void  operator delete(void *p, size_t sz)  { TKalObjectPool<TKalTrackState>::Free(p, sz);    }
+   void  operator delete(void *p, void *vp)   { TObject::operator delete(p, vp);                }
                                                                                 
    // Implementation of paraent class pure virtuals
                                                                                 
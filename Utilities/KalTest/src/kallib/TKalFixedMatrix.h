@@ -0,0 +1,69 @@
+#ifndef TKALFIXEDMATRIX_H
+#define TKALFIXEDMATRIX_H
+//*************************************************************************
+//* ========================
+//*  TKalFixedMatrix Types
+//* ========================
+//*
+//* (Description)
+//*    Stack allocated matrices of fixed dimensions used internally by
+//*    the Kalman filter kernels (filter, smoother, propagation).
+//*    TKalMatrix stays the type of the public interfaces; the kernels
+//*    load their operands from TKalMatrix, compute with fixed matrices
+//*    and store the results back, so no temporary is heap-allocated.
+//* (Requires)
+//*     ROOT::Math::SMatrix
+//* (Provides)
+//*     TKalFixedMatrix<R,C>
+//*     TKalFixed::Load, TKalFixed::Store, TKalFixed::HasDim
+//*
+//*************************************************************************
+
+#include "Math/SMatrix.h"
+#include "TMatrixD.h"
+
+#include <algorithm>
+
+//_____________________________________________________________________
+//  ------------------------------
+//  Fixed dimension matrix: R rows, C columns
+//  ------------------------------
+//
+template <unsigned int R, unsigned int C = R>
+using TKalFixedMatrix = ROOT::Math::SMatrix<Double_t, R, C>;
+
+namespace TKalFixed {
+
+   // True if the TMatrixD has R rows and C columns
+   template <unsigned int R, unsigned int C>
+   inline Bool_t HasDim(const TMatrixD &a)
+   {
+      return a.GetNrows() == Int_t(R) && a.GetNcols() == Int_t(C);
+   }
+
+   // Copy TMatrixD to a fixed matrix, both are stored row by row
+   template <unsigned int R, unsigned int C>
+   inline void Load(const TMatrixD &a, TKalFixedMatrix<R,C> &m)
+   {
+      const Double_t *p = a.GetMatrixArray();
+      m.SetElements(p, p + R*C);
+   }
+
+   template <unsigned int R, unsigned int C>
+   inline TKalFixedMatrix<R,C> Load(const TMatrixD &a)
+   {
+      TKalFixedMatrix<R,C> m;
+      Load(a, m);
+      return m;
+   }
+
+   // Copy a fixed matrix to TMatrixD, which must have the same dimensions
+   template <unsigned int R, unsigned int C>
+   inline void Store(const TKalFixedMatrix<R,C> &m, TMatrixD &a)
+   {
+      std::copy(m.begin(), m.end(), a.GetMatrixArray());
+   }
+
+} // namespace TKalFixed
+
+#endif
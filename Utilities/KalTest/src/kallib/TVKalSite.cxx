@@ -13,6 +13,9 @@
 //* (Update Recored)
 //*   2003/09/30  K.Fujii	Original version.
 //*   2009/06/18  K.Fujii       Implement inverse Kalman filter
+//*                             Filter and Smooth use fixed size matrices
+//*                             for the usual dimensions (see TKalFixedMatrix).
+//*                             Added the gain formalism to Filter.
 //*
 //*************************************************************************
 //
@@ -21,6 +24,174 @@
 #include <cstdlib>
 #include "TVKalSite.h"
 #include "TVKalState.h"
+#include "TKalFixedMatrix.h"
+
+//_____________________________________________________________________
+//  ------------------------------
+//  Fixed size kernels
+//  ------------------------------
+//    M: dimension of the measurement vector
+//    P: dimension of the state vector
+//    The kernels return kFALSE if the dimensions are not the expected
+//    ones or if an inversion fails; the caller then uses the generic
+//    TKalMatrix implementation.
+//
+namespace {
+
+   using namespace TKalFixed;
+   using ROOT::Math::Transpose;
+
+   // Filtered state vector and covariance matrix in the weighted means
+   // formalism, the covariance matrix of the residual, and the part of the
+   // chi2 increment from the change of the state vector.
+   template <unsigned int M, unsigned int P>
+   Bool_t FilterFixed(const TKalMatrix &mv,     // measurement vector
+                      const TKalMatrix &hv,     // expected measurement vector
+                      const TKalMatrix &Vm,     // measurement noise
+                      const TKalMatrix &Hm,     // H = @h/@a
+                      const TKalMatrix &preav,  // predicted state vector
+                      const TKalMatrix &preCm,  // predicted covariance matrix
+                            TKalMatrix &curav,  // filtered state vector
+                            TKalMatrix &curCm,  // filtered covariance matrix
+                            TKalMatrix &Rm,     // covariance matrix of residual
+                            Double_t   &chi2)   // Kpull^t * preC^-1 * Kpull
+   {
+      if (!HasDim<P,P>(preCm) || !HasDim<M,P>(Hm) || !HasDim<M,M>(Vm)) return kFALSE;
+
+      TKalFixedMatrix<M,1> pull = Load<M,1>(mv) - Load<M,1>(hv);
+      TKalFixedMatrix<M,P> H    = Load<M,P>(Hm);
+      TKalFixedMatrix<P,M> Ht   = Transpose(H);
+      TKalFixedMatrix<M,M> V    = Load<M,M>(Vm);
+
+      TKalFixedMatrix<P,P> preCinv = Load<P,P>(preCm);
+      TKalFixedMatrix<M,M> G       = V;
+      if (!preCinv.Invert() || !G.Invert()) return kFALSE;
+
+      TKalFixedMatrix<P,P> curC = preCinv + Ht * G * H;
+      if (!curC.Invert()) return kFALSE;
+      TKalFixedMatrix<P,M> K     = curC * Ht * G;
+      TKalFixedMatrix<P,1> Kpull = K * pull;
+      TKalFixedMatrix<P,1> av    = Load<P,1>(preav) + Kpull;
+
+      TKalFixedMatrix<1,1> dchi2 = Transpose(Kpull) * preCinv * Kpull;
+      TKalFixedMatrix<M,M> R     = V - H * curC * Ht;
+
+      Store(av,   curav);
+      Store(curC, curCm);
+      Store(R,    Rm);
+      chi2 = dchi2(0,0);
+      return kTRUE;
+   }
+
+   // Filtered state vector and covariance matrix in the gain formalism:
+   //    K    = C H^t (V + H C H^t)^-1
+   //    a'   = a + K (m - h(a))
+   //    C'   = (1 - K H) C (1 - K H)^t + K V K^t    (Joseph form)
+   // Only the MxM covariance matrix of the predicted residual is inverted.
+   // The chi2 increment is pull^t (V + H C H^t)^-1 pull, which is the
+   // same as the one of the weighted means formalism for a linear h(a).
+   template <unsigned int M, unsigned int P>
+   Bool_t FilterGainFixed(const TKalMatrix &mv,
+                          const TKalMatrix &hv,
+                          const TKalMatrix &Vm,
+                          const TKalMatrix &Hm,
+                          const TKalMatrix &preav,
+                          const TKalMatrix &preCm,
+                                TKalMatrix &curav,
+                                TKalMatrix &curCm,
+                                TKalMatrix &Rm,
+                                Double_t   &chi2)   // full chi2 increment
+   {
+      if (!HasDim<P,P>(preCm) || !HasDim<M,P>(Hm) || !HasDim<M,M>(Vm)) return kFALSE;
+
+      TKalFixedMatrix<M,1> pull = Load<M,1>(mv) - Load<M,1>(hv);
+      TKalFixedMatrix<M,P> H    = Load<M,P>(Hm);
+      TKalFixedMatrix<P,M> Ht   = Transpose(H);
+      TKalFixedMatrix<M,M> V    = Load<M,M>(Vm);
+      TKalFixedMatrix<P,P> preC = Load<P,P>(preCm);
+
+      TKalFixedMatrix<M,M> preRinv = V + H * preC * Ht;
+      if (!preRinv.Invert()) return kFALSE;
+
+      TKalFixedMatrix<P,M> K  = preC * Ht * preRinv;
+      TKalFixedMatrix<P,1> av = Load<P,1>(preav) + K * pull;
+
+      TKalFixedMatrix<P,P> IKH(ROOT::Math::SMatrixIdentity());
+      IKH -= K * H;
+      TKalFixedMatrix<P,P> curC = IKH * preC * Transpose(IKH) + K * V * Transpose(K);
+
+      TKalFixedMatrix<1,1> dchi2 = Transpose(pull) * preRinv * pull;
+      TKalFixedMatrix<M,M> R     = V - H * curC * Ht;
+
+      Store(av,   curav);
+      Store(curC, curCm);
+      Store(R,    Rm);
+      chi2 = dchi2(0,0);
+      return kTRUE;
+   }
+
+   // res^t * A^-1 * res
+   template <unsigned int M>
+   Bool_t Chi2Fixed(const TKalMatrix &resm, const TKalMatrix &Am, Double_t &chi2)
+   {
+      if (!HasDim<M,M>(Am)) return kFALSE;
+
+      TKalFixedMatrix<M,1> res  = Load<M,1>(resm);
+      TKalFixedMatrix<M,M> Ainv = Load<M,M>(Am);
+      if (!Ainv.Invert()) return kFALSE;
+
+      TKalFixedMatrix<1,1> c = Transpose(res) * Ainv * res;
+      chi2 = c(0,0);
+      return kTRUE;
+   }
+
+   // Smoothed state vector and covariance matrix, and the updated
+   // residual, its covariance matrix and the chi2 increment
+   template <unsigned int M, unsigned int P>
+   Bool_t SmoothFixed(const TKalMatrix &curav,  // filtered state at this site
+                      const TKalMatrix &curCm,
+                      const TKalMatrix &curFtm, // F^t from this to the next site
+                      const TKalMatrix &preav,  // predicted state at the next site
+                      const TKalMatrix &preCm,
+                      const TKalMatrix &spreav, // smoothed state at the next site
+                      const TKalMatrix &spreCm,
+                      const TKalMatrix &Vm,
+                      const TKalMatrix &Hm,
+                            TKalMatrix &sv,     // smoothed state at this site
+                            TKalMatrix &scurCm,
+                            TKalMatrix &Rm,
+                            TKalMatrix &resm,   // residual, updated in place
+                            Double_t   &chi2)
+   {
+      if (!HasDim<P,P>(curCm) || !HasDim<P,P>(curFtm) || !HasDim<P,P>(preCm) ||
+          !HasDim<P,P>(spreCm) || !HasDim<M,P>(Hm) || !HasDim<M,M>(Vm)) return kFALSE;
+
+      TKalFixedMatrix<P,P> curC    = Load<P,P>(curCm);
+      TKalFixedMatrix<P,P> preC    = Load<P,P>(preCm);
+      TKalFixedMatrix<P,P> preCinv = preC;
+      if (!preCinv.Invert()) return kFALSE;
+
+      TKalFixedMatrix<P,P> curA  = curC * Load<P,P>(curFtm) * preCinv;
+      TKalFixedMatrix<P,P> scurC = curC + curA * (Load<P,P>(spreCm) - preC) * Transpose(curA);
+
+      TKalFixedMatrix<P,1> cura = Load<P,1>(curav);
+      TKalFixedMatrix<P,1> sa   = cura + curA * (Load<P,1>(spreav) - Load<P,1>(preav));
+
+      TKalFixedMatrix<M,P> H    = Load<M,P>(Hm);
+      TKalFixedMatrix<M,M> R    = Load<M,M>(Vm) - H * scurC * Transpose(H);
+      TKalFixedMatrix<M,1> res  = Load<M,1>(resm) - H * (sa - cura);
+      TKalFixedMatrix<M,M> Rinv = R;
+      if (!Rinv.Invert()) return kFALSE;
+      TKalFixedMatrix<1,1> c    = Transpose(res) * Rinv * res;
+
+      Store(sa,    sv);
+      Store(scurC, scurCm);
+      Store(R,     Rm);
+      Store(res,   resm);
+      chi2 = c(0,0);
+      return kTRUE;
+   }
+}
 
 //_____________________________________________________________________
 //  ------------------------------
@@ -53,20 +224,80 @@ TVKalSite::~TVKalSite()
 // Filter
 //---------------------------------------------------------------
 
-Bool_t TVKalSite::Filter()
+Bool_t TVKalSite::Filter(EFilterMode mode)
 {
    // prea and preC should be preset by TVKalState::Propagate()
    TVKalState &prea = GetState(TVKalSite::kPredicted);
    TKalMatrix h = fM;
    if (!CalcExpectedMeasVec(prea,h)) return kFALSE;
-   TKalMatrix pull  = fM - h;
-   TKalMatrix preC  = GetState(TVKalSite::kPredicted).GetCovMat();
 
    // Calculate fH and fHt
 
    if (!CalcMeasVecDerivative(prea,fH)) return kFALSE;
    fHt = TKalMatrix(TKalMatrix::kTransposed, fH);
 
+   // Fixed size kernel for the usual dimensions
+
+   Int_t    m    = fM.GetNrows();
+   Int_t    p    = prea.GetNrows();
+   Double_t chi2 = 0.;
+   TKalMatrix filtav(p,1);
+   TKalMatrix filtC(p,p);
+   Bool_t   done = kFALSE;
+   Bool_t   gain = mode == kGainJoseph;
+
+#define FILTER_FIXED(M,P) \
+   (gain ? FilterGainFixed<M,P>(fM,h,fV,fH,prea,prea.GetCovMat(),filtav,filtC,fR,chi2) \
+         : FilterFixed    <M,P>(fM,h,fV,fH,prea,prea.GetCovMat(),filtav,filtC,fR,chi2))
+
+   switch (m*10 + p) {
+      case 15: done = FILTER_FIXED(1,5); break;
+      case 16: done = FILTER_FIXED(1,6); break;
+      case 25: done = FILTER_FIXED(2,5); break;
+      case 26: done = FILTER_FIXED(2,6); break;
+      default: break;
+   }
+
+#undef FILTER_FIXED
+
+   if (done) {
+      TVKalState &a = CreateState(filtav,filtC,TVKalSite::kFiltered);
+      Add(&a);
+      SetOwner();
+
+      // Calculate chi2 increment
+
+      if (!CalcExpectedMeasVec(a,h)) return kFALSE;
+      fResVec  = fM;
+      fResVec -= h;
+      Double_t reschi2 = 0.;
+      if (gain) {
+         // the gain kernel already returned the full chi2 increment
+         fDeltaChi2 = chi2;
+         if (IsAccepted()) return kTRUE;
+         else              return kFALSE;
+      }
+      switch (m) {
+         case 1:  done = Chi2Fixed<1>(fResVec,fV,reschi2); break;
+         case 2:  done = Chi2Fixed<2>(fResVec,fV,reschi2); break;
+         default: done = kFALSE; break;
+      }
+      if (!done) {
+         TKalMatrix G          = TKalMatrix(TKalMatrix::kInverted, fV);
+         TKalMatrix curResVect = TKalMatrix(TKalMatrix::kTransposed, fResVec);
+         reschi2 = (curResVect * G * fResVec)(0,0);
+      }
+      fDeltaChi2 = reschi2 + chi2;
+
+      if (IsAccepted()) return kTRUE;
+      else              return kFALSE;
+   }
+
+   // Generic implementation (weighted means formalism)
+
+   TKalMatrix pull  = fM - h;
+   TKalMatrix preC  = GetState(TVKalSite::kPredicted).GetCovMat();
+
    // Calculate covariance matrix of residual
 
    TKalMatrix preR    = fV + fH * preC * fHt;
@@ -116,6 +347,41 @@ void TVKalSite::Smooth(TVKalSite &pre)
    TVKalState &prea  = pre.GetState(TVKalSite::kPredicted);
    TVKalState &sprea = pre.GetState(TVKalSite::kSmoothed);
 
+   // Fixed size kernel for the usual dimensions
+
+   Int_t    m    = fM.GetNrows();
+   Int_t    p    = cura.GetNrows();
+   TKalMatrix sa(p,1);
+   TKalMatrix sC(p,p);
+   TKalMatrix res(fResVec);
+   Double_t chi2 = 0.;
+   Bool_t   done = kFALSE;
+
+#define SMOOTH_FIXED(M,P) \
+   SmoothFixed<M,P>(cura,cura.GetCovMat(),cura.GetPropMat("T"), \
+                    prea,prea.GetCovMat(),sprea,sprea.GetCovMat(), \
+                    fV,fH,sa,sC,fR,res,chi2)
+
+   switch (m*10 + p) {
+      case 15: done = SMOOTH_FIXED(1,5); break;
+      case 16: done = SMOOTH_FIXED(1,6); break;
+      case 25: done = SMOOTH_FIXED(2,5); break;
+      case 26: done = SMOOTH_FIXED(2,6); break;
+      default: break;
+   }
+
+#undef SMOOTH_FIXED
+
+   if (done) {
+      Add(&CreateState(sa,sC,TVKalSite::kSmoothed));
+      SetOwner();
+      fResVec    = res;
+      fDeltaChi2 = chi2;
+      return;
+   }
+
+   // Generic implementation
+
    TKalMatrix curC    = cura.GetCovMat();
    TKalMatrix curFt   = cura.GetPropMat("T");
    TKalMatrix preC    = prea.GetCovMat();
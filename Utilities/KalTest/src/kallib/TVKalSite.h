@@ -18,6 +18,9 @@
 //*   2005/08/25  A.Yamaguchi	Removed getter and setter for a new static
 //*                             data member, fgKalSysPtr.
 //*   2009/06/18  K.Fujii       Implement inverse Kalman filter
+//*                             Added the gain formalism with the Joseph
+//*                             form covariance update, selected by
+//*                             the mode passed to Filter().
 //*
 //*************************************************************************
 //
@@ -42,6 +45,8 @@ public:
                   kFiltered,
                   kSmoothed,
                   kInvFiltered };
+   enum EFilterMode { kWeightedMeans = 0, // inversions of the state covariance
+                      kGainJoseph };      // inversion of the residual covariance only
 public:
    // Ctors and Dtor
 
@@ -58,7 +63,7 @@ public:
 
    virtual void    DebugPrint() const = 0;
 
-   virtual Bool_t  Filter();
+   virtual Bool_t  Filter(EFilterMode mode = kWeightedMeans);
 
    virtual void    Smooth(TVKalSite &pre);
 
@@ -16,6 +16,30 @@
 //
 #include "TVKalState.h"
 #include "TVKalSite.h"
+#include "TKalFixedMatrix.h"
+
+namespace {
+   // C' = F * C * F^t + Q with fixed size matrices, also fills F^t
+   template <unsigned int P>
+   Bool_t PropagateCovFixed(const TKalMatrix &Fm,
+                            const TKalMatrix &Cm,
+                            const TKalMatrix &Qm,
+                                  TKalMatrix &Ftm,
+                                  TKalMatrix &preCm)
+   {
+      using namespace TKalFixed;
+      if (!HasDim<P,P>(Fm) || !HasDim<P,P>(Cm) || !HasDim<P,P>(Qm) ||
+          !HasDim<P,P>(Ftm) || !HasDim<P,P>(preCm)) return kFALSE;
+
+      TKalFixedMatrix<P,P> F    = Load<P,P>(Fm);
+      TKalFixedMatrix<P,P> Ft   = ROOT::Math::Transpose(F);
+      TKalFixedMatrix<P,P> preC = F * Load<P,P>(Cm) * Ft + Load<P,P>(Qm);
+
+      Store(Ft,   Ftm);
+      Store(preC, preCm);
+      return kTRUE;
+   }
+}
 //_____________________________________________________________________
 //  ------------------------------
 //  Base Class for measurement vector used by Kalman filter
@@ -106,11 +130,20 @@ void TVKalState::Propagate(TVKalSite &to)
    TVKalState &prea    = MoveTo(to,fF,fQ);
    TVKalState *preaPtr = &prea;
 
-   fFt = TKalMatrix(TKalMatrix::kTransposed, fF);
-
    // Calculate covariance matrix
 
-   TKalMatrix preC = fF * fC * fFt + fQ;
+   Int_t p = fF.GetNrows();
+   TKalMatrix preC(p,p);
+   Bool_t done = kFALSE;
+   switch (p) {
+      case 5:  done = PropagateCovFixed<5>(fF,fC,fQ,fFt,preC); break;
+      case 6:  done = PropagateCovFixed<6>(fF,fC,fQ,fFt,preC); break;
+      default: break;
+   }
+   if (!done) {
+      fFt  = TKalMatrix(TKalMatrix::kTransposed, fF);
+      preC = fF * fC * fFt + fQ;
+   }
 
    // Set predicted state vector and covariance matrix to next site
 
@@ -12,6 +12,10 @@
 //* (Update Recored)
 //*   2003/09/30  K.Fujii	Original version.
 //*   2009/06/18  K.Fujii       Implement inverse Kalman filter
+//*                             The current instance is kept per thread
+//*                             and only set while a system uses it
+//*                             (TScopedInstance).
+//*                             CutBackTo() to resume a fit from a site.
 //*
 //*************************************************************************
 
@@ -27,19 +31,32 @@
 //
 ClassImp(TVKalSystem)
 
-TVKalSystem *TVKalSystem::fgCurInstancePtr = 0;
+namespace {
+   // currently active instance of this thread
+   thread_local TVKalSystem *gCurInstancePtr = 0;
+}
+
+TVKalSystem *TVKalSystem::GetCurInstancePtr()
+{
+   return gCurInstancePtr;
+}
+
+void TVKalSystem::SetCurInstancePtr(TVKalSystem *ksp)
+{
+   gCurInstancePtr = ksp;
+}
 
 TVKalSystem::TVKalSystem(Int_t n) 
             :TObjArray(n),
              fCurSitePtr(0),
-             fChi2(0.)
+             fChi2(0.),
+             fFilterMode(TVKalSite::kWeightedMeans)
 {
-   if (!fgCurInstancePtr) fgCurInstancePtr = this;
 }
 
 TVKalSystem::~TVKalSystem() 
 {
-   if (this == fgCurInstancePtr) fgCurInstancePtr = 0;
+   if (this == gCurInstancePtr) gCurInstancePtr = 0;
 }
 
 //-------------------------------------------------------
@@ -48,7 +65,7 @@ TVKalSystem::~TVKalSystem()
 
 Bool_t TVKalSystem::AddAndFilter(TVKalSite &next)
 {
-   SetCurInstancePtr(this);
+   TScopedInstance current(this);
 
    //
    // Propagate current state to the next site
@@ -60,7 +77,7 @@ Bool_t TVKalSystem::AddAndFilter(TVKalSite &next)
    // Calculate new pull and gain matrix
    //
 
-   if (next.Filter()) {
+   if (next.Filter(fFilterMode)) {
       //
       // Add this to the system if accepted.
       //
@@ -151,3 +168,27 @@ void TVKalSystem::InvFilter(Int_t k)
    fCurSitePtr = curPtr;
    curPtr->InvFilter();
 }
+
+//-------------------------------------------------------
+// CutBackTo
+//-------------------------------------------------------
+
+void TVKalSystem::CutBackTo(Int_t k)
+{
+   // Removes the sites after site k (deleted if the system owns them), so
+   // that AddAndFilter() continues from the filtered state of site k.
+   // The chi2 is summed again over the remaining sites in the order they
+   // were filtered: it is the one the system had after filtering site k.
+   // The sites must not have been smoothed, which changes their chi2.
+
+   for (Int_t i=GetLast(); i>k; i--) {
+      TObject *sitePtr = RemoveAt(i);
+      if (IsOwner()) delete sitePtr;
+   }
+   fCurSitePtr = static_cast<TVKalSite *>(At(k));
+
+   fChi2 = 0.;
+   for (Int_t isite=1; isite<=k; isite++) {
+      fChi2 += static_cast<TVKalSite *>(At(isite))->GetDeltaChi2();
+   }
+}
@@ -15,6 +15,10 @@
 //*   2003/09/30  K.Fujii	Original version.
 //*   2005/08/25  A.Yamaguchi	Added fgCurInstancePtr and its getter & setter.
 //*   2009/06/18  K.Fujii       Implement inverse Kalman filter
+//*                             The current instance is kept per thread
+//*                             and only set while a system uses it
+//*                             (TScopedInstance).
+//*                             CutBackTo() to resume a fit from a site.
 //*
 //*************************************************************************
 
@@ -32,6 +36,22 @@ class TVKalSystem : public TObjArray {
 friend class TVKalSite;
 public:
 
+   // Makes a system the current instance of this thread, which the
+   // measurement layers ask for the particle mass, until the end of the
+   // scope; the previous instance is then restored.
+   class TScopedInstance {
+   public:
+      TScopedInstance(TVKalSystem *ksp) : fPrevPtr(GetCurInstancePtr())
+                                        { SetCurInstancePtr(ksp);     }
+      ~TScopedInstance()                { SetCurInstancePtr(fPrevPtr); }
+
+   private:
+      TScopedInstance(const TScopedInstance &);
+      TScopedInstance &operator=(const TScopedInstance &);
+
+      TVKalSystem *fPrevPtr;  // instance to restore
+   };
+
    // Ctors and Dtor
 
    TVKalSystem(Int_t n = 1);
@@ -43,6 +63,7 @@ public:
    virtual void   SmoothBackTo(Int_t k);
    virtual void   SmoothAll();
    virtual void   InvFilter(Int_t k);
+   virtual void   CutBackTo(Int_t k);
 
    inline  void   Add(TObject *obj);
 
@@ -53,21 +74,24 @@ public:
                                    { return fCurSitePtr->GetState(t); }
    inline virtual Double_t     GetChi2() { return fChi2; }
           virtual Int_t        GetNDF (Bool_t self = kTRUE);
+   inline TVKalSite::EFilterMode GetFilterMode() const { return fFilterMode; }
    
-   static         TVKalSystem *GetCurInstancePtr() { return fgCurInstancePtr; }
+   static         TVKalSystem *GetCurInstancePtr();
 
    // Setters
 
+   // formalism used by AddAndFilter() for the sites of this system
+   inline void SetFilterMode(TVKalSite::EFilterMode mode) { fFilterMode = mode; }
+
 private:
-   static void SetCurInstancePtr(TVKalSystem *ksp) { fgCurInstancePtr = ksp; }
+   static void SetCurInstancePtr(TVKalSystem *ksp);
 
 private:
    TVKalSite   *fCurSitePtr;  // pointer to current site
    Double_t     fChi2;        // current total chi2
-
-   static TVKalSystem *fgCurInstancePtr;  //! currently active instance
+   TVKalSite::EFilterMode fFilterMode; // formalism used by the filter
    
-   ClassDef(TVKalSystem,1)  // Base class for Kalman Filter
+   ClassDef(TVKalSystem,2)  // Base class for Kalman Filter
 };
 
 //=======================================================
@@ -18,6 +18,8 @@
 //*                              Transport() to do their functions.
 //*   2010/04/06  K.Fujii        Modified Transport() to allow a 1-dim hit,
 //*                              for which pivot is at the expected hit.
+//*                              Transport() uses the layer index built by
+//*                              Update() to skip layers out of reach.
 //*
 //*************************************************************************
 
@@ -27,11 +29,127 @@
 #include "TKalTrackSite.h"   // from KalTrackLib
 #include "TKalTrackState.h"  // from KalTrackLib
 #include "TVSurface.h"       // from GeomLib
+#include "TCylinder.h"       // from GeomLib
+#include "THype.h"           // from GeomLib
+#include "THelicalTrack.h"   // from GeomLib
+#include "TKalFixedMatrix.h" // from KalLib
 #include <memory>            // from STL
 #include <iostream>          // from STL
+#include <cmath>             // from STL
 
 ClassImp(TKalDetCradle)
 
+//_________________________________________________________________________
+//  ----------------------------------
+//   Fixed size kernels
+//  ----------------------------------
+namespace {
+  // F = DF * F with fixed size matrices
+  template <unsigned int P>
+  Bool_t UpdatePropMatFixed(const TKalMatrix &DFm, TKalMatrix &Fm)
+  {
+    using namespace TKalFixed;
+    if (!HasDim<P,P>(DFm) || !HasDim<P,P>(Fm)) return kFALSE;
+
+    TKalFixedMatrix<P,P> F = Load<P,P>(DFm) * Load<P,P>(Fm);
+    Store(F, Fm);
+    return kTRUE;
+  }
+
+  // F = DF * F and Q = DF * (Q + Qms) * DF^t with fixed size matrices
+  template <unsigned int P>
+  Bool_t TransportStepFixed(const TKalMatrix &DFm, const TKalMatrix &Qmsm,
+                                  TKalMatrix &Fm,        TKalMatrix &Qm)
+  {
+    using namespace TKalFixed;
+    if (!HasDim<P,P>(DFm) || !HasDim<P,P>(Qmsm) ||
+        !HasDim<P,P>(Fm)  || !HasDim<P,P>(Qm)) return kFALSE;
+
+    TKalFixedMatrix<P,P> DF = Load<P,P>(DFm);
+    TKalFixedMatrix<P,P> F  = DF * Load<P,P>(Fm);
+    TKalFixedMatrix<P,P> Q  = DF * (Load<P,P>(Qm) + Load<P,P>(Qmsm)) * ROOT::Math::Transpose(DF);
+    Store(F, Fm);
+    Store(Q, Qm);
+    return kTRUE;
+  }
+
+  void UpdatePropMat(const TKalMatrix &DF, TKalMatrix &F)
+  {
+    Bool_t done = kFALSE;
+    switch (F.GetNrows()) {
+      case 5:  done = UpdatePropMatFixed<5>(DF, F); break;
+      case 6:  done = UpdatePropMatFixed<6>(DF, F); break;
+      default: break;
+    }
+    if (!done) F = DF * F;
+  }
+
+  void TransportStep(const TKalMatrix &DF, const TKalMatrix &Qms,
+                           TKalMatrix &F,        TKalMatrix &Q)
+  {
+    Bool_t done = kFALSE;
+    switch (F.GetNrows()) {
+      case 5:  done = TransportStepFixed<5>(DF, Qms, F, Q); break;
+      case 6:  done = TransportStepFixed<6>(DF, Qms, F, Q); break;
+      default: break;
+    }
+    if (!done) {
+      F = DF * F;
+      TKalMatrix DFt = TKalMatrix(TMatrixD::kTransposed, DF);
+      Q = DF * (Q + Qms) * DFt;
+    }
+  }
+
+  // Propagator and noise segments reused by all the transports of a thread
+  struct TransportWorkspace {
+    TKalMatrix fDF;
+    TKalMatrix fQms;
+
+    void Prepare(Int_t sdim)
+    {
+      if (fDF.GetNrows() != sdim) {
+        fDF .ResizeTo(sdim, sdim);
+        fQms.ResizeTo(sdim, sdim);
+      }
+      fDF.Zero();
+    }
+  };
+
+  // Radial range [rmin,rmax] covered by the circle of a helix,
+  // measured from the axis at (xa,ya)
+  class HelixReach {
+  public:
+    HelixReach() : fIsValid(kFALSE), fXc(0.), fYc(0.), fRho(0.) {}
+
+    void Update(const TVTrack &trk)
+    {
+      const THelicalTrack *hp = dynamic_cast<const THelicalTrack *>(&trk);
+      fIsValid = hp != 0 && hp->GetKappa() != 0.;
+      if (!fIsValid) return;
+
+      Double_t rho  = hp->GetRho();
+      Double_t dr   = hp->GetDrho() + rho;
+      fXc  = hp->GetPivot().X() + dr * std::cos(hp->GetPhi0());
+      fYc  = hp->GetPivot().Y() + dr * std::sin(hp->GetPhi0());
+      fRho = std::fabs(rho);
+    }
+
+    Bool_t CanReach(Double_t xa, Double_t ya, Double_t rmin, Double_t rmax) const
+    {
+      static const Double_t kTol = 1.e-3;   // keep the test conservative
+      if (!fIsValid) return kTRUE;
+      Double_t d = std::hypot(fXc - xa, fYc - ya);
+      return rmin <= d + fRho + kTol && rmax >= std::fabs(d - fRho) - kTol;
+    }
+
+  private:
+    Bool_t   fIsValid;
+    Double_t fXc;
+    Double_t fYc;
+    Double_t fRho;
+  };
+}
+
 //_________________________________________________________________________
 //  ----------------------------------
 //   Ctors and Dtor
@@ -98,7 +216,7 @@ void TKalDetCradle::Transport(const TKalTrackSite  &from,   // site from
     TKalMatrix DF(sdim, sdim);               // propagator matrix segment
     
     hel.MoveTo(to.GetPivot(), fid, &DF);     // move pivot to actual hit (to)
-    F = DF * F;                              // update F accordingly
+    UpdatePropMat(DF, F);                    // update F accordingly
     hel.PutInto(sv);                         // save updated hel to sv
     
   } else {
@@ -143,6 +261,9 @@ int TKalDetCradle::Transport(const TKalTrackSite  &from,  // site from
   
   TVTrack &hel = *help;
 
+  HelixReach reach;                         // radial range of the helix
+  reach.Update(hel);
+
   //=====================
   // FIXME
   //=====================
@@ -177,7 +298,10 @@ int TKalDetCradle::Transport(const TKalTrackSite  &from,  // site from
   F.UnitMatrix();                            // set the propagator matrix to the unit matrix
   Q.Zero();                                  // zero the noise matrix
   
-  TKalMatrix DF(sdim, sdim);                 // propagator matrix segment
+  static thread_local TransportWorkspace ws;
+  ws.Prepare(sdim);
+  TKalMatrix &DF  = ws.fDF;                  // propagator matrix segment
+  TKalMatrix &Qms = ws.fQms;                 // process noise segment
   
   // ---------------------------------------------------------------------
   //  Loop over layers and transport sv, F, and Q step by step
@@ -194,7 +318,12 @@ int TKalDetCradle::Transport(const TKalTrackSite  &from,  // site from
     
     int mode = ito!=fridx ? di : 0; // need to move to the from site as the helix may not be on the crossing point yet, meaning that the eloss and ms will be incorrectely attributed ...
 
-    if (dynamic_cast<TVSurface *>(At(ito))->CalcXingPointWith(hel, xx, fid, mode)) { // if we have a crossing point at this surface, note di specifies if we are moving forwards or backwards
+    const LayerIndex &li = fLayerIndex[ito];
+    
+    // skip the layers the helix cannot reach: CalcXingPointWith would not find a crossing point
+    if (ito != fridx && li.fIsBounded && !reach.CanReach(li.fXa, li.fYa, li.fRmin, li.fRmax)) continue;
+
+    if (li.fSurfacePtr->CalcXingPointWith(hel, xx, fid, mode)) { // if we have a crossing point at this surface, note di specifies if we are moving forwards or backwards
       
       //=====================
       // FIXME
@@ -212,9 +341,9 @@ int TKalDetCradle::Transport(const TKalTrackSite  &from,  // site from
       //=====================
       // ENDFIXME
       //=====================
-      const TVMeasLayer   &ml  = *dynamic_cast<TVMeasLayer *>(At(ifr)); // get the last layer 
+      const TVMeasLayer   &ml  = *fLayerIndex[ifr].fMeasLayerPtr; // get the last layer 
       
-      TKalMatrix Qms(sdim, sdim);                                       
+      Qms.Zero();
       if (IsMSOn()&& ito!=fridx ){
         
         ml.CalcQms(isout, hel, fid, Qms);                   // Qms for this step, using the fact that the material was found to be outgoing or incomming above, and the distance from the last layer 
@@ -222,10 +351,7 @@ int TKalDetCradle::Transport(const TKalTrackSite  &from,  // site from
       
       hel.MoveTo(xx, fid, &DF);         // move the helix to the present crossing point, DF will simply have its values overwritten so it could be explicitly set to unity here
       if (sdim == 6) DF(5, 5) = 1.;     // t0 stays the same
-      F = DF * F;                       // update F
-      TKalMatrix DFt  = TKalMatrix(TMatrixD::kTransposed, DF);
-      
-      Q = DF * (Q + Qms) * DFt;         // transport Q to the present crossing point
+      TransportStep(DF, Qms, F, Q);     // update F and transport Q to the present crossing point: Q = DF * (Q + Qms) * DF^t
       
       if (IsDEDXOn() && ito!=fridx) {
         hel.PutInto(sv);                              // copy hel to sv
@@ -233,6 +359,7 @@ int TKalDetCradle::Transport(const TKalTrackSite  &from,  // site from
                                                       // Bool_t isfwd = ((cpa > 0 && df < 0) || (cpa <= 0 && df > 0)) ? kForward : kBackward;  // taken from TVMeasurmentLayer::GetEnergyLoss  not df = fid
         sv(2,0) += ml.GetEnergyLoss(isout, hel, fid); // correct for dE/dx, returns delta kappa i.e. the change in pt 
         hel.SetTo(sv, hel.GetPivot());                // save sv back to hel
+        reach.Update(hel);                            // the radius has changed
       }
       ifr = ito; // for the next iteration set the "previous" layer to the current layer moved to 
 
@@ -278,8 +405,35 @@ void TKalDetCradle::Update()
   TVMeasLayer *mlp = 0;
   Int_t i = 0;
   
+  fLayerIndex.clear();
+  fLayerIndex.reserve(GetEntriesFast());
+  
   while ((mlp = dynamic_cast<TVMeasLayer *>(next()))) {
     mlp->SetIndex(i++);
+    
+    // navigation data used by Transport()
+    LayerIndex li;
+    li.fSurfacePtr   = dynamic_cast<const TVSurface *>(mlp);
+    li.fMeasLayerPtr = mlp;
+    li.fIsBounded    = kFALSE;
+    li.fXa = li.fYa = li.fRmin = li.fRmax = 0.;
+    
+    if (const TCylinder *cp = dynamic_cast<const TCylinder *>(mlp)) {
+      li.fIsBounded = kTRUE;
+      li.fXa   = cp->GetXc().X();
+      li.fYa   = cp->GetXc().Y();
+      li.fRmin = cp->GetR();
+      li.fRmax = cp->GetR();
+    } else if (const THype *hp = dynamic_cast<const THype *>(mlp)) {
+      // r^2 = r0^2 + (tanA * z)^2 with z measured from the center
+      Double_t zmax = 0.5 * hp->GetLength();
+      li.fIsBounded = kTRUE;
+      li.fXa   = hp->GetXc().X();
+      li.fYa   = hp->GetXc().Y();
+      li.fRmin = hp->GetR0();
+      li.fRmax = std::sqrt(hp->GetR0() * hp->GetR0() + hp->GetTanA() * hp->GetTanA() * zmax * zmax);
+    }
+    fLayerIndex.push_back(li);
   }
   
 }
@@ -16,12 +16,14 @@
 //*   2004/09/17  K.Fujii           Added ownership flag.
 //*   2010/04/06  K.Fujii           Added a setter for the pivot and a
 //*                                 condition object
+//*                                 Allocated from a TKalObjectPool.
 //*
 //*************************************************************************
 
 #include "TVector3.h"    // from ROOT
 #include "TVKalSite.h"   // from KalLib
 #include "TVTrackHit.h"  // from KalTrackLib
+#include "TKalObjectPool.h" // from KalLib
 
 class TVKalState;
 class TKalTrackState;
@@ -39,6 +41,12 @@ public:
                         Int_t       p = kSdim);
    ~TKalTrackSite();
 
+   // Allocation from the pool of sites
+   void *operator new   (size_t sz)           { return TKalObjectPool<TKalTrackSite>::Alloc(sz); }
+   void *operator new   (size_t sz, void *vp) { return TObject::operator new(sz, vp);          }
+   void  operator delete(void *p, size_t sz)  { TKalObjectPool<TKalTrackSite>::Free(p, sz);    }
+   void  operator delete(void *p, void *vp)   { TObject::operator delete(p, vp);               }
+
    Int_t        CalcExpectedMeasVec  (const TVKalState &a, TKalMatrix &h);
    Int_t        CalcMeasVecDerivative(const TVKalState &a, TKalMatrix &H);
    Bool_t       IsAccepted();
@@ -25,6 +25,8 @@
 //*                                 default value set to "TVMeasLayer"
 //*                                 and corresponding member function
 //*                                 TString GetName()
+//*                                 The material coefficients are computed
+//*                                 once in the ctor.
 //*
 //*************************************************************************
 
@@ -48,6 +50,35 @@ TVMeasLayer::TVMeasLayer(TMaterial     &matIn,
              fIsActive(isactive),
              fname(name)
 {
+   CalcMatCoeffs(matIn,  fMatCoeffs[0]);
+   CalcMatCoeffs(matOut, fMatCoeffs[1]);
+}
+
+//_________________________________________________________________________
+// -----------------
+//  CalcMatCoeffs
+// -----------------
+//    computes the parts of the energy loss and multiple scattering
+//    that depend only on the material.
+//
+void TVMeasLayer::CalcMatCoeffs(const TMaterial &mat, TMatCoeffs &c)
+{
+   static const Double_t kK   = 0.307075e-3;     // [GeV*cm^2]
+
+   Double_t dnsty = mat.GetDensity();		// density
+   Double_t A     = mat.GetA();                 // atomic mass
+   Double_t Z     = mat.GetZ();                 // atomic number
+   //Double_t I    = Z * 1.e-8;			// mean excitation energy [GeV]
+   //Double_t I    = (2.4 +Z) * 1.e-8;		// mean excitation energy [GeV]
+   Double_t I    = (9.76 * Z + 58.8 * TMath::Power(Z, -0.19)) * 1.e-9;
+   Double_t hwp  = 28.816 * TMath::Sqrt(dnsty * Z/A) * 1.e-9;
+
+   c.fX0Inv   = 1. / mat.GetRadLength();
+   c.fDensity = dnsty;
+   c.fKZoverA = kK * Z/A;
+   c.fI2      = I*I;
+   c.fC0      = - (2. * log(I/hwp) + 1.);
+   c.fA       = -c.fC0/27.;
 }
 
 //_________________________________________________________________________
@@ -74,33 +105,26 @@ Double_t TVMeasLayer::GetEnergyLoss(      Bool_t    isoutgoing,
    // -----------------------------------------
    // Bethe-Bloch eq. (Physical Review D P195.)
    // -----------------------------------------
-   static const Double_t kK   = 0.307075e-3;     // [GeV*cm^2]
    static const Double_t kMe  = 0.510998902e-3;  // electron mass [GeV]
    static const Double_t kMpi = 0.13957018;      // pion mass [GeV]
 
    TKalTrack *ktp  = static_cast<TKalTrack *>(TVKalSystem::GetCurInstancePtr());
    Double_t   mass = ktp ? ktp->GetMass() : kMpi;
 
-   const TMaterial &mat = GetMaterial(isoutgoing);
-   Double_t dnsty = mat.GetDensity();		// density
-   Double_t A     = mat.GetA();                 // atomic mass
-   Double_t Z     = mat.GetZ();                 // atomic number
-   //Double_t I    = Z * 1.e-8;			// mean excitation energy [GeV]
-   //Double_t I    = (2.4 +Z) * 1.e-8;		// mean excitation energy [GeV]
-   Double_t I    = (9.76 * Z + 58.8 * TMath::Power(Z, -0.19)) * 1.e-9;
-   Double_t hwp  = 28.816 * TMath::Sqrt(dnsty * Z/A) * 1.e-9;
+   const TMatCoeffs &mc = GetMatCoeffs(isoutgoing);
+   Double_t dnsty = mc.fDensity;		// density
    Double_t bg2  = mom2 / (mass * mass);
    Double_t gm2  = 1. + bg2;
    Double_t meM  = kMe / mass;
    Double_t x    = log10(TMath::Sqrt(bg2));
-   Double_t C0   = - (2. * log(I/hwp) + 1.);
-   Double_t a    = -C0/27.;
+   Double_t C0   = mc.fC0;
+   Double_t a    = mc.fA;
    Double_t del;
    if (x >= 3.)            del = 4.606 * x + C0;
    else if (0.<=x && x<3.) del = 4.606 * x + C0 + a * TMath::Power(3.-x, 3.);
    else                    del = 0.;
    Double_t tmax = 2.*kMe*bg2 / (1. + meM*(2.*TMath::Sqrt(gm2) + meM)); 
-   Double_t dedx = kK * Z/A * gm2/bg2 * (0.5*log(2.*kMe*bg2*tmax / (I*I))
+   Double_t dedx = mc.fKZoverA * gm2/bg2 * (0.5*log(2.*kMe*bg2*tmax / mc.fI2)
                  - bg2/gm2 - del);
 
    Double_t path = hel.IsInB()
@@ -148,8 +172,7 @@ void TVMeasLayer::CalcQms(      Bool_t       isoutgoing,
    Double_t   mass = ktp ? ktp->GetMass() : kMpi;
    Double_t   beta = mom / TMath::Sqrt(mom * mom + mass * mass);
 
-   const TMaterial &mat = GetMaterial(isoutgoing);
-   Double_t x0inv = 1. / mat.GetRadLength();  // radiation length inverse
+   Double_t x0inv = GetMatCoeffs(isoutgoing).fX0Inv;  // radiation length inverse
 
    // *Calculate sigma_ms0 =============================================
    static const Double_t kMS1  = 0.0136;
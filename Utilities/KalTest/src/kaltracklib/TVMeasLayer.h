@@ -25,6 +25,9 @@
 //*                                 default value set to "TVMeasLayer"
 //*                                 and corresponding member function
 //*                                 TString GetName()  
+//*                                 Added the material coefficients used
+//*                                 by GetEnergyLoss() and CalcQms(),
+//*                                 computed once in the ctor.
 //*
 //*************************************************************************
 
@@ -39,6 +42,16 @@ class TVTrackHit;
 
 class TVMeasLayer : public TAttElement {
 public:
+   // Material coefficients for multiple scattering and energy loss
+   struct TMatCoeffs {
+      Double_t fX0Inv;      // radiation length inverse
+      Double_t fDensity;    // density
+      Double_t fKZoverA;    // K * Z/A of Bethe-Bloch eq.
+      Double_t fI2;         // mean excitation energy squared [GeV^2]
+      Double_t fC0;         // density effect: -(2 ln(I/hwp) + 1)
+      Double_t fA;          // density effect: -C0/27
+   };
+
    // Ctors and Dtor
 
    TVMeasLayer(TMaterial &matIn, 
@@ -59,6 +72,8 @@ public:
 
    inline virtual TMaterial &GetMaterial(Bool_t isoutgoing) const
               { return isoutgoing ? *fMaterialOutPtr : *fMaterialInPtr; }
+   inline const TMatCoeffs &GetMatCoeffs(Bool_t isoutgoing) const
+              { return fMatCoeffs[isoutgoing ? 1 : 0]; }
      
    inline  Int_t      GetIndex() const  { return fIndex;    }
    inline  void       SetIndex(Int_t i) { fIndex = i;       }    
@@ -74,12 +89,16 @@ public:
 
   inline TString       GetName() const { return fname;    }
   
+private:
+   static void CalcMatCoeffs(const TMaterial &mat, TMatCoeffs &c);
+
 private:
    TMaterial     *fMaterialInPtr;   // pointer of inner Material
    TMaterial     *fMaterialOutPtr;  // pointer of outer Material
    Int_t          fIndex;           // index in TKalDetCradle
    Bool_t         fIsActive;        // flag to tell layer is active or not
   const Char_t   *fname;
+   TMatCoeffs     fMatCoeffs[2];    //! coefficients of inner [0] and outer [1] material
    ClassDef(TVMeasLayer,1)      // Measurement layer interface class
 };
 
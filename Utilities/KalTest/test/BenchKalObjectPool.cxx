@@ -0,0 +1,98 @@
+//*************************************************************************
+//* Allocation count and time of the sites and states of a Kalman fit,
+//* with the pool (TKalTrackSite, TKalTrackState) and without it (derived
+//* classes of another size, which TKalObjectPool passes to TStorage).
+//* An event creates for every hit of every track a site with a predicted,
+//* a filtered and a smoothed state, and deletes them at the end.
+//*************************************************************************
+
+#include "kaltest/TKalTrackSite.h"
+#include "kaltest/TKalTrackState.h"
+#include "kaltest/TKalMatrix.h"
+
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+namespace {
+
+   const Int_t kNtracks = 200;   // tracks per event
+   const Int_t kNhits   = 100;   // hits per track
+   const Int_t kNevents = 20;
+
+   // Same objects, not served by the pool
+   class TPlainSite : public TKalTrackSite {
+   public:
+      TPlainSite() : fPad(0) {}
+   private:
+      Long64_t fPad;
+   };
+
+   class TPlainState : public TKalTrackState {
+   public:
+      TPlainState(const TKalMatrix &sv, const TVKalSite &site, Int_t type)
+                 : TKalTrackState(sv, site, type), fPad(0) {}
+   private:
+      Long64_t fPad;
+   };
+
+   template <class SITE, class STATE>
+   Long64_t Event(const TKalMatrix &sv)
+   {
+      Long64_t nobjs = 0;
+      std::vector<SITE *> sites;
+      sites.reserve(kNtracks*kNhits);
+      for (Int_t itrk=0; itrk<kNtracks; itrk++) {
+         for (Int_t ihit=0; ihit<kNhits; ihit++) {
+            SITE *site = new SITE;
+            site->Add(new STATE(sv, *site, TVKalSite::kPredicted));
+            site->Add(new STATE(sv, *site, TVKalSite::kFiltered));
+            site->Add(new STATE(sv, *site, TVKalSite::kSmoothed));
+            site->SetOwner();
+            sites.push_back(site);
+            nobjs += 4;
+         }
+      }
+      for (auto sp : sites) delete sp;
+      return nobjs;
+   }
+
+   template <class SITE, class STATE>
+   void Run(const char *name, Bool_t pooled)
+   {
+      typedef std::chrono::steady_clock Clock;
+
+      TKalMatrix sv(kSdim,1);
+      Long64_t nobjs  = 0;
+      Long64_t nfirst = 0;
+      Long64_t nsys   = 0;
+      double   tfirst = 0.;
+      double   tnext  = 0.;
+      for (Int_t ievt=0; ievt<kNevents; ievt++) {
+         Long64_t nchunks = TKalObjectPool<TKalTrackSite>::GetStats().fNChunks
+                          + TKalObjectPool<TKalTrackState>::GetStats().fNChunks;
+         Clock::time_point t0 = Clock::now();
+         nobjs = Event<SITE,STATE>(sv);
+         double dt = std::chrono::duration<double,std::milli>(Clock::now() - t0).count();
+         Long64_t n = pooled ? TKalObjectPool<TKalTrackSite>::GetStats().fNChunks
+                             + TKalObjectPool<TKalTrackState>::GetStats().fNChunks - nchunks
+                             : nobjs;
+         if (ievt == 0) { nfirst = n; tfirst = dt; }
+         else           { nsys  += n; tnext += dt; }
+      }
+      std::printf("%-8s %10lld %14lld %14.1f %10.2f %10.2f\n", name, nobjs, nfirst,
+                  double(nsys)/(kNevents-1), tfirst, tnext/(kNevents-1));
+   }
+}
+
+int main()
+{
+   std::printf("%d tracks of %d hits, 1 site and 3 states per hit\n", kNtracks, kNhits);
+   std::printf("%-8s %10s %14s %14s %10s %10s\n", "", "objects", "sys. allocs",
+               "sys. allocs", "ms", "ms");
+   std::printf("%-8s %10s %14s %14s %10s %10s\n", "", "per event", "1st event",
+               "next events", "1st event", "next");
+   Run<TPlainSite,   TPlainState   >("TStorage", kFALSE);
+   Run<TKalTrackSite,TKalTrackState>("pool",     kTRUE);
+   return 0;
+}
@@ -0,0 +1,265 @@
+//*************************************************************************
+//* Check that a fit resumed with TVKalSystem::CutBackTo() is the fit
+//* made from scratch. The toy track of TestKalFilterModes is fitted with
+//* a chi2 cut on measurements with outliers; the fit is cut back to the
+//* last site before the first measurement that another cut decides
+//* differently and continued with that cut. Sites, chi2, ndf and the
+//* filtered and smoothed states must be those of a new fit with the
+//* other cut - bit by bit, as the same operations are done.
+//*************************************************************************
+
+#include "kaltest/TVKalSystem.h"
+#include "kaltest/TVKalSite.h"
+#include "kaltest/TVKalState.h"
+#include "kaltest/TKalMatrix.h"
+
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+namespace {
+
+   const Int_t    kP     = 5;      // state dimension
+   const Int_t    kNsite = 30;     // measurement planes
+   const Double_t kQms   = 1.e-6;  // process noise on the slopes
+
+   Int_t gNfailed = 0;
+
+   //_____________________________________________________________________
+   // State: the parameters do not depend on the plane, F = 1
+   //
+   class TToyState : public TVKalState {
+   public:
+      TToyState(const TKalMatrix &sv, const TVKalSite &site, Int_t type)
+               : TVKalState(sv, site, type, kP) {}
+      TToyState(const TKalMatrix &sv, const TKalMatrix &c,
+                const TVKalSite &site, Int_t type)
+               : TVKalState(sv, c, site, type, kP) {}
+
+      TVKalState * MoveTo(TVKalSite &to, TKalMatrix &F, TKalMatrix *QPtr = 0) const
+      {
+         F.UnitMatrix();
+         if (QPtr) {
+            QPtr->Zero();
+            (*QPtr)(1,1) = kQms;
+            (*QPtr)(4,4) = kQms;
+         }
+         return new TToyState(*this, to, TVKalSite::kPredicted);
+      }
+      TVKalState & MoveTo(TVKalSite &to, TKalMatrix &F, TKalMatrix &Q) const
+      {
+         return *MoveTo(to, F, &Q);
+      }
+      void DebugPrint() const { Print(); }
+   };
+
+   //_____________________________________________________________________
+   // Site: y (and z for a 2-dim site) measured on the plane at fX,
+   // accepted if the chi2 increment is below the cut
+   //
+   class TToySite : public TVKalSite {
+   public:
+      TToySite(Double_t x, Int_t m, const Double_t *meas, const Double_t *sigma,
+               Double_t maxDeltaChi2)
+              : TVKalSite(m, kP), fX(x), fMaxDeltaChi2(maxDeltaChi2)
+      {
+         for (Int_t i=0; i<m; i++) {
+            GetMeasVec     ()(i,0) = meas[i];
+            GetMeasNoiseMat()(i,i) = sigma[i]*sigma[i];
+         }
+      }
+
+      Int_t CalcExpectedMeasVec(const TVKalState &a, TKalMatrix &h)
+      {
+         h(0,0) = a(0,0) + a(1,0)*fX + a(2,0)*fX*fX;
+         if (GetDimension() > 1) h(1,0) = a(3,0) + a(4,0)*fX;
+         return 1;
+      }
+      Int_t CalcMeasVecDerivative(const TVKalState &, TKalMatrix &H)
+      {
+         H.Zero();
+         H(0,0) = 1.;
+         H(0,1) = fX;
+         H(0,2) = fX*fX;
+         if (GetDimension() > 1) {
+            H(1,3) = 1.;
+            H(1,4) = fX;
+         }
+         return 1;
+      }
+      Bool_t IsAccepted()       { return GetDeltaChi2() < fMaxDeltaChi2; }
+      void   DebugPrint() const {}
+
+   private:
+      TVKalState & CreateState(const TKalMatrix &sv, Int_t type = 0)
+      {
+         SetOwner();
+         return *(new TToyState(sv, *this, type));
+      }
+      TVKalState & CreateState(const TKalMatrix &sv, const TKalMatrix &c, Int_t type = 0)
+      {
+         SetOwner();
+         return *(new TToyState(sv, c, *this, type));
+      }
+
+   private:
+      Double_t fX;
+      Double_t fMaxDeltaChi2;
+   };
+
+   struct Measurement {
+      Double_t x;
+      Int_t    m;
+      Double_t meas[2];
+   };
+
+   const Double_t kSigma[2] = { 1.e-2, 2.e-2 };
+
+   std::vector<Measurement> MakeMeasurements(std::mt19937 &rng)
+   {
+      const Double_t truth[kP] = { 0.1, 0.3, -0.05, 0.2, -0.4 };
+      std::normal_distribution<double> gauss(0., 1.);
+      std::uniform_real_distribution<double> uni(0., 1.);
+
+      std::vector<Measurement> result;
+      for (Int_t k=0; k<kNsite; k++) {
+         Measurement mk;
+         mk.x = 0.05*(k+1);
+         mk.m = k%2 ? 1 : 2;
+         // outliers from a few to many sigma
+         Double_t scale = uni(rng) < 0.2 ? 2. + 8.*uni(rng) : 1.;
+         mk.meas[0] = truth[0] + truth[1]*mk.x + truth[2]*mk.x*mk.x + scale*kSigma[0]*gauss(rng);
+         mk.meas[1] = truth[3] + truth[4]*mk.x                      + scale*kSigma[1]*gauss(rng);
+         result.push_back(mk);
+      }
+      return result;
+   }
+
+   // Add the initial site with a large covariance matrix
+   void Init(TVKalSystem &sys)
+   {
+      sys.SetOwner();
+
+      Double_t zero[2]  = { 0., 0. };
+      Double_t sigma[2] = { 1., 1. };
+      TToySite &site = *new TToySite(0., 2, zero, sigma, 0.);
+
+      TKalMatrix a(kP,1);
+      TKalMatrix C(kP,kP);
+      for (Int_t i=0; i<kP; i++) C(i,i) = 1.e2;
+      site.Add(new TToyState(a, site, TVKalSite::kPredicted));
+      site.Add(new TToyState(a, C, site, TVKalSite::kFiltered));
+      sys.Add(&site);
+   }
+
+   // Filter the measurements from the first one on, returns for each one
+   // whether it was accepted
+   std::vector<Bool_t> Fit(TVKalSystem &sys, const std::vector<Measurement> &meas,
+                           Double_t maxDeltaChi2, UInt_t first = 0)
+   {
+      std::vector<Bool_t> accepted;
+      for (UInt_t k=first; k<meas.size(); k++) {
+         TToySite *site = new TToySite(meas[k].x, meas[k].m, meas[k].meas, kSigma, maxDeltaChi2);
+         Bool_t ok = sys.AddAndFilter(*site);
+         if (!ok) delete site;
+         accepted.push_back(ok);
+      }
+      return accepted;
+   }
+
+   void Expect(Bool_t ok, const char *what, Double_t cut1, Double_t cut2)
+   {
+      if (ok) return;
+      ++gNfailed;
+      std::printf("FAILED: %s (cut %g resumed with cut %g)\n", what, cut1, cut2);
+   }
+
+   Bool_t SameState(TVKalState &a, TVKalState &b)
+   {
+      for (Int_t i=0; i<kP; i++) {
+         if (a(i,0) != b(i,0)) return kFALSE;
+         for (Int_t j=0; j<kP; j++) if (a.GetCovMat()(i,j) != b.GetCovMat()(i,j)) return kFALSE;
+      }
+      return kTRUE;
+   }
+
+   // Fit with cut1, resume with cut2 and compare with a new fit with cut2,
+   // returns the measurement the fit was resumed from
+   UInt_t TestResume(const std::vector<Measurement> &meas, Double_t cut1, Double_t cut2)
+   {
+      TVKalSystem fresh;
+      Init(fresh);
+      std::vector<Bool_t> reference = Fit(fresh, meas, cut2);
+
+      TVKalSystem resumed;
+      Init(resumed);
+      std::vector<Bool_t> accepted = Fit(resumed, meas, cut1);
+
+      // the first measurement decided differently, as in MarlinKalTestTrack::refit()
+      UInt_t first = 0;
+      Int_t  nKept = 0;
+      while (first < meas.size() && accepted[first] == reference[first]) {
+         nKept += accepted[first];
+         first++;
+      }
+
+      resumed.CutBackTo(nKept);
+      Expect(resumed.GetEntriesFast() == nKept + 1, "sites after CutBackTo", cut1, cut2);
+      Expect(&resumed.GetCurSite() == resumed.At(nKept), "current site after CutBackTo", cut1, cut2);
+      Fit(resumed, meas, cut2, first);
+
+      Expect(resumed.GetEntriesFast() == fresh.GetEntriesFast(), "number of sites", cut1, cut2);
+      Expect(resumed.GetChi2() == fresh.GetChi2(), "chi2", cut1, cut2);
+      Expect(resumed.GetNDF() == fresh.GetNDF(), "ndf", cut1, cut2);
+      if (resumed.GetEntriesFast() != fresh.GetEntriesFast()) return first;
+
+      Bool_t sameSites = kTRUE;
+      for (Int_t i=1; i<fresh.GetEntriesFast(); i++) {
+         TVKalSite &r = *static_cast<TVKalSite *>(resumed.At(i));
+         TVKalSite &f = *static_cast<TVKalSite *>(fresh.At(i));
+         sameSites = sameSites && r.GetDeltaChi2() == f.GetDeltaChi2()
+                               && SameState(r.GetState(TVKalSite::kFiltered), f.GetState(TVKalSite::kFiltered));
+      }
+      Expect(sameSites, "filtered sites", cut1, cut2);
+
+      resumed.SmoothBackTo(1);
+      fresh  .SmoothBackTo(1);
+      Expect(SameState(resumed.GetCurSite().GetState(TVKalSite::kSmoothed),
+                       fresh  .GetCurSite().GetState(TVKalSite::kSmoothed)), "smoothed state", cut1, cut2);
+      Expect(resumed.GetChi2() == fresh.GetChi2(), "chi2 after smoothing", cut1, cut2);
+
+      return first;
+   }
+}
+
+int main()
+{
+   std::mt19937 rng(20090618);
+
+   Int_t nResumed = 0, nCutToStart = 0;
+   for (Int_t iEvent=0; iEvent<20; iEvent++) {
+      std::vector<Measurement> meas = MakeMeasurements(rng);
+
+      // a larger cut, as the refit of Clupatra, a smaller one, the same
+      // cut (nothing to refit), and a cut that rejects the first site
+      const Double_t cuts[][2] = { { 4., 8. }, { 10., 20. }, { 20., 4. }, { 10., 10. }, { 1.e-9, 8. } };
+      for (const auto &cut : cuts) {
+         UInt_t first = TestResume(meas, cut[0], cut[1]);
+         if (first > 0 && first < meas.size()) nResumed++;
+         if (first == 0) nCutToStart++;
+      }
+   }
+
+   if (nResumed == 0 || nCutToStart == 0) {
+      ++gNfailed;
+      std::printf("FAILED: %d fits resumed in the middle, %d from the first site\n", nResumed, nCutToStart);
+   }
+
+   if (gNfailed) {
+      std::printf("FAILED: %d checks\n", gNfailed);
+      return 1;
+   }
+   std::printf("OK\n");
+   return 0;
+}
@@ -0,0 +1,216 @@
+//*************************************************************************
+//* Check that the weighted means and the gain (Joseph form) filters of
+//* TVKalSite give the same fit. The track is a linear toy model, for
+//* which both formalisms are exact:
+//*    y(x) = a0 + a1 x + a2 x^2,   z(x) = a3 + a4 x
+//* measured on planes at fixed x, with process noise on the slopes.
+//* The two fits run interleaved on two systems to check that the filter
+//* mode is a property of each system.
+//*************************************************************************
+
+#include "kaltest/TVKalSystem.h"
+#include "kaltest/TVKalSite.h"
+#include "kaltest/TVKalState.h"
+#include "kaltest/TKalMatrix.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <random>
+
+namespace {
+
+   const Int_t    kP     = 5;      // state dimension
+   const Int_t    kNsite = 20;     // measurement planes
+   const Double_t kQms   = 1.e-6;  // process noise on the slopes
+   const Double_t kTol   = 1.e-6;  // in units of the parameter errors
+
+   Int_t gNfailed = 0;
+
+   //_____________________________________________________________________
+   // State: the parameters do not depend on the plane, F = 1
+   //
+   class TToyState : public TVKalState {
+   public:
+      TToyState(const TKalMatrix &sv, const TVKalSite &site, Int_t type)
+               : TVKalState(sv, site, type, kP) {}
+      TToyState(const TKalMatrix &sv, const TKalMatrix &c,
+                const TVKalSite &site, Int_t type)
+               : TVKalState(sv, c, site, type, kP) {}
+
+      TVKalState * MoveTo(TVKalSite &to, TKalMatrix &F, TKalMatrix *QPtr = 0) const
+      {
+         F.UnitMatrix();
+         if (QPtr) {
+            QPtr->Zero();
+            (*QPtr)(1,1) = kQms;
+            (*QPtr)(4,4) = kQms;
+         }
+         return new TToyState(*this, to, TVKalSite::kPredicted);
+      }
+      TVKalState & MoveTo(TVKalSite &to, TKalMatrix &F, TKalMatrix &Q) const
+      {
+         return *MoveTo(to, F, &Q);
+      }
+      void DebugPrint() const { Print(); }
+   };
+
+   //_____________________________________________________________________
+   // Site: y (and z for a 2-dim site) measured on the plane at fX
+   //
+   class TToySite : public TVKalSite {
+   public:
+      TToySite(Double_t x, Int_t m, const Double_t *meas, const Double_t *sigma)
+              : TVKalSite(m, kP), fX(x)
+      {
+         for (Int_t i=0; i<m; i++) {
+            GetMeasVec     ()(i,0) = meas[i];
+            GetMeasNoiseMat()(i,i) = sigma[i]*sigma[i];
+         }
+      }
+
+      Int_t CalcExpectedMeasVec(const TVKalState &a, TKalMatrix &h)
+      {
+         h(0,0) = a(0,0) + a(1,0)*fX + a(2,0)*fX*fX;
+         if (GetDimension() > 1) h(1,0) = a(3,0) + a(4,0)*fX;
+         return 1;
+      }
+      Int_t CalcMeasVecDerivative(const TVKalState &, TKalMatrix &H)
+      {
+         H.Zero();
+         H(0,0) = 1.;
+         H(0,1) = fX;
+         H(0,2) = fX*fX;
+         if (GetDimension() > 1) {
+            H(1,3) = 1.;
+            H(1,4) = fX;
+         }
+         return 1;
+      }
+      Bool_t IsAccepted()       { return kTRUE; }
+      void   DebugPrint() const {}
+
+   private:
+      TVKalState & CreateState(const TKalMatrix &sv, Int_t type = 0)
+      {
+         SetOwner();
+         return *(new TToyState(sv, *this, type));
+      }
+      TVKalState & CreateState(const TKalMatrix &sv, const TKalMatrix &c, Int_t type = 0)
+      {
+         SetOwner();
+         return *(new TToyState(sv, c, *this, type));
+      }
+
+   private:
+      Double_t fX;
+   };
+
+   // Add the initial site with a large covariance matrix
+   void Init(TVKalSystem &sys, TVKalSite::EFilterMode mode)
+   {
+      sys.SetOwner();
+      sys.SetFilterMode(mode);
+
+      Double_t zero[2]  = { 0., 0. };
+      Double_t sigma[2] = { 1., 1. };
+      TToySite &site = *new TToySite(0., 2, zero, sigma);
+
+      TKalMatrix a(kP,1);
+      TKalMatrix C(kP,kP);
+      for (Int_t i=0; i<kP; i++) C(i,i) = 1.e2;
+      site.Add(new TToyState(a, site, TVKalSite::kPredicted));
+      site.Add(new TToyState(a, C, site, TVKalSite::kFiltered));
+      sys.Add(&site);
+   }
+
+   void Check(const char *what, Double_t w, Double_t g, Double_t scale)
+   {
+      if (std::fabs(w - g) <= kTol*scale) return;
+      ++gNfailed;
+      std::printf("MISMATCH %s: weighted means %.12g, gain %.12g\n", what, w, g);
+   }
+
+   // Compare the state vectors and covariance matrices of the two fits
+   void Compare(const char *what, TVKalState &w, TVKalState &g)
+   {
+      const TKalMatrix &Cw = w.GetCovMat();
+      const TKalMatrix &Cg = g.GetCovMat();
+      char name[64];
+      for (Int_t i=0; i<kP; i++) {
+         std::snprintf(name, sizeof(name), "%s a(%d)", what, i);
+         Check(name, w(i,0), g(i,0), std::sqrt(Cw(i,i)));
+         for (Int_t j=0; j<kP; j++) {
+            std::snprintf(name, sizeof(name), "%s C(%d,%d)", what, i, j);
+            Check(name, Cw(i,j), Cg(i,j), std::sqrt(Cw(i,i)*Cw(j,j)));
+         }
+      }
+   }
+}
+
+int main()
+{
+   TVKalSystem weighted;
+   TVKalSystem gain;
+
+   if (weighted.GetFilterMode() != TVKalSite::kWeightedMeans) {
+      std::printf("FAILED: the default filter mode is not the weighted means\n");
+      return 1;
+   }
+
+   Init(weighted, TVKalSite::kWeightedMeans);
+   Init(gain,     TVKalSite::kGainJoseph);
+
+   const Double_t truth[kP] = { 0.1, 0.3, -0.05, 0.2, -0.4 };
+   const Double_t sigma[2]  = { 1.e-2, 2.e-2 };
+
+   std::mt19937 rng(20090618);
+   std::normal_distribution<double> gauss(0., 1.);
+
+   for (Int_t k=0; k<kNsite; k++) {
+      // alternate 2-dim and 1-dim sites to use both kernels
+      Double_t x = 0.05*(k+1);
+      Int_t    m = k%2 ? 1 : 2;
+      Double_t meas[2];
+      meas[0] = truth[0] + truth[1]*x + truth[2]*x*x + sigma[0]*gauss(rng);
+      meas[1] = truth[3] + truth[4]*x                + sigma[1]*gauss(rng);
+
+      TToySite *wsite = new TToySite(x, m, meas, sigma);
+      TToySite *gsite = new TToySite(x, m, meas, sigma);
+      if (!weighted.AddAndFilter(*wsite) || !gain.AddAndFilter(*gsite)) {
+         std::printf("FAILED: filter rejected site %d\n", k);
+         return 1;
+      }
+
+      Check("delta chi2", wsite->GetDeltaChi2(), gsite->GetDeltaChi2(),
+            std::max(1., wsite->GetDeltaChi2()));
+   }
+
+   Compare("filtered", weighted.GetState(TVKalSite::kFiltered),
+                       gain    .GetState(TVKalSite::kFiltered));
+   Check("chi2", weighted.GetChi2(), gain.GetChi2(), std::max(1., weighted.GetChi2()));
+
+   // the fit itself must be sensible
+   TVKalState &a = weighted.GetState(TVKalSite::kFiltered);
+   for (Int_t i=0; i<kP; i++) {
+      if (std::fabs(a(i,0) - truth[i]) > 5.*std::sqrt(a.GetCovMat()(i,i))) {
+         ++gNfailed;
+         std::printf("FAILED: a(%d) = %g, expected %g\n", i, a(i,0), truth[i]);
+      }
+   }
+
+   weighted.SmoothBackTo(1);
+   gain    .SmoothBackTo(1);
+   Compare("smoothed", weighted.GetCurSite().GetState(TVKalSite::kSmoothed),
+                       gain    .GetCurSite().GetState(TVKalSite::kSmoothed));
+
+   std::printf("chi2 / ndf: weighted means %.6f, gain %.6f / %d\n",
+               weighted.GetChi2(), gain.GetChi2(), weighted.GetNDF());
+
+   if (gNfailed) {
+      std::printf("FAILED: %d mismatches\n", gNfailed);
+      return 1;
+   }
+   std::printf("OK\n");
+   return 0;
+}
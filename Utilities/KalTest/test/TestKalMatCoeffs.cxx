@@ -0,0 +1,231 @@
+//*************************************************************************
+//* Check the energy loss and multiple scattering of TVMeasLayer, computed
+//* from the material coefficients of the ctor, against the expressions
+//* evaluated directly from the TMaterial (the code before the table was
+//* introduced), for a set of reference helices, materials and masses.
+//*************************************************************************
+
+#include "kaltest/TVMeasLayer.h"
+#include "kaltest/TKalTrack.h"
+#include "kaltest/THelicalTrack.h"
+#include "kaltest/TKalMatrix.h"
+
+#include "TMaterial.h"
+#include "TMath.h"
+#include "TVector3.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+namespace {
+
+   const Double_t kTol = 1.e-14;   // relative
+
+   Int_t gNfailed = 0;
+   Int_t gNchecks = 0;
+
+   //_____________________________________________________________________
+   // Layer: only the material part of TVMeasLayer is used
+   //
+   class TToyLayer : public TVMeasLayer {
+   public:
+      TToyLayer(TMaterial &min, TMaterial &mout) : TVMeasLayer(min, mout) {}
+
+      TKalMatrix XvToMv (const TVTrackHit &, const TVector3 &) const { return TKalMatrix(2,1); }
+      TVector3   HitToXv(const TVTrackHit &) const { return TVector3(); }
+      void       CalcDhDa(const TVTrackHit &, const TVector3 &,
+                          const TKalMatrix &, TKalMatrix &) const {}
+   };
+
+   //_____________________________________________________________________
+   // Reference: GetEnergyLoss() evaluated from the TMaterial
+   //
+   Double_t RefEnergyLoss(const TMaterial &mat, const TVTrack &hel, Double_t df)
+   {
+      Double_t cpa    = hel.GetKappa();
+      Double_t tnl    = hel.GetTanLambda();
+      Double_t tnl2   = tnl * tnl;
+      Double_t tnl21  = 1. + tnl2;
+      Double_t cslinv = TMath::Sqrt(tnl21);
+      Double_t mom2   = tnl21 / (cpa * cpa);
+
+      static const Double_t kK   = 0.307075e-3;     // [GeV*cm^2]
+      static const Double_t kMe  = 0.510998902e-3;  // electron mass [GeV]
+      static const Double_t kMpi = 0.13957018;      // pion mass [GeV]
+
+      TKalTrack *ktp  = static_cast<TKalTrack *>(TVKalSystem::GetCurInstancePtr());
+      Double_t   mass = ktp ? ktp->GetMass() : kMpi;
+
+      Double_t dnsty = mat.GetDensity();
+      Double_t A     = mat.GetA();
+      Double_t Z     = mat.GetZ();
+      Double_t I    = (9.76 * Z + 58.8 * TMath::Power(Z, -0.19)) * 1.e-9;
+      Double_t hwp  = 28.816 * TMath::Sqrt(dnsty * Z/A) * 1.e-9;
+      Double_t bg2  = mom2 / (mass * mass);
+      Double_t gm2  = 1. + bg2;
+      Double_t meM  = kMe / mass;
+      Double_t x    = log10(TMath::Sqrt(bg2));
+      Double_t C0   = - (2. * log(I/hwp) + 1.);
+      Double_t a    = -C0/27.;
+      Double_t del;
+      if (x >= 3.)            del = 4.606 * x + C0;
+      else if (0.<=x && x<3.) del = 4.606 * x + C0 + a * TMath::Power(3.-x, 3.);
+      else                    del = 0.;
+      Double_t tmax = 2.*kMe*bg2 / (1. + meM*(2.*TMath::Sqrt(gm2) + meM));
+      Double_t dedx = kK * Z/A * gm2/bg2 * (0.5*log(2.*kMe*bg2*tmax / (I*I))
+                    - bg2/gm2 - del);
+
+      Double_t path = hel.IsInB()
+                    ? TMath::Abs(hel.GetRho()*df)*cslinv
+                    : TMath::Abs(df)*cslinv;
+      path /= 10. ;
+
+      Double_t edep = dedx * dnsty * path;
+
+      Double_t cpaa = TMath::Sqrt(tnl21 / (mom2 + edep
+                    * (edep + 2. * TMath::Sqrt(mom2 + mass * mass))));
+      Double_t dcpa = TMath::Abs(cpa) - cpaa;
+
+      Bool_t isfwd = ((cpa > 0 && df < 0) || (cpa <= 0 && df > 0));
+      return isfwd ? (cpa > 0 ? dcpa : -dcpa) : (cpa > 0 ? -dcpa : dcpa);
+   }
+
+   //_____________________________________________________________________
+   // Reference: CalcQms() evaluated from the TMaterial
+   //
+   void RefQms(const TMaterial &mat, const TVTrack &hel, Double_t df, TKalMatrix &Qms)
+   {
+      Double_t cpa    = hel.GetKappa();
+      Double_t tnl    = hel.GetTanLambda();
+      Double_t tnl2   = tnl * tnl;
+      Double_t tnl21  = 1. + tnl2;
+      Double_t cpatnl = cpa * tnl;
+      Double_t cslinv = TMath::Sqrt(tnl21);
+      Double_t mom    = TMath::Abs(1. / cpa) * cslinv;
+
+      static const Double_t kMpi = 0.13957018;
+      TKalTrack *ktp  = static_cast<TKalTrack *>(TVKalSystem::GetCurInstancePtr());
+      Double_t   mass = ktp ? ktp->GetMass() : kMpi;
+      Double_t   beta = mom / TMath::Sqrt(mom * mom + mass * mass);
+
+      Double_t x0inv = 1. / mat.GetRadLength();
+
+      static const Double_t kMS1  = 0.0136;
+      static const Double_t kMS12 = kMS1 * kMS1;
+      static const Double_t kMS2  = 0.038;
+
+      Double_t path = hel.IsInB()
+                    ? TMath::Abs(hel.GetRho()*df)*cslinv
+                    : TMath::Abs(df)*cslinv;
+      path /= 10. ;
+
+      Double_t xl   = path * x0inv;
+      Double_t tmp = 1. + kMS2 * TMath::Log(TMath::Max(1.e-4, xl));
+      tmp /= (mom * beta);
+      Double_t sgms2 = kMS12 * xl * tmp * tmp;
+
+      Qms(1,1) = sgms2 * tnl21;
+      Qms(2,2) = sgms2 * cpatnl * cpatnl;
+      Qms(2,4) = sgms2 * cpatnl * tnl21;
+      Qms(4,2) = sgms2 * cpatnl * tnl21;
+      Qms(4,4) = sgms2 * tnl21  * tnl21;
+   }
+
+   void Check(const char *what, Double_t layer, Double_t ref)
+   {
+      ++gNchecks;
+      if (std::fabs(layer - ref) <= kTol*std::fabs(ref)) return;
+      ++gNfailed;
+      std::printf("MISMATCH %s: layer %.17g, reference %.17g\n", what, layer, ref);
+   }
+
+   // all helices, both materials of one layer, for the current mass
+   void CheckLayer(const TToyLayer &layer, const char *mass)
+   {
+      const Double_t bfield[] = { 30., 0. };             // [kG]
+      const Double_t pt    [] = { 0.1, 0.3, 1., 10., 100. };  // [GeV]
+      const Double_t tanl  [] = { 0., 0.5, -1.2, 3. };
+      const Double_t df    [] = { 0.01, -0.01, 0.4, -0.4 };
+      const Double_t charge[] = { 1., -1. };
+
+      char name[160];
+      for (Double_t b : bfield)
+      for (Double_t p : pt)
+      for (Double_t t : tanl)
+      for (Double_t q : charge) {
+         THelicalTrack hel(0.5, 0.3, q/p, -1.2, t, 0., 0., 0., b);
+         for (Double_t f : df) {
+            for (Int_t out=0; out<2; out++) {
+               const TMaterial &mat = layer.GetMaterial(out);
+
+               std::snprintf(name, sizeof(name), "%s %s %s B=%g pt=%g tanl=%g q=%g df=%g dE/dx",
+                             mat.GetName(), out ? "out" : "in", mass, b, p, t, q, f);
+               Check(name, layer.GetEnergyLoss(out, hel, f), RefEnergyLoss(mat, hel, f));
+
+               TKalMatrix Q   (kSdim,kSdim);
+               TKalMatrix Qref(kSdim,kSdim);
+               layer.CalcQms(out, hel, f, Q);
+               RefQms(mat, hel, f, Qref);
+               for (Int_t i=0; i<kSdim; i++) {
+                  for (Int_t j=0; j<kSdim; j++) {
+                     std::snprintf(name, sizeof(name), "%s %s %s B=%g pt=%g tanl=%g q=%g df=%g Qms(%d,%d)",
+                                   mat.GetName(), out ? "out" : "in", mass, b, p, t, q, f, i, j);
+                     Check(name, Q(i,j), Qref(i,j));
+                  }
+               }
+            }
+         }
+      }
+   }
+}
+
+int main()
+{
+   //                       name       title  A        Z      density    radlen [cm], interlen
+   TMaterial air      ("air",      "", 14.61,    7.3,  1.205e-3,  30390., 0.);
+   TMaterial gas      ("TPCGas",   "", 39.948,   18.,  1.749e-3,  11760., 0.);
+   TMaterial beryllium("beryllium","", 9.012182, 4.,   1.848,     35.28, 0.);
+   TMaterial silicon  ("silicon",  "", 28.0855,  14.,  2.33,      9.36, 0.);
+   TMaterial copper   ("copper",   "", 63.546,   29.,  8.96,      1.436, 0.);
+   TMaterial support  ("support",  "", 20.75865162, 10.39383117, 0.2765900, 101.4262421, 0.);
+
+   TToyLayer layers[] = { TToyLayer(air,       beryllium),
+                          TToyLayer(beryllium, silicon),
+                          TToyLayer(gas,       support),
+                          TToyLayer(support,   copper) };
+
+   // the table of the layer
+   for (const TToyLayer &layer : layers) {
+      for (Int_t out=0; out<2; out++) {
+         const TMaterial &mat = layer.GetMaterial(out);
+         const TVMeasLayer::TMatCoeffs &mc = layer.GetMatCoeffs(out);
+         char name[64];
+         std::snprintf(name, sizeof(name), "%s 1/X0", mat.GetName());
+         Check(name, mc.fX0Inv, 1. / mat.GetRadLength());
+         std::snprintf(name, sizeof(name), "%s density", mat.GetName());
+         Check(name, mc.fDensity, mat.GetDensity());
+      }
+   }
+
+   // no current track: pion mass
+   for (const TToyLayer &layer : layers) CheckLayer(layer, "pion");
+
+   // the mass of the current track
+   const Double_t mass[]  = { 0.510998902e-3, 0.105658, 0.938272 };
+   const char    *pname[] = { "electron", "muon", "proton" };
+   for (Int_t i=0; i<3; i++) {
+      TKalTrack track;
+      track.SetMass(mass[i]);
+      TVKalSystem::TScopedInstance current(&track);
+      for (const TToyLayer &layer : layers) CheckLayer(layer, pname[i]);
+   }
+
+   std::printf("%d values checked\n", gNchecks);
+   if (gNfailed) {
+      std::printf("FAILED: %d mismatches\n", gNfailed);
+      return 1;
+   }
+   std::printf("OK\n");
+   return 0;
+}
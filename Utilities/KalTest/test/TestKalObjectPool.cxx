@@ -0,0 +1,104 @@
+//*************************************************************************
+//* Check that TKalObjectPool reuses its slots: within a thread, across
+//* threads, and after the threads that freed them have exited. The
+//* trackers may start new threads for every event, so the number of
+//* chunks taken from the system must not grow with the number of events.
+//*************************************************************************
+
+#include "kaltest/TKalObjectPool.h"
+
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+namespace {
+
+   // an object of the size of a small state
+   class TToyObject {
+   public:
+      TToyObject() { for (Int_t i=0; i<kN; i++) fData[i] = i; }
+
+      void *operator new   (size_t sz)          { return TKalObjectPool<TToyObject>::Alloc(sz); }
+      void  operator delete(void *p, size_t sz) { TKalObjectPool<TToyObject>::Free(p, sz);    }
+
+   private:
+      enum { kN = 40 };
+      Double_t fData[kN];
+   };
+
+   typedef TKalObjectPool<TToyObject> Pool;
+
+   const Int_t kNobjects = 1000;   // objects per thread and event
+   const Int_t kNthreads = 4;
+   const Int_t kNevents  = 50;
+   const Int_t kNslots   = 512;    // slots per chunk of the pool
+
+   Int_t gNfailed = 0;
+
+   void Expect(Bool_t ok, const char *what, Long64_t value)
+   {
+      if (ok) return;
+      ++gNfailed;
+      std::printf("FAILED: %s (%lld)\n", what, value);
+   }
+
+   // one "event" of a thread
+   void Event()
+   {
+      std::vector<TToyObject *> objs;
+      for (Int_t i=0; i<kNobjects; i++) objs.push_back(new TToyObject);
+      for (auto op : objs) delete op;
+   }
+
+   // at most the chunks of the main thread and of kNthreads running ones
+   Long64_t MaxChunks()
+   {
+      return Pool::GetStats().fNChunks + kNthreads*((kNobjects + kNslots - 1)/kNslots);
+   }
+}
+
+int main()
+{
+   // the slots of a thread are reused by its next events
+   Event();
+   Long64_t nchunks = Pool::GetStats().fNChunks;
+   for (Int_t ievt=1; ievt<kNevents; ievt++) Event();
+   Expect(Pool::GetStats().fNChunks == nchunks, "chunks of the main thread after the events",
+          Pool::GetStats().fNChunks);
+   Expect(Pool::GetStats().fNAlloc == kNevents*kNobjects, "allocations of the main thread",
+          Pool::GetStats().fNAlloc);
+   Expect(Pool::GetStats().fNFree == kNevents*kNobjects, "frees of the main thread",
+          Pool::GetStats().fNFree);
+
+   // new threads for every event reuse the slots of the exited ones
+   for (Int_t ievt=0; ievt<kNevents; ievt++) {
+      std::vector<std::thread> threads;
+      for (Int_t i=0; i<kNthreads; i++) threads.emplace_back(Event);
+      for (auto &t : threads) t.join();
+   }
+   Expect(Pool::GetNChunks() <= MaxChunks(), "chunks after the events on new threads",
+          Pool::GetNChunks());
+
+   // objects allocated here and deleted by another thread
+   std::vector<TToyObject *> objs;
+   for (Int_t i=0; i<kNthreads*kNobjects; i++) objs.push_back(new TToyObject);
+   std::thread deleter([&objs]() { for (auto op : objs) delete op; });
+   deleter.join();
+   for (Int_t ievt=0; ievt<kNevents; ievt++) {
+      std::vector<std::thread> threads;
+      for (Int_t i=0; i<kNthreads; i++) threads.emplace_back(Event);
+      for (auto &t : threads) t.join();
+   }
+   Expect(Pool::GetNChunks() <= MaxChunks(), "chunks after the deletion by another thread",
+          Pool::GetNChunks());
+
+   std::printf("chunks: %lld of %d slots after %d events of %d threads of %d objects\n",
+               Pool::GetNChunks(), kNslots, 2*kNevents, kNthreads, kNobjects);
+
+   if (gNfailed) {
+      std::printf("FAILED: %d checks\n", gNfailed);
+      return 1;
+   }
+   std::printf("OK\n");
+   return 0;
+}
@@ -12,6 +12,9 @@
 
 namespace KiTrack{
 
+   
+   class SegmentPairBatch;
+   
 
    /** An Interface for Criteria.
     * 
@@ -27,6 +30,14 @@ namespace KiTrack{
        */
       virtual bool areCompatible( Segment* parent , Segment* child ) = 0;
       
+      /** Checks all pairs of segments of a batch at once (see SegmentPairBatch): sets pass[i] to 0 for every pair i,
+       * that is not compatible. Pairs with pass[i] == 0 need not be checked.
+       * 
+       * @return false, if the criterion has no batched version (the default) or can't use it for this batch. Then the
+       * pairs have to be checked one by one with areCompatible().
+       */
+      virtual bool areCompatibleBatch( const SegmentPairBatch& /*batch*/ , std::vector< char >& /*pass*/ ){ return false; }
+      
       
       /** @return A map, where the calculated values are stored. The keys are the names of the values.
        */
@@ -0,0 +1,130 @@
+#ifndef SegmentPairBatch_h
+#define SegmentPairBatch_h
+
+#include <vector>
+
+#include "KiTrack/Segment.h"
+
+
+
+namespace KiTrack{
+
+
+   class ICriterion;
+
+
+   /** A batch of pairs of segments (parent and child), that are checked by the criteria together.
+    *
+    * When the pairs are checked one by one, every criterion reads the hits of the pair and calculates its geometric
+    * quantities on its own. The batch instead stores the hits of all pairs in arrays (one array per coordinate and
+    * hit) and calculates the quantities used by several criteria only once: the squared distance of the hits to the
+    * z axis, the vectors between neighbouring hits and the circle in the xy plane through the inner three hits.
+    * Criteria with a batched version (see ICriterion::areCompatibleBatch()) apply their cuts in one loop over these
+    * arrays, all other criteria are still called pair by pair.
+    *
+    * The hits of a pair are numbered from the inside out: first the hits of the child, then the outermost hit of the
+    * parent (the other hits of the parent are the same as the outer hits of the child). So for two 1-hit segments
+    * hit 0 is the hit of the child and hit 1 the hit of the parent.
+    */
+   class SegmentPairBatch{
+
+
+   public:
+
+      /** The number of pairs that are worth collecting before applying the criteria: many enough for long loops,
+       * few enough to stay in the cache.
+       */
+      static const unsigned blockSize = 1024;
+
+      /** Adds the pair of parent and child to the batch
+       */
+      void addPair( Segment* parent , Segment* child ){ _parents.push_back( parent ); _children.push_back( child ); }
+
+      /** Removes all pairs
+       */
+      void clear(){ _parents.clear(); _children.clear(); }
+
+      /** @return the number of pairs */
+      unsigned size() const { return _parents.size(); }
+
+      Segment* getParent( unsigned i ) const { return _parents[i]; }
+      Segment* getChild( unsigned i ) const { return _children[i]; }
+
+      /** Checks all pairs with the criteria.
+       *
+       * The criteria are applied one after the other, each one only to the pairs that passed all criteria before.
+       * So every criterion is called for the same pairs as when checking the pairs one by one and stopping at the
+       * first criterion that fails.
+       *
+       * @param pass is set to one entry per pair: 1 if the pair passed all criteria, 0 if not
+       */
+      void applyCriteria( const std::vector< ICriterion* >& criteria , std::vector< char >& pass );
+
+
+      // The quantities for the batched criteria. They are calculated by applyCriteria().
+
+      /** @return the number of hits of the segments, or 0 if not all segments have the same number of hits
+       */
+      unsigned getSegmentLength() const { return _segmentLength; }
+
+      /** @return the coordinates of hit iHit of all pairs */
+      const float* getX( unsigned iHit ) const { return _x.data() + iHit*size(); }
+      const float* getY( unsigned iHit ) const { return _y.data() + iHit*size(); }
+      const float* getZ( unsigned iHit ) const { return _z.data() + iHit*size(); }
+
+      /** @return x*x + y*y of hit iHit of all pairs */
+      const float* getRhoSquared( unsigned iHit ) const { return _rhoSquared.data() + iHit*size(); }
+
+      /** @return the vector from hit iHit to hit iHit+1 of all pairs */
+      const float* getDeltaX( unsigned iHit ) const { return _deltaX.data() + iHit*size(); }
+      const float* getDeltaY( unsigned iHit ) const { return _deltaY.data() + iHit*size(); }
+      const float* getDeltaZ( unsigned iHit ) const { return _deltaZ.data() + iHit*size(); }
+
+      /** The circle in the xy plane through the hits 0, 1 and 2 of the pairs, as calculated by SimpleCircle.
+       * It is only calculated on the first request. The segments must have at least 2 hits.
+       *
+       * @return for every pair 1, if there is such a circle, 0 if the three hits are on one line
+       */
+      const char* getCircleValid() const;
+
+      /** @return the center and the radius of the circles. Only set, where getCircleValid() is 1. */
+      const double* getCircleCenterX() const { getCircleValid(); return _circleCenterX.data(); }
+      const double* getCircleCenterY() const { getCircleValid(); return _circleCenterY.data(); }
+      const double* getCircleRadius() const { getCircleValid(); return _circleR.data(); }
+
+
+   private:
+
+      /** Fills the hits and the quantities calculated for all criteria */
+      void fill();
+
+
+      std::vector< Segment* > _parents{};
+      std::vector< Segment* > _children{};
+
+      unsigned _segmentLength{};
+
+      std::vector< float > _x{};
+      std::vector< float > _y{};
+      std::vector< float > _z{};
+      std::vector< float > _rhoSquared{};
+      std::vector< float > _deltaX{};
+      std::vector< float > _deltaY{};
+      std::vector< float > _deltaZ{};
+
+      mutable bool _hasCircles{};
+      mutable std::vector< char > _circleValid{};
+      mutable std::vector< double > _circleCenterX{};
+      mutable std::vector< double > _circleCenterY{};
+      mutable std::vector< double > _circleR{};
+
+
+   };
+
+
+}
+
+
+#endif
+
+
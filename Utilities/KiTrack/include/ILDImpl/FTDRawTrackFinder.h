@@ -0,0 +1,132 @@
+#ifndef FTDRawTrackFinder_h
+#define FTDRawTrackFinder_h
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "KiTrack/IHit.h"
+#include "Criteria/ICriterion.h"
+#include "ILDImpl/SectorSystemFTD.h"
+
+
+
+namespace KiTrackMarlin{
+
+   /** Finds the raw tracks (vectors of hits, from the outside in) in the FTD with the SegmentBuilder and the
+    * Cellular Automaton.
+    *
+    * If the Automaton creates more than maxConnections connections, it is rerun with the next (tighter) cut off
+    * values of the criteria, as long as there are new ones.
+    *
+    * With one phi partition and one thread (the default) all hits go into one Cellular Automaton.
+    *
+    * Otherwise the FTD is split into regions, which are processed independently by up to setNumberOfThreads()
+    * threads. The two sides of the FTD share no segments and are always separate regions. With several phi
+    * partitions every side is further split into ranges of petals. A region gets the hits of its range and of
+    * the overlapping petals on both sides of it, and keeps the tracks with their outermost hit in its range.
+    * The overlap must be at least getMinPhiPartitionOverlap(): then every region has all the hits and segments
+    * the tracks of its range can be built from, and the raw tracks are those of one automaton (in a different
+    * order). The rounds with tighter cut offs are decided for each region, so the tracks only differ from
+    * those of one automaton in events where a region exceeds maxConnections.
+    *
+    * If the overlap makes every region reach all petals of its side, there is one region per side. For the
+    * CEPC FTD (16 petals, 5 disks and the IP: an overlap of 6 petals) this is the case for up to 5 partitions,
+    * and with more every region still holds at least 13 of the 16 petals of its side: there the phi partitions
+    * only duplicate work, and the concurrency comes from the two sides.
+    */
+   class FTDRawTrackFinder{
+
+
+   public:
+
+      /** @param criteriaNames the names of the criteria to use
+       *
+       * @param critMinima, critMaxima for every criterion the cut off values of the rounds
+       *
+       * @param maxConnections the maximum number of connections of the Automaton
+       */
+      FTDRawTrackFinder( const SectorSystemFTD* sectorSystemFTD , const std::vector< std::string >& criteriaNames ,
+                         const std::map< std::string , std::vector< float > >& critMinima ,
+                         const std::map< std::string , std::vector< float > >& critMaxima , unsigned maxConnections );
+
+      /** @param nPhiPartitions into how many ranges of petals every side of the FTD is split
+       *
+       * @param overlap how many petals on each side of its range a region gets in addition.
+       * Throws InvalidParameter, if there is more than one partition and the overlap is below getMinPhiPartitionOverlap().
+       */
+      void setPhiPartitions( unsigned nPhiPartitions , unsigned overlap );
+
+      /** The number of threads processing the regions, 0 means the hardware concurrency */
+      void setNumberOfThreads( int nThreads ){ _nThreads = nThreads; }
+
+      /** @return the overlap needed to find the same tracks as one automaton: the petals a track can cross,
+       * petalStepMax for each layer
+       */
+      unsigned getMinPhiPartitionOverlap() const { return petalStepMax * _sectorSystemFTD->getNumberOfLayers(); }
+
+      /** @return the raw tracks found in the hits. The hits of the IP (layer 0) are used on their side only.
+       *
+       * @param map_sector_hits the hits sorted by their sectors
+       */
+      std::vector< std::vector< IHit* > > getRawTracks( const std::map< int , std::vector< IHit* > >& map_sector_hits );
+
+      /** @return for every region of the last call of getRawTracks() the number of rounds of the Automaton */
+      const std::vector< unsigned >& getNumberOfRounds() const { return _nRounds; }
+
+      /** @return for every region of the last call of getRawTracks() the number of hits it got */
+      const std::vector< unsigned >& getNumberOfRegionHits() const { return _nRegionHits; }
+
+
+      static const unsigned layerStepMax = 1; // how many layers to go at max
+      static const unsigned petalStepMax = 1; // how many petals to go at max
+      static const unsigned lastLayerToIP = 5;// layer 1,2,3 and 4 get connected directly to the IP
+
+
+   private:
+
+      /** Runs the SegmentBuilder and the Cellular Automaton on the hits of one region.
+       *
+       * @param nRounds is set to the number of rounds that were run
+       */
+      std::vector< std::vector< IHit* > > getRegionRawTracks( const std::map< int , std::vector< IHit* > >& map_sector_hits ,
+                                                             unsigned& nRounds ) const;
+
+      /** Creates the criteria of a round. The criteria in the vectors are deleted first.
+       * If there are no new cut off values for a criterion, the last one remains.
+       *
+       * @return whether any new cut off value was set. false == there are no new cutoff values anymore
+       */
+      bool setCriteria( unsigned round , std::vector< ICriterion* >& crit2Vec ,
+                        std::vector< ICriterion* >& crit3Vec , std::vector< ICriterion* >& crit4Vec ) const;
+
+      /** @return the number of hits in all sectors */
+      static unsigned countHits( const std::map< int , std::vector< IHit* > >& map_sector_hits );
+
+      /** @return the range of petals (phi partition) the module belongs to */
+      unsigned getPhiPartition( unsigned module ) const { return module * _nSidePartitions / _sectorSystemFTD->getNumberOfModules(); }
+
+
+      const SectorSystemFTD* _sectorSystemFTD;
+
+      std::vector< std::string > _criteriaNames;
+      std::map< std::string , std::vector< float > > _critMinima;
+      std::map< std::string , std::vector< float > > _critMaxima;
+      unsigned _maxConnections;
+
+      unsigned _nPhiPartitions;
+      unsigned _nSidePartitions; // the ranges of petals every side is split into
+      unsigned _overlap;
+      int _nThreads;
+
+      std::vector< unsigned > _nRounds;
+      std::vector< unsigned > _nRegionHits;
+
+   };
+
+
+}
+
+
+#endif
+
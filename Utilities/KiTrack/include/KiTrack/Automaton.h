@@ -2,6 +2,7 @@
 #define Automaton_h
 
 #include <vector>
+#include <utility>
 #include "KiTrack/Segment.h"
 #include "Criteria/ICriterion.h"
 
@@ -42,7 +43,11 @@ namespace KiTrack{
     *   - Segments have states: this is simply an integer number (an unsigned to be more precise). It is needed by the 
     * Automaton to find connections that go all the way through (see pdf!)
     *
-    * The Segments can be added via the addSegment() method and are stored layerwise.
+    * The Segments are passed to the constructor together with their connections and are stored layerwise.
+    * All segments are kept in one contiguous array sorted by layer (keeping their order within a layer) and the
+    * connections in compressed sparse row form: for every segment the indices of its children (and of its parents)
+    * are stored next to each other in one array, in the order the connections were made. Removing segments or
+    * connections compacts these arrays, so the iterations of the automaton never copy lists of segments.
     * 
     * Once the Segments are all stored in the Cellular Automaton it can perform.
     * Via the method doAutomaton() it raises the states of the Segments until no change happens anymore.
@@ -84,16 +89,15 @@ namespace KiTrack{
       
       Automaton(): _nConnections(0){}
       
-      /**
-       * delete all the segments
-       */
-      ~Automaton();
-      
-      
-      /** Adds a segment to the automaton.\
-       * Take care to set the layer of the segment before adding!
+      /** Creates the automaton from segments and their connections.
+       * Take care to set the layer of the segments before!
+       * 
+       * @param segments the segments, they are copied into the automaton
+       * 
+       * @param connections pairs ( parent , child ) of indices into segments. The children (and parents) of a
+       * segment keep the order of the connections.
        */
-      void addSegment ( Segment* segment );
+      Automaton( const std::vector< Segment >& segments , const std::vector< std::pair< unsigned , unsigned > >& connections );
       
       /**Lengthens the segments by one via adding the first hit of the next segment it is connected to
        * to it.
@@ -164,30 +168,56 @@ namespace KiTrack{
       //std::vector < std::vector< IHit* > > getTracks( unsigned minHits = 3 );
       std::vector < std::vector< IHit* > > getTracks( unsigned minHits = 2 ); // YV, 2 mini-vector hits can form a track     
       
-      /**Returns all the tracks starting from this segment.
-       * It is a recursive method and gets invoked by getTracks.
-       */
-      //std::vector < std::vector< IHit* > > getTracksOfSegment ( Segment* segment, std::vector< IHit* > hits , unsigned minHits = 3 );
-      std::vector < std::vector< IHit* > > getTracksOfSegment ( Segment* segment, std::vector< IHit* > hits , unsigned minHits = 2 );    // YV, 2 mini-vector hits can form a track   
-      
       /**
        * @return All the segments currently saved in the automaton
        */
       std::vector <const Segment*> getSegments() const;
       
+      /**
+       * @return the connections as pairs ( parent , child ) of indices into getSegments(), like those passed to
+       * the constructor. They are ordered by the parent and then like the children of the parent.
+       */
+      std::vector< std::pair< unsigned , unsigned > > getConnections() const;
+      
       unsigned getNumberOfConnections(){ return _nConnections; }
       
    private:
       
-      /** Here the segments are stored.
-       * The vector corresponds to the layer.
-       * The list corresponds to the segments on the layer.
-       * _segments[2] is a list with all segments on layer 2.
-       * 
-       * The segments will be deleted by the Automaton in the destructor
+      /** Stores the segments sorted by layer and connects them.
+       * The connections are given as pairs ( parent , child ) of indices into segments.
+       */
+      void setSegments( const std::vector< Segment >& segments , unsigned nLayers , 
+                        const std::vector< std::pair< unsigned , unsigned > >& connections );
+      
+      /** Fills the parents from the children. The parents of a segment are ordered like the
+       * connections in _children.
+       */
+      void setParents();
+      
+      /**Adds all the tracks starting from the segment with index iSeg to tracks.
+       * It is a recursive method and gets invoked by getTracks.
        * 
+       * @param hits the hits collected so far, on return it is the same as on entry
+       */
+      void getTracksOfSegment ( unsigned iSeg , std::vector< IHit* >& hits , unsigned minHits , 
+                                std::vector < std::vector< IHit* > >& tracks ) const;
+      
+      unsigned getNumberOfLayers() const { return _layerBegin.empty() ? 0 : _layerBegin.size() - 1; }
+      
+      /** Here the segments are stored, sorted by layer.
+       * The segments on layer 2 are _segments[ _layerBegin[2] ] ... _segments[ _layerBegin[3] - 1 ].
+       */
+      std::vector < Segment > _segments{};
+      std::vector < unsigned > _layerBegin{};
+      
+      /** The connections between the segments.
+       * The children of segment i are _segments[ _children[k] ] for _childBegin[i] <= k < _childBegin[i+1],
+       * the parents likewise with _parentBegin and _parents.
        */
-      std::vector < std::list < Segment* > > _segments{};
+      std::vector < unsigned > _childBegin{};
+      std::vector < unsigned > _children{};
+      std::vector < unsigned > _parentBegin{};
+      std::vector < unsigned > _parents{};
       
       /** A vector containing all the criteria, that are used in the Automaton
        */
@@ -2,6 +2,7 @@
 #define HopfieldNeuralNet_h
  
  
+#include <random>
 #include <vector>
 
 #include "KiTrackExceptions.h"
@@ -13,6 +14,14 @@ namespace KiTrack{
     * 
     * See <a href="../SubsetHopfieldNN.pdf">this</a> for detailed info.
     * 
+    * The weight matrix is not stored: all compatible neurons have the same weight, so only the lists of the
+    * incompatible neurons are kept and the contribution of the compatible ones is taken from the sum of all states.
+    * One iteration therefore costs the number of neurons plus the number of incompatible pairs.
+    * 
+    * A network can also be one part of a larger one, whose other neurons are all compatible with its own ones
+    * (see the constructor taking the conflicts and setExternalStates()). Iterated together with the other parts,
+    * it then has the same weights as the larger network.
+    * 
     * Author: Robin Glattauer, HEPHY
     */
    class HopfieldNeuralNet {
@@ -35,6 +44,17 @@ namespace KiTrack{
          * set. 1 means highest influence from the quality of the neurons -> the highest quality neurons tend to win.
          */
          HopfieldNeuralNet( std::vector < std::vector <bool> > G , std::vector < double > QI , std::vector < double > states , double omega) ;
+         
+         /**
+         * @param conflicts For every neuron the neurons it is incompatible with. Must be symmetric: if j is in 
+         * conflicts[i], i must be in conflicts[j]. All other neurons are compatible.
+         * 
+         * @param QI, states, omega see above
+         * 
+         * @param nNeuronsTotal If the network is a part of a larger one: the number of neurons of the larger network,
+         * which sets the weight of compatible neurons, (1 - omega) / nNeuronsTotal. 0 means the size of this network.
+         */
+         HopfieldNeuralNet( const std::vector < std::vector <unsigned> >& conflicts , std::vector < double > QI , std::vector < double > states , double omega , unsigned nNeuronsTotal = 0 ) ;
                
                
          /** Does one iteration of the neuronal network.
@@ -65,19 +85,48 @@ namespace KiTrack{
          */
          void setLimitForStable (double limit) { _limitForStable = limit; };
          
+         /**
+         * Sets the summed states of the neurons of the larger network, that are not part of this one. They are
+         * compatible with all neurons of this network and are kept fixed during an iteration.
+         */
+         void setExternalStates (double sumStates) { _externalStates = sumStates; };
+         
+         /**
+         * Makes the random order, in which the neurons are updated, reproducible: it is then drawn from a
+         * std::mt19937 seeded with seed. Without a seed every iteration takes a new one from std::random_device.
+         */
+         void setSeed (unsigned seed) { _rng.seed( seed ); _hasSeed = true; };
+         
          
          /** @return the vector of the states
          */
          std::vector <double> getStates(){ return _States; };
          
+         /** @return the sum of the states
+         */
+         double getSumStates() const;
+         
 
          
       protected:
          
          
             
-         /** the matrix of the weights*/
-         std::vector < std::vector <double> > _W{};
+         /** Checks the parameters and sets up everything but the conflicts */
+         void init( unsigned nNeurons , const std::vector < double >& QI , const std::vector < double >& states , double omega ,
+                    unsigned nNeuronsTotal = 0 );
+         
+         /** the incompatible neurons of neuron i are _conflicts[ _conflictBegin[i] ] ... _conflicts[ _conflictBegin[i+1] - 1 ]
+         * (their weight is -1)
+         */
+         std::vector < unsigned > _conflictBegin{};
+         std::vector < unsigned > _conflicts{};
+         
+         /** the weight between two compatible neurons */
+         double _comp{};
+         
+         /** the summed states of the neurons outside of this network (all compatible) */
+         double _externalStates{};
          
          /** states describing how active a neuron is*/
          std::vector < double > _States{};
@@ -109,6 +158,10 @@ namespace KiTrack{
          */
          std::vector <unsigned> _order{};
          
+         /** the random generator for the order, if a seed was set */
+         std::mt19937 _rng{};
+         bool _hasSeed{};
+         
          
          /** Calculates the activation function
          * 
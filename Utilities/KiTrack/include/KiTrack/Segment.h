@@ -2,7 +2,6 @@
 #define Segment_h
 
 #include <vector>
-#include <list>
 #include <string>
 
 #include "KiTrack/IHit.h"
@@ -21,6 +20,7 @@ namespace KiTrack{
     * The main difference to a hit (in case of 1-hit-segments) or a track (in case of segments with more hits) is, that
     * the segments can have connection to other Segments. They can have children and parents.
     * Children are connected Segments on the inside, Parents are connected Segments on the outside.
+    * The connections are not stored in the Segment itself but in the Automaton holding it.
     * 
     * Inside and outside are w.r.t. the layer a segment is on. Every Segment has a layer (getLayer(), setLayer() ). The 
     * layer indicates the place of the segment (whereever that place is. e.g. a detector ). Layer 0 usually means inside 
@@ -46,17 +46,7 @@ namespace KiTrack{
       Segment( IHit* hit);
       
       
-      void deleteParent ( Segment* delParent ){ _parents.remove( delParent );};
-      void deleteChild ( Segment* delChild ){ _children.remove( delChild );};
-      
-      
-      std::list <Segment*> getChildren() { return _children;};
-      std::list <Segment*> getParents()  { return _parents;};
-      
-      std::vector <IHit*> getHits()const {return _hits;};
-      
-      void addChild( Segment* child ){ _children.push_back(child); };
-      void addParent( Segment* parent ){ _parents.push_back(parent); };
+      const std::vector <IHit*>& getHits()const {return _hits;};
       
       unsigned getLayer()const { return _layer; };
       void setLayer( unsigned layer ) { _layer = layer; }; 
@@ -78,11 +68,6 @@ namespace KiTrack{
      
    private:
       
-      std::list <Segment*> _children{}; 
-      std::list <Segment*> _parents{};
-      
-      
-      
       std::vector <IHit*> _hits{};
       
       std::vector<int> _state{};
@@ -3,6 +3,14 @@
 
 #include <CLHEP/Random/RandFlat.h>
 
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <utility>
+
 #include "KiTrack/Subset.h"
 #include "KiTrack/HopfieldNeuralNet.h"
 
@@ -10,6 +18,42 @@
 
 namespace KiTrack {
  
+   /** A barrier for a fixed number of threads: wait() returns, when all of them have called it. It can be passed
+    * again right away, so the same threads can be synchronised after every iteration of a loop.
+    */
+   class IterationBarrier{
+      
+   public:
+      
+      IterationBarrier( unsigned nThreads ): _nThreads( nThreads ), _nWaiting( 0 ), _generation( 0 ){}
+      
+      void wait(){
+         
+         std::unique_lock< std::mutex > lock( _mutex );
+         unsigned generation = _generation;
+         
+         if ( ++_nWaiting == _nThreads ){ // the last one releases the others
+            
+            _nWaiting = 0;
+            _generation++;
+            _allArrived.notify_all();
+            
+         }
+         else _allArrived.wait( lock , [&](){ return generation != _generation; } );
+         
+      }
+      
+   private:
+      
+      std::mutex _mutex;
+      std::condition_variable _allArrived;
+      unsigned _nThreads;
+      unsigned _nWaiting;
+      unsigned _generation;
+      
+   };
+   
+   
    /** A class to get the best subset with help of a Hopfield Neural Network
     * 
     */
@@ -99,6 +143,17 @@ std::vector< Artist > artistsToStayAtHome = subset.getRejected();
       template< class GetQI, class AreCompatible >
       void calculateBestSet( AreCompatible areCompatible, GetQI getQI );
       
+      /** Same as calculateBestSet( areCompatible, getQI ), but only elements that share a hit are checked with
+       * areCompatible, all others are taken as compatible. So use it only if two elements without a common hit 
+       * are always compatible (like tracks that are incompatible if they share a hit). The number of checks then
+       * grows with the number of overlapping elements instead of the square of the number of elements.
+       * 
+       * @param getHits a functor of type std::vector< H >( T ) returning the hits of an element. Two hits are the 
+       * same, if neither is smaller than the other (H needs an operator<).
+       */
+      template< class GetQI, class AreCompatible, class GetHits >
+      void calculateBestSet( AreCompatible areCompatible, GetQI getQI, GetHits getHits );
+      
       
       SubsetHopfieldNN(){ 
        
@@ -109,6 +164,7 @@ std::vector< Artist > artistsToStayAtHome = subset.getRejected();
          _initStateMin = 0.;
          _initStateMax = 0.1;
          _activationThreshold = 0.5;
+         _nThreads = 1;
          
       }
       
@@ -119,6 +175,13 @@ std::vector< Artist > artistsToStayAtHome = subset.getRejected();
       void setInitStateMin( double initStateMin ){ _initStateMin = initStateMin; }
       void setInitStateMax( double initStateMax ){ _initStateMax = initStateMax; }
       void setActivationThreshold( double activationThreshold ){ _activationThreshold = activationThreshold; }
+      /** With more than one thread, the groups of elements that are not connected by incompatibilities get their
+       * own part of the Neural Network. The parts are iterated together, each one seeing the states of the others,
+       * by up to nThreads threads; 0 means the hardware concurrency. The threads are started once per
+       * calculateBestSet() and meet at a barrier after every iteration. 1 (the default) runs one network: an
+       * iteration of the sparse network is cheap, so the threads only pay off for many interfering elements.
+       */
+      void setNumberOfThreads( int nThreads ){ _nThreads = nThreads; }
       
       double getTStart(){ return _TStart; }
       double getTInf(){ return _TInf; }
@@ -127,9 +190,42 @@ std::vector< Artist > artistsToStayAtHome = subset.getRejected();
       double getInitStateMin(){ return _initStateMin; }
       double getInitStateMax(){ return _initStateMax; }
       double getActivationThreshold(){ return _activationThreshold; }
+      int getNumberOfThreads(){ return _nThreads; }
       
    protected:
       
+      /** Step 1 of calculateBestSet( areCompatible, getQI ): checks all pairs of elements.
+       * 
+       * @param conflicts is set to the elements every element is incompatible with, in ascending order
+       * @param QI is set to the qualities of the elements
+       * @param states is set to the initial states of the neurons
+       */
+      template< class GetQI, class AreCompatible >
+      void findConflicts( AreCompatible areCompatible, GetQI getQI, std::vector< std::vector< unsigned > >& conflicts ,
+                          std::vector< double >& QI , std::vector< double >& states );
+      
+      /** Step 1 of calculateBestSet( areCompatible, getQI, getHits ): checks the pairs of elements sharing a hit.
+       * Gives the same as the overload checking all pairs, if elements without a common hit are compatible.
+       */
+      template< class GetQI, class AreCompatible, class GetHits >
+      void findConflicts( AreCompatible areCompatible, GetQI getQI, GetHits getHits,
+                          std::vector< std::vector< unsigned > >& conflicts ,
+                          std::vector< double >& QI , std::vector< double >& states );
+      
+      /** Steps 2 to 4 of calculateBestSet: sorts the elements into accepted and rejected ones.
+       * 
+       * @param conflicts for every element the elements it is incompatible with
+       */
+      void findBestSubset( const std::vector< std::vector< unsigned > >& conflicts , 
+                           const std::vector< double >& QI , const std::vector< double >& states );
+      
+      /** Lets a Hopfield Neural Network perform until it is stable.
+       * 
+       * @return the final states
+       */
+      std::vector< double > runNeuralNet( const std::vector< std::vector< unsigned > >& conflicts , 
+                                          const std::vector< double >& QI , const std::vector< double >& states );
+      
       
       double _TStart{};
       double _TInf{};
@@ -138,6 +234,7 @@ std::vector< Artist > artistsToStayAtHome = subset.getRejected();
       double _initStateMin{};
       double _initStateMax{};
       double _activationThreshold{};
+      int _nThreads{};
       
    };
    
@@ -146,29 +243,46 @@ std::vector< Artist > artistsToStayAtHome = subset.getRejected();
    void SubsetHopfieldNN<T>::calculateBestSet( AreCompatible areCompatible, GetQI getQI ){
       
       
-      unsigned nAccepted=0;
-      unsigned nRejected=0;
-      unsigned nCompWithAll=0;
-      unsigned nIncompatible=0;
+      // the information for the Hopfield Neural Network:
       
+      std::vector < std::vector <unsigned> > conflicts; // for every neuron (element) the ones it is incompatible with
+      std::vector < double > QI ; // the quality indicators of the neurons (elements)
+      std::vector < double > states; // the initial state to start from.
       
-      std::vector< T > elements = this->_elements; //this pointer is needed here, because of the template!
+      findConflicts( areCompatible , getQI , conflicts , QI , states );
       
-      unsigned nElements = elements.size();
+      findBestSubset( conflicts , QI , states );
       
-      // the information for the Hopfield Neural Network:
+   }
+   
+   
+   template< class T > template< class GetQI, class AreCompatible, class GetHits >
+   void SubsetHopfieldNN<T>::calculateBestSet( AreCompatible areCompatible, GetQI getQI, GetHits getHits ){
       
-      std::vector < std::vector <bool> > G; // a matrix telling, if two neurons (elements) are compatible
-      G.resize( nElements );
-      for (unsigned i=0; i<nElements; i++) G[i].resize( elements.size() );
       
-      std::vector < double > QI ; // the quality indicators of the neurons (elements)
-      QI.resize( nElements );
+      std::vector < std::vector <unsigned> > conflicts;
+      std::vector < double > QI;
+      std::vector < double > states;
       
-      std::vector < double > states; // the initial state to start from.
-      states.resize( nElements );
+      findConflicts( areCompatible , getQI , getHits , conflicts , QI , states );
       
+      findBestSubset( conflicts , QI , states );
       
+   }
+   
+   
+   template< class T > template< class GetQI, class AreCompatible >
+   void SubsetHopfieldNN<T>::findConflicts( AreCompatible areCompatible, GetQI getQI, 
+                                            std::vector< std::vector< unsigned > >& conflicts ,
+                                            std::vector< double >& QI , std::vector< double >& states ){
+      
+      
+      const std::vector< T >& elements = this->_elements; //this pointer is needed here, because of the template!
+      unsigned nElements = elements.size();
+      
+      conflicts.assign( nElements , std::vector< unsigned >() );
+      QI.resize( nElements );
+      states.resize( nElements );
       
       
       /**********************************************************************************************/
@@ -186,26 +300,19 @@ std::vector< Artist > artistsToStayAtHome = subset.getRejected();
          
          //streamlog_out(DEBUG3) << "QI of element " << i << " = " << QI[i] << "\n";
          
-         
          // Set an initial state
          states[i] = CLHEP::RandFlat::shoot ( _initStateMin , _initStateMax ); //random ( uniformly ) values from initStateMin to initStateMax
          
          
-         // Fill the states in the G matrix. (whether two elements are compatible or not
+         // Store the incompatible elements
          for ( unsigned j=i+1; j < nElements ; j++ ){ // over all elements that come after the current one (the elements before get filled automatically because of symmetry)
             
             T elementB = elements[j]; // the track we check if it is in conflict with trackA
             
-            if ( areCompatible( elementA , elementB ) ){ 
-               
-               G[i][j] = 0;
-               G[j][i] = 0;
+            if ( !areCompatible( elementA , elementB ) ){ 
                
-            }
-            else{
-               
-               G[i][j] = 1;
-               G[j][i] = 1;            
+               conflicts[i].push_back( j );
+               conflicts[j].push_back( i );
                
             }
             
@@ -213,90 +320,117 @@ std::vector< Artist > artistsToStayAtHome = subset.getRejected();
          
       }
       
-      // output of the G matrix:
-      if( !G.empty() ){
+   }
+   
+   
+   template< class T > template< class GetQI, class AreCompatible, class GetHits >
+   void SubsetHopfieldNN<T>::findConflicts( AreCompatible areCompatible, GetQI getQI, GetHits getHits,
+                                            std::vector< std::vector< unsigned > >& conflicts ,
+                                            std::vector< double >& QI , std::vector< double >& states ){
+      
+      
+      typedef typename std::decay< decltype( getHits( this->_elements[0] ) ) >::type HitVec;
+      typedef typename HitVec::value_type Hit;
+      
+      const std::vector< T >& elements = this->_elements; //this pointer is needed here, because of the template!
+      unsigned nElements = elements.size();
+      
+      conflicts.assign( nElements , std::vector< unsigned >() );
+      QI.resize( nElements );
+      states.resize( nElements );
+      
+      
+      /**********************************************************************************************/
+      /*                1. Find out which elements are compatible and get the QIs                     */
+      /**********************************************************************************************/
+      
+      // all pairs ( hit , element ) sorted by the hit: the elements sharing a hit are next to each other
+      std::vector< std::pair< Hit , unsigned > > hitElements;
+      
+      for ( unsigned i=0; i < nElements ; i++){ //over all elements
          
-	//streamlog_out(DEBUG2) << "G:\n";
+         QI[i] = getQI( elements[i] );
+         states[i] = CLHEP::RandFlat::shoot ( _initStateMin , _initStateMax ); //random ( uniformly ) values from initStateMin to initStateMax
          
+         HitVec hits = getHits( elements[i] );
+         for ( unsigned k=0; k < hits.size(); k++ ) hitElements.push_back( std::make_pair( hits[k] , i ) );
          
-         for ( unsigned i=0; i < G.size(); i++ ){
-            
-            
-            for ( unsigned j=0; j < G[i].size(); j++ ){
-               
-	      //streamlog_out(DEBUG2) << G[i][j] << "  ";
-               
+      }
+      
+      std::sort( hitElements.begin() , hitElements.end() );
+      
+      // the pairs of elements sharing a hit, sorted: the conflicts of every element are in ascending order
+      std::vector< std::pair< unsigned , unsigned > > candidates;
+      
+      for ( unsigned begin=0, end=0; begin < hitElements.size(); begin = end ){
+         
+         end = begin + 1;
+         while ( end < hitElements.size() && !( hitElements[begin].first < hitElements[end].first ) ) end++;
+         
+         for ( unsigned a=begin; a < end; a++ ){
+            for ( unsigned b=a+1; b < end; b++ ){
+               // the elements are sorted within a hit
+               if ( hitElements[a].second != hitElements[b].second ) candidates.push_back( std::make_pair( hitElements[a].second , hitElements[b].second ) );
             }
-            
-            //streamlog_out(DEBUG2) << "\n";
-            
          }
-        
-      }
-      // output, where one sees, what elements are  incompatible with what others:
-      if( !G.empty() ){
          
-	//streamlog_out(DEBUG2) << "Incompatible ones:\n";
+      }
+      
+      std::sort( candidates.begin() , candidates.end() );
+      candidates.erase( std::unique( candidates.begin() , candidates.end() ) , candidates.end() );
+      
+      for ( unsigned k=0; k < candidates.size(); k++ ){
          
+         unsigned i = candidates[k].first;
+         unsigned j = candidates[k].second;
          
-         for ( unsigned i=0; i < G.size(); i++ ){
-            
-	   //streamlog_out(DEBUG2) << "Element " << i << ":\t";
+         if ( !areCompatible( elements[i] , elements[j] ) ){
             
-            for ( unsigned j=0; j < G[i].size(); j++ ){
-               
-	      //if( G[i][j] ) streamlog_out(DEBUG2) << j << ", ";
-               
-            }
-            
-            //streamlog_out(DEBUG2) << "\n";
+            conflicts[i].push_back( j );
+            conflicts[j].push_back( i );
             
          }
          
       }
       
+   }
+   
+   
+   template< class T >
+   void SubsetHopfieldNN<T>::findBestSubset( const std::vector< std::vector< unsigned > >& conflicts , 
+                                             const std::vector< double >& QI , const std::vector< double >& states ){
+      
+      
+      unsigned nAccepted=0;
+      unsigned nRejected=0;
+      unsigned nCompWithAll=0;
+      unsigned nIncompatible=0;
+      
+      const std::vector< T >& elements = this->_elements;
+      unsigned nElements = elements.size();
+      
+      
+      // output, where one sees, what elements are  incompatible with what others:
+      //streamlog_out(DEBUG2) << "Incompatible ones:\n";
+      //for ( unsigned i=0; i < conflicts.size(); i++ ){
+      //   streamlog_out(DEBUG2) << "Element " << i << ":\t";
+      //   for ( unsigned j=0; j < conflicts[i].size(); j++ ) streamlog_out(DEBUG2) << conflicts[i][j] << ", ";
+      //   streamlog_out(DEBUG2) << "\n";
+      //}
+      
       
       /**********************************************************************************************/
       /*                2. Save elements, that are compatible with all others                         */
       /**********************************************************************************************/
       
-      for( unsigned i=0; i < elements.size(); i++ ){
-         
-         
-         bool isCompatibleWithAll = true;
-         
-         //check if this track is compatible with all others
-         for( unsigned j=0; j < elements.size(); j++){
-            
-            //G[i][j] == 0 i and j are compatible, if G[i][j] == 1 i and j are incompatible
-            if( (i != j) && G[i][j] ){
-               
-               isCompatibleWithAll = false;
-               break;
-               
-            }
-            
-         }
+      for( unsigned i=0; i < nElements; i++ ){
          
-         
-         if ( isCompatibleWithAll ){ //if it is compatible with all others, we don't need the Hopfield Neural Net, we can just save it
-            
+         if ( conflicts[i].empty() ){ //if it is compatible with all others, we don't need the Hopfield Neural Net, we can just save it
             
             //add the track to the good ones
             this->_acceptedElements.push_back( elements[i] );
             nCompWithAll++;
             
-            
-            //And now erase it from the ones we will still check:
-            elements.erase( elements.begin() + i );
-            states.erase( states.begin() + i );
-            QI.erase( QI.begin() + i );
-            
-            for( unsigned j=0; j<G.size(); j++ ) G[j].erase( G[j].begin() + i );
-                     G.erase( G.begin() + i );
-            
-            i--;
-            
          }
          else{
             
@@ -306,81 +440,220 @@ std::vector< Artist > artistsToStayAtHome = subset.getRejected();
          
       }
       
-      
       //streamlog_out( DEBUG3 ) << nCompWithAll << " elements are compatible with all others, " << nIncompatible
       //<< " elements are interfering and will be checked for the best subset\n";
       
       
-      
       /**********************************************************************************************/
       /*                3. Let the Neural Network perform to find the best subset                   */
       /**********************************************************************************************/  
       
-      if( !elements.empty() ){
+      // All interfering elements form one Neural Network, as before: the weight of two compatible elements is
+      // normalised to the number of interfering elements and every element feels all the others.
+      // Elements interact through the compatible weight only by the sum of their states, so with more than one
+      // thread the groups of elements connected by incompatibilities (connected components) get networks of their
+      // own, which are iterated in lockstep. In every iteration a group sees the summed states of the other groups 
+      // from the start of the iteration; the temperature and the stop criterion are those of the whole network.
+      // The threads are started once and wait for each other at a barrier after every iteration.
+      
+      std::vector< double > finalStates( nElements , 0. );
+      
+      std::vector< unsigned > index( nElements ); // the index of an element within its network
+      
+      // the conflicts, QIs and states of a network of some of the elements
+      auto collect = [&]( const std::vector< unsigned >& members , std::vector< std::vector< unsigned > >& netConflicts ,
+                          std::vector< double >& netQI , std::vector< double >& netStates ){
          
-         HopfieldNeuralNet net( G , QI , states , _omega);
+         netConflicts.assign( members.size() , std::vector< unsigned >() );
+         netQI.resize( members.size() );
+         netStates.resize( members.size() );
          
-         net.setT ( _TStart );
-         net.setTInf( _TInf );
-         net.setLimitForStable( _limitForStable );
+         for( unsigned k=0; k < members.size(); k++ ){
+            
+            const std::vector< unsigned >& neighbours = conflicts[ members[k] ];
+            for( unsigned n=0; n < neighbours.size(); n++ ) netConflicts[k].push_back( index[ neighbours[n] ] );
+            
+            netQI[k] = QI[ members[k] ];
+            netStates[k] = states[ members[k] ];
+            
+         }
          
-         unsigned nIterations=1;
+      };
+      
+      int nThreads = _nThreads > 0 ? _nThreads : int( std::thread::hardware_concurrency() );
+      
+      std::vector< std::vector< unsigned > > groupElements;
+      
+      if ( nThreads > 1 ){
          
-         //streamlog_out(DEBUG1) << "states: ( ";
-         //for ( unsigned int i=0; i< states.size(); i++) streamlog_out(DEBUG1) << states[i] << " "; 
-         //streamlog_out(DEBUG1) << ")\n";
+         const unsigned noGroup = nElements;
+         std::vector< unsigned > group( nElements , noGroup );
          
-         while ( !net.doIteration() ){ // while the Neural Net is not (yet) stable
-            
-            nIterations++;
+         for( unsigned i=0; i < nElements; i++ ){
             
-            std::vector <double> newStates = net.getStates();
+            if ( conflicts[i].empty() || group[i] != noGroup ) continue;
             
-            //streamlog_out(DEBUG1) << "states: ( ";      
+            // collect all elements connected to element i
+            unsigned iGroup = groupElements.size();
+            groupElements.push_back( std::vector< unsigned >( 1 , i ) );
+            group[i] = iGroup;
             
-            //for ( unsigned int i=0; i< newStates.size(); i++) streamlog_out(DEBUG1) << newStates[i] << " "; 
+            for( unsigned k=0; k < groupElements[iGroup].size(); k++ ){
+               
+               const std::vector< unsigned >& neighbours = conflicts[ groupElements[iGroup][k] ];
+               
+               for( unsigned n=0; n < neighbours.size(); n++ ){
+                  
+                  if ( group[ neighbours[n] ] == noGroup ){
+                     
+                     group[ neighbours[n] ] = iGroup;
+                     groupElements[iGroup].push_back( neighbours[n] );
+                     
+                  }
+                  
+               }
+               
+            }
             
-            //streamlog_out(DEBUG1) << ")\n";
+            std::sort( groupElements[iGroup].begin() , groupElements[iGroup].end() );
             
          }
          
+         nThreads = std::min( nThreads , int( groupElements.size() ) );
          
+      }
+      
+      if ( nThreads <= 1 ){
          
-         //streamlog_out( DEBUG3 ) << "Hopfield Neural Network is stable after " << nIterations << " iterations.\n";
+         // one network of all interfering elements
+         std::vector< unsigned > members;
+         for( unsigned i=0; i < nElements; i++ ){
+            if ( !conflicts[i].empty() ){
+               index[i] = members.size();
+               members.push_back( i );
+            }
+         }
          
+         if ( !members.empty() ){
+            
+            std::vector< std::vector< unsigned > > netConflicts;
+            std::vector< double > netQI;
+            std::vector< double > netStates;
+            collect( members , netConflicts , netQI , netStates );
+            
+            netStates = runNeuralNet( netConflicts , netQI , netStates );
+            
+            for( unsigned k=0; k < members.size(); k++ ) finalStates[ members[k] ] = netStates[k];
+            
+         }
          
+      }
+      else{
          
+         const unsigned nGroups = groupElements.size();
          
-         /**********************************************************************************************/
-         /*                4. Now just sort the elements into accepted and rejected ones                 */
-         /**********************************************************************************************/  
+         for( unsigned iGroup=0; iGroup < nGroups; iGroup++ ){
+            for( unsigned k=0; k < groupElements[iGroup].size(); k++ ) index[ groupElements[iGroup][k] ] = k;
+         }
          
+         std::vector< HopfieldNeuralNet > nets;
+         nets.reserve( nGroups );
          
-         states = net.getStates();
+         for( unsigned iGroup=0; iGroup < nGroups; iGroup++ ){
+            
+            std::vector< std::vector< unsigned > > netConflicts;
+            std::vector< double > netQI;
+            std::vector< double > netStates;
+            collect( groupElements[iGroup] , netConflicts , netQI , netStates );
+            
+            nets.push_back( HopfieldNeuralNet( netConflicts , netQI , netStates , _omega , nIncompatible ) );
+            nets.back().setT ( _TStart );
+            nets.back().setTInf( _TInf );
+            nets.back().setLimitForStable( _limitForStable );
+            
+         }
          
+         std::vector< double > sumStates( nGroups );
+         std::vector< char > isStable( nGroups );
          
+         bool allStable = false;
+         std::atomic< unsigned > next( 0 );
+         IterationBarrier barrier( nThreads );
          
-         for ( unsigned i=0; i < states.size(); i++ ){
-            
+         // The calling thread sets up every iteration and checks the result, between the barriers. The groups are
+         // independent within an iteration, every thread changes only the networks it takes.
+         auto iterate = [&]( bool isCaller ){
             
-            if ( states[i] >= _activationThreshold ){
+            while ( true ){
                
-               this->_acceptedElements.push_back( elements[i] );
-               nAccepted++;
+               if ( isCaller ){
+                  
+                  // the states of the other groups, fixed during the iteration
+                  double sumAll = 0.;
+                  for( unsigned iGroup=0; iGroup < nGroups; iGroup++ ){
+                     sumStates[iGroup] = nets[iGroup].getSumStates();
+                     sumAll += sumStates[iGroup];
+                  }
+                  for( unsigned iGroup=0; iGroup < nGroups; iGroup++ ) nets[iGroup].setExternalStates( sumAll - sumStates[iGroup] );
+                  
+                  next = 0;
+                  
+               }
                
-            }
-            else{
+               barrier.wait(); // the iteration is set up, or all groups are stable
+               
+               if ( allStable ) break;
+               
+               unsigned iGroup;
+               while ( ( iGroup = next++ ) < nGroups ) isStable[iGroup] = nets[iGroup].doIteration();
+               
+               barrier.wait(); // all groups are iterated
                
-               this->_rejectedElements.push_back( elements[i] );
-               nRejected++;
+               if ( isCaller ) allStable = std::find( isStable.begin() , isStable.end() , 0 ) == isStable.end();
                
             }
             
+         };
+         
+         std::vector< std::thread > threads;
+         threads.reserve( nThreads - 1 );
+         for ( int t=1; t < nThreads; t++ ) threads.emplace_back( iterate , false );
+         iterate( true );
+         for ( unsigned t=0; t < threads.size(); t++ ) threads[t].join();
+         
+         for( unsigned iGroup=0; iGroup < nGroups; iGroup++ ){
+            
+            std::vector< double > netStates = nets[iGroup].getStates();
+            for( unsigned k=0; k < groupElements[iGroup].size(); k++ ) finalStates[ groupElements[iGroup][k] ] = netStates[k];
+            
          }
          
       }
       
       
+      /**********************************************************************************************/
+      /*                4. Now just sort the elements into accepted and rejected ones                 */
+      /**********************************************************************************************/  
+      
+      for ( unsigned i=0; i < nElements; i++ ){
+         
+         if ( conflicts[i].empty() ) continue; // already accepted
+         
+         if ( finalStates[i] >= _activationThreshold ){
+            
+            this->_acceptedElements.push_back( elements[i] );
+            nAccepted++;
+            
+         }
+         else{
+            
+            this->_rejectedElements.push_back( elements[i] );
+            nRejected++;
+            
+         }
+         
+      }
+      
       //streamlog_out( DEBUG3 ) << "Hopfield Neural Network accepted " << nAccepted 
       //<< " elements and rejected " << nRejected << " elements of all in all " 
       //<< nAccepted + nRejected << "incomaptible elements.\n";
@@ -388,6 +661,31 @@ std::vector< Artist > artistsToStayAtHome = subset.getRejected();
       //streamlog_out( DEBUG3 )   << "So in sum " << nAccepted + nCompWithAll
       //<< " elements survived and " << nRejected << " elements got rejected.\n";
       
+   }
+   
+   
+   template< class T >
+   std::vector< double > SubsetHopfieldNN<T>::runNeuralNet( const std::vector< std::vector< unsigned > >& conflicts , 
+                                                            const std::vector< double >& QI , const std::vector< double >& states ){
+      
+      
+      HopfieldNeuralNet net( conflicts , QI , states , _omega);
+      
+      net.setT ( _TStart );
+      net.setTInf( _TInf );
+      net.setLimitForStable( _limitForStable );
+      
+      unsigned nIterations=1;
+      
+      while ( !net.doIteration() ){ // while the Neural Net is not (yet) stable
+         
+         nIterations++;
+         
+      }
+      
+      //streamlog_out( DEBUG3 ) << "Hopfield Neural Network is stable after " << nIterations << " iterations.\n";
+      
+      return net.getStates();
       
    }
    
@@ -397,3 +695,4 @@ std::vector< Artist > artistsToStayAtHome = subset.getRejected();
 
 #endif
 
+
@@ -1,4 +1,5 @@
 #include "Criteria/Crit2_DeltaPhi.h"
+#include "Criteria/SegmentPairBatch.h"
 
 #include <cmath>
 #include <sstream>
@@ -82,3 +83,45 @@ bool Crit2_DeltaPhi::areCompatible( Segment* parent , Segment* child ) {
 }
 
 
+bool Crit2_DeltaPhi::areCompatibleBatch( const SegmentPairBatch& batch , std::vector< char >& pass ){
+   
+   
+   if ( _saveValues || ( batch.getSegmentLength() != 1 ) ) return false; // the values are only saved pair by pair
+   
+   // a is the hit of the parent, b the one of the child (as in areCompatible)
+   const float* ax = batch.getX( 1 );
+   const float* ay = batch.getY( 1 );
+   const float* rhoASquared = batch.getRhoSquared( 1 );
+   
+   const float* bx = batch.getX( 0 );
+   const float* by = batch.getY( 0 );
+   const float* rhoBSquared = batch.getRhoSquared( 0 );
+   
+   const float deltaPhiMax = _deltaPhiMax;
+   const float deltaPhiMin = _deltaPhiMin;
+   
+   const unsigned nPairs = batch.size();
+   
+   for ( unsigned i = 0; i < nPairs; i++ ){
+      
+      
+      float phia = atan2( ay[i], ax[i] );
+      float phib = atan2( by[i], bx[i] );
+      float deltaPhi = phia-phib;
+      if (deltaPhi > M_PI) deltaPhi -= 2*M_PI;           //to the range from -pi to pi
+      if (deltaPhi < -M_PI) deltaPhi += 2*M_PI;           //to the range from -pi to pi
+      
+      if (( rhoBSquared[i] < 0.0001 )||( rhoASquared[i] < 0.0001 )) deltaPhi = 0.; // In case one of the hits is too close to the origin
+      
+      deltaPhi = 180.*fabs( deltaPhi ) / M_PI;
+      
+      pass[i] = pass[i] & !( deltaPhi > deltaPhiMax ) & !( deltaPhi < deltaPhiMin );
+      
+      
+   }
+   
+   
+   return true;
+   
+   
+}
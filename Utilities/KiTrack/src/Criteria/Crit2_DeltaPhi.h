@@ -19,6 +19,8 @@ namespace KiTrack{
       Crit2_DeltaPhi ( float deltaPhiMin , float deltaPhiMax );
       
       virtual bool areCompatible( Segment* parent , Segment* child );
+      
+      virtual bool areCompatibleBatch( const SegmentPairBatch& batch , std::vector< char >& pass );
 
       virtual ~Crit2_DeltaPhi(){};
 
@@ -1,4 +1,5 @@
 #include "Criteria/Crit2_DeltaRho.h"
+#include "Criteria/SegmentPairBatch.h"
 
 #include <cmath>
 #include <sstream>
@@ -79,3 +80,35 @@ bool Crit2_DeltaRho::areCompatible( Segment* parent , Segment* child ) {
 }
 
 
+bool Crit2_DeltaRho::areCompatibleBatch( const SegmentPairBatch& batch , std::vector< char >& pass ){
+   
+   
+   if ( _saveValues || ( batch.getSegmentLength() != 1 ) ) return false; // the values are only saved pair by pair
+   
+   // a is the hit of the parent, b the one of the child (as in areCompatible)
+   const float* rhoASquared = batch.getRhoSquared( 1 );
+   const float* rhoBSquared = batch.getRhoSquared( 0 );
+   
+   const float deltaRhoMax = _deltaRhoMax;
+   const float deltaRhoMin = _deltaRhoMin;
+   
+   const unsigned nPairs = batch.size();
+   
+   for ( unsigned i = 0; i < nPairs; i++ ){
+      
+      
+      float rhoA =  sqrt( rhoASquared[i] );
+      float rhoB =  sqrt( rhoBSquared[i] );
+      
+      float deltaRho = rhoA - rhoB;
+      
+      pass[i] = pass[i] & !( deltaRho > deltaRhoMax ) & !( deltaRho < deltaRhoMin );
+      
+      
+   }
+   
+   
+   return true;
+   
+   
+}
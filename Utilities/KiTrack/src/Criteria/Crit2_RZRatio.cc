@@ -1,4 +1,5 @@
 #include "Criteria/Crit2_RZRatio.h"
+#include "Criteria/SegmentPairBatch.h"
 
 #include <cmath>
 #include <sstream>
@@ -76,7 +77,34 @@ bool Crit2_RZRatio::areCompatible( Segment* parent , Segment* child ) {
 }
 
 
-
-
-
-
+bool Crit2_RZRatio::areCompatibleBatch( const SegmentPairBatch& batch , std::vector< char >& pass ){
+   
+   
+   if ( _saveValues || ( batch.getSegmentLength() != 1 ) ) return false; // the values are only saved pair by pair
+   
+   // the vector from the hit of the child (b) to the hit of the parent (a), i.e. a - b
+   const float* dx = batch.getDeltaX( 0 );
+   const float* dy = batch.getDeltaY( 0 );
+   const float* dz = batch.getDeltaZ( 0 );
+   
+   const float ratioMaxSquared = _ratioMax * _ratioMax;
+   const float ratioMinSquared = _ratioMin * _ratioMin;
+   
+   const unsigned nPairs = batch.size();
+   
+   for ( unsigned i = 0; i < nPairs; i++ ){
+      
+      
+      double ratioSquared = 0.; 
+      if ( dz[i] != 0. ) ratioSquared = ( dx[i]*dx[i] + dy[i]*dy[i] + dz[i]*dz[i] ) / ( dz[i]*dz[i] );
+      
+      pass[i] = pass[i] & !( ratioSquared > ratioMaxSquared ) & !( ratioSquared < ratioMinSquared );
+      
+      
+   }
+   
+   
+   return true;
+   
+   
+}
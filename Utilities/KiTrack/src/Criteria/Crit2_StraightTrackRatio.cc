@@ -1,4 +1,5 @@
 #include "Criteria/Crit2_StraightTrackRatio.h"
+#include "Criteria/SegmentPairBatch.h"
 
 #include <cmath>
 #include <sstream>
@@ -88,3 +89,41 @@ bool Crit2_StraightTrackRatio::areCompatible( Segment* parent , Segment* child )
 }
 
 
+bool Crit2_StraightTrackRatio::areCompatibleBatch( const SegmentPairBatch& batch , std::vector< char >& pass ){
+   
+   
+   if ( _saveValues || ( batch.getSegmentLength() != 1 ) ) return false; // the values are only saved pair by pair
+   
+   // a is the hit of the parent, b the one of the child (as in areCompatible)
+   const float* az = batch.getZ( 1 );
+   const float* rhoASq = batch.getRhoSquared( 1 );
+   
+   const float* bz = batch.getZ( 0 );
+   const float* rhoBSq = batch.getRhoSquared( 0 );
+   
+   const float ratioMaxSquared = _ratioMax * _ratioMax;
+   const float ratioMinSquared = _ratioMin * _ratioMin;
+   
+   const unsigned nPairs = batch.size();
+   
+   for ( unsigned i = 0; i < nPairs; i++ ){
+      
+      
+      double rhoASquared = rhoASq[i];
+      double rhoBSquared = rhoBSq[i];
+      
+      // calculated for all pairs, but only used where there is no division by 0
+      double ratioSquared = ( ( rhoASquared * ( bz[i]*bz[i] )  ) / ( rhoBSquared * ( az[i]*az[i] )  ) );
+      
+      bool isOutside = ( ratioSquared > ratioMaxSquared ) | ( ratioSquared < ratioMinSquared );
+      
+      pass[i] = pass[i] & !( ( rhoBSquared > 0. ) & ( az[i] != 0. ) & isOutside );
+      
+      
+   }
+   
+   
+   return true;
+   
+   
+}
@@ -22,6 +22,8 @@ namespace KiTrack{
       Crit2_StraightTrackRatio ( float ratioMin, float ratioMax );
       
       virtual bool areCompatible( Segment* parent , Segment* child );
+      
+      virtual bool areCompatibleBatch( const SegmentPairBatch& batch , std::vector< char >& pass );
 
       virtual ~Crit2_StraightTrackRatio(){};
 
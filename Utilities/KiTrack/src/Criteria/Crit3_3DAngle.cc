@@ -1,4 +1,5 @@
 #include "Criteria/Crit3_3DAngle.h"
+#include "Criteria/SegmentPairBatch.h"
 
 #include <cmath>
 #include <sstream>
@@ -122,3 +123,49 @@ bool Crit3_3DAngle::areCompatible( Segment* parent , Segment* child ) {
    
 }
 
+
+bool Crit3_3DAngle::areCompatibleBatch( const SegmentPairBatch& batch , std::vector< char >& pass ){
+   
+   
+   if ( _saveValues || ( batch.getSegmentLength() != 2 ) ) return false; // the values are only saved pair by pair
+   
+   // u = b - a and v = c - b, with a, b, c as in areCompatible
+   const float* ux = batch.getDeltaX( 0 );
+   const float* uy = batch.getDeltaY( 0 );
+   const float* uz = batch.getDeltaZ( 0 );
+   
+   const float* vx = batch.getDeltaX( 1 );
+   const float* vy = batch.getDeltaY( 1 );
+   const float* vz = batch.getDeltaZ( 1 );
+   
+   const float cosAngleMinSquared = _cosAngleMin*_cosAngleMin;
+   const float cosAngleMaxSquared = _cosAngleMax*_cosAngleMax;
+   
+   const unsigned nPairs = batch.size();
+   
+   for ( unsigned i = 0; i < nPairs; i++ ){
+      
+      
+      double numerator= ux[i]*vx[i] + uy[i]*vy[i] + uz[i]*vz[i];
+      
+      double uSquared= ux[i]*ux[i] + uy[i]*uy[i] + uz[i]*uz[i];
+      double vSquared= vx[i]*vx[i] + vy[i]*vy[i] + vz[i]*vz[i];
+      
+      double denomSquared = uSquared * vSquared;
+      
+      // calculated for all pairs, but only used where there is no division by 0
+      double cosThetaSquared = numerator * numerator / ( uSquared * vSquared );
+      if( cosThetaSquared > 1. ) cosThetaSquared = 1;
+      
+      bool isOutside = ( cosThetaSquared < cosAngleMinSquared ) | ( cosThetaSquared > cosAngleMaxSquared );
+      
+      pass[i] = pass[i] & !( ( denomSquared > 0. ) & isOutside );
+      
+      
+   }
+   
+   
+   return true;
+   
+   
+}
@@ -20,6 +20,8 @@ namespace KiTrack{
       Crit3_3DAngle ( float angleMin, float angleMax );
       
       virtual bool areCompatible( Segment* parent , Segment* child );
+      
+      virtual bool areCompatibleBatch( const SegmentPairBatch& batch , std::vector< char >& pass );
 
       virtual ~Crit3_3DAngle(){};
     
@@ -1,4 +1,5 @@
 #include "Criteria/Crit3_ChangeRZRatio.h"
+#include "Criteria/SegmentPairBatch.h"
 
 #include <cmath>
 #include <sstream>
@@ -85,6 +86,49 @@ bool Crit3_ChangeRZRatio::areCompatible( Segment* parent , Segment* child ) {
    
    
    
+   return true;
+   
+   
+}
+
+
+bool Crit3_ChangeRZRatio::areCompatibleBatch( const SegmentPairBatch& batch , std::vector< char >& pass ){
+   
+   
+   if ( _saveValues || ( batch.getSegmentLength() != 2 ) ) return false; // the values are only saved pair by pair
+   
+   // u = b - a and v = c - b, with a, b, c as in areCompatible (the sign doesn't matter for the squares)
+   const float* ux = batch.getDeltaX( 0 );
+   const float* uy = batch.getDeltaY( 0 );
+   const float* uz = batch.getDeltaZ( 0 );
+   
+   const float* vx = batch.getDeltaX( 1 );
+   const float* vy = batch.getDeltaY( 1 );
+   const float* vz = batch.getDeltaZ( 1 );
+   
+   const float ratioChangeMaxSquared = _ratioChangeMaxSquared;
+   const float ratioChangeMinSquared = _ratioChangeMinSquared;
+   
+   const unsigned nPairs = batch.size();
+   
+   for ( unsigned i = 0; i < nPairs; i++ ){
+      
+      
+      double ratioSquaredParent = 0.; 
+      if ( uz[i] != 0. ) ratioSquaredParent = ( ux[i]*ux[i] + uy[i]*uy[i] + uz[i]*uz[i] ) / ( uz[i]*uz[i] );
+      
+      double ratioSquaredChild = 0.; 
+      if ( vz[i] != 0. ) ratioSquaredChild = ( vx[i]*vx[i] + vy[i]*vy[i] + vz[i]*vz[i] ) / ( vz[i]*vz[i] );
+      
+      double ratioOfRZRatioSquared = 0.;
+      if (ratioSquaredChild != 0.) ratioOfRZRatioSquared = ratioSquaredParent / ratioSquaredChild;
+      
+      pass[i] = pass[i] & !( ratioOfRZRatioSquared > ratioChangeMaxSquared ) & !( ratioOfRZRatioSquared < ratioChangeMinSquared );
+      
+      
+   }
+   
+   
    return true;
    
    
@@ -18,6 +18,8 @@ namespace KiTrack{
       
       virtual bool areCompatible( Segment* parent , Segment* child );
       
+      virtual bool areCompatibleBatch( const SegmentPairBatch& batch , std::vector< char >& pass );
+      
       virtual ~Crit3_ChangeRZRatio(){};
       
       
@@ -1,4 +1,5 @@
 #include "Criteria/Crit3_IPCircleDist.h"
+#include "Criteria/SegmentPairBatch.h"
 
 
 #include <cmath>
@@ -88,3 +89,42 @@ bool Crit3_IPCircleDist::areCompatible( Segment* parent , Segment* child ) {
    
    
 }
+
+
+bool Crit3_IPCircleDist::areCompatibleBatch( const SegmentPairBatch& batch , std::vector< char >& pass ){
+   
+   
+   if ( _saveValues || ( batch.getSegmentLength() != 2 ) ) return false; // the values are only saved pair by pair
+   
+   // the circle through a, b and c (as in areCompatible). Where there is none, the pair is compatible.
+   const char* hasCircle = batch.getCircleValid();
+   const double* centerX = batch.getCircleCenterX();
+   const double* centerY = batch.getCircleCenterY();
+   const double* radius = batch.getCircleRadius();
+   
+   const float distToCircleMax = _distToCircleMax;
+   const float distToCircleMin = _distToCircleMin;
+   
+   const unsigned nPairs = batch.size();
+   
+   for ( unsigned i = 0; i < nPairs; i++ ){
+      
+      
+      double x = centerX[i];
+      double y = centerY[i];
+      double R = radius[i];
+      
+      double circleDistToIP = fabs( R - sqrt (x*x+y*y) );
+      
+      bool isOutside = ( circleDistToIP > distToCircleMax ) | ( circleDistToIP < distToCircleMin );
+      
+      pass[i] = pass[i] & !( hasCircle[i] & isOutside );
+      
+      
+   }
+   
+   
+   return true;
+   
+   
+}
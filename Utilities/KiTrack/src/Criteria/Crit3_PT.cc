@@ -1,4 +1,5 @@
 #include "Criteria/Crit3_PT.h"
+#include "Criteria/SegmentPairBatch.h"
 
 #include <cmath>
 #include <sstream>
@@ -97,3 +98,38 @@ bool Crit3_PT::areCompatible( Segment* parent , Segment* child ) {
    
    
 }
+
+
+bool Crit3_PT::areCompatibleBatch( const SegmentPairBatch& batch , std::vector< char >& pass ){
+   
+   
+   if ( _saveValues || ( batch.getSegmentLength() != 2 ) ) return false; // the values are only saved pair by pair
+   
+   // the circle through a, b and c (as in areCompatible). Where there is none, the pair is compatible.
+   const char* hasCircle = batch.getCircleValid();
+   const double* radius = batch.getCircleRadius();
+   
+   const double K= 0.00029979; //K depends on the used units
+   const float Bz = _Bz;
+   const float ptMin = _ptMin;
+   const float ptMax = _ptMax;
+   
+   const unsigned nPairs = batch.size();
+   
+   for ( unsigned i = 0; i < nPairs; i++ ){
+      
+      
+      double pt = radius[i] * K * Bz;
+      
+      bool isOutside = ( pt < ptMin ) | ( pt > ptMax );
+      
+      pass[i] = pass[i] & !( hasCircle[i] & isOutside );
+      
+      
+   }
+   
+   
+   return true;
+   
+   
+}
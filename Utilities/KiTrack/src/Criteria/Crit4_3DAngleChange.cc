@@ -1,4 +1,5 @@
 #include "Criteria/Crit4_3DAngleChange.h"
+#include "Criteria/SegmentPairBatch.h"
 
 #include <cmath>
 #include <sstream>
@@ -99,3 +100,55 @@ bool Crit4_3DAngleChange::areCompatible( Segment* parent , Segment* child ) {
    
 }
 
+
+bool Crit4_3DAngleChange::areCompatibleBatch( const SegmentPairBatch& batch , std::vector< char >& pass ){
+   
+   
+   if ( _saveValues || ( batch.getSegmentLength() != 3 ) ) return false; // the values are only saved pair by pair
+   
+   // the vectors b - a, c - b and d - c, with a, b, c, d as in areCompatible
+   const float* dx0 = batch.getDeltaX( 0 );
+   const float* dy0 = batch.getDeltaY( 0 );
+   const float* dz0 = batch.getDeltaZ( 0 );
+   
+   const float* dx1 = batch.getDeltaX( 1 );
+   const float* dy1 = batch.getDeltaY( 1 );
+   const float* dz1 = batch.getDeltaZ( 1 );
+   
+   const float* dx2 = batch.getDeltaX( 2 );
+   const float* dy2 = batch.getDeltaY( 2 );
+   const float* dz2 = batch.getDeltaZ( 2 );
+   
+   const unsigned nPairs = batch.size();
+   
+   for ( unsigned i = 0; i < nPairs; i++ ){
+      
+      
+      if ( !pass[i] ) continue; // the angles are expensive, so only calculate them where needed
+      
+      TVector3 outerVec  ( dx0[i] , dy0[i] , dz0[i] );
+      TVector3 middleVec ( dx1[i] , dy1[i] , dz1[i] );
+      TVector3 innerVec  ( dx2[i] , dy2[i] , dz2[i] );
+      
+      double angleXY1 = outerVec.Angle( middleVec ); 
+      double angleXY2 = middleVec.Angle( innerVec );
+      
+      angleXY1 -= 2*M_PI*floor( angleXY1 /2. /M_PI );    //to the range from 0 to 2pi 
+      if (angleXY1 > M_PI) angleXY1 -= 2*M_PI;           //to the range from -pi to pi
+      
+      angleXY2 -= 2*M_PI*floor( angleXY2 /2. /M_PI );    //to the range from 0 to 2pi 
+      if (angleXY2 > M_PI) angleXY2 -= 2*M_PI;           //to the range from -pi to pi
+      
+      float ratioOf3DAngles = angleXY1 / angleXY2 ;
+      
+      if ( ratioOf3DAngles > _changeMax ) pass[i] = 0;
+      if ( ratioOf3DAngles < _changeMin ) pass[i] = 0;
+      
+      
+   }
+   
+   
+   return true;
+   
+   
+}
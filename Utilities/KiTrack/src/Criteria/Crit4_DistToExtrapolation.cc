@@ -1,4 +1,5 @@
 #include "Criteria/Crit4_DistToExtrapolation.h"
+#include "Criteria/SegmentPairBatch.h"
 
 #include <cmath>
 #include <sstream>
@@ -117,3 +118,69 @@ bool Crit4_DistToExtrapolation::areCompatible( Segment* parent , Segment* child
    
 }
 
+
+bool Crit4_DistToExtrapolation::areCompatibleBatch( const SegmentPairBatch& batch , std::vector< char >& pass ){
+   
+   
+   if ( _saveValues || ( batch.getSegmentLength() != 3 ) ) return false; // the values are only saved pair by pair
+   
+   // b, c and d as in areCompatible
+   const float* bx = batch.getX( 1 );
+   const float* by = batch.getY( 1 );
+   const float* bz = batch.getZ( 1 );
+   
+   const float* cx = batch.getX( 2 );
+   const float* cy = batch.getY( 2 );
+   const float* cz = batch.getZ( 2 );
+   
+   const float* dx = batch.getX( 3 );
+   const float* dy = batch.getY( 3 );
+   const float* dz = batch.getZ( 3 );
+   
+   // the circle through a, b and c. Where there is none, the pair is compatible.
+   const char* hasCircle = batch.getCircleValid();
+   const double* circleCenterX = batch.getCircleCenterX();
+   const double* circleCenterY = batch.getCircleCenterY();
+   const double* circleR = batch.getCircleRadius();
+   
+   const unsigned nPairs = batch.size();
+   
+   for ( unsigned i = 0; i < nPairs; i++ ){
+      
+      
+      if ( !pass[i] || !hasCircle[i] ) continue; // the extrapolation is expensive, so only calculate it where needed
+      
+      double centerX = circleCenterX[i];
+      double centerY = circleCenterY[i];
+      double R = circleR[i];
+      
+      TVector3 u ( bx[i] - centerX , by[i] - centerY , bz[i] );
+      TVector3 v ( cx[i] - centerX , cy[i] - centerY , cz[i] );
+      
+      double deltaPhiParent = v.Phi() - u.Phi(); //angle in xy plane from center of circle, between point 2 and 3
+      
+      // use this angle and the distance to the next layer to extrapolate
+      double zDistParent = fabs( cz[i] - bz[i] );
+      double zDistChild  = fabs( dz[i] - cz[i] );
+      
+      double deltaPhiChild = deltaPhiParent * zDistChild / zDistParent ;
+      
+      double phiChild = v.Phi() + deltaPhiChild;
+      
+      double xChildPred = centerX + R* cos(phiChild);
+      double yChildPred = centerY + R* sin(phiChild);
+      
+      double DistToPrediction = sqrt ( ( xChildPred- dx[i] )*( xChildPred- dx[i] ) + ( yChildPred- dy[i] )*( yChildPred- dy[i] ) );
+      double distNormed = DistToPrediction / zDistChild;   
+      
+      if ( distNormed > _distMax ) pass[i] = 0;
+      if ( distNormed < _distMin ) pass[i] = 0;
+      
+      
+   }
+   
+   
+   return true;
+   
+   
+}
@@ -0,0 +1,151 @@
+#include "Criteria/SegmentPairBatch.h"
+
+#include "Criteria/ICriterion.h"
+#include "Criteria/SimpleCircle.h"
+
+
+
+using namespace KiTrack;
+
+
+void SegmentPairBatch::applyCriteria( const std::vector< ICriterion* >& criteria , std::vector< char >& pass ){
+
+
+   const unsigned nPairs = size();
+
+   pass.assign( nPairs , 1 );
+
+   if ( nPairs == 0 ) return;
+
+   fill();
+
+   unsigned nPassed = nPairs;
+
+   for ( unsigned iCrit = 0; iCrit < criteria.size(); iCrit++ ){
+
+
+      if ( nPassed == 0 ) break; // no pair left to check
+
+      ICriterion* criterion = criteria[iCrit];
+
+      if ( criterion->areCompatibleBatch( *this , pass ) == false ){ // no batched version --> check the pairs one by one
+
+         for ( unsigned i = 0; i < nPairs; i++ ){
+
+            if ( pass[i] && criterion->areCompatible( _parents[i] , _children[i] ) == false ) pass[i] = 0;
+
+         }
+
+      }
+
+      nPassed = 0;
+      for ( unsigned i = 0; i < nPairs; i++ ) nPassed += pass[i];
+
+   }
+
+
+}
+
+
+void SegmentPairBatch::fill(){
+
+
+   const unsigned nPairs = size();
+
+   _hasCircles = false;
+
+
+   // the segments must all have the same length
+   _segmentLength = _parents[0]->getHits().size();
+
+   for ( unsigned i = 0; i < nPairs; i++ ){
+
+      if ( ( _parents[i]->getHits().size() != _segmentLength ) || ( _children[i]->getHits().size() != _segmentLength ) ){
+
+         _segmentLength = 0;
+         return;
+
+      }
+
+   }
+
+
+   // the hits: those of the child and the outermost of the parent
+   const unsigned nHits = _segmentLength + 1;
+
+   _x.resize( nHits * nPairs );
+   _y.resize( nHits * nPairs );
+   _z.resize( nHits * nPairs );
+   _rhoSquared.resize( nHits * nPairs );
+
+   for ( unsigned iHit = 0; iHit < nHits; iHit++ ){
+
+      float* x = &_x[ iHit*nPairs ];
+      float* y = &_y[ iHit*nPairs ];
+      float* z = &_z[ iHit*nPairs ];
+
+      for ( unsigned i = 0; i < nPairs; i++ ){
+
+         IHit* hit = ( iHit < _segmentLength ) ? _children[i]->getHits()[iHit] : _parents[i]->getHits().back();
+
+         x[i] = hit->getX();
+         y[i] = hit->getY();
+         z[i] = hit->getZ();
+
+      }
+
+      float* rhoSquared = &_rhoSquared[ iHit*nPairs ];
+      for ( unsigned i = 0; i < nPairs; i++ ) rhoSquared[i] = x[i]*x[i] + y[i]*y[i];
+
+   }
+
+
+   // the vectors between neighbouring hits
+   _deltaX.resize( _segmentLength * nPairs );
+   _deltaY.resize( _segmentLength * nPairs );
+   _deltaZ.resize( _segmentLength * nPairs );
+
+   for ( unsigned k = 0; k < _segmentLength * nPairs; k++ ){
+
+      _deltaX[k] = _x[ k + nPairs ] - _x[k];
+      _deltaY[k] = _y[ k + nPairs ] - _y[k];
+      _deltaZ[k] = _z[ k + nPairs ] - _z[k];
+
+   }
+
+
+}
+
+
+const char* SegmentPairBatch::getCircleValid() const {
+
+
+   if ( _hasCircles ) return _circleValid.data();
+
+   const unsigned nPairs = size();
+
+   _circleValid.resize( nPairs );
+   _circleCenterX.resize( nPairs );
+   _circleCenterY.resize( nPairs );
+   _circleR.resize( nPairs );
+
+   const float* x1 = getX(0);
+   const float* y1 = getY(0);
+   const float* x2 = getX(1);
+   const float* y2 = getY(1);
+   const float* x3 = getX(2);
+   const float* y3 = getY(2);
+
+   for ( unsigned i = 0; i < nPairs; i++ ){
+
+      _circleValid[i] = SimpleCircle::calculate( x1[i] , y1[i] , x2[i] , y2[i] , x3[i] , y3[i] ,
+                                                 _circleCenterX[i] , _circleCenterY[i] , _circleR[i] );
+
+   }
+
+   _hasCircles = true;
+
+   return _circleValid.data();
+
+
+}
@@ -19,6 +19,13 @@ class SimpleCircle {
     
       SimpleCircle ( double x1 , double y1 , double x2 , double y2 , double x3, double y3 ) ;
       
+      /** Calculates the circle through 3 points without creating an object (and without throwing).
+       * 
+       * @return false, if the points are on one line in xy-space. Then the center and radius are not set.
+       */
+      static bool calculate( double x1 , double y1 , double x2 , double y2 , double x3, double y3 ,
+                             double& centerX , double& centerY , double& R );
+      
       double getRadius() {return _R;};
       double getCenterX() {return _centerX;};
       double getCenterY() {return _centerY;};
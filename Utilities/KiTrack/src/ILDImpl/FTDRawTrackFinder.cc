@@ -0,0 +1,339 @@
+#include "ILDImpl/FTDRawTrackFinder.h"
+
+#include <algorithm>
+#include <atomic>
+#include <set>
+#include <sstream>
+#include <thread>
+
+#include "KiTrack/SegmentBuilder.h"
+#include "KiTrack/Automaton.h"
+#include "KiTrack/KiTrackExceptions.h"
+#include "Criteria/Criteria.h"
+#include "ILDImpl/FTDSectorConnector.h"
+
+
+using namespace KiTrackMarlin;
+
+
+FTDRawTrackFinder::FTDRawTrackFinder( const SectorSystemFTD* sectorSystemFTD , const std::vector< std::string >& criteriaNames ,
+                                      const std::map< std::string , std::vector< float > >& critMinima ,
+                                      const std::map< std::string , std::vector< float > >& critMaxima , unsigned maxConnections ):
+   _sectorSystemFTD( sectorSystemFTD ),
+   _criteriaNames( criteriaNames ),
+   _critMinima( critMinima ),
+   _critMaxima( critMaxima ),
+   _maxConnections( maxConnections ),
+   _nPhiPartitions( 1 ),
+   _nSidePartitions( 1 ),
+   _overlap( 0 ),
+   _nThreads( 1 ){
+
+}
+
+
+void FTDRawTrackFinder::setPhiPartitions( unsigned nPhiPartitions , unsigned overlap ){
+
+   // there can't be more ranges than petals
+   const unsigned nModules = _sectorSystemFTD->getNumberOfModules();
+
+   _nPhiPartitions = std::max( 1u , std::min( nPhiPartitions , nModules ) );
+   _overlap = overlap;
+
+   if( ( _nPhiPartitions > 1 ) && ( _overlap < getMinPhiPartitionOverlap() ) ){
+
+      std::stringstream s;
+      s << "FTDRawTrackFinder: an overlap of " << _overlap << " petals is too small for " << _nPhiPartitions
+        << " phi partitions, tracks can cross " << getMinPhiPartitionOverlap() << " petals\n";
+      throw InvalidParameter( s.str() );
+
+   }
+
+   // If the largest range together with the overlap on both sides reaches all petals, every region would get
+   // all hits of its side: then only the two sides are split.
+   unsigned maxRange = ( nModules + _nPhiPartitions - 1 ) / _nPhiPartitions;
+   _nSidePartitions = ( maxRange + 2*_overlap >= nModules ) ? 1 : _nPhiPartitions;
+
+}
+
+
+std::vector< std::vector< IHit* > > FTDRawTrackFinder::getRawTracks( const std::map< int , std::vector< IHit* > >& map_sector_hits ){
+
+
+   int nThreads = _nThreads > 0 ? _nThreads : int(std::thread::hardware_concurrency());
+
+   // one Cellular Automaton for all hits
+   if( _nPhiPartitions == 1 && nThreads <= 1 ){
+
+      _nRounds.assign( 1 , 0 );
+      _nRegionHits.assign( 1 , countHits( map_sector_hits ) );
+      return getRegionRawTracks( map_sector_hits , _nRounds[0] );
+
+   }
+
+
+   /**********************************************************************************************/
+   /*                Split the FTD into independent regions                                      */
+   /**********************************************************************************************/
+
+   // The two sides of the FTD have no connections between them, and every side is split in phi into
+   // ranges of petals (with one phi partition there is one region per side). A region gets the hits of
+   // its range plus those of the neighbouring petals (the overlap on each side). The IP belongs to all
+   // regions of its side.
+   const unsigned nModules = _sectorSystemFTD->getNumberOfModules();
+   const unsigned nRegions = 2*_nSidePartitions;
+
+   std::vector< std::map< int , std::vector< IHit* > > > regionSectorHits( nRegions );
+
+   std::map< int , std::vector< IHit* > >::const_iterator it;
+   for( it = map_sector_hits.begin(); it != map_sector_hits.end(); it++ ){
+
+      int sector = it->first;
+      unsigned firstRegion = ( _sectorSystemFTD->getSide( sector ) > 0 ) ? 0 : _nSidePartitions;
+
+      std::set< unsigned > partitions;
+      if( _sectorSystemFTD->getLayer( sector ) == 0 ){
+         for( unsigned iPart=0; iPart < _nSidePartitions; iPart++ ) partitions.insert( iPart );
+      }
+      else{
+         int module = _sectorSystemFTD->getModule( sector );
+         for( int iPetal = module - int(_overlap); iPetal <= module + int(_overlap); iPetal++ ){
+            int iModule = ( iPetal % int(nModules) + int(nModules) ) % int(nModules);
+            partitions.insert( getPhiPartition( iModule ) );
+         }
+      }
+
+      for( std::set< unsigned >::iterator itPart = partitions.begin(); itPart != partitions.end(); itPart++ ){
+         regionSectorHits[ firstRegion + *itPart ][ sector ] = it->second;
+      }
+
+   }
+
+
+   _nRegionHits.resize( nRegions );
+   for( unsigned iRegion=0; iRegion < nRegions; iRegion++ ) _nRegionHits[iRegion] = countHits( regionSectorHits[iRegion] );
+
+
+   /**********************************************************************************************/
+   /*                SegmentBuilder and Cellular Automaton                                       */
+   /**********************************************************************************************/
+
+   // the regions are independent: run them concurrently, each writes only its own raw tracks
+   std::vector< std::vector< std::vector< IHit* > > > regionRawTracks( nRegions );
+   _nRounds.assign( nRegions , 0 );
+   std::atomic<int> next(0);
+
+   auto worker = [&](){
+      int iRegion;
+      while( ( iRegion = next++ ) < int(nRegions) ){
+         regionRawTracks[iRegion] = getRegionRawTracks( regionSectorHits[iRegion] , _nRounds[iRegion] );
+      }
+   };
+
+   nThreads = std::min( nThreads , int(nRegions) );
+
+   if( nThreads <= 1 ){
+      worker();
+   }
+   else{
+      std::vector<std::thread> threads;
+      threads.reserve(nThreads-1);
+      for( int t=1; t<nThreads; ++t ) threads.emplace_back(worker);
+      worker();
+      for( unsigned t=0; t<threads.size(); ++t ) threads[t].join();
+   }
+
+
+   // Merge in the order of the regions, so the result does not depend on the number of threads.
+   // A track found in several overlapping regions is only taken from the region whose own range
+   // of petals holds its outermost hit.
+   std::vector< std::vector< IHit* > > rawTracks;
+
+   for( unsigned iRegion=0; iRegion < nRegions; iRegion++ ){
+
+      for( unsigned i=0; i < regionRawTracks[iRegion].size(); i++ ){
+
+         const std::vector< IHit* >& rawTrack = regionRawTracks[iRegion][i];
+         unsigned module = _sectorSystemFTD->getModule( rawTrack[0]->getSector() ); // the hits go from the outside in
+
+         if( getPhiPartition( module ) == iRegion % _nSidePartitions ) rawTracks.push_back( rawTrack );
+
+      }
+
+   }
+
+   return rawTracks;
+
+}
+
+
+std::vector< std::vector< IHit* > > FTDRawTrackFinder::getRegionRawTracks( const std::map< int , std::vector< IHit* > >& map_sector_hits ,
+                                                                          unsigned& nRounds ) const {
+
+   nRounds = 0; // the round we are in
+   std::vector< std::vector< IHit* > > rawTracks;
+   std::vector< ICriterion* > crit2Vec;
+   std::vector< ICriterion* > crit3Vec;
+   std::vector< ICriterion* > crit4Vec;
+
+   // The following while loop ideally only runs once. (So we do round 0 and everything works)
+   // It will repeat as long as the Automaton creates too many connections and as long as there are new criteria
+   // parameters to use to cut down the problem.
+   // Ideally already in round 0, there is a reasonable number of connections (not more than _maxConnections),
+   // so the loop will be left. If however there are too many connections we stay in the loop and use
+   // (hopefully) tighter cut offs (if provided in the steering). This should prevent combinatorial breakdown
+   // for very evil events.
+   while( setCriteria( nRounds , crit2Vec , crit3Vec , crit4Vec ) ){
+      nRounds++; // count up the round we are in
+
+      /**********************************************************************************************/
+      /*                Build the segments                                                          */
+      /**********************************************************************************************/
+
+      //Create a segmentbuilder
+      SegmentBuilder segBuilder( map_sector_hits );
+
+      segBuilder.addCriteria ( crit2Vec ); // Add the criteria on when to connect two hits. The vector has been filled by the method setCriteria
+
+      //Also load hit connectors
+      FTDSectorConnector secCon( _sectorSystemFTD , layerStepMax , petalStepMax , lastLayerToIP );
+
+      segBuilder.addSectorConnector ( & secCon ); // Add the sector connector (so the SegmentBuilder knows what hits from different sectors it is allowed to look for connections)
+
+      // And get out the Cellular Automaton with the 1-segments
+      Automaton automaton = segBuilder.get1SegAutomaton();
+
+      // Check if there are not too many connections
+      if( automaton.getNumberOfConnections() > _maxConnections ) continue;
+
+      /**********************************************************************************************/
+      /*                Automaton                                                                   */
+      /**********************************************************************************************/
+
+      /*******************************/
+      /*      2-hit segments         */
+      /*******************************/
+
+      automaton.clearCriteria();
+      automaton.addCriteria( crit3Vec );  // Add the criteria for 3 hits (i.e. 2 2-hit segments )
+
+      // Let the automaton lengthen its 1-hit-segments to 2-hit-segments
+      automaton.lengthenSegments();
+
+      // So now we have 2-hit-segments and are ready to perform the Cellular Automaton.
+
+      // Perform the automaton
+      automaton.doAutomaton();
+
+      // Clean segments with bad states
+      automaton.cleanBadStates();
+
+      // Reset the states of all segments
+      automaton.resetStates();
+
+      // Check if there are not too many connections
+      if( automaton.getNumberOfConnections() > _maxConnections ) continue;
+
+      /*******************************/
+      /*      3-hit segments         */
+      /*******************************/
+
+      automaton.clearCriteria();
+      automaton.addCriteria( crit4Vec );
+
+      // Lengthen the 2-hit-segments to 3-hits-segments
+      automaton.lengthenSegments();
+
+      // Perform the Cellular Automaton
+      automaton.doAutomaton();
+
+      //Clean segments with bad states
+      automaton.cleanBadStates();
+
+      //Reset the states of all segments
+      automaton.resetStates();
+
+      // Check if there are not too many connections
+      if( automaton.getNumberOfConnections() > _maxConnections ) continue;
+
+      // get the raw tracks (raw track = just a vector of hits, the most rudimentary form of a track)
+      rawTracks = automaton.getTracks( 3 );
+
+      break; // if we reached this place all went well and we don't need another round --> exit the loop
+   }
+
+   for ( unsigned i=0; i< crit2Vec.size(); i++) delete crit2Vec[i];
+   for ( unsigned i=0; i< crit3Vec.size(); i++) delete crit3Vec[i];
+   for ( unsigned i=0; i< crit4Vec.size(); i++) delete crit4Vec[i];
+
+   return rawTracks;
+
+}
+
+
+bool FTDRawTrackFinder::setCriteria( unsigned round , std::vector< ICriterion* >& crit2Vec ,
+                                     std::vector< ICriterion* >& crit3Vec , std::vector< ICriterion* >& crit4Vec ) const {
+
+   // delete the old ones
+   for ( unsigned i=0; i< crit2Vec.size(); i++) delete crit2Vec[i];
+   for ( unsigned i=0; i< crit3Vec.size(); i++) delete crit3Vec[i];
+   for ( unsigned i=0; i< crit4Vec.size(); i++) delete crit4Vec[i];
+   crit2Vec.clear();
+   crit3Vec.clear();
+   crit4Vec.clear();
+
+   bool newValuesGotUsed = false; // if new values are used
+   for( unsigned i=0; i<_criteriaNames.size(); i++ ){
+
+      std::string critName = _criteriaNames[i];
+
+      const std::vector< float >& minima = _critMinima.at( critName );
+      const std::vector< float >& maxima = _critMaxima.at( critName );
+
+      float min = minima.back();
+      float max = maxima.back();
+
+      // use the value corresponding to the round, if there are no new ones for this criterion, just do nothing (the previous value stays in place)
+      if( round + 1 <= minima.size() ){
+         min = minima[round];
+         newValuesGotUsed = true;
+      }
+
+      if( round + 1 <= maxima.size() ){
+         max = maxima[round];
+         newValuesGotUsed = true;
+      }
+
+      ICriterion* crit = Criteria::createCriterion( critName, min , max );
+
+      std::string type = crit->getType();
+
+      // Add the new criterion to the corresponding vector
+      if( type == "2Hit" ){
+         crit2Vec.push_back( crit );
+      }
+      else if( type == "3Hit" ){
+         crit3Vec.push_back( crit );
+      }
+      else if( type == "4Hit" ){
+         crit4Vec.push_back( crit );
+      }
+      else delete crit;
+
+   }
+
+   return newValuesGotUsed;
+
+}
+
+
+unsigned FTDRawTrackFinder::countHits( const std::map< int , std::vector< IHit* > >& map_sector_hits ){
+
+   unsigned nHits = 0;
+
+   std::map< int , std::vector< IHit* > >::const_iterator it;
+   for( it = map_sector_hits.begin(); it != map_sector_hits.end(); it++ ) nHits += it->second.size();
+
+   return nHits;
+
+}
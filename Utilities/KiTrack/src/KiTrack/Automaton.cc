@@ -1,18 +1,68 @@
 #include "KiTrack/Automaton.h"
 
+#include "Criteria/SegmentPairBatch.h"
+
 #include <iostream>
 //#include "marlin/VerbosityLevels.h"
 
 using namespace KiTrack;
 
-void Automaton::addSegment ( Segment* segment ){
-  if ( segment->getLayer() >= _segments.size() ) { //in case this layer is not included so far
-    _segments.resize( segment->getLayer() + 1 ); //resize the vector, so that the layer of the segment is now included
+Automaton::Automaton( const std::vector< Segment >& segments , const std::vector< std::pair< unsigned , unsigned > >& connections ){
+  unsigned nLayers = 0;
+  for ( unsigned i = 0; i < segments.size(); i++ ){
+    if ( segments[i].getLayer() >= nLayers ) nLayers = segments[i].getLayer() + 1;
+  }
+
+  setSegments( segments , nLayers , connections );
+}
+
+void Automaton::setSegments( const std::vector< Segment >& segments , unsigned nLayers ,
+                             const std::vector< std::pair< unsigned , unsigned > >& connections ){
+  // sort the segments by layer (counting sort, so the order within a layer is kept)
+  _layerBegin.assign( nLayers + 1 , 0 );
+  for ( unsigned i = 0; i < segments.size(); i++ ) _layerBegin[ segments[i].getLayer() + 1 ]++;
+  for ( unsigned layer = 0; layer < nLayers; layer++ ) _layerBegin[ layer + 1 ] += _layerBegin[ layer ];
+
+  std::vector< unsigned > next( _layerBegin.begin() , _layerBegin.end() - 1 );
+  std::vector< unsigned > index( segments.size() ); // the index of a segment in _segments
+  std::vector< unsigned > order( segments.size() );
+  for ( unsigned i = 0; i < segments.size(); i++ ){
+    index[i] = next[ segments[i].getLayer() ]++;
+    order[ index[i] ] = i;
   }
 
-  _segments[ segment->getLayer() ].push_back ( segment );
+  _segments.clear();
+  _segments.reserve( segments.size() );
+  for ( unsigned i = 0; i < order.size(); i++ ) _segments.push_back( segments[ order[i] ] );
+
+  // the children, in the order of the connections
+  const unsigned nSegments = _segments.size();
+  _childBegin.assign( nSegments + 1 , 0 );
+  for ( unsigned i = 0; i < connections.size(); i++ ) _childBegin[ index[ connections[i].first ] + 1 ]++;
+  for ( unsigned iSeg = 0; iSeg < nSegments; iSeg++ ) _childBegin[ iSeg + 1 ] += _childBegin[ iSeg ];
+
+  next.assign( _childBegin.begin() , _childBegin.end() - 1 );
+  _children.resize( connections.size() );
+  for ( unsigned i = 0; i < connections.size(); i++ ){
+    _children[ next[ index[ connections[i].first ] ]++ ] = index[ connections[i].second ];
+  }
 
-  _nConnections += segment->getChildren().size();
+  setParents();
+
+  _nConnections = connections.size();
+}
+
+void Automaton::setParents(){
+  const unsigned nSegments = _segments.size();
+  _parentBegin.assign( nSegments + 1 , 0 );
+  for ( unsigned k = 0; k < _children.size(); k++ ) _parentBegin[ _children[k] + 1 ]++;
+  for ( unsigned iSeg = 0; iSeg < nSegments; iSeg++ ) _parentBegin[ iSeg + 1 ] += _parentBegin[ iSeg ];
+
+  std::vector< unsigned > next( _parentBegin.begin() , _parentBegin.end() - 1 );
+  _parents.resize( _children.size() );
+  for ( unsigned iSeg = 0; iSeg < nSegments; iSeg++ ){
+    for ( unsigned k = _childBegin[iSeg]; k < _childBegin[iSeg+1]; k++ ) _parents[ next[ _children[k] ]++ ] = iSeg;
+  }
 }
 
 void Automaton::lengthenSegments(){
@@ -69,243 +119,203 @@ void Automaton::lengthenSegments(){
   //   Compare the layer before ( 2 ) to the layer after ( 0 ). The skipped layers are the difference -1
   //   ( 2 - 0 - 1 = 1 --> segment->setSkippedLayers( 1 );
   
-  //std::cout << "Combining the shorter segments to longer ones\n";
-  
+  const unsigned nLayers = getNumberOfLayers();
+  if ( nLayers == 0 ) return;
+
   //----------------------------------------------------------------------------------------------//
   //                                                                                              //
-  // first: we create a new vector of a list of segments                                          //
-  //   to have somewhere we can put the longer segments                                           //
+  // first: find all the longer segments                                                          //
   //                                                                                              //
   //----------------------------------------------------------------------------------------------//
+  //
+  // Every connection between a parent (on layer 1 or above) and a child gives one longer segment.
+  // They are made in the order of the connections, so the connection _children[k] gives the
+  // longer segment number k - firstConnection.
+  const unsigned firstSegment = _layerBegin[1];
+  const unsigned firstConnection = _childBegin[ firstSegment ];
 
-  std::vector < std::list < Segment* > > longerSegments;
-   
-  if( _segments.size() > 0 ) longerSegments.resize ( _segments.size() -1 ); //This will have one layer less  
+  std::vector < Segment > longerSegments;
+  longerSegments.reserve( _children.size() - firstConnection );
 
-  //----------------------------------------------------------------------------------------------//
-  //                                                                                              //
-  // next: find all the longer segments and store them in the new vector[][]                      //
-  //                                                                                              //
-  //----------------------------------------------------------------------------------------------//
-  
-  unsigned nLongerSegments=0;
-  unsigned nShorterSegments= _segments[0].size();
-  
-  for (unsigned layer = 1; layer < _segments.size(); layer++){ //over all layers where there still can be something below
-    std::list<Segment*> segments = _segments[layer];
-    for ( std::list<Segment*>::iterator iSeg=segments.begin(); iSeg != segments.end(); iSeg++){ //over all segments in this layer
-      nShorterSegments++;
-         
-      Segment* parent = *iSeg;
-      
-      std::list <Segment*> children = parent->getChildren();
-         
-      for ( std::list<Segment*>::iterator iChild=children.begin(); iChild !=children.end(); iChild++){ //over all children of this parent
-	Segment* child = *iChild;
-            
-	//Combine the parent and the child to form a new longer segment
-        
-	//take all the hits from the parent
-	std::vector < IHit* > hits = parent->getHits();
-        
-	//and also add the inner hit from the child
-	hits.insert( hits.begin(), child->getHits().at(0) );
-        
-	//make the new (longer) segment
-	Segment* newSegment = new Segment ( hits );
-	nLongerSegments++;
-        
-	//set the layer to the layer of the childsegment
-	unsigned newLayer = child->getLayer();
-	newSegment->setLayer ( newLayer );
-        
-	// Set the skipped layers.                  For an explanation see Info A above
-	int skippedLayers = parent->getLayer() - child->getLayer() - 1;
-	if( skippedLayers < 0 ) throw InvalidParameter( "skippedLayers can't be < 0!" );
-	newSegment->setSkippedLayers( unsigned(skippedLayers) );      //
-        /*
-	std::cout << "Created longer segment: " << parent->getHits().size()
-		  << "hits -->" << newSegment->getHits().size()
-		  << " hits, layer = " << newLayer
-		  << ", skipped layers = " << skippedLayers <<"\n";
-	std::cout << "Combined: " << child->getInfo() << "<--with-->" << parent->getInfo() << "\n";
-	*/
-	// In a next step we want to again establish the conenctions between the longer segments (so we can do the 
-	// Automaton and later combine them and then do it all again... ).
-	// If we just created the Segments and dumped the old ones, we would have no idea what of the new, longer
-	// Segments we can connect.
-	// We could add some other container to store the possible connections of the longer Segments, but maybe
-	// it's the easiest approach to use, what is already there: the shorter Segments.
-	//
-	// So when we combine two shorter segments, we store the new longer Segment as a parent or child.
-	// Child, when the longer Segment goes on towards the inside, Parent if it continues on to the outside.
-	// So the shorter Segments kind of act as joints, that hold the longer Segments together.
-	//
-	// Let's visulaize that, so that it makes more sense:
-	// Let's have a look at 3 2-hit segments:
-	//
-	//          /       2-hit-Segment A
-	//          \       2-hit-Segment B
-	//          /       2-hit-Segment C
-	//
-	// Obviously we can make 2 3-hit segments out of this:
-	//
-	//          / -->   /       3-hit-Segment D
-	//          \       \  \    .
-	//          / -->      /    3-hit-Segment E
-	// 
-	// In the 2-hit-Segment B we store the 3-hit-Segments D and E as parent and child (while deleting A and C
-	// as parent and child, because that is now not needed anymore )
-	//
-	// So when we want to connect the 3-hit-Segments, all we have to do is iterate over all 2-hit-Segments which
-	// then only have 3-hit-Segments as parents and children.
-	// When we come to Segment B, we see that D is a parent and E is a child, thus we connect them. Or to be more
-	// precise, we connect them, if the criteria do say so.
-	//
-	// So, yes B acts like a joint connecting D and E
-	// 
-	// Erase the connection from the child to the parent segment and replace it with a link to the new
-	// (longer) segment. ( and vice versa ) This way we can connect the longer segments easily after.
-	child->deleteParent( parent );
-	child->addParent ( newSegment );
-	parent->deleteChild ( child );
-	parent->addChild ( newSegment );
-	// So now the new longer segment is a child of the old parent and a parent of the childsegment.
-        
-        
-	// Save the new segment in the new vector[][]
-	longerSegments[newLayer].push_back( newSegment );
-      }
+  for ( unsigned iSeg = firstSegment; iSeg < _segments.size(); iSeg++ ){ //over all segments where there still can be something below
+    const Segment& parent = _segments[iSeg];
+
+    for ( unsigned k = _childBegin[iSeg]; k < _childBegin[iSeg+1]; k++ ){ //over all children of this parent
+      const Segment& child = _segments[ _children[k] ];
+
+      //Combine the parent and the child to form a new longer segment
+
+      //take all the hits from the parent
+      std::vector < IHit* > hits = parent.getHits();
+
+      //and also add the inner hit from the child
+      hits.insert( hits.begin(), child.getHits().at(0) );
+
+      //make the new (longer) segment
+      Segment newSegment ( hits );
+
+      //set the layer to the layer of the childsegment
+      newSegment.setLayer ( child.getLayer() );
+
+      // Set the skipped layers.                  For an explanation see Info A above
+      int skippedLayers = parent.getLayer() - child.getLayer() - 1;
+      if( skippedLayers < 0 ) throw InvalidParameter( "skippedLayers can't be < 0!" );
+      newSegment.setSkippedLayers( unsigned(skippedLayers) );
+
+      longerSegments.push_back( newSegment );
     }
   }
 
-  //std::cout << " Made " << nLongerSegments << " longer segments from " << nShorterSegments << " shorter segments.\n";
-  
+  //std::cout << " Made " << longerSegments.size() << " longer segments from " << _segments.size() << " shorter segments.\n";
+
   //----------------------------------------------------------------------------------------------//
   //                                                                                              //
   // Connect the new (longer) segments                                                            //
   //                                                                                              //
   //----------------------------------------------------------------------------------------------//
-  
+  //
+  // In a next step we want to again establish the conenctions between the longer segments (so we can do the 
+  // Automaton and later combine them and then do it all again... ).
+  // If we just created the Segments and dumped the old ones, we would have no idea what of the new, longer
+  // Segments we can connect.
+  // We could add some other container to store the possible connections of the longer Segments, but maybe
+  // it's the easiest approach to use, what is already there: the shorter Segments.
+  //
+  // So when we combine two shorter segments, we store the new longer Segment as a parent or child.
+  // Child, when the longer Segment goes on towards the inside, Parent if it continues on to the outside.
+  // So the shorter Segments kind of act as joints, that hold the longer Segments together.
+  //
+  // Let's visulaize that, so that it makes more sense:
+  // Let's have a look at 3 2-hit segments:
+  //
+  //          /       2-hit-Segment A
+  //          \       2-hit-Segment B
+  //          /       2-hit-Segment C
+  //
+  // Obviously we can make 2 3-hit segments out of this:
+  //
+  //          / -->   /       3-hit-Segment D
+  //          \       \  \    .
+  //          / -->      /    3-hit-Segment E
+  // 
+  // In the 2-hit-Segment B we store the 3-hit-Segments D and E as parent and child (while deleting A and C
+  // as parent and child, because that is now not needed anymore )
+  //
+  // So when we want to connect the 3-hit-Segments, all we have to do is iterate over all 2-hit-Segments which
+  // then only have 3-hit-Segments as parents and children.
+  // When we come to Segment B, we see that D is a parent and E is a child, thus we connect them. Or to be more
+  // precise, we connect them, if the criteria do say so.
+  //
+  // So, yes B acts like a joint connecting D and E
+  //
+  // The longer parents of a shorter segment are the longer segments made from its connections to its
+  // parents, the longer children those made from the connections to its children.
+  // The parents are stored in the order of the connections (see setParents()), so both come in the order the
+  // longer segments were made.
+
   //std::cout << "Next connecting the new longer segments\n";
-     
-  unsigned nConnections=0;
+
+  std::vector < unsigned > longerParentBegin( _segments.size() + 1 , 0 );
+  std::vector < unsigned > longerParents( longerSegments.size() );
+  for ( unsigned k = firstConnection; k < _children.size(); k++ ) longerParentBegin[ _children[k] + 1 ]++;
+  for ( unsigned iSeg = 0; iSeg < _segments.size(); iSeg++ ) longerParentBegin[ iSeg + 1 ] += longerParentBegin[ iSeg ];
+
+  std::vector < unsigned > next( longerParentBegin.begin() , longerParentBegin.end() - 1 );
+  for ( unsigned k = firstConnection; k < _children.size(); k++ ) longerParents[ next[ _children[k] ]++ ] = k - firstConnection;
+
+  // The possible connections are collected in blocks, so that the criteria can check them together
+  // (see SegmentPairBatch). The connections that pass are kept in the order they were collected.
+  std::vector < std::pair < unsigned , unsigned > > connections;
+  std::vector < std::pair < unsigned , unsigned > > possibleConnections;
+  SegmentPairBatch batch;
+  std::vector < char > pass;
   unsigned nPossibleConnections=0;
-  
-  for ( unsigned layer = 1; layer + 1 < _segments.size(); layer++ ){ // over all layers (of course the first and the last ones are spared out because there is nothing more above or below
-    std::list<Segment*> segments = _segments[layer];
-    for ( std::list<Segment*>::iterator iSeg=segments.begin(); iSeg != segments.end(); iSeg++ ){ //over all (short) segments in this layer
-      Segment* segment = *iSeg;
-         
-      std::list<Segment*> parents = segment->getParents();
-      std::list<Segment*> children = segment->getChildren();
-      
-      for ( std::list<Segment*>::iterator iParent = parents.begin(); iParent != parents.end(); iParent++ ){ // over all parents of the segment
-	Segment* parent = *iParent;
-	for ( std::list<Segment*>::iterator iChild = children.begin(); iChild != children.end(); iChild++ ){ // over all children of the segment
-	  Segment* child = *iChild;
-	  
-	  // Check if they are compatible
-	  bool areCompatible = true;
-	  ICriterion* theFailedCrit = NULL; 
-          
-	  //check all criteria (or at least until one returns false)
-	  for ( unsigned iCrit = 0; iCrit < _criteria.size(); iCrit++ ){
-	    if ( _criteria[iCrit]->areCompatible ( parent , child ) == false ){
-	      areCompatible = false;
-	      theFailedCrit = _criteria[iCrit];
-	      break;
-	    }
-	  }
-               
-	  if ( areCompatible ){
-	    //connect parent and child (i.e. connect the longer segments we previously created)
-	    child->addParent( parent );
-	    parent->addChild( child );
-            
-	    nConnections++;
-            
-	    //std::cout << "Connected: " << child->getInfo() << "<--with-->" << parent->getInfo() << "\n";
-	  }
-	  else{
-	    //std::cout << "NOT Connected: " << child->getInfo() << "<--XXXX-->" << parent->getInfo() << "\n";
-	    //if( theFailedCrit != NULL ) std::cout << "Failed first at criterion: " << theFailedCrit->getName() << "\n";
-	  }
-                         
-	  nPossibleConnections++;
-	}
+
+  auto checkBatch = [&](){
+    // Check if they are compatible
+    batch.applyCriteria( _criteria , pass );
+
+    for ( unsigned i = 0; i < batch.size(); i++ ){
+      //connect parent and child (i.e. connect the longer segments we previously created)
+      if ( pass[i] ) connections.push_back( possibleConnections[i] );
+    }
+
+    batch.clear();
+    possibleConnections.clear();
+  };
+
+  // over all layers (of course the first and the last ones are spared out because there is nothing more above or below
+  const unsigned endSegment = _layerBegin[ nLayers - 1 ];
+  for ( unsigned iSeg = firstSegment; iSeg < endSegment; iSeg++ ){ //over all (short) segments in these layers
+    for ( unsigned iParent = longerParentBegin[iSeg]; iParent < longerParentBegin[iSeg+1]; iParent++ ){ // over all parents of the segment
+      Segment* parent = &longerSegments[ longerParents[iParent] ];
+      for ( unsigned k = _childBegin[iSeg]; k < _childBegin[iSeg+1]; k++ ){ // over all children of the segment
+        Segment* child = &longerSegments[ k - firstConnection ];
+
+        batch.addPair( parent , child );
+        possibleConnections.push_back( std::make_pair( longerParents[iParent] , k - firstConnection ) );
+
+        nPossibleConnections++;
+
+        if ( batch.size() == SegmentPairBatch::blockSize ) checkBatch();
       }
     }
   }
-  _nConnections = nConnections;
+  checkBatch();
+
+  //std::cout << "Made " << connections.size() << " of " << nPossibleConnections << " possible connections \n";
 
-  //std::cout << "Made " << nConnections << " of " << nPossibleConnections << " possible connections \n";
-  
   //----------------------------------------------------------------------------------------------//
   //                                                                                              //
-  //   Finally: replace the vector<list<segment*>> of the old segments with the new one           //
+  //   Finally: replace the old segments with the new ones (they have one layer less)             //
   //                                                                                              //
   //----------------------------------------------------------------------------------------------//
-  
-  //delete all old Segments:
-  for( unsigned i=0; i<_segments.size(); i++){
-    std::list<Segment*>& segments = _segments[i];
-    for ( std::list<Segment*>::iterator iSeg=segments.begin(); iSeg != segments.end(); iSeg++ ){
-      Segment* segment = *iSeg;
-      delete segment;
-    }
-    segments.clear();
-  }
-   
-  // And replace with the newer ones
-  _segments = longerSegments;
+
+  setSegments( longerSegments , nLayers - 1 , connections );
 }
 
 void Automaton::doAutomaton(){
 
   bool hasChanged = true;
   int nIterations = -1;
-  
+
   while ( hasChanged == true ){ //repeat this until no more changes happen (this should always be equal or smaller to the number of layers - 1
     hasChanged = false;
     nIterations++;
-    
-    for ( int layer = _segments.size()-1; layer >= 0; layer--){ //for all layers from outside in
-      std::list <Segment*> segments = _segments[layer];
-      for ( std::list<Segment*>::iterator iSeg=segments.begin(); iSeg!= segments.end(); iSeg++ ){ //for all segments in the layer
-	Segment* parent= *iSeg;
-            
-	//Simulate skipped layers
-	std::vector < int >& state = parent->getState();
-	
-	for ( int j= state.size()-1; j>=1; j--){
-	  if ( state[j] == state[j-1] ){
-	    state[j]++;
-	    hasChanged = true; //something changed
-	  }
-	}
-	
-	if ( parent->isActive() ){
-	  bool isActive = false; //whether the segment is active (i.e. still changing). This will be changed in the for loop, if it is active
-	  
-	  //Check if there is a neighbor
-	  std::list <Segment*> children = parent->getChildren();
-                         
-	  for ( std::list<Segment*>::iterator iChild=children.begin(); iChild != children.end(); iChild++ ){// for all children
-	    Segment* child = *iChild;
-
-	    if ( child->getOuterState() == parent->getInnerState() ){  //Only if they have the same state
-	      parent->raiseState(); //So it has a neighbor --> raise the state
-
-	      hasChanged = true; //something changed
-	      isActive = true;
-	      
-	      break; //It has a neighbor, we raised the state, so we need not check again in this iteration
-	    }
-	  }
-               
-	  parent->setActive( isActive );
-	}
+
+    for ( int layer = (int) getNumberOfLayers()-1; layer >= 0; layer--){ //for all layers from outside in
+      for ( unsigned iSeg = _layerBegin[layer]; iSeg < _layerBegin[layer+1]; iSeg++ ){ //for all segments in the layer
+        Segment& parent = _segments[iSeg];
+
+        //Simulate skipped layers
+        std::vector < int >& state = parent.getState();
+
+        for ( int j= state.size()-1; j>=1; j--){
+          if ( state[j] == state[j-1] ){
+            state[j]++;
+            hasChanged = true; //something changed
+          }
+        }
+
+        if ( parent.isActive() ){
+          bool isActive = false; //whether the segment is active (i.e. still changing). This will be changed in the for loop, if it is active
+
+          //Check if there is a neighbor
+          for ( unsigned k = _childBegin[iSeg]; k < _childBegin[iSeg+1]; k++ ){// for all children
+            const Segment& child = _segments[ _children[k] ];
+
+            if ( child.getOuterState() == parent.getInnerState() ){  //Only if they have the same state
+              parent.raiseState(); //So it has a neighbor --> raise the state
+
+              hasChanged = true; //something changed
+              isActive = true;
+
+              break; //It has a neighbor, we raised the state, so we need not check again in this iteration
+            }
+          }
+
+          parent.setActive( isActive );
+        }
       }
     }
   }
@@ -318,52 +328,56 @@ void Automaton::cleanBadStates(){
   unsigned nErasedSegments = 0;
   unsigned nKeptSegments = 0;
 
-  for( unsigned layer=0; layer < _segments.size(); layer++ ){//for every layer
-    std::list <Segment*> & segments = _segments[layer]; // We want to change things in the original list! Therefore the reference operator
-    for( std::list<Segment*>::iterator iSeg= segments.begin(); iSeg != segments.end(); iSeg++ ){//over every segment
-      Segment* segment = *iSeg;
+  // The kept segments are moved to the front, index holds their new position
+  const unsigned nSegments = _segments.size();
+  const unsigned keep = nSegments;
+  std::vector < unsigned > index( nSegments , keep );
+
+  for( unsigned layer=0; layer < getNumberOfLayers(); layer++ ){//for every layer
+    const unsigned begin = _layerBegin[layer];
+    _layerBegin[layer] = nKeptSegments;
 
-      if( segment->getInnerState() == (int) layer ){ //the state is alright (equals the layer), this segment is good
-	nKeptSegments++;
+    for( unsigned iSeg = begin; iSeg < _layerBegin[layer+1]; iSeg++ ){//over every segment
+      if( _segments[iSeg].getInnerState() == (int) layer ){ //the state is alright (equals the layer), this segment is good
+        index[iSeg] = nKeptSegments;
+        if( nKeptSegments != iSeg ) _segments[nKeptSegments] = _segments[iSeg];
+        nKeptSegments++;
       }
       else { //state is wrong, delete the segment
-	nErasedSegments++;
-
-	//erase it from all its children
-	std::list <Segment*> children = segment->getChildren();
-	
-	for (std::list<Segment*>::iterator iChild = children.begin(); iChild != children.end(); iChild++ ){
-	  (*iChild)->deleteParent ( segment );
-	  _nConnections--;
-	}
-
-	//erase it from all its parents
-	std::list <Segment*> parents = segment->getParents();
-
-	for (std::list<Segment*>::iterator iParent = parents.begin(); iParent!= parents.end(); iParent++){
-	  (*iParent)->deleteChild ( segment );
-	  _nConnections--;
-	}
-
-	//erase from the automaton
-	delete *iSeg;
-	iSeg = segments.erase( iSeg ); // erase the segment and update the iterator (updating is important!!!)
+        nErasedSegments++;
       }
     }
   }
+  if( !_layerBegin.empty() ) _layerBegin.back() = nKeptSegments;
+  _segments.erase( _segments.begin() + nKeptSegments , _segments.end() );
+
+  // erase the connections to the deleted segments
+  std::vector < unsigned > childBegin( nKeptSegments + 1 , 0 );
+  unsigned nConnections = 0;
+
+  for( unsigned iSeg = 0; iSeg < nSegments; iSeg++ ){
+    if( index[iSeg] == keep ) continue;
+
+    childBegin[ index[iSeg] ] = nConnections;
+    for( unsigned k = _childBegin[iSeg]; k < _childBegin[iSeg+1]; k++ ){
+      if( index[ _children[k] ] != keep ) _children[ nConnections++ ] = index[ _children[k] ];
+    }
+  }
+  childBegin[ nKeptSegments ] = nConnections;
+
+  _nConnections -= _children.size() - nConnections;
+  _children.resize( nConnections );
+  _childBegin.swap( childBegin );
+  setParents();
 
   //std::cout << "Erased segments because of bad states= " << nErasedSegments << "\n";
   //std::cout << "Kept segments because of good states= " << nKeptSegments << "\n";
 }
 
 void Automaton::resetStates(){
-  for ( unsigned layer = 0; layer < _segments.size(); layer++ ){ //over all layers
-    std::list<Segment*> segments = _segments[layer];
-    
-    for ( std::list<Segment*>::iterator iSeg = segments.begin(); iSeg != segments.end(); iSeg++ ){ //over all segments in the layer
-      (*iSeg)->resetState();
-      (*iSeg)->setActive( true );
-    }
+  for ( unsigned iSeg = 0; iSeg < _segments.size(); iSeg++ ){ //over all segments
+    _segments[iSeg].resetState();
+    _segments[iSeg].setActive( true );
   }
 }
 
@@ -371,128 +385,131 @@ void Automaton::cleanBadConnections(){
 
   unsigned nConnectionsKept = 0;
   unsigned nConnectionsErased = 0;
-  
-  for ( int layer = _segments.size()-1 ; layer >= 1 ; layer-- ){ //over all layers from outside in. And there's no need to check layer 0, as it has no children.
-    std::list<Segment*> segments = _segments[layer];
-    for ( std::list<Segment*>::iterator iSeg = segments.begin(); iSeg!=segments.end(); iSeg++ ){ // over all segments in the layer
-      Segment* parent = *iSeg;
-      std::list < Segment* > children = parent->getChildren();
-      
-      for ( std::list<Segment*>::iterator iChild = children.begin(); iChild != children.end(); iChild++ ){ //over all children the segment has got
-	Segment* child = *iChild;
-	
-	bool areCompatible = true; //whether segment and child are compatible
-	
-	//check all criteria (or at least until the first false pops up)
-	for ( unsigned iCrit=0; iCrit < _criteria.size() ; iCrit++ ){
-	  if ( _criteria[iCrit]->areCompatible( parent , child ) == false ){
-	    areCompatible = false;
-	    break; //no need to continue, now that we know, they're not compatible
-	  }
-	}
-	
-	if ( areCompatible == false ){ // they are not compatible --> erase the connection
-	  nConnectionsErased++;
-	  _nConnections--;
-          
-	  //erase the connection:
-	  parent->deleteChild ( child );
-	  child->deleteParent ( parent );
-          
-	  //A small note here: although we deleted a child from the vector, this doesn't mean we have to do iSeg--!
-	  //Because we copied the value of segment->getChildren to the vector children. And this one doesn't change!
-	}
-	else{
-	  nConnectionsKept++;
-	}
+
+  std::vector < char > isKept( _children.size() , 1 );
+
+  // The connections are checked in blocks by the criteria (see SegmentPairBatch)
+  SegmentPairBatch batch;
+  std::vector < unsigned > connectionIndex; // the index in _children of the connections in the batch
+  std::vector < char > pass;
+
+  auto checkBatch = [&](){
+    //check all criteria
+    batch.applyCriteria( _criteria , pass );
+
+    for ( unsigned i = 0; i < batch.size(); i++ ){
+      if ( pass[i] == 0 ){ // they are not compatible --> erase the connection
+        nConnectionsErased++;
+        _nConnections--;
+        isKept[ connectionIndex[i] ] = 0;
+      }
+      else{
+        nConnectionsKept++;
+      }
+    }
+
+    batch.clear();
+    connectionIndex.clear();
+  };
+
+  for ( int layer = (int) getNumberOfLayers()-1 ; layer >= 1 ; layer-- ){ //over all layers from outside in. And there's no need to check layer 0, as it has no children.
+    for ( unsigned iSeg = _layerBegin[layer]; iSeg < _layerBegin[layer+1]; iSeg++ ){ // over all segments in the layer
+      Segment* parent = &_segments[iSeg];
+
+      for ( unsigned k = _childBegin[iSeg]; k < _childBegin[iSeg+1]; k++ ){ //over all children the segment has got
+        Segment* child = &_segments[ _children[k] ];
+
+        batch.addPair( parent , child );
+        connectionIndex.push_back( k );
+
+        if ( batch.size() == SegmentPairBatch::blockSize ) checkBatch();
       }
     }
   }
-  
+  checkBatch();
+
+  //erase the connections
+  if( nConnectionsErased > 0 ){
+    unsigned nConnections = 0;
+    for ( unsigned iSeg = 0; iSeg < _segments.size(); iSeg++ ){
+      const unsigned begin = _childBegin[iSeg];
+      _childBegin[iSeg] = nConnections;
+      for ( unsigned k = begin; k < _childBegin[iSeg+1]; k++ ){
+        if( isKept[k] ) _children[ nConnections++ ] = _children[k];
+      }
+    }
+    _childBegin.back() = nConnections;
+    _children.resize( nConnections );
+    setParents();
+  }
+
   //std::cout << "Erased bad connections= " << nConnectionsErased << "\n";
   //std::cout << "Kept good connections= " << nConnectionsKept << "\n";
 }
 
-std::vector < std::vector< IHit* > > Automaton::getTracksOfSegment ( Segment* segment, std::vector< IHit*> hits , unsigned minHits ){
+void Automaton::getTracksOfSegment ( unsigned iSeg, std::vector< IHit*>& hits , unsigned minHits ,
+                                     std::vector < std::vector< IHit* > >& tracks ) const {
 
-  std::vector < std::vector< IHit* > > tracks; //the vector of the tracks to be returned
+  const unsigned nHits = hits.size();
 
-  std::vector <IHit*> segHits = segment->getHits(); // the hits of the segment
+  const std::vector <IHit*>& segHits = _segments[iSeg].getHits(); // the hits of the segment
 
   //add the outer hit
   if ( segHits.back()->isVirtual() == false ) hits.push_back ( segHits.back() );  //Of course add only real hits to the track
-  
-  std::list <Segment*> children = segment->getChildren();
 
-  if ( children.empty() ){ //No more children --> we are at the bottom --> start a new Track here
+  if ( _childBegin[iSeg] == _childBegin[iSeg+1] ){ //No more children --> we are at the bottom --> start a new Track here
     //add the rest of the hits to the vector
     for ( int i = segHits.size()-2 ; i >= 0; i--){
       if ( segHits[i]->isVirtual() == false ) hits.push_back ( segHits[i] );
     }
-          
+
     if ( hits.size() >= minHits ){
       //add this to the tracks
       tracks.push_back ( hits );
     }
   }
   else{// there are still children below --> so just take all their tracks and do it again
-    for ( std::list<Segment*>::iterator iChild=children.begin(); iChild!= children.end(); iChild++){ //for all children
-      std::vector < std::vector< IHit* > > newTracks = getTracksOfSegment( *iChild , hits );
-      for (unsigned int j=0; j < newTracks.size(); j++){//for all the tracks of the child
-	tracks.push_back ( newTracks[j] );
-      }
+    for ( unsigned k = _childBegin[iSeg]; k < _childBegin[iSeg+1]; k++ ){ //for all children
+      getTracksOfSegment( _children[k] , hits , 2 , tracks ); // as before, the children use the default of 2 hits
     }
   }
 
-  return tracks;
+  hits.resize( nHits );
 }
 
 std::vector < std::vector< IHit* > > Automaton::getTracks( unsigned minHits ){
 
   std::vector < std::vector< IHit* > > tracks;
-  std::vector <IHit*> emptyHitVec;
-
-  for ( unsigned layer = 0 ; layer < _segments.size() ; layer++ ){ //over all layers
-    std::list<Segment*> segments = _segments[layer];
-    for ( std::list<Segment*>::iterator iSeg = segments.begin(); iSeg != segments.end(); iSeg++ ){ //over all segments
-      Segment* segment = *iSeg;
-      // by fucd: comment "if" in new ILC version of Automaton, why?
-      if ( segment->getParents().empty() ){ // if it has no parents it is the end of a possible track
-	// get the tracks from the segment
-	std::vector < std::vector< IHit* > > newTracks = getTracksOfSegment( segment , emptyHitVec , minHits );
-	
-	// and add them to the vector of all tracks
-	tracks.insert( tracks.end() , newTracks.begin() , newTracks.end() );
-      }
+  std::vector <IHit*> hits;
+
+  for ( unsigned iSeg = 0; iSeg < _segments.size(); iSeg++ ){ //over all segments, layer by layer
+    // by fucd: comment "if" in new ILC version of Automaton, why?
+    if ( _parentBegin[iSeg] == _parentBegin[iSeg+1] ){ // if it has no parents it is the end of a possible track
+      // add the tracks from the segment
+      getTracksOfSegment( iSeg , hits , minHits , tracks );
     }
   }
   return tracks;
 }
 
 std::vector <const Segment*> Automaton::getSegments() const{
-   
-  std::vector <const Segment*> segments;
-  
-  for( unsigned layer=0; layer < _segments.size(); layer++ ){
-    segments.insert( segments.end() , _segments[layer].begin() , _segments[layer].end() );
-  }
-     
-  return segments; 
-}
-
-Automaton::~Automaton(){
-  //delete the segments
-  for( unsigned layer=0; layer < _segments.size(); layer++){ //over all layers
-    std::list<Segment*> segments = _segments[layer];
-    for( std::list<Segment*>::iterator iSeg = segments.begin(); iSeg!=segments.end(); iSeg++ ){ //over all segments
-      delete *iSeg;
-    }
-  }
-}
 
+  std::vector <const Segment*> segments;
+  segments.reserve( _segments.size() );
 
+  for( unsigned iSeg=0; iSeg < _segments.size(); iSeg++ ) segments.push_back( &_segments[iSeg] );
 
+  return segments;
+}
 
+std::vector< std::pair< unsigned , unsigned > > Automaton::getConnections() const{
 
+  std::vector< std::pair< unsigned , unsigned > > connections;
+  connections.reserve( _children.size() );
 
+  for( unsigned iSeg=0; iSeg < _segments.size(); iSeg++ ){
+    for( unsigned k = _childBegin[iSeg]; k < _childBegin[iSeg+1]; k++ ) connections.push_back( std::make_pair( iSeg , _children[k] ) );
+  }
 
+  return connections;
+}
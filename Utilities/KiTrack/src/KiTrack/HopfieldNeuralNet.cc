@@ -34,6 +34,81 @@ HopfieldNeuralNet::HopfieldNeuralNet( std::vector < std::vector <bool> > G , std
       
    }
    
+   init( nNeurons , QI , states , omega );
+   
+   
+   // Store the incompatible neurons. (the diagonal elements are 0 --> whatever the matrix G says there is ignored.)
+   
+   _conflictBegin.resize( nNeurons + 1 );
+   
+   for (unsigned int i=0; i< nNeurons ; i++){ 
+
+      _conflictBegin[i] = _conflicts.size();
+      
+      for (unsigned int j=0; j< nNeurons ; j++){
+       
+         if ( ( i != j ) && ( G[i][j] == 1 ) ) _conflicts.push_back( j );   //Neurons are incompatible
+         
+      }
+      
+   }
+   
+   _conflictBegin[nNeurons] = _conflicts.size();
+
+}
+
+
+
+HopfieldNeuralNet::HopfieldNeuralNet( const std::vector < std::vector <unsigned> >& conflicts , std::vector < double > QI , std::vector < double > states , double omega , unsigned nNeuronsTotal ) {
+
+   unsigned int nNeurons = conflicts.size();
+   
+   init( nNeurons , QI , states , omega , nNeuronsTotal );
+   
+   
+   // Store the incompatible neurons.
+   
+   _conflictBegin.resize( nNeurons + 1 );
+   
+   for (unsigned int i=0; i< nNeurons ; i++){ 
+
+      _conflictBegin[i] = _conflicts.size();
+      
+      for (unsigned int k=0; k< conflicts[i].size() ; k++){
+       
+         unsigned j = conflicts[i][k];
+         
+         if( j >= nNeurons ){
+            
+            std::stringstream s;
+            s << "HopfieldNeuralNet: conflicts[" << i << "] contains " << j << ", but there are only " << nNeurons << " neurons!\n";
+            throw InvalidParameter( s.str() );
+            
+         }
+         
+         if ( i != j ) _conflicts.push_back( j ); // a neuron can't be incompatible with itself
+         
+      }
+      
+   }
+   
+   _conflictBegin[nNeurons] = _conflicts.size();
+
+}
+
+
+
+void HopfieldNeuralNet::init( unsigned nNeurons , const std::vector < double >& QI , const std::vector < double >& states , double omega ,
+                              unsigned nNeuronsTotal ){
+   
+   
+   //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+   // Check the validity of the input parameters
+   
+   
+   std::stringstream s;
+   s << "HopfieldNeuralNet: ";
+   
    // Does the QI vector have the right size?
    if( QI.size() != nNeurons ){
       
@@ -72,6 +147,14 @@ HopfieldNeuralNet::HopfieldNeuralNet( std::vector < std::vector <bool> > G , std
       
    }
    
+   // Is the larger network at least as large as this one
+   if( ( nNeuronsTotal != 0 ) && ( nNeuronsTotal < nNeurons ) ){
+      
+      s << "The larger network must not have less neurons than this one! nNeuronsTotal == " << nNeuronsTotal << " < " << nNeurons << "\n";
+      throw InvalidParameter( s.str() );
+      
+   }
+   
    // Is omega in the range from  0 to 1
    if( ( omega < 0. ) || ( omega > 1. ) ){
       
@@ -87,15 +170,10 @@ HopfieldNeuralNet::HopfieldNeuralNet( std::vector < std::vector <bool> > G , std
    // resize the vectors.
    _States.resize( nNeurons );
    _w0.resize( nNeurons );
-   _W.resize( nNeurons );
    _order.resize( nNeurons);
    
    for ( unsigned int i =0; i < nNeurons; i++){
       
-      // resize the vectors of the matrix W
-      _W[i].resize( nNeurons );
-      
-      
       // initialise the order vector
       _order[i]=i;                      //the order now is 0,1,2,3... (will be changed to a random sequence in the iteration)
       
@@ -107,31 +185,14 @@ HopfieldNeuralNet::HopfieldNeuralNet( std::vector < std::vector <bool> > G , std
    
    
    
-   // Build the W matrix. (the matrix of the influences including their force)
+   // The weight of compatible neurons. (incompatible ones have -1)
    
-   double comp = 1;
-   if (nNeurons > 0 ) comp = (1. - omega) / double (nNeurons);
+   if ( nNeuronsTotal == 0 ) nNeuronsTotal = nNeurons;
    
-
-   for (unsigned int i=0; i< nNeurons ; i++){ 
-
-      for (unsigned int j=0; j< nNeurons ; j++){
-       
-         if (i == j) _W[i][j] = 0.; //diagonal elements are 0 --> whatever the matrix G says here is ignored.
-            
-         else{  
-            
-            if ( G[i][j] == 1 ) _W[i][j] = -1;   //Neurons are incompatible
-            
-            else _W[i][j] =  comp;   //Neurons are compatible
-            
-         }
-         
-      }
-      
-   }
+   _comp = 1;
+   if (nNeuronsTotal > 0 ) _comp = (1. - omega) / double (nNeuronsTotal);
    
-  
+   _externalStates = 0.;
    
 
 
@@ -168,10 +229,16 @@ bool HopfieldNeuralNet::doIteration(){
    _isStable = true;
    
    // initialize the random generator
-   std::random_device rng;
-   std::mt19937 urng(rng());
+   if ( !_hasSeed ){
+      std::random_device rng;
+      _rng.seed( rng() );
+   }
 
-   shuffle ( _order.begin() , _order.end() , urng ); //shuffle the order
+   shuffle ( _order.begin() , _order.end() , _rng ); //shuffle the order
+   
+   // the sum of all states: the compatible neurons of a neuron are all the others except the incompatible ones
+   // (plus the ones outside of this network)
+   double sumStates = getSumStates();
    
    for (unsigned int i=0; i<_States.size() ; i++){ //for all entries of the vector
       
@@ -183,18 +250,22 @@ bool HopfieldNeuralNet::doIteration(){
       y = _w0[iNeuron];
       
       //matrix vector multiplication (or one line of it to be precise)  
-      for (unsigned int j=0; j< _W[iNeuron].size(); j++){ 
+      double sumConflicts = 0.;
+      for (unsigned int k=_conflictBegin[iNeuron]; k< _conflictBegin[iNeuron+1]; k++){ 
        
-         y  += _W[iNeuron][j] * _States[j]; 
+         sumConflicts += _States[ _conflicts[k] ]; 
          
       }
       
+      y += _comp * ( sumStates - _States[iNeuron] - sumConflicts + _externalStates ) - sumConflicts;
+      
       y = activationFunction ( y , _T );
       
       // check if the change was big enough that the Network is not stable
       if ( fabs( _States[iNeuron] - y ) > _limitForStable ) _isStable = false;
       
       // update the state
+      sumStates += y - _States[iNeuron];
       _States[iNeuron] = y;
       
    }
@@ -212,6 +283,11 @@ bool HopfieldNeuralNet::doIteration(){
 
 
 
-
-
-
+double HopfieldNeuralNet::getSumStates() const {
+   
+   double sumStates = 0.;
+   for (unsigned int i=0; i<_States.size() ; i++) sumStates += _States[i];
+   
+   return sumStates;
+   
+}
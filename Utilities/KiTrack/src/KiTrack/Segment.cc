@@ -9,9 +9,6 @@ Segment::Segment( std::vector <IHit*> hits){
    _hits = hits; 
    
    _state.push_back(0); 
-   
-   _children.clear(); 
-   _parents.clear();
 
    _active = true;
    
@@ -24,8 +21,6 @@ Segment::Segment( IHit* hit){
    
    _hits.push_back( hit) ;
    _state.push_back(0); 
-   _children.clear(); 
-   _parents.clear();
    
    _active = true;
    
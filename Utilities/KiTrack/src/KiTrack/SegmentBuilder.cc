@@ -1,5 +1,7 @@
 #include "KiTrack/SegmentBuilder.h"
 
+#include "Criteria/SegmentPairBatch.h"
+
 // ----- include for verbosity dependend logging ---------
 //#include "marlin/VerbosityLevels.h"
 #include <iostream>
@@ -14,22 +16,24 @@ Automaton SegmentBuilder::get1SegAutomaton(){
   /*                Create and fill a map for the segments                                      */
   /**********************************************************************************************/
   std::map< int , std::vector< IHit* > >::iterator itSecHit; // Sec = sector , Hit = hits
-  std::map< int , std::vector< Segment* > > map_sector_segments;
-  std::map< int , std::vector< Segment* > > ::iterator itSecSeg; // Sec = sector , Seg = segments
+  std::vector< Segment > segments;
+  std::map< int , std::vector< unsigned > > map_sector_segments; // the indices of the segments in a sector
+  std::map< int , std::vector< unsigned > > ::iterator itSecSeg; // Sec = sector , Seg = segments
         
   unsigned nCreatedSegments=0;
      
   for ( itSecHit = _map_sector_hits.begin(); itSecHit!=_map_sector_hits.end(); itSecHit++ ){ //over all sectors
     // All the hits in the sector
     int sector = itSecHit->first;
-    std::vector <IHit*> hits = itSecHit->second;
+    const std::vector <IHit*>& hits = itSecHit->second;
     for ( unsigned int i=0; i < hits.size(); i++ ){ //over every hit in the sector
       // create a Segment
-      Segment* segment = new Segment( hits[i] );
-      segment->setLayer( hits[i]->getLayer() );
+      Segment segment( hits[i] );
+      segment.setLayer( hits[i]->getLayer() );
       
       // Store the segment in its map
-      map_sector_segments[sector].push_back( segment );
+      map_sector_segments[sector].push_back( segments.size() );
+      segments.push_back( segment );
       
       nCreatedSegments++;
     }
@@ -42,15 +46,30 @@ Automaton SegmentBuilder::get1SegAutomaton(){
   /*                Afterwards store them in an Automaton                                       */
   /**********************************************************************************************/
   
-  unsigned nConnections=0;
+  std::vector< std::pair< unsigned , unsigned > > connections; // ( parent , child )
   unsigned nStoredSegments = 0;
-  
-  Automaton automaton;
+
+  // The possible connections are collected in blocks, so that the criteria can check them together
+  // (see SegmentPairBatch). The connections that pass are kept in the order they were collected.
+  std::vector< std::pair< unsigned , unsigned > > possibleConnections;
+  SegmentPairBatch batch;
+  std::vector< char > pass;
+
+  auto checkBatch = [&](){
+    batch.applyCriteria( _criteria , pass );
+
+    for ( unsigned i = 0; i < batch.size(); i++ ){
+      if ( pass[i] ) connections.push_back( possibleConnections[i] ); //the connection was successful
+    }
+
+    batch.clear();
+    possibleConnections.clear();
+  };
   
   for ( itSecSeg = map_sector_segments.begin(); itSecSeg != map_sector_segments.end(); itSecSeg++ ){ // over all sectors
     // All the segments with one certain code
     int sector = itSecSeg->first;
-    std::vector <Segment*> segments = itSecSeg->second;
+    const std::vector <unsigned>& sectorSegments = itSecSeg->second;
           
     // Now find out, what the allowed codes to connect to are:
     std::set <int> targetSectors;
@@ -63,50 +82,35 @@ Automaton SegmentBuilder::get1SegAutomaton(){
       targetSectors.insert( newTargetSectors.begin() , newTargetSectors.end() );
     }
           
-    for ( unsigned int i=0; i< segments.size(); i++ ){ //over all segments within the sector
-      Segment* parent = segments[i]; 
+    for ( unsigned int i=0; i< sectorSegments.size(); i++ ){ //over all segments within the sector
+      Segment* parent = &segments[ sectorSegments[i] ]; 
       
       for ( std::set<int>::iterator itTarg = targetSectors.begin(); itTarg!=targetSectors.end(); itTarg++ ){ // over all target codes
 	int targetSector = *itTarg;
-	std::vector <Segment*> targetSegments = map_sector_segments[ targetSector ];
+	std::map< int , std::vector< unsigned > >::const_iterator itTargSeg = map_sector_segments.find( targetSector );
+	if ( itTargSeg == map_sector_segments.end() ) continue;
+	const std::vector <unsigned>& targetSegments = itTargSeg->second;
                     
 	for ( unsigned int j=0; j < targetSegments.size(); j++ ){ // over all segments in the target sector
-	  Segment* child = targetSegments[j];
-	  bool areCompatible = true;
-	  ICriterion* theFailedCrit = NULL; 
-                         
-	  for (unsigned int iCrit = 0; iCrit < _criteria.size(); iCrit++){
-	    if ( _criteria[iCrit]->areCompatible( parent , child ) == false ){
-	      areCompatible = false;
-	      theFailedCrit = _criteria[iCrit];
-	      break;
-	    }
-	  }
-                         
-	  if ( areCompatible ){ //the connection was successful 
-	    parent->addChild( child );
-	    child->addParent( parent );
-            
-	    nConnections++;              
-	    //std::cout << "Connected: " << child->getInfo() << "<--with-->" << parent->getInfo() << "\n"; 
-	  } 
-	  else{
-	    //std::cout << "NOT Connected: " << child->getInfo() << "<--XXXX-->" << parent->getInfo() << "\n";
-	    //if( theFailedCrit != NULL ) std::cout << "Failed first at criterion: " << theFailedCrit->getName() << "\n";
-	  }
+	  Segment* child = &segments[ targetSegments[j] ];
+
+	  batch.addPair( parent , child );
+	  possibleConnections.push_back( std::make_pair( sectorSegments[i] , targetSegments[j] ) );
+
+	  if ( batch.size() == SegmentPairBatch::blockSize ) checkBatch();
 	}
       }
          
-      // Store the segment in the automaton
-      automaton.addSegment( parent );
       nStoredSegments++;
     }      
   }
+  checkBatch();
       
-  //std::cout << "Number of connections made " << nConnections <<"\n";
+  //std::cout << "Number of connections made " << connections.size() <<"\n";
   //std::cout << "Number of 1-segments, that got stored in the automaton: " << nStoredSegments <<"\n";
     
-  return automaton;
+  // Store the segments and their connections in the automaton
+  return Automaton( segments , connections );
 }
 
 
@@ -0,0 +1,266 @@
+// Test of SegmentBuilder and Automaton on a toy event with the segment, connection and track lists written out.
+//
+// The event has the IP (layer 0) and three layers: two tracks a and b through all layers, a short track c in
+// the layers 1 and 2 and noise hits, that don't reach the IP. A criterion connects hits of the same track (or
+// the IP). The noise gives consecutive segments with bad states in one layer and a bad segment at the end of a
+// layer (cleanBadStates must erase all of them), once for the 1-hit segments and once for the 2-hit segments
+// of the sequence of FTDRawTrackFinder. A hit of track a that misses the IP gives a bad child of a good segment.
+
+#include "KiTrack/Automaton.h"
+#include "KiTrack/ISectorConnector.h"
+#include "KiTrack/ISectorSystem.h"
+#include "KiTrack/SegmentBuilder.h"
+#include "Criteria/ICriterion.h"
+
+#include <iostream>
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+#include <vector>
+
+using namespace KiTrack;
+
+namespace {
+
+  int nFailed = 0;
+
+  void expect(bool ok, const std::string& what) {
+    if (ok) return;
+    ++nFailed;
+    std::cout << "FAILED: " << what << std::endl;
+  }
+
+  // the sector is the layer
+  class LayerSystem : public ISectorSystem {
+  public:
+    LayerSystem(unsigned nLayers) { _nLayers = nLayers; }
+    virtual unsigned getLayer(int sector) const { return sector; }
+    virtual std::string getInfoOnSector(int sector) const { return "layer " + std::to_string(sector); }
+  };
+
+  // connects a layer to the next one inside
+  class NextLayerConnector : public ISectorConnector {
+  public:
+    virtual std::set< int > getTargetSectors(int sector) {
+      std::set< int > targets;
+      if (sector > 0) targets.insert(sector - 1);
+      return targets;
+    }
+  };
+
+  // a hit with a name, the track is the part of the name before the '_', a name ending with 'm' misses the IP
+  class NamedHit : public IHit {
+  public:
+    NamedHit(const std::string& name, unsigned layer, const ISectorSystem* sectorSystem)
+      : _name(name), _sectorSystem(sectorSystem) {
+      _x = layer;
+      _sector = layer;
+      _isVirtual = (name == "IP");
+    }
+    virtual const ISectorSystem* getSectorSystem() const { return _sectorSystem; }
+    const std::string& getName() const { return _name; }
+    std::string getTrack() const { return _name.substr(0, _name.find('_')); }
+    bool missesIP() const { return _name.back() == 'm'; }
+
+  private:
+    std::string _name;
+    const ISectorSystem* _sectorSystem;
+  };
+
+  // compatible, if all real hits of both segments are of the same track, which is not the rejected one, and
+  // no hit missing the IP is together with the IP
+  class SameTrack : public ICriterion {
+  public:
+    SameTrack(const std::string& rejected = "") : _rejected(rejected) {}
+
+    virtual bool areCompatible(Segment* parent, Segment* child) {
+      std::set< std::string > tracks;
+      bool hasIP = false, missesIP = false;
+      for (Segment* segment : { parent, child })
+        for (IHit* hit : segment->getHits()) {
+          if (hit->isVirtual()) hasIP = true;
+          else {
+            tracks.insert(static_cast< NamedHit* >(hit)->getTrack());
+            missesIP = missesIP || static_cast< NamedHit* >(hit)->missesIP();
+          }
+        }
+      return tracks.size() == 1 && *tracks.begin() != _rejected && !(hasIP && missesIP);
+    }
+
+  private:
+    std::string _rejected;
+  };
+
+  std::string name(const std::vector< IHit* >& hits) {
+    std::string result;
+    for (IHit* hit : hits) result += (result.empty() ? "" : " ") + static_cast< NamedHit* >(hit)->getName();
+    return result;
+  }
+
+  std::vector< std::string > segmentList(const Automaton& automaton) {
+    std::vector< std::string > result;
+    for (const Segment* segment : automaton.getSegments()) result.push_back(name(segment->getHits()));
+    return result;
+  }
+
+  std::vector< std::string > connectionList(const Automaton& automaton) {
+    std::vector< const Segment* > segments = automaton.getSegments();
+    std::vector< std::string > result;
+    for (const auto& connection : automaton.getConnections())
+      result.push_back(name(segments[connection.first]->getHits()) + " -> " + name(segments[connection.second]->getHits()));
+    return result;
+  }
+
+  std::vector< std::string > trackList(Automaton& automaton, unsigned minHits) {
+    std::vector< std::string > result;
+    for (const std::vector< IHit* >& track : automaton.getTracks(minHits)) result.push_back(name(track));
+    return result;
+  }
+
+  void print(const std::vector< std::string >& list) {
+    for (const std::string& entry : list) std::cout << "    " << entry << std::endl;
+  }
+
+  void expectList(const std::vector< std::string >& list, const std::vector< std::string >& expected, const std::string& what) {
+    expect(list == expected, what);
+    if (list != expected) {
+      std::cout << "  got:" << std::endl;
+      print(list);
+      std::cout << "  expected:" << std::endl;
+      print(expected);
+    }
+  }
+
+  void expectState(Automaton& automaton, const std::vector< std::string >& segments,
+                   const std::vector< std::string >& connections, const std::string& what) {
+    expectList(segmentList(automaton), segments, what + ": segments");
+    expectList(connectionList(automaton), connections, what + ": connections");
+    expect(automaton.getNumberOfConnections() == connections.size(), what + ": number of connections");
+  }
+
+  struct ToyEvent {
+    LayerSystem layers{ 4 };
+    std::vector< std::unique_ptr< NamedHit > > hits;
+    std::map< int, std::vector< IHit* > > sectorHits;
+
+    ToyEvent() {
+      // noise in the layers 2 and 3 (n7, n8, n9), noise only in layer 3 (n6); n9 is the last hit of its layers
+      const std::vector< std::vector< std::string > > names = {
+        { "IP" },
+        { "a_1", "a_1m", "b_1", "c_1" },
+        { "a_2", "n7_2", "n8_2", "b_2", "c_2", "n9_2" },
+        { "a_3", "n6_3", "n7_3", "n8_3", "b_3", "n9_3" } };
+      for (unsigned layer = 0; layer < names.size(); ++layer)
+        for (const std::string& hitName : names[layer]) {
+          hits.emplace_back(new NamedHit(hitName, layer, &layers));
+          sectorHits[layer].push_back(hits.back().get());
+        }
+    }
+  };
+
+  Automaton get1SegAutomaton(ToyEvent& event, ICriterion* criterion) {
+    SegmentBuilder segBuilder(event.sectorHits);
+    segBuilder.addCriterion(criterion);
+    NextLayerConnector connector;
+    segBuilder.addSectorConnector(&connector);
+    return segBuilder.get1SegAutomaton();
+  }
+
+  // the Cellular Automaton on the 1-hit segments
+  void testOneHitSegments() {
+    ToyEvent event;
+    SameTrack sameTrack;
+    Automaton automaton = get1SegAutomaton(event, &sameTrack);
+
+    automaton.doAutomaton();
+    automaton.cleanBadStates();
+    expectState(automaton,
+                { "IP", "a_1", "b_1", "c_1", "a_2", "b_2", "c_2", "a_3", "b_3" },
+                { "a_1 -> IP", "b_1 -> IP", "c_1 -> IP", "a_2 -> a_1", "b_2 -> b_1", "c_2 -> c_1", "a_3 -> a_2", "b_3 -> b_2" },
+                "1-hit segments, cleanBadStates");
+    expectList(trackList(automaton, 2), { "c_2 c_1", "a_3 a_2 a_1", "b_3 b_2 b_1" }, "1-hit segments: tracks");
+
+    // without the connections of track b
+    SameTrack notB("b");
+    automaton.clearCriteria();
+    automaton.addCriterion(&notB);
+    automaton.cleanBadConnections();
+    expectState(automaton,
+                { "IP", "a_1", "b_1", "c_1", "a_2", "b_2", "c_2", "a_3", "b_3" },
+                { "a_1 -> IP", "c_1 -> IP", "a_2 -> a_1", "c_2 -> c_1", "a_3 -> a_2" },
+                "1-hit segments, cleanBadConnections");
+    expectList(trackList(automaton, 2), { "c_2 c_1", "a_3 a_2 a_1" }, "1-hit segments without b: tracks");
+  }
+
+  // the sequence of FTDRawTrackFinder: the segments are lengthened before the Cellular Automaton
+  void testSequence() {
+    ToyEvent event;
+    SameTrack sameTrack;
+    Automaton automaton = get1SegAutomaton(event, &sameTrack);
+
+    expectState(automaton,
+                { "IP", "a_1", "a_1m", "b_1", "c_1", "a_2", "n7_2", "n8_2", "b_2", "c_2", "n9_2",
+                  "a_3", "n6_3", "n7_3", "n8_3", "b_3", "n9_3" },
+                { "a_1 -> IP", "b_1 -> IP", "c_1 -> IP", "a_2 -> a_1", "a_2 -> a_1m", "b_2 -> b_1", "c_2 -> c_1",
+                  "a_3 -> a_2", "n7_3 -> n7_2", "n8_3 -> n8_2", "b_3 -> b_2", "n9_3 -> n9_2" },
+                "SegmentBuilder");
+
+    automaton.clearCriteria();
+    automaton.addCriterion(&sameTrack);
+    automaton.lengthenSegments();
+    expectState(automaton,
+                { "IP a_1", "IP b_1", "IP c_1", "a_1 a_2", "a_1m a_2", "b_1 b_2", "c_1 c_2",
+                  "a_2 a_3", "n7_2 n7_3", "n8_2 n8_3", "b_2 b_3", "n9_2 n9_3" },
+                { "a_1 a_2 -> IP a_1", "b_1 b_2 -> IP b_1", "c_1 c_2 -> IP c_1",
+                  "a_2 a_3 -> a_1 a_2", "a_2 a_3 -> a_1m a_2", "b_2 b_3 -> b_1 b_2" },
+                "2-hit segments");
+
+    automaton.doAutomaton();
+    automaton.cleanBadStates();
+    automaton.resetStates();
+    expectState(automaton,
+                { "IP a_1", "IP b_1", "IP c_1", "a_1 a_2", "b_1 b_2", "c_1 c_2", "a_2 a_3", "b_2 b_3" },
+                { "a_1 a_2 -> IP a_1", "b_1 b_2 -> IP b_1", "c_1 c_2 -> IP c_1",
+                  "a_2 a_3 -> a_1 a_2", "b_2 b_3 -> b_1 b_2" },
+                "2-hit segments, cleanBadStates");
+
+    automaton.lengthenSegments();
+    automaton.doAutomaton();
+    automaton.cleanBadStates();
+    automaton.resetStates();
+    expectState(automaton,
+                { "IP a_1 a_2", "IP b_1 b_2", "IP c_1 c_2", "a_1 a_2 a_3", "b_1 b_2 b_3" },
+                { "a_1 a_2 a_3 -> IP a_1 a_2", "b_1 b_2 b_3 -> IP b_1 b_2" },
+                "3-hit segments, cleanBadStates");
+
+    expectList(trackList(automaton, 3), { "a_3 a_2 a_1", "b_3 b_2 b_1" }, "3-hit segments: tracks");
+  }
+
+  // an automaton made from its own connections is the same
+  void testConnectionsRoundTrip() {
+    ToyEvent event;
+    SameTrack sameTrack;
+    Automaton automaton = get1SegAutomaton(event, &sameTrack);
+
+    std::vector< Segment > segments;
+    for (const Segment* segment : automaton.getSegments()) segments.push_back(*segment);
+    Automaton copy(segments, automaton.getConnections());
+
+    expectList(segmentList(copy), segmentList(automaton), "round trip: segments");
+    expectList(connectionList(copy), connectionList(automaton), "round trip: connections");
+  }
+}
+
+int main() {
+  testOneHitSegments();
+  testSequence();
+  testConnectionsRoundTrip();
+
+  if (nFailed) {
+    std::cout << "FAILED: " << nFailed << " checks" << std::endl;
+    return 1;
+  }
+  std::cout << "OK" << std::endl;
+  return 0;
+}
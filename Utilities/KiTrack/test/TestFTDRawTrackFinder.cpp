@@ -0,0 +1,414 @@
+// Test of FTDRawTrackFinder on toy FTD events: helices from the IP plus noise hits.
+//
+// With one phi partition and one thread the raw tracks must be those of the former
+// ForwardTrackingAlg::execute (copied below as the reference), in the same order, including the rounds
+// with tighter cut offs. With several threads the two sides are split: the reference of the side +1
+// followed by the one of the side -1, with the rounds of each side. With several phi partitions and the
+// minimum overlap they must be the same set of tracks for any number of threads; a smaller overlap must
+// be rejected. Every hit must go to one region only where the overlap reaches all petals, and the
+// largest region must not get more hits than its share of the petals. At the end the time of the
+// Cellular Automaton and the hits of the regions are printed for 1 to 8 threads.
+
+#include "ILDImpl/FTDRawTrackFinder.h"
+#include "ILDImpl/FTDHitSimple.h"
+#include "ILDImpl/FTDSectorConnector.h"
+#include "ILDImpl/SectorSystemFTD.h"
+#include "KiTrack/Automaton.h"
+#include "KiTrack/KiTrackExceptions.h"
+#include "KiTrack/SegmentBuilder.h"
+#include "Criteria/Criteria.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace KiTrack;
+using namespace KiTrackMarlin;
+
+namespace {
+
+  int nFailed = 0;
+
+  void expect(bool ok, const std::string& what) {
+    if (ok) return;
+    ++nFailed;
+    std::cout << "FAILED: " << what << std::endl;
+  }
+
+  typedef std::vector< std::vector< IHit* > > RawTracks;
+  typedef std::map< int , std::vector< IHit* > > SectorHits;
+
+  const unsigned nLayers  = 8;   // including the IP
+  const unsigned nSensors = 2;
+  const double   diskZ[]  = { 220., 370., 640., 850., 1090., 1330., 1570. };
+  const double   rMin     = 30.;
+  const double   rMax     = 320.;
+  const double   bField   = 3.5;
+
+  // the criteria and cut offs of the CRD steering
+  struct Cuts {
+    std::vector< std::string > names;
+    std::map< std::string , std::vector< float > > minima;
+    std::map< std::string , std::vector< float > > maxima;
+  };
+
+  Cuts steeringCuts() {
+    const std::vector< std::string > names = { "Crit2_DeltaPhi", "Crit2_StraightTrackRatio", "Crit3_3DAngle",
+                                               "Crit3_ChangeRZRatio", "Crit3_IPCircleDist", "Crit4_3DAngleChange",
+                                               "Crit4_DistToExtrapolation", "Crit2_DeltaRho", "Crit2_RZRatio", "Crit3_PT" };
+    const std::vector< float > mins = { 0,  0.9,  0,  0.995, 0,  0.8, 0,   20,  1.002, 0.1,      0,   0.99, 0,    0.999, 0,   0.99, 0 };
+    const std::vector< float > maxs = { 30, 1.02, 10, 1.015, 20, 1.3, 1.0, 150, 1.08,  99999999.f, 0.8, 1.01, 0.35, 1.001, 1.5, 1.01, 0.05 };
+
+    // the same filling as ForwardTrackingAlg::initialize: one value per criterion, then the next round
+    Cuts cuts;
+    cuts.names = names;
+    for (size_t i = 0; i < mins.size(); ++i) {
+      const std::string& name = names[i % names.size()];
+      cuts.minima[name].push_back(mins[i]);
+      cuts.maxima[name].push_back(maxs[i]);
+    }
+    return cuts;
+  }
+
+  // the hits of one event, sorted by sectors
+  struct Event {
+    std::vector< std::unique_ptr< IHit > > hits;
+    SectorHits sectorHits;
+
+    void add(const SectorSystemFTD* ss, double x, double y, double z, int side, bool isVirtual = false) {
+      unsigned layer = 0, module = 0, sensor = 0;
+      if (!isVirtual) {
+        double r = std::sqrt(x*x + y*y);
+        double phi = std::atan2(y, x);
+        if (phi < 0) phi += 2*M_PI;
+        while (std::fabs(diskZ[layer]) < std::fabs(z) - 1.) ++layer;
+        ++layer;
+        unsigned nModules = ss->getNumberOfModules();
+        module = std::min(unsigned(phi / (2*M_PI/nModules)), nModules-1);
+        sensor = r < 150. ? 0 : 1;
+      }
+      FTDHitSimple* hit = new FTDHitSimple(x, y, z, side, layer, module, sensor, ss);
+      hit->setIsVirtual(isVirtual);
+      hits.emplace_back(hit);
+      sectorHits[hit->getSector()].push_back(hit);
+    }
+  };
+
+  Event makeEvent(const SectorSystemFTD* ss, unsigned nTracks, unsigned nNoise, std::mt19937& rng) {
+    std::uniform_real_distribution<double> uniform(0., 1.);
+    Event event;
+
+    // the IP of both sides
+    event.add(ss, 0., 0., 0.,  1, true);
+    event.add(ss, 0., 0., 0., -1, true);
+
+    for (unsigned i = 0; i < nTracks; ++i) {
+      double pt   = 0.5 + 4.5*uniform(rng);                 // GeV
+      double phi0 = 2*M_PI*uniform(rng);
+      double q    = uniform(rng) < 0.5 ? -1. : 1.;
+      double tanTheta = 0.03 + 0.3*uniform(rng);            // r/z
+      double side = uniform(rng) < 0.5 ? -1. : 1.;
+      double radius = pt / (0.299792458e-3 * bField);      // mm
+
+      for (double zDisk : diskZ) {
+        double s   = zDisk * tanTheta;                       // transverse path length, about r for large radii
+        double phi = phi0 + q*s/radius;
+        double x = radius/q * (std::sin(phi) - std::sin(phi0));
+        double y = -radius/q * (std::cos(phi) - std::cos(phi0));
+        double r = std::sqrt(x*x + y*y);
+        if (r < rMin || r > rMax) continue;
+        event.add(ss, x, y, side*zDisk, int(side));
+      }
+    }
+
+    for (unsigned i = 0; i < nNoise; ++i) {
+      double r   = rMin + (rMax - rMin)*uniform(rng);
+      double phi = 2*M_PI*uniform(rng);
+      int side   = uniform(rng) < 0.5 ? -1 : 1;
+      double z   = side * diskZ[unsigned(7*uniform(rng)) % 7];
+      event.add(ss, r*std::cos(phi), r*std::sin(phi), z, side);
+    }
+
+    return event;
+  }
+
+  // the former ForwardTrackingAlg::setCriteria
+  bool setCriteria(const Cuts& cuts, unsigned round, std::vector< ICriterion* >& crit2Vec,
+                   std::vector< ICriterion* >& crit3Vec, std::vector< ICriterion* >& crit4Vec) {
+    for (unsigned i = 0; i < crit2Vec.size(); i++) delete crit2Vec[i];
+    for (unsigned i = 0; i < crit3Vec.size(); i++) delete crit3Vec[i];
+    for (unsigned i = 0; i < crit4Vec.size(); i++) delete crit4Vec[i];
+    crit2Vec.clear();
+    crit3Vec.clear();
+    crit4Vec.clear();
+
+    bool newValuesGotUsed = false;
+    for (unsigned i = 0; i < cuts.names.size(); i++) {
+      std::string critName = cuts.names[i];
+      float min = cuts.minima.at(critName).back();
+      float max = cuts.maxima.at(critName).back();
+      if (round + 1 <= cuts.minima.at(critName).size()) {
+        min = cuts.minima.at(critName)[round];
+        newValuesGotUsed = true;
+      }
+      if (round + 1 <= cuts.maxima.at(critName).size()) {
+        max = cuts.maxima.at(critName)[round];
+        newValuesGotUsed = true;
+      }
+      ICriterion* crit = Criteria::createCriterion(critName, min, max);
+      std::string type = crit->getType();
+      if (type == "2Hit") crit2Vec.push_back(crit);
+      else if (type == "3Hit") crit3Vec.push_back(crit);
+      else if (type == "4Hit") crit4Vec.push_back(crit);
+      else delete crit;
+    }
+    return newValuesGotUsed;
+  }
+
+  // the former round loop of ForwardTrackingAlg::execute, one automaton for all hits
+  RawTracks referenceRawTracks(const SectorSystemFTD* ss, const Cuts& cuts, unsigned maxConnections,
+                               const SectorHits& sectorHits, unsigned& nRounds) {
+    nRounds = 0;
+    RawTracks rawTracks;
+    std::vector< ICriterion* > crit2Vec, crit3Vec, crit4Vec;
+
+    while (setCriteria(cuts, nRounds, crit2Vec, crit3Vec, crit4Vec)) {
+      nRounds++;
+
+      SegmentBuilder segBuilder(sectorHits);
+      segBuilder.addCriteria(crit2Vec);
+      FTDSectorConnector secCon(ss, 1, 1, 5);
+      segBuilder.addSectorConnector(&secCon);
+      Automaton automaton = segBuilder.get1SegAutomaton();
+      if (automaton.getNumberOfConnections() > maxConnections) continue;
+
+      automaton.clearCriteria();
+      automaton.addCriteria(crit3Vec);
+      automaton.lengthenSegments();
+      automaton.doAutomaton();
+      automaton.cleanBadStates();
+      automaton.resetStates();
+      if (automaton.getNumberOfConnections() > maxConnections) continue;
+
+      automaton.clearCriteria();
+      automaton.addCriteria(crit4Vec);
+      automaton.lengthenSegments();
+      automaton.doAutomaton();
+      automaton.cleanBadStates();
+      automaton.resetStates();
+      if (automaton.getNumberOfConnections() > maxConnections) continue;
+
+      rawTracks = automaton.getTracks(3);
+      break;
+    }
+
+    for (unsigned i = 0; i < crit2Vec.size(); i++) delete crit2Vec[i];
+    for (unsigned i = 0; i < crit3Vec.size(); i++) delete crit3Vec[i];
+    for (unsigned i = 0; i < crit4Vec.size(); i++) delete crit4Vec[i];
+    return rawTracks;
+  }
+
+  // the hits of one side of the FTD
+  SectorHits sideHits(const SectorSystemFTD* ss, const SectorHits& sectorHits, int side) {
+    SectorHits result;
+    for (const auto& sector : sectorHits)
+      if (ss->getSide(sector.first) == side) result.insert(sector);
+    return result;
+  }
+
+  unsigned countHits(const SectorHits& sectorHits) {
+    unsigned nHits = 0;
+    for (const auto& sector : sectorHits) nHits += sector.second.size();
+    return nHits;
+  }
+
+  RawTracks sorted(RawTracks rawTracks) {
+    std::sort(rawTracks.begin(), rawTracks.end());
+    return rawTracks;
+  }
+
+  RawTracks findRawTracks(const SectorSystemFTD* ss, const Cuts& cuts, unsigned maxConnections,
+                          const SectorHits& sectorHits, unsigned nPartitions, unsigned overlap, int nThreads,
+                          std::vector< unsigned >* nRounds = nullptr, std::vector< unsigned >* nRegionHits = nullptr) {
+    FTDRawTrackFinder finder(ss, cuts.names, cuts.minima, cuts.maxima, maxConnections);
+    finder.setPhiPartitions(nPartitions, overlap);
+    finder.setNumberOfThreads(nThreads);
+    RawTracks rawTracks = finder.getRawTracks(sectorHits);
+    if (nRounds) *nRounds = finder.getNumberOfRounds();
+    if (nRegionHits) *nRegionHits = finder.getNumberOfRegionHits();
+    return rawTracks;
+  }
+
+  // one partition: the raw tracks and rounds of the former code, in the same order. With several threads
+  // those of the two sides, one after the other.
+  void testOnePartition(const SectorSystemFTD* ss, const Cuts& cuts, const Event& event,
+                        unsigned maxConnections, const std::string& what) {
+    unsigned refRounds = 0;
+    RawTracks reference = referenceRawTracks(ss, cuts, maxConnections, event.sectorHits, refRounds);
+    expect(!reference.empty(), what + ": the reference finds tracks");
+
+    std::vector< unsigned > sideRounds(2, 0);
+    RawTracks sideReference;
+    for (int side : { 1, -1 }) {
+      RawTracks tracks = referenceRawTracks(ss, cuts, maxConnections, sideHits(ss, event.sectorHits, side),
+                                            sideRounds[side > 0 ? 0 : 1]);
+      sideReference.insert(sideReference.end(), tracks.begin(), tracks.end());
+    }
+
+    std::vector< unsigned > nRounds, nRegionHits;
+    RawTracks rawTracks = findRawTracks(ss, cuts, maxConnections, event.sectorHits, 1, 0, 1, &nRounds, &nRegionHits);
+    std::string name = what + ", 1 partition, 1 thread";
+    expect(rawTracks == reference, name + ": raw tracks in the order of the reference");
+    expect(nRounds.size() == 1 && nRounds[0] == refRounds, name + ": rounds of the reference");
+    expect(nRegionHits.size() == 1 && nRegionHits[0] == countHits(event.sectorHits), name + ": all hits in one region");
+
+    for (int nThreads : { 2, 4 }) {
+      rawTracks = findRawTracks(ss, cuts, maxConnections, event.sectorHits, 1, 0, nThreads, &nRounds, &nRegionHits);
+      name = what + ", 1 partition, " + std::to_string(nThreads) + " threads";
+      expect(rawTracks == sideReference, name + ": raw tracks of the references of the two sides");
+      expect(nRounds == sideRounds, name + ": rounds of the two sides");
+      expect(nRegionHits.size() == 2 && nRegionHits[0] + nRegionHits[1] == countHits(event.sectorHits),
+             name + ": every hit in one side");
+    }
+  }
+
+  // several partitions with the minimum overlap: the tracks of one automaton, the same for any number of threads
+  void testPartitions(const SectorSystemFTD* ss, const Cuts& cuts, const Event& event, const std::string& what) {
+    unsigned refRounds = 0;
+    RawTracks reference = sorted(referenceRawTracks(ss, cuts, 100000, event.sectorHits, refRounds));
+    expect(!reference.empty() && refRounds == 1, what + ": the reference finds tracks in one round");
+
+    FTDRawTrackFinder finder(ss, cuts.names, cuts.minima, cuts.maxima, 100000);
+    const unsigned overlap = finder.getMinPhiPartitionOverlap();
+    expect(overlap == nLayers, what + ": minimum overlap of one petal per layer");
+
+    for (unsigned nPartitions : { 2u, 3u, 4u }) {
+      // a region of the largest range and the overlap on both sides must not reach all petals
+      const unsigned nModules = ss->getNumberOfModules();
+      const unsigned maxRange = (nModules + nPartitions - 1) / nPartitions;
+      const bool sidesOnly = maxRange + 2*overlap >= nModules;
+      const unsigned nRegions = sidesOnly ? 2 : 2*nPartitions;
+
+      RawTracks first;
+      for (int nThreads : { 1, 2, 4 }) {
+        std::string name = what + ", " + std::to_string(nPartitions) + " partitions, " + std::to_string(nThreads) + " threads";
+        std::vector< unsigned > nRounds, nRegionHits;
+        RawTracks rawTracks = findRawTracks(ss, cuts, 100000, event.sectorHits, nPartitions, overlap, nThreads,
+                                            &nRounds, &nRegionHits);
+        expect(nRounds.size() == nRegions, name + ": " + std::to_string(nRegions) + " regions");
+
+        // the work per region: without phi partitions every hit is in one region, otherwise the largest
+        // one gets about the hits of its range and the overlap (the hits are uniform in phi)
+        const unsigned nHits = countHits(event.sectorHits);
+        unsigned sumHits = 0, maxHits = 0;
+        for (unsigned n : nRegionHits) {
+          sumHits += n;
+          maxHits = std::max(maxHits, n);
+        }
+        if (sidesOnly) expect(sumHits == nHits, name + ": every hit in one region");
+        else expect(maxHits < 1.3 * nHits * (maxRange + 2*overlap) / (2*nModules),
+                    name + ": the largest region gets more hits than its petals");
+        expect(sorted(rawTracks) == reference, name + ": the raw tracks of one automaton");
+        if (nThreads == 1) first = rawTracks;
+        else expect(rawTracks == first, name + ": same order as 1 thread");
+      }
+    }
+  }
+
+  void testSmallOverlap(const SectorSystemFTD* ss, const Cuts& cuts) {
+    FTDRawTrackFinder finder(ss, cuts.names, cuts.minima, cuts.maxima, 100000);
+
+    bool thrown = false;
+    try { finder.setPhiPartitions(4, finder.getMinPhiPartitionOverlap() - 1); }
+    catch (InvalidParameter&) { thrown = true; }
+    expect(thrown, "an overlap below the minimum is rejected");
+
+    thrown = false;
+    try { finder.setPhiPartitions(1, 0); }
+    catch (InvalidParameter&) { thrown = true; }
+    expect(!thrown, "no overlap needed for one partition");
+  }
+
+  // the time to find the raw tracks, for one automaton and for the regions with 1 to 8 threads
+  void printScaling(const SectorSystemFTD* ss, const Cuts& cuts, const Event& event, unsigned nPartitions) {
+    const int nRepeat = 3;
+    FTDRawTrackFinder finder(ss, cuts.names, cuts.minima, cuts.maxima, 100000);
+    const unsigned overlap = finder.getMinPhiPartitionOverlap();
+
+    auto timeIt = [&](unsigned nPart, int nThreads) {
+      auto start = std::chrono::steady_clock::now();
+      for (int i = 0; i < nRepeat; ++i)
+        findRawTracks(ss, cuts, 100000, event.sectorHits, nPart, overlap, nThreads);
+      return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / nRepeat;
+    };
+
+    // the hits of the largest region and of all regions together
+    auto regionHits = [&](unsigned nPart, int nThreads, unsigned& sumHits) {
+      std::vector< unsigned > nRegionHits;
+      findRawTracks(ss, cuts, 100000, event.sectorHits, nPart, overlap, nThreads, nullptr, &nRegionHits);
+      sumHits = 0;
+      for (unsigned n : nRegionHits) sumHits += n;
+      return *std::max_element(nRegionHits.begin(), nRegionHits.end());
+    };
+
+    std::printf("%u petals, %zu hits\n", ss->getNumberOfModules(), event.hits.size());
+    std::printf("%-12s %-8s %12s %8s %12s %12s\n", "partitions", "threads", "time [ms]", "speedup", "max hits", "sum hits");
+    unsigned sumHits = 0;
+    unsigned maxHits = regionHits(1, 1, sumHits);
+    double single = timeIt(1, 1);
+    std::printf("%-12u %-8d %12.2f %8.2f %12u %12u\n", 1u, 1, single, 1., maxHits, sumHits);
+    for (int nThreads : { 1, 2, 4, 8 }) {
+      maxHits = regionHits(nPartitions, nThreads, sumHits);
+      double t = timeIt(nPartitions, nThreads);
+      std::printf("%-12u %-8d %12.2f %8.2f %12u %12u\n", nPartitions, nThreads, t, single / t, maxHits, sumHits);
+    }
+  }
+}
+
+int main() {
+  std::mt19937 rng(2024);
+  Cuts cuts = steeringCuts();
+
+  // petals as in the CEPC FTD: the minimum overlap reaches all petals, only the two sides are split
+  SectorSystemFTD ss16(nLayers, 16, nSensors);
+  Event event16 = makeEvent(&ss16, 200, 400, rng);
+  testOnePartition(&ss16, cuts, event16, 100000, "16 petals");
+  testPartitions(&ss16, cuts, event16, "16 petals");
+
+  // more petals: split in phi
+  SectorSystemFTD ss64(nLayers, 64, nSensors);
+  Event event64 = makeEvent(&ss64, 200, 400, rng);
+  testOnePartition(&ss64, cuts, event64, 100000, "64 petals");
+  testPartitions(&ss64, cuts, event64, "64 petals");
+
+  // too many connections in the first round: the second round with tighter cut offs
+  Cuts tight = cuts;
+  for (const std::string& name : tight.names) {
+    tight.minima[name].resize(1);
+    tight.maxima[name].resize(1);
+  }
+  tight.maxima["Crit2_DeltaPhi"].push_back(2.);
+  tight.maxima["Crit3_3DAngle"].push_back(1.);
+  unsigned refRounds = 0;
+  referenceRawTracks(&ss16, tight, 2000, event16.sectorHits, refRounds);
+  expect(refRounds == 2, "tight: the reference needs the second round");
+  testOnePartition(&ss16, tight, event16, 2000, "tight");
+
+  testSmallOverlap(&ss16, cuts);
+
+  printScaling(&ss16, cuts, makeEvent(&ss16, 1000, 2000, rng), 4);
+  printScaling(&ss64, cuts, makeEvent(&ss64, 1000, 2000, rng), 4);
+
+  if (nFailed) {
+    std::cout << "FAILED: " << nFailed << " checks" << std::endl;
+    return 1;
+  }
+  std::cout << "OK" << std::endl;
+  return 0;
+}
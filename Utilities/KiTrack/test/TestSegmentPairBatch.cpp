@@ -0,0 +1,254 @@
+// The batched criteria of SegmentPairBatch must decide like the criteria checked pair by pair.
+//
+// Random pairs of 1-, 2- and 3-hit segments are built from helices from the IP, straight lines (collinear
+// hits), hits with the same z (dz == 0), hits at or near the origin and random hits. For every criterion
+// and several cut windows (quantiles of the values of the criterion on the pairs, so the cuts fall on the
+// values themselves) SegmentPairBatch::applyCriteria must set pass for every pair as areCompatible does.
+// The same holds for the criteria of the CRD steering applied one after the other.
+
+#include "ILDImpl/FTDHitSimple.h"
+#include "ILDImpl/SectorSystemFTD.h"
+#include "KiTrack/Segment.h"
+#include "Criteria/Criteria.h"
+#include "Criteria/ICriterion.h"
+#include "Criteria/SegmentPairBatch.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+
+using namespace KiTrack;
+using namespace KiTrackMarlin;
+
+namespace {
+
+  int nFailed = 0;
+
+  void expect(bool ok, const std::string& what) {
+    if (ok) return;
+    ++nFailed;
+    std::cout << "FAILED: " << what << std::endl;
+  }
+
+  const double diskZ[] = { 220., 370., 640., 850., 1090., 1330., 1570. };
+
+  enum Kind { helix, collinear, sameZ, nearOrigin, random, nKinds };
+
+  // the segment pairs of one length: the child has the hits 0..length-1, the parent the hits 1..length
+  struct Pairs {
+    std::vector< std::unique_ptr< IHit > > hits;
+    std::vector< std::unique_ptr< Segment > > segments;
+    SegmentPairBatch batch;
+  };
+
+  std::vector< double > helixPoint(double radius, double q, double phi0, double tanTheta, double z) {
+    double phi = phi0 + q*z*tanTheta/radius;
+    return { radius/q * (std::sin(phi) - std::sin(phi0)), -radius/q * (std::cos(phi) - std::cos(phi0)), z };
+  }
+
+  // the length+1 hits of a pair from the inside out
+  std::vector< std::vector< double > > pairHits(Kind kind, unsigned length, std::mt19937& rng) {
+    std::uniform_real_distribution<double> uniform(0., 1.);
+    std::normal_distribution<double> smear(0., 1.);
+    const unsigned nHits = length + 1;
+    const double side = uniform(rng) < 0.5 ? -1. : 1.;
+
+    // consecutive disks
+    unsigned firstDisk = unsigned(uniform(rng)*(7 - nHits + 1));
+    std::vector< double > z;
+    for (unsigned i = 0; i < nHits; ++i) z.push_back(side*diskZ[firstDisk + i]);
+
+    std::vector< std::vector< double > > points;
+
+    if (kind == collinear) {
+      // a straight line, from the IP or from a displaced point
+      double phi = 2*M_PI*uniform(rng);
+      double tanTheta = 0.03 + 0.3*uniform(rng);
+      double x0 = uniform(rng) < 0.5 ? 0. : 20.*smear(rng), y0 = uniform(rng) < 0.5 ? 0. : 20.*smear(rng);
+      for (double zi : z)
+        points.push_back({ x0 + std::fabs(zi)*tanTheta*std::cos(phi), y0 + std::fabs(zi)*tanTheta*std::sin(phi), zi });
+      return points;
+    }
+
+    if (kind == random) {
+      for (double zi : z) {
+        double r = 30. + 290.*uniform(rng), phi = 2*M_PI*uniform(rng);
+        points.push_back({ r*std::cos(phi), r*std::sin(phi), uniform(rng) < 0.2 ? z[0] : zi });
+      }
+      return points;
+    }
+
+    double pt = 0.1 + 5.*uniform(rng);
+    double radius = pt / (0.299792458e-3 * 3.5);
+    double q = uniform(rng) < 0.5 ? -1. : 1.;
+    double phi0 = 2*M_PI*uniform(rng);
+    double tanTheta = 0.03 + 0.3*uniform(rng);
+    double scale = std::pow(10., 2.*uniform(rng) - 2.); // from below to far above the resolution
+
+    for (double zi : z) {
+      std::vector< double > p = helixPoint(radius, q, phi0, tanTheta, std::fabs(zi));
+      points.push_back({ p[0] + scale*smear(rng), p[1] + scale*smear(rng), zi });
+    }
+
+    if (kind == sameZ) {
+      // all hits or two neighbouring ones at the same z
+      unsigned i = unsigned(uniform(rng)*length);
+      if (uniform(rng) < 0.5) for (auto& p : points) p[2] = points[0][2];
+      else points[i + 1][2] = points[i][2];
+    }
+
+    if (kind == nearOrigin) {
+      // the IP, or a hit close to it
+      double d = uniform(rng) < 0.5 ? 0. : 0.02*uniform(rng);
+      double phi = 2*M_PI*uniform(rng);
+      points[0] = { d*std::cos(phi), d*std::sin(phi), uniform(rng) < 0.5 ? 0. : d };
+    }
+
+    return points;
+  }
+
+  void makePairs(const SectorSystemFTD* ss, unsigned length, unsigned nPairs, std::mt19937& rng, Pairs& pairs) {
+    for (unsigned iPair = 0; iPair < nPairs; ++iPair) {
+      std::vector< IHit* > hits;
+      for (const std::vector< double >& p : pairHits(Kind(iPair % nKinds), length, rng)) {
+        int side = p[2] < 0. ? -1 : 1;
+        pairs.hits.emplace_back(new FTDHitSimple(p[0], p[1], p[2], side, 1, 0, 0, ss));
+        hits.push_back(pairs.hits.back().get());
+      }
+      Segment* child = new Segment(std::vector< IHit* >(hits.begin(), hits.end() - 1));
+      Segment* parent = new Segment(std::vector< IHit* >(hits.begin() + 1, hits.end()));
+      pairs.segments.emplace_back(child);
+      pairs.segments.emplace_back(parent);
+      pairs.batch.addPair(parent, child);
+    }
+  }
+
+  // pass of the criteria checked pair by pair, stopping at the first one that fails
+  std::vector< char > passOneByOne(const std::vector< ICriterion* >& criteria, const SegmentPairBatch& batch) {
+    std::vector< char > pass(batch.size(), 1);
+    for (unsigned i = 0; i < batch.size(); ++i)
+      for (ICriterion* crit : criteria)
+        if (!crit->areCompatible(batch.getParent(i), batch.getChild(i))) {
+          pass[i] = 0;
+          break;
+        }
+    return pass;
+  }
+
+  // compares the batch with the pairs one by one, @return the number of passing pairs
+  unsigned compare(const std::vector< ICriterion* >& criteria, Pairs& pairs, const std::string& what) {
+    std::vector< char > reference = passOneByOne(criteria, pairs.batch);
+    std::vector< char > pass;
+    pairs.batch.applyCriteria(criteria, pass);
+
+    unsigned nDifferent = 0, nPassed = 0;
+    for (unsigned i = 0; i < reference.size(); ++i) {
+      nDifferent += (pass[i] != reference[i]);
+      nPassed += reference[i];
+    }
+    expect(nDifferent == 0, what + ": " + std::to_string(nDifferent) + " of " + std::to_string(reference.size()) +
+           " pairs decided differently");
+    return nPassed;
+  }
+
+  // the values of the criterion on the pairs (those saved under its name)
+  std::vector< float > values(const std::string& name, const SegmentPairBatch& batch) {
+    std::unique_ptr< ICriterion > crit(Criteria::createCriterion(name, -1.e30, 1.e30));
+    crit->setSaveValues(true);
+    std::vector< float > result;
+    for (unsigned i = 0; i < batch.size(); ++i) {
+      crit->areCompatible(batch.getParent(i), batch.getChild(i));
+      std::map< std::string, float > map = crit->getMapOfValues();
+      if (map.count(name) && std::isfinite(map[name])) result.push_back(map[name]);
+    }
+    std::sort(result.begin(), result.end());
+    return result;
+  }
+
+  void testCriterion(const std::string& name, Pairs& pairs, std::set< std::string >& batched) {
+    std::vector< float > v = values(name, pairs.batch);
+    expect(!v.empty(), name + ": no values");
+    if (v.empty()) return;
+
+    auto quantile = [&](double q) { return v[std::min(size_t(q*v.size()), v.size() - 1)]; };
+
+    // windows on the values: in the middle, the lower and the upper half, a single value, everything
+    const std::vector< std::pair< float, float > > windows = {
+      { quantile(0.1), quantile(0.9) }, { v.front(), quantile(0.5) }, { quantile(0.5), v.back() },
+      { quantile(0.3), quantile(0.3) }, { -1.e30f, 1.e30f } };
+
+    unsigned nPassedMin = pairs.batch.size(), nPassedMax = 0;
+    for (const auto& window : windows) {
+      std::unique_ptr< ICriterion > crit(Criteria::createCriterion(name, window.first, window.second));
+      std::vector< char > pass(pairs.batch.size(), 1);
+      if (crit->areCompatibleBatch(pairs.batch, pass)) batched.insert(name);
+
+      unsigned nPassed = compare({ crit.get() }, pairs, name + " in [" + std::to_string(window.first) + ", " +
+                                 std::to_string(window.second) + "]");
+      nPassedMin = std::min(nPassedMin, nPassed);
+      nPassedMax = std::max(nPassedMax, nPassed);
+    }
+
+    // the cuts have to decide something (the mini-vector criteria have no values for these hits)
+    if (name.find("_MV") == std::string::npos)
+      expect(nPassedMin < nPassedMax, name + ": the windows select the same pairs");
+  }
+
+  // the criteria of the CRD steering of one type, one after the other
+  void testSteering(const std::vector< std::string >& names, const std::vector< float >& mins,
+                    const std::vector< float >& maxs, Pairs& pairs, const std::string& what) {
+    std::vector< std::unique_ptr< ICriterion > > owner;
+    std::vector< ICriterion* > criteria;
+    for (unsigned i = 0; i < names.size(); ++i) {
+      owner.emplace_back(Criteria::createCriterion(names[i], mins[i], maxs[i]));
+      criteria.push_back(owner.back().get());
+    }
+    unsigned nPassed = compare(criteria, pairs, what);
+    expect(nPassed > 0 && nPassed < pairs.batch.size(), what + ": the steering selects some of the pairs");
+  }
+}
+
+int main() {
+  std::mt19937 rng(4711);
+  SectorSystemFTD ss(8, 16, 2);
+
+  // the types of the criteria and the lengths of their segments
+  const std::vector< std::pair< std::string, unsigned > > types = { { "2Hit", 1 }, { "3Hit", 2 }, { "4Hit", 3 } };
+
+  std::set< std::string > batched;
+  for (const auto& type : types) {
+    // more pairs than a block of Automaton and SegmentBuilder
+    Pairs pairs;
+    makePairs(&ss, type.second, 2*SegmentPairBatch::blockSize + 17, rng, pairs);
+
+    for (const std::string& name : Criteria::getCriteriaNames(type.first)) testCriterion(name, pairs, batched);
+
+    if (type.second == 1)
+      testSteering({ "Crit2_DeltaPhi", "Crit2_StraightTrackRatio", "Crit2_DeltaRho", "Crit2_RZRatio" },
+                   { 0, 0.9, 20, 1.002 }, { 30, 1.02, 150, 1.08 }, pairs, "steering 2Hit");
+    if (type.second == 2)
+      testSteering({ "Crit3_3DAngle", "Crit3_ChangeRZRatio", "Crit3_IPCircleDist", "Crit3_PT" },
+                   { 0, 0.995, 0, 0.1 }, { 10, 1.015, 20, 99999999.f }, pairs, "steering 3Hit");
+    if (type.second == 3)
+      testSteering({ "Crit4_3DAngleChange", "Crit4_DistToExtrapolation" },
+                   { 0.8, 0 }, { 1.3, 1.0 }, pairs, "steering 4Hit");
+  }
+
+  // the criteria of the steering have a batched version
+  for (const char* name : { "Crit2_DeltaPhi", "Crit2_StraightTrackRatio", "Crit2_DeltaRho", "Crit2_RZRatio",
+                                   "Crit3_3DAngle", "Crit3_ChangeRZRatio", "Crit3_IPCircleDist", "Crit3_PT",
+                                   "Crit4_3DAngleChange", "Crit4_DistToExtrapolation" })
+    expect(batched.count(name) == 1, std::string(name) + ": no batched version used");
+
+  if (nFailed) {
+    std::cout << "FAILED: " << nFailed << " checks" << std::endl;
+    return 1;
+  }
+  std::cout << "OK" << std::endl;
+  return 0;
+}
@@ -0,0 +1,253 @@
+// Test of the sparse Hopfield Neural Network and of the conflicts of SubsetHopfieldNN.
+//
+// On random conflict graphs the network built from the conflict lists, the one built from the matrix G and
+// the former dense network (copied below as the reference, with the full weight matrix) must give the same
+// states after every iteration, for the same order of the updates. The conflicts that calculateBestSet finds
+// through the shared hits must be those of the check of all pairs. With one and with several threads the
+// best subset must contain every element once and no incompatible pair.
+
+#include "KiTrack/HopfieldNeuralNet.h"
+#include "KiTrack/SubsetHopfieldNN.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+
+using namespace KiTrack;
+
+namespace {
+
+  int nFailed = 0;
+
+  void expect(bool ok, const std::string& what) {
+    if (ok) return;
+    ++nFailed;
+    std::cout << "FAILED: " << what << std::endl;
+  }
+
+  // the former HopfieldNeuralNet with the dense weight matrix
+  class DenseReference {
+  public:
+    DenseReference(const std::vector< std::vector< bool > >& G, const std::vector< double >& QI,
+                   const std::vector< double >& states, double omega, unsigned seed)
+      : _states(states), _rng(seed) {
+      unsigned nNeurons = G.size();
+      double comp = nNeurons > 0 ? (1. - omega) / double(nNeurons) : 1.;
+      _W.assign(nNeurons, std::vector< double >(nNeurons, 0.));
+      for (unsigned i = 0; i < nNeurons; i++)
+        for (unsigned j = 0; j < nNeurons; j++)
+          if (i != j) _W[i][j] = G[i][j] ? -1. : comp;
+      for (unsigned i = 0; i < nNeurons; i++) {
+        _w0.push_back(omega * QI[i]);
+        _order.push_back(i);
+      }
+    }
+
+    bool doIteration() {
+      bool isStable = true;
+      std::shuffle(_order.begin(), _order.end(), _rng);
+      for (unsigned iNeuron : _order) {
+        double y = _w0[iNeuron];
+        for (unsigned j = 0; j < _W[iNeuron].size(); j++) y += _W[iNeuron][j] * _states[j];
+        y = _T > 0 ? 0.5 * (1 + std::tanh(y / _T)) : 1.;
+        if (std::fabs(_states[iNeuron] - y) > _limitForStable) isStable = false;
+        _states[iNeuron] = y;
+      }
+      _T = 0.5 * (_T + _TInf);
+      return isStable;
+    }
+
+    const std::vector< double >& getStates() const { return _states; }
+
+  private:
+    std::vector< std::vector< double > > _W;
+    std::vector< double > _w0;
+    std::vector< double > _states;
+    std::vector< unsigned > _order;
+    std::mt19937 _rng;
+    double _T = 2.1;
+    double _TInf = 0.1;
+    double _limitForStable = 0.01;
+  };
+
+  double maxDifference(const std::vector< double >& a, const std::vector< double >& b) {
+    double diff = a.size() == b.size() ? 0. : 1.e99;
+    for (unsigned i = 0; i < a.size() && i < b.size(); i++) diff = std::max(diff, std::fabs(a[i] - b[i]));
+    return diff;
+  }
+
+  void testNetwork(unsigned nNeurons, double density, double omega, std::mt19937& gen) {
+    const std::string what = "network of " + std::to_string(nNeurons) + " neurons, density " +
+                             std::to_string(density) + ", omega " + std::to_string(omega);
+    std::uniform_real_distribution< double > uni(0., 1.);
+
+    // a symmetric random graph; the diagonal of G and self conflicts must be ignored
+    std::vector< std::vector< bool > > G(nNeurons, std::vector< bool >(nNeurons, false));
+    std::vector< std::vector< unsigned > > conflicts(nNeurons);
+    for (unsigned i = 0; i < nNeurons; i++) {
+      G[i][i] = uni(gen) < 0.5;
+      if (G[i][i]) conflicts[i].push_back(i);
+      for (unsigned j = i + 1; j < nNeurons; j++) {
+        if (uni(gen) >= density) continue;
+        G[i][j] = G[j][i] = true;
+        conflicts[i].push_back(j);
+        conflicts[j].push_back(i);
+      }
+    }
+
+    std::vector< double > QI(nNeurons), states(nNeurons);
+    for (unsigned i = 0; i < nNeurons; i++) {
+      QI[i] = uni(gen);
+      states[i] = 0.1 * uni(gen);
+    }
+
+    const unsigned seed = gen();
+    HopfieldNeuralNet dense(G, QI, states, omega);
+    HopfieldNeuralNet sparse(conflicts, QI, states, omega);
+    DenseReference reference(G, QI, states, omega, seed);
+    for (HopfieldNeuralNet* net : { &dense, &sparse }) {
+      net->setT(2.1);
+      net->setTInf(0.1);
+      net->setLimitForStable(0.01);
+      net->setSeed(seed);
+    }
+
+    double diffDense = 0., diffSparse = 0.;
+    bool sameStability = true, isStable = false;
+    unsigned nIterations = 0;
+    while (!isStable && nIterations < 1000) {
+      isStable = reference.doIteration();
+      sameStability = sameStability && dense.doIteration() == isStable && sparse.doIteration() == isStable;
+      diffDense = std::max(diffDense, maxDifference(dense.getStates(), reference.getStates()));
+      diffSparse = std::max(diffSparse, maxDifference(sparse.getStates(), reference.getStates()));
+      nIterations++;
+    }
+
+    expect(isStable, what + ": the reference is not stable");
+    expect(diffDense < 1.e-9, what + ": the network from G differs from the dense one by " + std::to_string(diffDense));
+    expect(diffSparse < 1.e-9, what + ": the network from the conflicts differs from the dense one by " +
+           std::to_string(diffSparse));
+    expect(sameStability, what + ": stable after a different number of iterations");
+  }
+
+  // an element with hits; elements are incompatible if they share a hit, or with shareOne if they share two
+  struct Element {
+    unsigned id;
+    std::vector< unsigned > hits;
+  };
+
+  unsigned nSharedHits(const Element* a, const Element* b) {
+    std::set< unsigned > hitsA(a->hits.begin(), a->hits.end()), hitsB(b->hits.begin(), b->hits.end());
+    unsigned nShared = 0;
+    for (unsigned hit : hitsA) nShared += hitsB.count(hit);
+    return nShared;
+  }
+
+  std::vector< Element > makeElements(unsigned nElements, unsigned nHits, std::mt19937& gen) {
+    std::uniform_int_distribution< unsigned > hit(0, nHits - 1), length(3, 6);
+    std::vector< Element > elements(nElements);
+    for (unsigned i = 0; i < nElements; i++) {
+      elements[i].id = i;
+      // the same hit can appear twice in an element
+      for (unsigned k = 0, n = length(gen); k < n; k++) elements[i].hits.push_back(hit(gen));
+    }
+    return elements;
+  }
+
+  // gives access to the conflicts
+  class TestSubset : public SubsetHopfieldNN< const Element* > {
+  public:
+    using SubsetHopfieldNN< const Element* >::findConflicts;
+  };
+
+  void testConflicts(unsigned nElements, unsigned nHits, unsigned maxShared, std::mt19937& gen) {
+    const std::string what = std::to_string(nElements) + " elements on " + std::to_string(nHits) +
+                             " hits, compatible with up to " + std::to_string(maxShared) + " shared hits";
+    std::vector< Element > elements = makeElements(nElements, nHits, gen);
+
+    unsigned nChecks = 0;
+    auto areCompatible = [&](const Element* a, const Element* b) { nChecks++; return nSharedHits(a, b) <= maxShared; };
+    auto getQI = [](const Element* a) { return 1. / a->hits.size(); };
+    auto getHits = [](const Element* a) { return a->hits; };
+
+    TestSubset subset;
+    for (const Element& element : elements) subset.add(&element);
+
+    std::vector< std::vector< unsigned > > allPairs, sharedHits;
+    std::vector< double > QIAllPairs, QISharedHits, states;
+    subset.findConflicts(areCompatible, getQI, allPairs, QIAllPairs, states);
+    unsigned nChecksAllPairs = nChecks;
+    nChecks = 0;
+    subset.findConflicts(areCompatible, getQI, getHits, sharedHits, QISharedHits, states);
+
+    unsigned nConflicts = 0;
+    for (const std::vector< unsigned >& c : allPairs) nConflicts += c.size();
+
+    expect(nElements < 2 || nConflicts > 0, what + ": no conflicts to compare");
+    expect(sharedHits == allPairs, what + ": the conflicts through the shared hits differ from those of all pairs");
+    expect(QISharedHits == QIAllPairs, what + ": different QIs");
+    expect(nChecksAllPairs == nElements * (nElements - 1) / 2, what + ": all pairs checked");
+    expect(nChecks <= nChecksAllPairs && (nElements < 100 || 4 * nChecks < nChecksAllPairs),
+           what + ": " + std::to_string(nChecks) + " checks through the shared hits");
+  }
+
+  // the best subset: every element either accepted or rejected, no two accepted ones share a hit
+  void testBestSubset(int nThreads, std::mt19937& gen) {
+    const std::string what = "best subset with " + std::to_string(nThreads) + " threads";
+    std::vector< Element > elements = makeElements(400, 1200, gen);
+
+    auto areCompatible = [](const Element* a, const Element* b) { return nSharedHits(a, b) == 0; };
+    auto getQI = [](const Element* a) { return 1. / a->hits.size(); };
+    auto getHits = [](const Element* a) { return a->hits; };
+
+    SubsetHopfieldNN< const Element* > subset;
+    subset.setNumberOfThreads(nThreads);
+    for (const Element& element : elements) subset.add(&element);
+    subset.calculateBestSet(areCompatible, getQI, getHits);
+
+    std::vector< const Element* > accepted = subset.getAccepted();
+    std::vector< const Element* > rejected = subset.getRejected();
+
+    std::vector< unsigned > ids;
+    for (const Element* e : accepted) ids.push_back(e->id);
+    for (const Element* e : rejected) ids.push_back(e->id);
+    std::sort(ids.begin(), ids.end());
+    bool partition = ids.size() == elements.size();
+    for (unsigned i = 0; partition && i < ids.size(); i++) partition = ids[i] == i;
+    expect(partition, what + ": not every element accepted or rejected once");
+
+    unsigned nIncompatible = 0;
+    for (unsigned i = 0; i < accepted.size(); i++)
+      for (unsigned j = i + 1; j < accepted.size(); j++) nIncompatible += !areCompatible(accepted[i], accepted[j]);
+    expect(nIncompatible == 0, what + ": " + std::to_string(nIncompatible) + " incompatible accepted pairs");
+    expect(!rejected.empty(), what + ": nothing rejected");
+  }
+}
+
+int main() {
+  std::mt19937 gen(2718);
+
+  for (unsigned nNeurons : { 1u, 2u, 50u, 300u })
+    for (double density : { 0.01, 0.1, 0.5 })
+      for (double omega : { 0., 0.75, 1. }) testNetwork(nNeurons, density, omega, gen);
+
+  for (unsigned maxShared : { 0u, 1u }) {
+    testConflicts(1, 10, maxShared, gen);
+    testConflicts(50, 100, maxShared, gen);
+    testConflicts(500, 2000, maxShared, gen);
+  }
+
+  for (int nThreads : { 1, 4 })
+    for (int i = 0; i < 5; i++) testBestSubset(nThreads, gen);
+
+  if (nFailed) {
+    std::cout << "FAILED: " << nFailed << " checks" << std::endl;
+    return 1;
+  }
+  std::cout << "OK" << std::endl;
+  return 0;
+}